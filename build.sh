@@ -3,12 +3,14 @@ set -e
 
 COSMO_DIR="${COSMO_DIR:-/opt/cosmo}"
 CC="${COSMO_DIR}/bin/cosmocc"
-CFLAGS="-O2 -Wall -Wextra -std=c11 -Isrc -Ithird_party/sqlite3"
+CFLAGS="-O2 -Wall -Wextra -std=c11 -Isrc -Ithird_party/sqlite3 -Iobj/gen"
 LDFLAGS="-static"
 TARGET="app.com"
 OBJ_DIR="obj"
 SRC_DIR="src"
 SQLITE3_DIR="third_party/sqlite3"
+GEN_DIR="${OBJ_DIR}/gen"
+HOSTCC="${HOSTCC:-cc}"
 
 echo "=== Cosmopolitan Build Script ==="
 echo "Toolchain: ${COSMO_DIR}"
@@ -32,12 +34,38 @@ SOURCES=(
     admin.c
     board.c
     upload.c
+    write_queue.c
+    maintenance.c
+    search.c
+    cjk_tokenizer.c
+    suggest.c
+    board_registry.c
+    id_filter.c
+    fragment_cache.c
+    template.c
+    templates.c
+    live.c
+    json.c
+    api.c
+    static_file.c
+    multipart.c
+    sha256.c
+    upload_session.c
+    media.c
 )
 
 OBJECTS=()
 
+echo "Generating templates..."
+mkdir -p "${GEN_DIR}"
+"${HOSTCC}" -O2 -Wall -Wextra -std=c11 tools/tmplc.c -o "${OBJ_DIR}/tmplc"
+"${OBJ_DIR}/tmplc" -I "${SRC_DIR}/board.h" -I "${SRC_DIR}/kaomoji.h" \
+    -o "${GEN_DIR}/templates_gen" templates/*.tmpl
+"${CC}" ${CFLAGS} -c "${GEN_DIR}/templates_gen.c" -o "${OBJ_DIR}/templates_gen.o"
+OBJECTS+=("${OBJ_DIR}/templates_gen.o")
+
 echo "Compiling SQLite3..."
-"${CC}" ${CFLAGS} -DSQLITE_THREADSAFE=0 -DSQLITE_OMIT_LOAD_EXTENSION \
+"${CC}" ${CFLAGS} -DSQLITE_THREADSAFE=2 -DSQLITE_ENABLE_FTS5 -DSQLITE_OMIT_LOAD_EXTENSION \
     -c "${SQLITE3_DIR}/sqlite3.c" -o "${OBJ_DIR}/sqlite3.o"
 OBJECTS+=("${OBJ_DIR}/sqlite3.o")
 
@@ -5,6 +5,9 @@
 #include "i18n.h"
 #include "auth.h"
 #include "utils.h"
+#include "maintenance.h"
+#include "fragment_cache.h"
+#include "live.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,6 +21,7 @@ void admin_init(void) {
 }
 
 void admin_register_routes(void) {
+    router_set_auth_check(admin_is_authenticated);
     router_add_route("GET", "/admin", admin_dashboard_handler);
     router_add_route("GET", "/admin/login", admin_login_handler);
     router_add_route("POST", "/admin/login", admin_login_handler);
@@ -53,12 +57,19 @@ http_response_t *admin_dashboard_handler(http_request_t *req) {
         return http_response_create(403, "text/html", html, strlen(html));
     }
     
-    char *html = malloc(4096);
+    char *html = malloc(8192);
     if (!html) {
         const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
         return http_response_create(500, "text/html", err, strlen(err));
     }
     
+    maintenance_stats_t maint;
+    maintenance_get_stats(&maint);
+    
+    fragment_cache_stats_t fragments;
+    fragment_cache_get_stats(&fragments);
+    int64_t fragment_lookups = fragments.hits + fragments.misses;
+    
     int board_count = 0, thread_count = 0, post_count = 0;
     
     sqlite3_stmt *stmt = db_prepare("SELECT COUNT(*) FROM boards");
@@ -85,7 +96,7 @@ http_response_t *admin_dashboard_handler(http_request_t *req) {
         db_finalize(stmt);
     }
     
-    int len = snprintf(html, 4096,
+    int len = snprintf(html, 8192,
         "<!DOCTYPE html>\n"
         "<html>\n"
         "<head>\n"
@@ -135,15 +146,35 @@ http_response_t *admin_dashboard_handler(http_request_t *req) {
         "</div>\n"
         "</div>\n"
         "<div class=\"card\">\n"
+        "<h2>🗄️ Storage</h2>\n"
+        "<div class=\"stats\">\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%lld KB</div><div class=\"stat-label\">WAL Size</div></div>\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%lld</div><div class=\"stat-label\">Checkpoints (%lld truncating)</div></div>\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%.2f ms</div><div class=\"stat-label\">Last Checkpoint (max %.2f ms)</div></div>\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%lld</div><div class=\"stat-label\">Pages Vacuumed</div></div>\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%.1f%%</div><div class=\"stat-label\">Post Cache Hits (%lld KB)</div></div>\n"
+        "<div class=\"stat-card\"><div class=\"stat-value\">%d</div><div class=\"stat-label\">Live Readers</div></div>\n"
+        "</div>\n"
+        "</div>\n"
+        "<div class=\"card\">\n"
         "<h2>🔥 Recent Activity</h2>\n"
         "<h3>Latest Threads</h3>\n"
         "<ul>\n",
-        board_count, thread_count, post_count);
+        board_count, thread_count, post_count,
+        (long long)(maint.wal_bytes / 1024),
+        (long long)maint.checkpoints,
+        (long long)maint.truncations,
+        maint.last_checkpoint_us / 1000.0,
+        maint.max_checkpoint_us / 1000.0,
+        (long long)maint.vacuumed_pages,
+        fragment_lookups > 0 ? 100.0 * fragments.hits / fragment_lookups : 0.0,
+        (long long)(fragments.bytes / 1024),
+        live_subscriber_count());
     
     stmt = db_prepare(
         "SELECT t.id, t.subject, b.name "
         "FROM threads t JOIN boards b ON t.board_id = b.id "
-        "ORDER BY t.created_at DESC LIMIT 10"
+        "ORDER BY t.created_at DESC, t.id DESC LIMIT 10"
     );
     if (stmt) {
         while (db_step(stmt) == SQLITE_ROW) {
@@ -151,7 +182,7 @@ http_response_t *admin_dashboard_handler(http_request_t *req) {
             const char *subject = (const char *)sqlite3_column_text(stmt, 1);
             const char *board = (const char *)sqlite3_column_text(stmt, 2);
             
-            len += snprintf(html + len, 4096 - len,
+            len += snprintf(html + len, 8192 - len,
                 "<li><a href=\"/thread?id=%lld\">%s</a> in /%s/</li>\n",
                 (long long)id,
                 subject ? subject : "No Subject",
@@ -160,7 +191,7 @@ http_response_t *admin_dashboard_handler(http_request_t *req) {
         db_finalize(stmt);
     }
     
-    len += snprintf(html + len, 4096 - len,
+    len += snprintf(html + len, 8192 - len,
         "</ul>\n"
         "</div>\n"
         "</div>\n"
@@ -437,7 +468,7 @@ static int get_current_user_id(http_request_t *req) {
     
     sqlite3_stmt *stmt = db_prepare(
         "SELECT s.user_id FROM admin_sessions s "
-        "WHERE s.token = ? AND s.expires_at > datetime('now')"
+        "WHERE s.token = ? AND s.expires_at > ?"
     );
     
     if (!stmt) {
@@ -445,6 +476,7 @@ static int get_current_user_id(http_request_t *req) {
     }
     
     sqlite3_bind_text(stmt, 1, session_token, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, db_now_ms());
     
     int user_id = -1;
     if (db_step(stmt) == SQLITE_ROW) {
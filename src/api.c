@@ -0,0 +1,256 @@
+#define _POSIX_C_SOURCE 200809L
+#include "api.h"
+#include "json.h"
+#include "board.h"
+#include "board_registry.h"
+#include "router.h"
+#include "render.h"
+#include "db.h"
+#include "id_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int64_t board_id;
+    thread_t *thread;               /* set for /api/thread/{id} */
+} api_stream_t;
+
+void api_register_routes(void) {
+    router_add_route("GET", "/api/boards", api_boards_handler);
+    router_add_route("GET", "/api/board/*", api_board_path_handler);
+    router_add_route("GET", "/api/thread/*", api_thread_path_handler);
+}
+
+static http_response_t *api_error(int status, const char *message) {
+    render_buf_t out;
+    json_writer_t json;
+    render_buf_init(&out, 64);
+    json_writer_init(&json, &out);
+    
+    int rc = json_begin_object(&json);
+    rc |= json_field_string(&json, "error", message);
+    rc |= json_end_object(&json);
+    
+    http_response_t *response = rc == 0
+        ? http_response_create(status, "application/json", out.data, out.len)
+        : http_response_create(500, "text/plain", "Out of memory", 13);
+    render_buf_free(&out);
+    return response;
+}
+
+static void api_stream_free(void *ctx) {
+    api_stream_t *stream = ctx;
+    thread_free(stream->thread);
+    free(stream);
+}
+
+/* Sends the buffer once it holds a full chunk. */
+static int maybe_flush(http_writer_t *writer, render_buf_t *out) {
+    if (out->len < API_STREAM_CHUNK) {
+        return 0;
+    }
+    int rc = http_writer_write(writer, out->data, out->len);
+    render_buf_reset(out);
+    return rc;
+}
+
+static int flush_rest(http_writer_t *writer, render_buf_t *out) {
+    int rc = out->len > 0 ? http_writer_write(writer, out->data, out->len) : 0;
+    render_buf_reset(out);
+    return rc;
+}
+
+/* GET /api/boards - every board, from the in-memory registry. */
+http_response_t *api_boards_handler(http_request_t *req) {
+    (void)req;
+    
+    size_t count;
+    const board_t *const *boards = board_registry_list(&count);
+    
+    render_buf_t out;
+    json_writer_t json;
+    render_buf_init(&out, 256 + count * 256);
+    json_writer_init(&json, &out);
+    
+    int rc = json_begin_object(&json);
+    rc |= json_key(&json, "boards");
+    rc |= json_begin_array(&json);
+    for (size_t i = 0; i < count && rc == 0; i++) {
+        rc |= json_begin_object(&json);
+        rc |= json_field_int(&json, "id", boards[i]->id);
+        rc |= json_field_string(&json, "name", boards[i]->name);
+        rc |= json_field_string(&json, "title", boards[i]->title);
+        rc |= json_field_string(&json, "description", boards[i]->description);
+        rc |= json_field_int(&json, "created_at", boards[i]->created_at);
+        rc |= json_end_object(&json);
+    }
+    rc |= json_end_array(&json);
+    rc |= json_end_object(&json);
+    
+    http_response_t *response = rc == 0
+        ? http_response_create(200, "application/json", out.data, out.len)
+        : api_error(500, "Out of memory");
+    render_buf_free(&out);
+    return response;
+}
+
+static int board_threads_stream(http_writer_t *writer, void *ctx) {
+    api_stream_t *stream = ctx;
+    
+    render_buf_t out;
+    json_writer_t json;
+    render_buf_init(&out, API_STREAM_CHUNK + 4096);
+    json_writer_init(&json, &out);
+    
+    int rc = json_begin_object(&json);
+    rc |= json_field_int(&json, "board_id", stream->board_id);
+    rc |= json_key(&json, "threads");
+    rc |= json_begin_array(&json);
+    
+    sqlite3_stmt *stmt = rc == 0 ? db_prepare(
+        "SELECT t.id, t.subject, t.created_at, COUNT(p.id), MAX(p.created_at) "
+        "FROM threads t LEFT JOIN posts p ON t.id = p.thread_id "
+        "WHERE t.board_id = ? "
+        "GROUP BY t.id "
+        "ORDER BY t.created_at DESC, t.id DESC"
+    ) : NULL;
+    if (!stmt) {
+        render_buf_free(&out);
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, stream->board_id);
+    
+    while (rc == 0 && db_step(stmt) == SQLITE_ROW) {
+        rc |= json_begin_object(&json);
+        rc |= json_field_int(&json, "id", sqlite3_column_int64(stmt, 0));
+        rc |= json_field_string(&json, "subject", (const char *)sqlite3_column_text(stmt, 1));
+        rc |= json_field_int(&json, "created_at", sqlite3_column_int64(stmt, 2));
+        rc |= json_field_int(&json, "post_count", sqlite3_column_int64(stmt, 3));
+        rc |= json_field_int(&json, "last_post_at", sqlite3_column_int64(stmt, 4));
+        rc |= json_end_object(&json);
+        if (rc == 0) {
+            rc = maybe_flush(writer, &out);
+        }
+    }
+    db_finalize(stmt);
+    
+    rc |= json_end_array(&json);
+    rc |= json_end_object(&json);
+    if (rc == 0) {
+        rc = flush_rest(writer, &out);
+    }
+    
+    render_buf_free(&out);
+    return rc;
+}
+
+static int thread_posts_stream(http_writer_t *writer, void *ctx) {
+    api_stream_t *stream = ctx;
+    thread_t *thread = stream->thread;
+    
+    render_buf_t out;
+    json_writer_t json;
+    render_buf_init(&out, API_STREAM_CHUNK + 4096);
+    json_writer_init(&json, &out);
+    
+    int rc = json_begin_object(&json);
+    rc |= json_field_int(&json, "id", thread->id);
+    rc |= json_field_int(&json, "board_id", thread->board_id);
+    rc |= json_field_string(&json, "subject", thread->subject);
+    rc |= json_field_int(&json, "created_at", thread->created_at);
+    rc |= json_key(&json, "posts");
+    rc |= json_begin_array(&json);
+    
+    sqlite3_stmt *stmt = rc == 0 ? db_prepare(
+        "SELECT id, author, content, reply_to, created_at FROM posts "
+        "WHERE thread_id = ? ORDER BY created_at ASC, id ASC"
+    ) : NULL;
+    if (!stmt) {
+        render_buf_free(&out);
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, thread->id);
+    
+    while (rc == 0 && db_step(stmt) == SQLITE_ROW) {
+        rc |= json_begin_object(&json);
+        rc |= json_field_int(&json, "id", sqlite3_column_int64(stmt, 0));
+        rc |= json_field_string(&json, "author", (const char *)sqlite3_column_text(stmt, 1));
+        rc |= json_field_string(&json, "content", (const char *)sqlite3_column_text(stmt, 2));
+        rc |= json_key(&json, "reply_to");
+        if (sqlite3_column_type(stmt, 3) == SQLITE_NULL) {
+            rc |= json_null(&json);
+        } else {
+            rc |= json_int(&json, sqlite3_column_int64(stmt, 3));
+        }
+        rc |= json_field_int(&json, "created_at", sqlite3_column_int64(stmt, 4));
+        rc |= json_end_object(&json);
+        if (rc == 0) {
+            rc = maybe_flush(writer, &out);
+        }
+    }
+    db_finalize(stmt);
+    
+    rc |= json_end_array(&json);
+    rc |= json_end_object(&json);
+    if (rc == 0) {
+        rc = flush_rest(writer, &out);
+    }
+    
+    render_buf_free(&out);
+    return rc;
+}
+
+/* GET /api/board/{id}/threads - newest threads first. */
+http_response_t *api_board_path_handler(http_request_t *req) {
+    long long board_id = 0;
+    int consumed = 0;
+    if (sscanf(req->path, "/api/board/%lld/threads%n", &board_id, &consumed) != 1 ||
+        consumed == 0 || req->path[consumed] != '\0') {
+        return api_error(404, "Not found");
+    }
+    if (!board_registry_get_by_id(board_id)) {
+        return api_error(404, "Board not found");
+    }
+    
+    api_stream_t *stream = calloc(1, sizeof(api_stream_t));
+    if (!stream) {
+        return api_error(500, "Out of memory");
+    }
+    stream->board_id = board_id;
+    
+    return http_response_create_stream(200, "application/json", board_threads_stream,
+                                       stream, api_stream_free);
+}
+
+/* GET /api/thread/{id} - the thread and all of its posts, oldest first. */
+http_response_t *api_thread_path_handler(http_request_t *req) {
+    long long thread_id = 0;
+    int consumed = 0;
+    if (sscanf(req->path, "/api/thread/%lld%n", &thread_id, &consumed) != 1 ||
+        consumed == 0 || req->path[consumed] != '\0') {
+        return api_error(404, "Not found");
+    }
+    
+    thread_t *thread = NULL;
+    if (id_filter_may_exist(ID_FILTER_THREADS, thread_id)) {
+        thread = thread_get_by_id(thread_id);
+        if (!thread) {
+            id_filter_record_miss(ID_FILTER_THREADS, thread_id);
+        }
+    }
+    if (!thread) {
+        return api_error(404, "Thread not found");
+    }
+    
+    api_stream_t *stream = calloc(1, sizeof(api_stream_t));
+    if (!stream) {
+        thread_free(thread);
+        return api_error(500, "Out of memory");
+    }
+    stream->board_id = thread->board_id;
+    stream->thread = thread;
+    
+    return http_response_create_stream(200, "application/json", thread_posts_stream,
+                                       stream, api_stream_free);
+}
@@ -0,0 +1,23 @@
+#ifndef API_H
+#define API_H
+
+#include "http.h"
+
+/*
+ * Read-only JSON API for mobile clients and archivers:
+ *   GET /api/boards
+ *   GET /api/board/{id}/threads
+ *   GET /api/thread/{id}
+ * Lists are written with the streaming JSON writer while rows are still
+ * being stepped, and sent in chunks, so memory stays flat however long a
+ * board or thread gets.
+ */
+
+#define API_STREAM_CHUNK 16384
+
+void api_register_routes(void);
+http_response_t *api_boards_handler(http_request_t *req);
+http_response_t *api_board_path_handler(http_request_t *req);
+http_response_t *api_thread_path_handler(http_request_t *req);
+
+#endif
@@ -3,6 +3,8 @@
 #include "utils.h"
 #include <string.h>
 
+#define AUTH_SESSION_TTL_MS (7LL * 24 * 60 * 60 * 1000)
+
 int auth_is_authenticated(http_request_t *req) {
     if (!req->cookies) {
         return 0;
@@ -15,7 +17,7 @@ int auth_is_authenticated(http_request_t *req) {
     
     sqlite3_stmt *stmt = db_prepare(
         "SELECT s.user_id FROM admin_sessions s "
-        "WHERE s.token = ? AND s.expires_at > datetime('now')"
+        "WHERE s.token = ? AND s.expires_at > ?"
     );
     
     if (!stmt) {
@@ -23,6 +25,7 @@ int auth_is_authenticated(http_request_t *req) {
     }
     
     sqlite3_bind_text(stmt, 1, session_token, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, db_now_ms());
     
     int authenticated = 0;
     if (db_step(stmt) == SQLITE_ROW) {
@@ -35,10 +38,11 @@ int auth_is_authenticated(http_request_t *req) {
 
 char *auth_create_session(int user_id) {
     char *token = generate_random_token(64);
+    int64_t now = db_now_ms();
     
     sqlite3_stmt *stmt = db_prepare(
-        "INSERT INTO admin_sessions (user_id, token, expires_at) "
-        "VALUES (?, ?, datetime('now', '+7 days'))"
+        "INSERT INTO admin_sessions (user_id, token, created_at, expires_at) "
+        "VALUES (?, ?, ?, ?)"
     );
     
     if (!stmt) {
@@ -47,6 +51,8 @@ char *auth_create_session(int user_id) {
     
     sqlite3_bind_int(stmt, 1, user_id);
     sqlite3_bind_text(stmt, 2, token, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, now);
+    sqlite3_bind_int64(stmt, 4, now + AUTH_SESSION_TTL_MS);
     
     if (db_step(stmt) != SQLITE_DONE) {
         db_finalize(stmt);
@@ -1,257 +1,171 @@
 #define _POSIX_C_SOURCE 200809L
 #include "board.h"
+#include "board_registry.h"
 #include "router.h"
 #include "render.h"
 #include "db.h"
 #include "admin.h"
 #include "i18n.h"
+#include "suggest.h"
 #include "kaomoji.h"
 #include "utils.h"
+#include "write_queue.h"
+#include "id_filter.h"
+#include "fragment_cache.h"
+#include "template.h"
+#include "templates.h"
+#include "templates_gen.h"
+#include "live.h"
+#include "upload.h"
+#include "media.h"
+#include "static_file.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *page_title;
+    int lang_en;
+    int lang_zh_cn;
+    const char *search_placeholder;
+    const char *search_label;
+    template_list_t boards;         /* board_t */
+    int is_admin;
+    const char *create_new_board;
+    const char *name_label;
+    const char *title_label;
+    const char *description_label;
+    const char *create_board_label;
+} board_list_page_t;
+
+static const template_field_t board_fields[] = {
+    TEMPLATE_FIELD(board_t, id, TEMPLATE_INT),
+    TEMPLATE_FIELD(board_t, name, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_t, title, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_t, description, TEMPLATE_TEXT),
+};
+static const template_schema_t board_schema = TEMPLATE_SCHEMA(board_t, board_fields);
+
+static const template_field_t board_list_page_fields[] = {
+    TEMPLATE_FIELD(board_list_page_t, page_title, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, lang_en, TEMPLATE_BOOL),
+    TEMPLATE_FIELD(board_list_page_t, lang_zh_cn, TEMPLATE_BOOL),
+    TEMPLATE_FIELD(board_list_page_t, search_placeholder, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, search_label, TEMPLATE_TEXT),
+    TEMPLATE_LIST_FIELD(board_list_page_t, boards, board_schema),
+    TEMPLATE_FIELD(board_list_page_t, is_admin, TEMPLATE_BOOL),
+    TEMPLATE_FIELD(board_list_page_t, create_new_board, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, name_label, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, title_label, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, description_label, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(board_list_page_t, create_board_label, TEMPLATE_TEXT),
+};
+static const template_schema_t board_list_page_schema =
+    TEMPLATE_SCHEMA(board_list_page_t, board_list_page_fields);
+
+static const template_t *board_list_template = NULL;
+
+/* The picker markup depends only on the built-in kaomoji table, so it is
+ * rendered once and embedded into every board and thread page. */
+static render_buf_t kaomoji_picker;
 
 void board_init(void) {
     printf("Board module initialized\n");
     
+    board_list_template = template_register("board_list", template_board_list,
+                                            &board_list_page_schema);
+    
+    kaomoji_picker_t picker = {
+        .categories = kaomoji_get_categories(),
+        .categories_count = kaomoji_get_categories_count(),
+    };
+    render_buf_init(&kaomoji_picker, 32768);
+    if (tmpl_kaomoji_picker(&kaomoji_picker, &picker) != 0) {
+        fprintf(stderr, "Failed to render kaomoji picker\n");
+        render_buf_free(&kaomoji_picker);
+    }
+    
     sqlite3_stmt *stmt = db_prepare("SELECT COUNT(*) FROM boards");
     if (stmt) {
         if (db_step(stmt) == SQLITE_ROW) {
             int count = sqlite3_column_int(stmt, 0);
             if (count == 0) {
                 printf("Creating sample boards...\n");
-                db_exec("INSERT INTO boards (name, title, description) VALUES "
-                       "('general', 'General Discussion', 'General discussion topics'), "
-                       "('tech', 'Technology', 'Technology and programming discussions'), "
-                       "('random', 'Random', 'Random and off-topic discussions')");
+                db_exec("INSERT INTO boards (name, title, description, created_at) VALUES "
+                       "('general', 'General Discussion', 'General discussion topics', " DB_NOW_MS_SQL "), "
+                       "('tech', 'Technology', 'Technology and programming discussions', " DB_NOW_MS_SQL "), "
+                       "('random', 'Random', 'Random and off-topic discussions', " DB_NOW_MS_SQL ")");
             }
         }
         db_finalize(stmt);
     }
+    
+    board_registry_load();
+}
+
+void board_shutdown(void) {
+    render_buf_free(&kaomoji_picker);
 }
 
 void board_register_routes(void) {
     router_add_route("GET", "/", board_list_handler);
     router_add_route("GET", "/board", board_view_handler);
+    router_add_route("GET", "/b/*", board_path_handler);
     router_add_route("POST", "/board/create", board_create_handler);
     router_add_route("GET", "/thread", thread_view_handler);
-    router_add_route("POST", "/thread", thread_create_handler);
-    router_add_route("POST", "/post", post_create_handler);
+    router_add_route("GET", "/thread/*", thread_path_handler);
+    router_add_limited_route("POST", "/thread", thread_create_handler, UPLOAD_MAX_BODY, 0);
+    router_add_limited_route("POST", "/post", post_create_handler, UPLOAD_MAX_BODY, 0);
 }
 
 http_response_t *board_list_handler(http_request_t *req) {
     language_t lang = i18n_get_language(req);
     
-    char *html = malloc(16384);
-    if (!html) {
+    size_t board_count;
+    const board_t *const *boards = board_registry_list(&board_count);
+    board_t *items = malloc((board_count ? board_count : 1) * sizeof(board_t));
+    
+    render_buf_t buf;
+    if (!board_list_template || !items || render_buf_init(&buf, 16384) != 0) {
+        free(items);
         const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
         return http_response_create(500, "text/html", err, strlen(err));
     }
     
-    int len = snprintf(html, 16384,
-        "<!DOCTYPE html>\n"
-        "<html>\n"
-        "<head>\n"
-        "<meta charset=\"UTF-8\">\n"
-        "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
-        "<title>%s</title>\n"
-        "<style>\n"
-        ":root {\n"
-        "  --primary: #1976d2;\n"
-        "  --primary-dark: #1565c0;\n"
-        "  --primary-light: #42a5f5;\n"
-        "  --accent: #ff4081;\n"
-        "  --text-primary: rgba(0,0,0,0.87);\n"
-        "  --text-secondary: rgba(0,0,0,0.54);\n"
-        "  --divider: rgba(0,0,0,0.12);\n"
-        "  --background: #fafafa;\n"
-        "  --surface: #ffffff;\n"
-        "  --error: #f44336;\n"
-        "}\n"
-        "* { box-sizing: border-box; margin: 0; padding: 0; }\n"
-        "body {\n"
-        "  font-family: 'Roboto', 'Segoe UI', Arial, sans-serif, 'Microsoft YaHei', 'SimHei';\n"
-        "  background: var(--background);\n"
-        "  color: var(--text-primary);\n"
-        "  line-height: 1.6;\n"
-        "  padding: 16px;\n"
-        "}\n"
-        ".container { max-width: 1200px; margin: 0 auto; }\n"
-        ".card {\n"
-        "  background: var(--surface);\n"
-        "  border-radius: 4px;\n"
-        "  box-shadow: 0 2px 4px rgba(0,0,0,0.1);\n"
-        "  padding: 16px;\n"
-        "  margin-bottom: 16px;\n"
-        "}\n"
-        ".card:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); transition: box-shadow 0.3s; }\n"
-        "h1 {\n"
-        "  font-size: 2rem;\n"
-        "  font-weight: 500;\n"
-        "  margin-bottom: 24px;\n"
-        "  color: var(--primary);\n"
-        "  display: flex;\n"
-        "  justify-content: space-between;\n"
-        "  align-items: center;\n"
-        "  flex-wrap: wrap;\n"
-        "}\n"
-        "@media (max-width: 768px) { h1 { font-size: 1.5rem; } }\n"
-        ".lang-switch { font-size: 0.875rem; font-weight: normal; }\n"
-        ".lang-switch a { color: var(--primary); text-decoration: none; padding: 6px 12px;\n"
-        "  border: 1px solid var(--primary); border-radius: 4px; margin-left: 8px; transition: all 0.2s; }\n"
-        ".lang-switch a:hover { background: var(--primary); color: white; }\n"
-        ".lang-switch a.active { background: var(--primary); color: white; }\n"
-        ".board-list { list-style: none; }\n"
-        ".board-item {\n"
-        "  display: block;\n"
-        "  padding: 16px;\n"
-        "  background: var(--surface);\n"
-        "  border-radius: 4px;\n"
-        "  margin-bottom: 12px;\n"
-        "  box-shadow: 0 1px 3px rgba(0,0,0,0.1);\n"
-        "  transition: all 0.2s;\n"
-        "}\n"
-        ".board-item:hover {\n"
-        "  box-shadow: 0 4px 8px rgba(0,0,0,0.15);\n"
-        "  transform: translateY(-2px);\n"
-        "}\n"
-        ".board-link {\n"
-        "  color: var(--primary);\n"
-        "  text-decoration: none;\n"
-        "  font-size: 1.25rem;\n"
-        "  font-weight: 500;\n"
-        "  display: block;\n"
-        "  margin-bottom: 8px;\n"
-        "}\n"
-        ".board-desc {\n"
-        "  color: var(--text-secondary);\n"
-        "  font-size: 0.875rem;\n"
-        "  display: block;\n"
-        "}\n"
-        ".btn {\n"
-        "  background: var(--primary);\n"
-        "  color: white;\n"
-        "  border: none;\n"
-        "  padding: 10px 24px;\n"
-        "  border-radius: 4px;\n"
-        "  font-size: 0.875rem;\n"
-        "  font-weight: 500;\n"
-        "  text-transform: uppercase;\n"
-        "  cursor: pointer;\n"
-        "  box-shadow: 0 2px 4px rgba(0,0,0,0.2);\n"
-        "  transition: all 0.2s;\n"
-        "  min-height: 48px;\n"
-        "}\n"
-        ".btn:hover { background: var(--primary-dark); box-shadow: 0 4px 8px rgba(0,0,0,0.3); }\n"
-        ".btn:active { box-shadow: 0 1px 2px rgba(0,0,0,0.2); }\n"
-        "@media (max-width: 768px) { .btn { width: 100%%; } }\n"
-        "input[type=\"text\"], textarea {\n"
-        "  width: 100%%;\n"
-        "  padding: 12px 16px;\n"
-        "  margin: 8px 0;\n"
-        "  border: 1px solid var(--divider);\n"
-        "  border-radius: 4px;\n"
-        "  font-size: 1rem;\n"
-        "  font-family: inherit;\n"
-        "  background: var(--surface);\n"
-        "  transition: border-color 0.2s;\n"
-        "}\n"
-        "input:focus, textarea:focus {\n"
-        "  outline: none;\n"
-        "  border-color: var(--primary);\n"
-        "  box-shadow: 0 0 0 2px rgba(25,118,210,0.1);\n"
-        "}\n"
-        "textarea { min-height: 120px; resize: vertical; }\n"
-        "</style>\n"
-        "<script>\n"
-        "function setLanguage(lang) {\n"
-        "  document.cookie = 'lang=' + lang + '; path=/; max-age=31536000';\n"
-        "  window.location.href = '/?lang=' + lang;\n"
-        "}\n"
-        "</script>\n"
-        "</head>\n"
-        "<body>\n"
-        "<div class=\"container\">\n"
-        "<h1>\n"
-        "  <span>📋 %s</span>\n"
-        "  <span class=\"lang-switch\">\n"
-        "    <a href=\"#\" onclick=\"setLanguage('en'); return false;\" class=\"%s\">English</a>\n"
-        "    <a href=\"#\" onclick=\"setLanguage('zh-cn'); return false;\" class=\"%s\">中文</a>\n"
-        "  </span>\n"
-        "</h1>\n"
-        "<ul class=\"board-list\">\n",
-        i18n_get(lang, "message_boards"),
-        i18n_get(lang, "message_boards"),
-        (lang == LANG_EN ? "active" : ""),
-        (lang == LANG_ZH_CN ? "active" : ""));
-    
-    sqlite3_stmt *stmt = db_prepare("SELECT id, name, title, description FROM boards ORDER BY name");
-    if (stmt) {
-        while (db_step(stmt) == SQLITE_ROW) {
-            int64_t id = sqlite3_column_int64(stmt, 0);
-            const char *name = (const char *)sqlite3_column_text(stmt, 1);
-            const char *title = (const char *)sqlite3_column_text(stmt, 2);
-            const char *desc = (const char *)sqlite3_column_text(stmt, 3);
-            
-            char *escaped_name = render_escape_html(name ? name : "Unknown");
-            char *escaped_title = render_escape_html(title ? title : "No Title");
-            char *escaped_desc = render_escape_html(desc ? desc : "");
-            
-            len += snprintf(html + len, 8192 - len,
-                "<li class=\"board-item\">\n"
-                "<a href=\"/board?id=%lld\" class=\"board-link\">%s - %s</a>\n"
-                "<span class=\"board-desc\">%s</span>\n"
-                "</li>\n",
-                (long long)id, 
-                escaped_name ? escaped_name : "Unknown",
-                escaped_title ? escaped_title : "No Title",
-                escaped_desc ? escaped_desc : "");
-            
-            free(escaped_name);
-            free(escaped_title);
-            free(escaped_desc);
-        }
-        db_finalize(stmt);
+    for (size_t i = 0; i < board_count; i++) {
+        items[i] = *boards[i];
     }
     
-    len += snprintf(html + len, 16384 - len, "</ul>\n");
-    
-    if (admin_is_authenticated(req)) {
-        len += snprintf(html + len, 16384 - len,
-            "<div class=\"card\" style=\"margin-top:24px;\">\n"
-            "<h2 style=\"font-size:1.5rem;margin-bottom:16px;\">%s</h2>\n"
-            "<form method=\"POST\" action=\"/board/create\">\n"
-            "<div style=\"margin-bottom:16px;\">\n"
-            "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">%s</label>\n"
-            "<input type=\"text\" name=\"name\" required>\n"
-            "</div>\n"
-            "<div style=\"margin-bottom:16px;\">\n"
-            "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">%s</label>\n"
-            "<input type=\"text\" name=\"title\" required>\n"
-            "</div>\n"
-            "<div style=\"margin-bottom:16px;\">\n"
-            "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">%s</label>\n"
-            "<textarea name=\"description\"></textarea>\n"
-            "</div>\n"
-            "<button type=\"submit\" class=\"btn\">%s</button>\n"
-            "</form>\n"
-            "</div>\n",
-            i18n_get(lang, "create_new_board"),
-            i18n_get(lang, "name"),
-            i18n_get(lang, "title"),
-            i18n_get(lang, "description"),
-            i18n_get(lang, "create_board"));
-    }
-    
-    len += snprintf(html + len, 16384 - len,
-        "</div>\n"
-        "</body>\n"
-        "</html>");
+    board_list_page_t page = {
+        .page_title = i18n_get(lang, "message_boards"),
+        .lang_en = lang == LANG_EN,
+        .lang_zh_cn = lang == LANG_ZH_CN,
+        .search_placeholder = i18n_get(lang, "search_placeholder"),
+        .search_label = i18n_get(lang, "search"),
+        .boards = { items, board_count },
+        .is_admin = admin_is_authenticated(req),
+        .create_new_board = i18n_get(lang, "create_new_board"),
+        .name_label = i18n_get(lang, "name"),
+        .title_label = i18n_get(lang, "title"),
+        .description_label = i18n_get(lang, "description"),
+        .create_board_label = i18n_get(lang, "create_board")
+    };
+    
+    http_response_t *response;
+    if (template_render(board_list_template, &page, &buf) == 0) {
+        response = http_response_create(200, "text/html", buf.data, buf.len);
+    } else {
+        const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
+        response = http_response_create(500, "text/html", err, strlen(err));
+    }
     
-    http_response_t *response = http_response_create(200, "text/html", html, len);
-    free(html);
+    render_buf_free(&buf);
+    free(items);
     return response;
 }
 
@@ -306,7 +220,7 @@ http_response_t *board_create_handler(http_request_t *req) {
     }
     
     sqlite3_stmt *stmt = db_prepare(
-        "INSERT INTO boards (name, title, description) VALUES (?, ?, ?)"
+        "INSERT INTO boards (name, title, description, created_at) VALUES (?, ?, ?, ?)"
     );
     if (!stmt) {
         const char *html = "<html><body><h1>Error: Failed to create board</h1></body></html>";
@@ -316,6 +230,7 @@ http_response_t *board_create_handler(http_request_t *req) {
     sqlite3_bind_text(stmt, 1, name, -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, title, -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, description, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 4, db_now_ms());
     
     int rc = db_step(stmt);
     int64_t board_id = sqlite3_last_insert_rowid(db_get_connection());
@@ -326,6 +241,8 @@ http_response_t *board_create_handler(http_request_t *req) {
         return http_response_create(500, "text/html", html, strlen(html));
     }
     
+    board_registry_load();
+    
     char *html = malloc(512);
     if (!html) {
         const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
@@ -349,15 +266,9 @@ http_response_t *board_create_handler(http_request_t *req) {
     return response;
 }
 
-http_response_t *board_view_handler(http_request_t *req) {
+static http_response_t *render_board(http_request_t *req, const board_t *board) {
     language_t lang = i18n_get_language(req);
     
-    int64_t board_id = 1;
-    if (req->query_string) {
-        sscanf(req->query_string, "id=%lld", (long long *)&board_id);
-    }
-    
-    board_t *board = board_get_by_id(board_id);
     if (!board) {
         char error_html[512];
         snprintf(error_html, sizeof(error_html),
@@ -367,307 +278,234 @@ http_response_t *board_view_handler(http_request_t *req) {
         return http_response_create(404, "text/html", error_html, strlen(error_html));
     }
     
-    char *html = malloc(65536);
-    if (!html) {
-        board_free(board);
-        const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
-        return http_response_create(500, "text/html", err, strlen(err));
-    }
-    
-    char *escaped_name_title = render_escape_html(board->name ? board->name : "Board");
-    char *escaped_name_h1 = render_escape_html(board->name ? board->name : "board");
-    char *escaped_name_body = render_escape_html(board->name ? board->name : "Board");
-    char *escaped_desc = render_escape_html(board->description ? board->description : "No description");
+    board_page_t page = {
+        .lang = lang,
+        .lang_en = lang == LANG_EN,
+        .lang_zh_cn = lang == LANG_ZH_CN,
+        .id = board->id,
+        .name = board->name,
+        .description = board->description,
+        .kaomoji_picker_html = kaomoji_picker.data ? kaomoji_picker.data : "",
+    };
     
-    int len = snprintf(html, 65536,
-        "<!DOCTYPE html>\n"
-        "<html>\n"
-        "<head>\n"
-        "<meta charset=\"UTF-8\">\n"
-        "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
-        "<title>%s</title>\n"
-        "<style>\n"
-        ":root {\n"
-        "  --primary: #1976d2; --primary-dark: #1565c0; --primary-light: #42a5f5;\n"
-        "  --accent: #ff4081; --text-primary: rgba(0,0,0,0.87); --text-secondary: rgba(0,0,0,0.54);\n"
-        "  --divider: rgba(0,0,0,0.12); --background: #fafafa; --surface: #ffffff; --error: #f44336;\n"
-        "}\n"
-        "* { box-sizing: border-box; margin: 0; padding: 0; }\n"
-        "body { font-family: 'Roboto', 'Segoe UI', Arial, sans-serif, 'Microsoft YaHei', 'SimHei'; background: var(--background);\n"
-        "  color: var(--text-primary); line-height: 1.6; padding: 16px; }\n"
-        ".container { max-width: 1200px; margin: 0 auto; }\n"
-        ".card { background: var(--surface); border-radius: 4px; box-shadow: 0 2px 4px rgba(0,0,0,0.1);\n"
-        "  padding: 16px; margin-bottom: 16px; transition: box-shadow 0.3s; }\n"
-        ".card:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); }\n"
-        ".header-card { background: linear-gradient(135deg, var(--primary) 0%%, var(--primary-dark) 100%%);\n"
-        "  color: white; padding: 24px; margin-bottom: 24px; }\n"
-        ".header-card h1 { color: white; font-size: 2rem; font-weight: 500; margin-bottom: 8px; }\n"
-        ".header-card p { color: rgba(255,255,255,0.9); font-size: 1rem; }\n"
-        "@media (max-width: 768px) { .header-card h1 { font-size: 1.5rem; } }\n"
-        ".nav-link { color: rgba(255,255,255,0.9); text-decoration: none; margin-right: 16px;\n"
-        "  display: inline-block; margin-top: 12px; font-size: 0.875rem; transition: color 0.2s; }\n"
-        ".nav-link:hover { color: white; text-decoration: underline; }\n"
-        "h2 { font-size: 1.5rem; font-weight: 500; margin-bottom: 16px; color: var(--text-primary); }\n"
-        ".thread-list { list-style: none; }\n"
-        ".thread-item { background: var(--surface); padding: 16px; margin-bottom: 12px;\n"
-        "  border-radius: 4px; box-shadow: 0 1px 3px rgba(0,0,0,0.1); transition: all 0.2s;\n"
-        "  display: flex; justify-content: space-between; align-items: center; }\n"
-        ".thread-item:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); transform: translateY(-2px); }\n"
-        ".thread-link { color: var(--primary); text-decoration: none; font-size: 1.125rem;\n"
-        "  font-weight: 500; flex: 1; }\n"
-        ".thread-link:hover { text-decoration: underline; }\n"
-        ".thread-meta { color: var(--text-secondary); font-size: 0.875rem; margin-left: 16px;\n"
-        "  white-space: nowrap; }\n"
-        "@media (max-width: 768px) {\n"
-        "  .thread-item { flex-direction: column; align-items: flex-start; }\n"
-        "  .thread-meta { margin-left: 0; margin-top: 8px; }\n"
-        "}\n"
-        ".btn { background: var(--primary); color: white; border: none; padding: 10px 24px;\n"
-        "  border-radius: 4px; font-size: 0.875rem; font-weight: 500; text-transform: uppercase;\n"
-        "  cursor: pointer; box-shadow: 0 2px 4px rgba(0,0,0,0.2); transition: all 0.2s; min-height: 48px; }\n"
-        ".btn:hover { background: var(--primary-dark); box-shadow: 0 4px 8px rgba(0,0,0,0.3); }\n"
-        ".btn:active { box-shadow: 0 1px 2px rgba(0,0,0,0.2); }\n"
-        "@media (max-width: 768px) { .btn { width: 100%%; } }\n"
-        "input[type=\"text\"], textarea { width: 100%%; padding: 12px 16px; margin: 8px 0;\n"
-        "  border: 1px solid var(--divider); border-radius: 4px; font-size: 1rem; font-family: inherit;\n"
-        "  background: var(--surface); transition: border-color 0.2s; }\n"
-        "input:focus, textarea:focus { outline: none; border-color: var(--primary);\n"
-        "  box-shadow: 0 0 0 2px rgba(25,118,210,0.1); }\n"
-        "textarea { min-height: 120px; resize: vertical; }\n"
-        "label { display: block; margin-bottom: 4px; font-weight: 500; color: var(--text-primary); }\n"
-        ".form-group { margin-bottom: 16px; }\n"
-        ".kaomoji-btn { background: var(--accent); color: white; border: none; padding: 8px 16px;\n"
-        "  cursor: pointer; border-radius: 4px; font-weight: 500; transition: background 0.2s;\n"
-        "  font-size: 0.875rem; box-shadow: 0 2px 4px rgba(0,0,0,0.2); }\n"
-        ".kaomoji-btn:hover { background: #e91e63; box-shadow: 0 3px 6px rgba(0,0,0,0.3); }\n"
-        ".kaomoji-modal { display: none; position: fixed; z-index: 1000; left: 0; top: 0;\n"
-        "  width: 100%%; height: 100%%; background: rgba(0,0,0,0.5); align-items: center;\n"
-        "  justify-content: center; }\n"
-        ".kaomoji-modal.show { display: flex; }\n"
-        ".kaomoji-popup { background: var(--surface); border-radius: 8px; box-shadow: 0 4px 20px rgba(0,0,0,0.3);\n"
-        "  max-width: 600px; width: 90%%; max-height: 70vh; display: flex; flex-direction: column;\n"
-        "  position: relative; }\n"
-        ".kaomoji-header { display: flex; justify-content: space-between; align-items: center;\n"
-        "  padding: 16px 20px; border-bottom: 1px solid var(--divider); }\n"
-        ".kaomoji-title { font-size: 1.125rem; font-weight: 500; color: var(--text-primary); }\n"
-        ".kaomoji-close { background: none; border: none; font-size: 1.5rem; color: var(--text-secondary);\n"
-        "  cursor: pointer; padding: 0; width: 32px; height: 32px; border-radius: 50%%;\n"
-        "  transition: all 0.2s; line-height: 1; }\n"
-        ".kaomoji-close:hover { background: rgba(0,0,0,0.05); color: var(--text-primary); }\n"
-        ".kaomoji-tabs { display: flex; overflow-x: auto; border-bottom: 1px solid var(--divider);\n"
-        "  background: #f5f5f5; }\n"
-        ".kaomoji-tab { background: none; border: none; padding: 12px 20px; cursor: pointer;\n"
-        "  font-size: 0.875rem; font-weight: 500; color: var(--text-secondary);\n"
-        "  transition: all 0.2s; white-space: nowrap; border-bottom: 2px solid transparent; }\n"
-        ".kaomoji-tab:hover { background: rgba(25,118,210,0.05); color: var(--primary); }\n"
-        ".kaomoji-tab.active { color: var(--primary); border-bottom-color: var(--primary); background: white; }\n"
-        ".kaomoji-content { flex: 1; overflow-y: auto; padding: 16px 20px; }\n"
-        ".kaomoji-category { display: none; }\n"
-        ".kaomoji-category.active { display: block; }\n"
-        ".kaomoji-items { display: flex; flex-wrap: wrap; gap: 8px; }\n"
-        ".kaomoji-item { padding: 8px 16px; border: 1px solid var(--divider); background: white;\n"
-        "  cursor: pointer; border-radius: 4px; font-size: 1rem; transition: all 0.2s;\n"
-        "  box-shadow: 0 1px 2px rgba(0,0,0,0.05); }\n"
-        ".kaomoji-item:hover { background: #e3f2fd; border-color: var(--primary);\n"
-        "  box-shadow: 0 2px 4px rgba(0,0,0,0.15); transform: translateY(-1px); }\n"
-        ".kaomoji-item:active { transform: translateY(0); box-shadow: 0 1px 2px rgba(0,0,0,0.1); }\n"
-        "@media (max-width: 768px) {\n"
-        "  .kaomoji-popup { width: 95%%; max-height: 80vh; }\n"
-        "  .kaomoji-tab { padding: 10px 12px; font-size: 0.8rem; }\n"
-        "  .kaomoji-item { padding: 6px 12px; font-size: 0.9rem; }\n"
-        "}\n"
-        "</style>\n"
-        "<script>\n"
-        "var currentTab = 0;\n"
-        "function openKaomoji() {\n"
-        "  document.getElementById('kaomoji-modal').classList.add('show');\n"
-        "}\n"
-        "function closeKaomoji() {\n"
-        "  document.getElementById('kaomoji-modal').classList.remove('show');\n"
-        "}\n"
-        "function switchTab(index) {\n"
-        "  currentTab = index;\n"
-        "  var tabs = document.querySelectorAll('.kaomoji-tab');\n"
-        "  var categories = document.querySelectorAll('.kaomoji-category');\n"
-        "  tabs.forEach(function(tab, i) {\n"
-        "    if (i === index) { tab.classList.add('active'); } else { tab.classList.remove('active'); }\n"
-        "  });\n"
-        "  categories.forEach(function(cat, i) {\n"
-        "    if (i === index) { cat.classList.add('active'); } else { cat.classList.remove('active'); }\n"
-        "  });\n"
-        "}\n"
-        "function insertKaomoji(kaomoji) {\n"
-        "  var textarea = document.querySelector('textarea[name=\"content\"]');\n"
-        "  var start = textarea.selectionStart;\n"
-        "  var end = textarea.selectionEnd;\n"
-        "  var text = textarea.value;\n"
-        "  textarea.value = text.substring(0, start) + kaomoji + text.substring(end);\n"
-        "  textarea.selectionStart = textarea.selectionEnd = start + kaomoji.length;\n"
-        "  textarea.focus();\n"
-        "  closeKaomoji();\n"
-        "}\n"
-        "window.onclick = function(event) {\n"
-        "  var modal = document.getElementById('kaomoji-modal');\n"
-        "  if (event.target === modal) { closeKaomoji(); }\n"
-        "}\n"
-        "function setLanguage(lang) {\n"
-        "  document.cookie = 'lang=' + lang + '; path=/; max-age=31536000';\n"
-        "  window.location.href = window.location.pathname + '?id=%lld&lang=' + lang;\n"
-        "}\n"
-        "</script>\n"
-        "</head>\n"
-        "<body>\n"
-        "<div class=\"container\">\n"
-        "<div class=\"header-card card\">\n"
-        "<h1 style=\"display:flex;justify-content:space-between;align-items:center;flex-wrap:wrap;\">\n"
-        "  <span>/%s/ - %s</span>\n"
-        "  <span style=\"font-size:0.875rem;font-weight:normal;\">\n"
-        "    <a href=\"#\" onclick=\"setLanguage('en'); return false;\" style=\"color:rgba(255,255,255,0.9);text-decoration:none;padding:6px 12px;border:1px solid rgba(255,255,255,0.5);border-radius:4px;margin-left:8px;%s\">English</a>\n"
-        "    <a href=\"#\" onclick=\"setLanguage('zh-cn'); return false;\" style=\"color:rgba(255,255,255,0.9);text-decoration:none;padding:6px 12px;border:1px solid rgba(255,255,255,0.5);border-radius:4px;margin-left:8px;%s\">中文</a>\n"
-        "  </span>\n"
-        "</h1>\n"
-        "<p>%s</p>\n"
-        "<a href=\"/\" class=\"nav-link\">← %s</a>\n"
-        "</div>\n"
-        "<h2>💬 %s</h2>\n"
-        "<ul class=\"thread-list\">\n",
-        escaped_name_title ? escaped_name_title : "Board",
-        (long long)board_id,
-        escaped_name_h1 ? escaped_name_h1 : "board",
-        escaped_name_body ? escaped_name_body : "Board",
-        (lang == LANG_EN ? "background:rgba(255,255,255,0.2);" : ""),
-        (lang == LANG_ZH_CN ? "background:rgba(255,255,255,0.2);" : ""),
-        escaped_desc ? escaped_desc : "No description",
-        i18n_get(lang, "back_to_boards"),
-        i18n_get(lang, "threads"));
-    
-    free(escaped_name_title);
-    free(escaped_name_h1);
-    free(escaped_name_body);
-    free(escaped_desc);
+    render_buf_t html;
+    render_buf_init(&html, 32768);
+    int rc = tmpl_board_head(&html, &page);
     
     sqlite3_stmt *stmt = db_prepare(
         "SELECT t.id, t.subject, COUNT(p.id) as post_count "
         "FROM threads t LEFT JOIN posts p ON t.id = p.thread_id "
         "WHERE t.board_id = ? "
         "GROUP BY t.id "
-        "ORDER BY t.created_at DESC"
+        "ORDER BY t.created_at DESC, t.id DESC"
     );
     
     if (stmt) {
-        sqlite3_bind_int64(stmt, 1, board_id);
+        sqlite3_bind_int64(stmt, 1, board->id);
         
-        while (db_step(stmt) == SQLITE_ROW) {
-            int64_t thread_id = sqlite3_column_int64(stmt, 0);
-            const char *subject = (const char *)sqlite3_column_text(stmt, 1);
-            int post_count = sqlite3_column_int(stmt, 2);
-            
-            char *escaped_subject = render_escape_html(subject ? subject : "No Subject");
-            
-            len += snprintf(html + len, 32768 - len,
-                "<li class=\"thread-item\">\n"
-                "<a href=\"/thread?id=%lld\" class=\"thread-link\">%s</a>\n"
-                "<span class=\"thread-meta\">💬 %d posts</span>\n"
-                "</li>\n",
-                (long long)thread_id,
-                escaped_subject ? escaped_subject : "No Subject",
-                post_count);
-            
-            free(escaped_subject);
+        while (rc == 0 && db_step(stmt) == SQLITE_ROW) {
+            thread_summary_t summary = {
+                .id = sqlite3_column_int64(stmt, 0),
+                .subject = (const char *)sqlite3_column_text(stmt, 1),
+                .post_count = sqlite3_column_int64(stmt, 2),
+            };
+            rc = tmpl_board_thread(&html, &summary);
         }
         db_finalize(stmt);
     }
     
-    len += snprintf(html + len, 65536 - len,
-        "</ul>\n"
-        "<div class=\"card\" style=\"margin-top:24px;\">\n"
-        "<h2>✏️ %s</h2>\n"
-        "<form method=\"POST\" action=\"/thread\">\n"
-        "<input type=\"hidden\" name=\"board_id\" value=\"%lld\">\n"
-        "<div class=\"form-group\">\n"
-        "<label>%s</label>\n"
-        "<input type=\"text\" name=\"subject\" required>\n"
-        "</div>\n"
-        "<div class=\"form-group\">\n"
-        "<label>%s</label>\n"
-        "<input type=\"text\" name=\"author\" placeholder=\"%s\">\n"
-        "</div>\n"
-        "<div class=\"form-group\">\n"
-        "<label>%s</label>\n"
-        "<textarea name=\"content\" required></textarea>\n"
-        "</div>\n"
-        "<div style=\"margin-bottom:16px;\">\n"
-        "<button type=\"button\" class=\"kaomoji-btn\" onclick=\"openKaomoji()\">😊 %s</button>\n"
-        "</div>\n"
-        "<button type=\"submit\" class=\"btn\">%s</button>\n"
-        "</form>\n"
-        "</div>\n"
-        "<div id=\"kaomoji-modal\" class=\"kaomoji-modal\">\n"
-        "<div class=\"kaomoji-popup\">\n"
-        "<div class=\"kaomoji-header\">\n"
-        "<span class=\"kaomoji-title\">😊 %s</span>\n"
-        "<button class=\"kaomoji-close\" onclick=\"closeKaomoji()\">×</button>\n"
-        "</div>\n"
-        "<div class=\"kaomoji-tabs\">\n",
-        i18n_get(lang, "create_new_thread"),
-        (long long)board_id,
-        i18n_get(lang, "subject"),
-        i18n_get(lang, "name"),
-        i18n_get(lang, "anonymous"),
-        i18n_get(lang, "content"),
-        i18n_get(lang, "kaomoji"),
-        i18n_get(lang, "create_thread"),
-        i18n_get(lang, "kaomoji"));
-    
-    const kaomoji_category_t *categories = kaomoji_get_categories();
-    int categories_count = kaomoji_get_categories_count();
-    
-    for (int i = 0; i < categories_count && len < 65536 - 1024; i++) {
-        char *escaped_title = render_escape_html(categories[i].title);
-        len += snprintf(html + len, 65536 - len,
-            "<button class=\"kaomoji-tab%s\" onclick=\"switchTab(%d)\">%s</button>\n",
-            (i == 0 ? " active" : ""),
-            i,
-            escaped_title ? escaped_title : categories[i].title);
-        free(escaped_title);
-    }
-    
-    len += snprintf(html + len, 65536 - len, "</div>\n<div class=\"kaomoji-content\">\n");
-    
-    for (int i = 0; i < categories_count && len < 65536 - 1024; i++) {
-        len += snprintf(html + len, 65536 - len,
-            "<div class=\"kaomoji-category%s\">\n"
-            "<div class=\"kaomoji-items\">\n",
-            (i == 0 ? " active" : ""));
+    if (rc == 0) {
+        rc = tmpl_board_tail(&html, &page);
+    }
+    
+    http_response_t *response;
+    if (rc == 0) {
+        response = http_response_create(200, "text/html", html.data, html.len);
+    } else {
+        const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
+        response = http_response_create(500, "text/html", err, strlen(err));
+    }
+    render_buf_free(&html);
+    return response;
+}
+
+http_response_t *board_view_handler(http_request_t *req) {
+    int64_t board_id = 1;
+    if (req->query_string) {
+        sscanf(req->query_string, "id=%lld", (long long *)&board_id);
+    }
+    
+    return render_board(req, board_get_by_id(board_id));
+}
+
+/* GET /b/{name}/ - the same page addressed by board name. */
+http_response_t *board_path_handler(http_request_t *req) {
+    const char *name_start = req->path + strlen("/b/");
+    const char *name_end = strchr(name_start, '/');
+    size_t name_len = name_end ? (size_t)(name_end - name_start) : strlen(name_start);
+    
+    char encoded[256];
+    char name[256];
+    const board_t *board = NULL;
+    if (name_len > 0 && name_len < sizeof(encoded) && (!name_end || name_end[1] == '\0')) {
+        memcpy(encoded, name_start, name_len);
+        encoded[name_len] = '\0';
+        url_decode(name, encoded, sizeof(name));
+        board = board_get_by_name(name);
+    }
+    
+    return render_board(req, board);
+}
+
+/* Bytes of rendered posts collected before they are sent as one chunk. */
+#define THREAD_STREAM_CHUNK 16384
+
+typedef struct {
+    thread_t *thread;
+    language_t lang;
+} thread_stream_t;
+
+/* Selected after a post's own columns by the queries that render posts;
+ * NULL when the post has no attachment. */
+#define POST_ATTACHMENT_COLUMNS "a.hash, a.filename, a.size, a.width, a.height"
+#define POST_ATTACHMENT_JOIN "LEFT JOIN attachments a ON a.post_id = p.id "
+
+/* Fills the attachment fields of post from the columns starting at col.
+ * url receives the file's address and must outlive the view. */
+static void post_view_set_attachment(post_view_t *post, sqlite3_stmt *stmt, int col,
+                                     char *url, size_t url_size) {
+    const char *hash = (const char *)sqlite3_column_text(stmt, col);
+    if (!hash) {
+        return;
+    }
+    post->attachment_name = (const char *)sqlite3_column_text(stmt, col + 1);
+    upload_url(hash, post->attachment_name, url, url_size);
+    post->attachment_url = url;
+    post->attachment_kb = (sqlite3_column_int64(stmt, col + 2) + 1023) / 1024;
+    post->attachment_width = sqlite3_column_int(stmt, col + 3);
+    post->attachment_height = sqlite3_column_int(stmt, col + 4);
+}
+
+static void thread_stream_free(void *ctx) {
+    thread_stream_t *stream = ctx;
+    thread_free(stream->thread);
+    free(stream);
+}
+
+static int flush_chunk(http_writer_t *writer, render_buf_t *html) {
+    int rc = http_writer_write(writer, html->data, html->len);
+    render_buf_reset(html);
+    return rc;
+}
+
+/* Sends the head as soon as it is rendered so the browser can fetch styles
+ * while posts are still being read, then streams posts in chunks. */
+static int thread_stream(http_writer_t *writer, void *ctx) {
+    thread_stream_t *stream = ctx;
+    thread_t *thread = stream->thread;
+    language_t lang = stream->lang;
+    
+    thread_page_t page = {
+        .lang = lang,
+        .lang_en = lang == LANG_EN,
+        .lang_zh_cn = lang == LANG_ZH_CN,
+        .id = thread->id,
+        .board_id = thread->board_id,
+        .subject = thread->subject,
+        .author = thread->author,
+        .content_html = thread->content_html,
+        .kaomoji_picker_html = kaomoji_picker.data ? kaomoji_picker.data : "",
+    };
+    
+    render_buf_t html;
+    render_buf_init(&html, THREAD_STREAM_CHUNK + 4096);
+    int rc = tmpl_thread_head(&html, &page);
+    if (rc == 0) {
+        rc = flush_chunk(writer, &html);
+    }
+    
+    /* Each chunk is read in its own pass that resumes after the last post
+     * rendered. The query is reset before the chunk is sent, so a client
+     * that stops reading holds no read snapshot open. */
+    sqlite3_stmt *stmt = rc == 0 ? db_prepare(
+        "SELECT p.id, p.author, COALESCE(p.content_html, " DB_ESCAPE_HTML_SQL("p.content") "), "
+        "p.created_at, p.reply_to, rp.id, rp.author, "
+        "COALESCE(rp.content_html, " DB_ESCAPE_HTML_SQL("rp.content") "), "
+        POST_ATTACHMENT_COLUMNS " "
+        "FROM posts p "
+        "LEFT JOIN posts rp ON p.reply_to = rp.id "
+        POST_ATTACHMENT_JOIN
+        "WHERE p.thread_id = ? AND (p.created_at, p.id) > (?, ?) "
+        "ORDER BY p.created_at ASC, p.id ASC"
+    ) : NULL;
+    
+    int64_t last_created = INT64_MIN;
+    int64_t last_id = 0;
+    int more = stmt != NULL;
+    while (rc == 0 && more) {
+        sqlite3_bind_int64(stmt, 1, thread->id);
+        sqlite3_bind_int64(stmt, 2, last_created);
+        sqlite3_bind_int64(stmt, 3, last_id);
         
-        for (int j = 0; j < categories[i].count && len < 65536 - 512; j++) {
-            char *escaped_js = render_escape_js(categories[i].items[j]);
-            char *escaped_html = render_escape_html(categories[i].items[j]);
-            len += snprintf(html + len, 65536 - len,
-                "<span class=\"kaomoji-item\" onclick=\"insertKaomoji('%s')\">%s</span>\n",
-                escaped_js ? escaped_js : categories[i].items[j],
-                escaped_html ? escaped_html : categories[i].items[j]);
-            free(escaped_js);
-            free(escaped_html);
+        more = 0;
+        while (rc == 0 && db_step(stmt) == SQLITE_ROW) {
+            int64_t post_id = sqlite3_column_int64(stmt, 0);
+            int64_t reply_to = sqlite3_column_int64(stmt, 4);
+            
+            /* Cached fragments are copied straight into the chunk; a fragment
+             * larger than the spare room is rendered again instead. */
+            if (render_buf_reserve(&html, 4096) != 0) {
+                rc = -1;
+                break;
+            }
+            int cached = fragment_cache_get(post_id, lang, html.data + html.len,
+                                            html.cap - html.len + 1);
+            if (cached >= 0) {
+                html.len += (size_t)cached;
+            } else {
+                post_view_t post = {
+                    .lang = lang,
+                    .id = post_id,
+                    .author = (const char *)sqlite3_column_text(stmt, 1),
+                    .content_html = (const char *)sqlite3_column_text(stmt, 2),
+                    .quoted_id = reply_to > 0 ? sqlite3_column_int64(stmt, 5) : 0,
+                    .quoted_author = (const char *)sqlite3_column_text(stmt, 6),
+                    .quoted_content_html = (const char *)sqlite3_column_text(stmt, 7),
+                };
+                char url[128];
+                post_view_set_attachment(&post, stmt, 8, url, sizeof(url));
+                size_t start = html.len;
+                rc = tmpl_thread_post(&html, &post);
+                if (rc == 0) {
+                    fragment_cache_put(post_id, post.quoted_id, lang,
+                                       html.data + start, html.len - start);
+                }
+            }
+            
+            last_created = sqlite3_column_int64(stmt, 3);
+            last_id = post_id;
+            if (rc == 0 && html.len >= THREAD_STREAM_CHUNK) {
+                more = 1;
+                break;
+            }
         }
+        sqlite3_reset(stmt);
         
-        len += snprintf(html + len, 65536 - len,
-            "</div>\n"
-            "</div>\n");
+        if (rc == 0 && more) {
+            rc = flush_chunk(writer, &html);
+        }
     }
+    db_finalize(stmt);
     
-    len += snprintf(html + len, 65536 - len,
-        "</div>\n"
-        "</div>\n"
-        "</div>\n"
-        "</div>\n"
-        "</body>\n"
-        "</html>");
+    if (rc == 0) {
+        rc = tmpl_thread_tail(&html, &page);
+    }
+    if (rc == 0) {
+        rc = flush_chunk(writer, &html);
+    }
     
-    board_free(board);
-    http_response_t *response = http_response_create(200, "text/html", html, len);
-    free(html);
-    return response;
+    render_buf_free(&html);
+    return rc;
 }
 
 http_response_t *thread_view_handler(http_request_t *req) {
@@ -678,7 +516,13 @@ http_response_t *thread_view_handler(http_request_t *req) {
         sscanf(req->query_string, "id=%lld", (long long *)&thread_id);
     }
     
-    thread_t *thread = thread_get_by_id(thread_id);
+    thread_t *thread = NULL;
+    if (id_filter_may_exist(ID_FILTER_THREADS, thread_id)) {
+        thread = thread_get_by_id(thread_id);
+        if (!thread) {
+            id_filter_record_miss(ID_FILTER_THREADS, thread_id);
+        }
+    }
     if (!thread) {
         char error_html[512];
         snprintf(error_html, sizeof(error_html),
@@ -688,446 +532,401 @@ http_response_t *thread_view_handler(http_request_t *req) {
         return http_response_create(404, "text/html", error_html, strlen(error_html));
     }
     
-    char *html = malloc(65536);
-    if (!html) {
+    thread_stream_t *stream = malloc(sizeof(thread_stream_t));
+    if (!stream) {
         thread_free(thread);
         const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
         return http_response_create(500, "text/html", err, strlen(err));
     }
+    stream->thread = thread;
+    stream->lang = lang;
     
-    char *escaped_subject_title = render_escape_html(thread->subject ? thread->subject : "Thread");
-    char *escaped_subject_h1 = render_escape_html(thread->subject ? thread->subject : "Thread");
-    char *escaped_author = render_escape_html(thread->author ? thread->author : "Anonymous");
-    char *escaped_content = render_escape_html(thread->content ? thread->content : "No content");
+    return http_response_create_stream(200, "text/html", thread_stream, stream,
+                                       thread_stream_free);
+}
+
+typedef struct {
+    int64_t thread_id;
+    language_t lang;
+} thread_events_t;
+
+static void thread_events_attach(int client_fd, void *ctx) {
+    thread_events_t *events = ctx;
+    live_subscribe(client_fd, events->thread_id, events->lang);
+}
+
+/* GET /thread/{id}/events - new posts as Server-Sent Events. */
+static http_response_t *thread_events_handler(http_request_t *req, int64_t thread_id) {
+    language_t lang = i18n_get_language(req);
     
-    int len = snprintf(html, 65536,
-        "<!DOCTYPE html>\n"
-        "<html>\n"
-        "<head>\n"
-        "<meta charset=\"UTF-8\">\n"
-        "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
-        "<title>%s</title>\n"
-        "<style>\n"
-        ":root {\n"
-        "  --primary: #1976d2; --primary-dark: #1565c0; --primary-light: #42a5f5;\n"
-        "  --accent: #ff4081; --success: #4caf50; --text-primary: rgba(0,0,0,0.87);\n"
-        "  --text-secondary: rgba(0,0,0,0.54); --divider: rgba(0,0,0,0.12);\n"
-        "  --background: #fafafa; --surface: #ffffff; --error: #f44336;\n"
-        "}\n"
-        "* { box-sizing: border-box; margin: 0; padding: 0; }\n"
-        "body { font-family: 'Roboto', 'Segoe UI', Arial, sans-serif, 'Microsoft YaHei', 'SimHei'; background: var(--background);\n"
-        "  color: var(--text-primary); line-height: 1.6; padding: 16px; }\n"
-        ".container { max-width: 1200px; margin: 0 auto; }\n"
-        ".card { background: var(--surface); border-radius: 4px; box-shadow: 0 2px 4px rgba(0,0,0,0.1);\n"
-        "  padding: 16px; margin-bottom: 16px; transition: box-shadow 0.3s; }\n"
-        ".card:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); }\n"
-        ".header-card { background: linear-gradient(135deg, var(--primary) 0%%, var(--primary-dark) 100%%);\n"
-        "  color: white; padding: 24px; margin-bottom: 24px; }\n"
-        ".header-card h1 { color: white; font-size: 2rem; font-weight: 500; margin-bottom: 8px; }\n"
-        "@media (max-width: 768px) { .header-card h1 { font-size: 1.5rem; } }\n"
-        ".nav-link { color: rgba(255,255,255,0.9); text-decoration: none; margin-right: 16px;\n"
-        "  display: inline-block; margin-top: 12px; font-size: 0.875rem; transition: color 0.2s; }\n"
-        ".nav-link:hover { color: white; text-decoration: underline; }\n"
-        "h2 { font-size: 1.5rem; font-weight: 500; margin-bottom: 16px; color: var(--text-primary); }\n"
-        ".op-post { background: linear-gradient(to right, #e3f2fd 0%%, var(--surface) 100%%);\n"
-        "  border-left: 4px solid var(--primary); padding: 20px; margin-bottom: 24px;\n"
-        "  border-radius: 4px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }\n"
-        ".op-post .author { font-weight: 600; color: var(--primary); font-size: 1.125rem; }\n"
-        ".op-post .content { margin-top: 12px; white-space: pre-wrap; word-wrap: break-word; }\n"
-        ".post { background: var(--surface); border-radius: 4px; padding: 16px; margin-bottom: 12px;\n"
-        "  box-shadow: 0 1px 3px rgba(0,0,0,0.1); transition: all 0.2s; position: relative; }\n"
-        ".post:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); }\n"
-        ".post-header { display: flex; justify-content: space-between; align-items: center;\n"
-        "  margin-bottom: 12px; flex-wrap: wrap; gap: 8px; }\n"
-        ".post-info { display: flex; align-items: center; gap: 12px; flex: 1; }\n"
-        ".post-author { font-weight: 500; color: var(--text-primary); }\n"
-        ".post-id { color: var(--text-secondary); font-size: 0.875rem; }\n"
-        ".reply-btn { background: var(--success); color: white; border: none; padding: 6px 16px;\n"
-        "  cursor: pointer; border-radius: 4px; font-size: 0.875rem; font-weight: 500;\n"
-        "  transition: all 0.2s; box-shadow: 0 1px 3px rgba(0,0,0,0.2); }\n"
-        ".reply-btn:hover { background: #45a049; box-shadow: 0 2px 4px rgba(0,0,0,0.3); }\n"
-        "@media (max-width: 768px) { .reply-btn { width: 100%%; margin-top: 8px; } }\n"
-        ".quote-ref { color: var(--primary); cursor: pointer; text-decoration: none;\n"
-        "  font-weight: 500; transition: color 0.2s; }\n"
-        ".quote-ref:hover { color: var(--primary-dark); text-decoration: underline; }\n"
-        ".quoted-post { display: none; background: #f5f5f5; border-left: 3px solid var(--primary);\n"
-        "  padding: 12px; margin: 12px 0; font-size: 0.9em; border-radius: 2px; }\n"
-        ".quoted-post.expanded { display: block; }\n"
-        ".post-content { white-space: pre-wrap; word-wrap: break-word; line-height: 1.6; }\n"
-        ".btn { background: var(--primary); color: white; border: none; padding: 10px 24px;\n"
-        "  border-radius: 4px; font-size: 0.875rem; font-weight: 500; text-transform: uppercase;\n"
-        "  cursor: pointer; box-shadow: 0 2px 4px rgba(0,0,0,0.2); transition: all 0.2s; min-height: 48px; }\n"
-        ".btn:hover { background: var(--primary-dark); box-shadow: 0 4px 8px rgba(0,0,0,0.3); }\n"
-        ".btn:active { box-shadow: 0 1px 2px rgba(0,0,0,0.2); }\n"
-        "@media (max-width: 768px) { .btn { width: 100%%; } }\n"
-        "input[type=\"text\"], textarea { width: 100%%; padding: 12px 16px; margin: 8px 0;\n"
-        "  border: 1px solid var(--divider); border-radius: 4px; font-size: 1rem; font-family: inherit;\n"
-        "  background: var(--surface); transition: border-color 0.2s; }\n"
-        "input:focus, textarea:focus { outline: none; border-color: var(--primary);\n"
-        "  box-shadow: 0 0 0 2px rgba(25,118,210,0.1); }\n"
-        "textarea { min-height: 120px; resize: vertical; }\n"
-        "label { display: block; margin-bottom: 4px; font-weight: 500; color: var(--text-primary); }\n"
-        ".form-group { margin-bottom: 16px; }\n"
-        ".kaomoji-btn { background: var(--accent); color: white; border: none; padding: 8px 16px;\n"
-        "  cursor: pointer; border-radius: 4px; font-weight: 500; transition: background 0.2s;\n"
-        "  font-size: 0.875rem; box-shadow: 0 2px 4px rgba(0,0,0,0.2); }\n"
-        ".kaomoji-btn:hover { background: #e91e63; box-shadow: 0 3px 6px rgba(0,0,0,0.3); }\n"
-        ".kaomoji-modal { display: none; position: fixed; z-index: 1000; left: 0; top: 0;\n"
-        "  width: 100%%; height: 100%%; background: rgba(0,0,0,0.5); align-items: center;\n"
-        "  justify-content: center; }\n"
-        ".kaomoji-modal.show { display: flex; }\n"
-        ".kaomoji-popup { background: var(--surface); border-radius: 8px; box-shadow: 0 4px 20px rgba(0,0,0,0.3);\n"
-        "  max-width: 600px; width: 90%%; max-height: 70vh; display: flex; flex-direction: column;\n"
-        "  position: relative; }\n"
-        ".kaomoji-header { display: flex; justify-content: space-between; align-items: center;\n"
-        "  padding: 16px 20px; border-bottom: 1px solid var(--divider); }\n"
-        ".kaomoji-title { font-size: 1.125rem; font-weight: 500; color: var(--text-primary); }\n"
-        ".kaomoji-close { background: none; border: none; font-size: 1.5rem; color: var(--text-secondary);\n"
-        "  cursor: pointer; padding: 0; width: 32px; height: 32px; border-radius: 50%%;\n"
-        "  transition: all 0.2s; line-height: 1; }\n"
-        ".kaomoji-close:hover { background: rgba(0,0,0,0.05); color: var(--text-primary); }\n"
-        ".kaomoji-tabs { display: flex; overflow-x: auto; border-bottom: 1px solid var(--divider);\n"
-        "  background: #f5f5f5; }\n"
-        ".kaomoji-tab { background: none; border: none; padding: 12px 20px; cursor: pointer;\n"
-        "  font-size: 0.875rem; font-weight: 500; color: var(--text-secondary);\n"
-        "  transition: all 0.2s; white-space: nowrap; border-bottom: 2px solid transparent; }\n"
-        ".kaomoji-tab:hover { background: rgba(25,118,210,0.05); color: var(--primary); }\n"
-        ".kaomoji-tab.active { color: var(--primary); border-bottom-color: var(--primary); background: white; }\n"
-        ".kaomoji-content { flex: 1; overflow-y: auto; padding: 16px 20px; }\n"
-        ".kaomoji-category { display: none; }\n"
-        ".kaomoji-category.active { display: block; }\n"
-        ".kaomoji-items { display: flex; flex-wrap: wrap; gap: 8px; }\n"
-        ".kaomoji-item { padding: 8px 16px; border: 1px solid var(--divider); background: white;\n"
-        "  cursor: pointer; border-radius: 4px; font-size: 1rem; transition: all 0.2s;\n"
-        "  box-shadow: 0 1px 2px rgba(0,0,0,0.05); }\n"
-        ".kaomoji-item:hover { background: #e3f2fd; border-color: var(--primary);\n"
-        "  box-shadow: 0 2px 4px rgba(0,0,0,0.15); transform: translateY(-1px); }\n"
-        ".kaomoji-item:active { transform: translateY(0); box-shadow: 0 1px 2px rgba(0,0,0,0.1); }\n"
-        "@media (max-width: 768px) {\n"
-        "  .kaomoji-popup { width: 95%%; max-height: 80vh; }\n"
-        "  .kaomoji-tab { padding: 10px 12px; font-size: 0.8rem; }\n"
-        "  .kaomoji-item { padding: 6px 12px; font-size: 0.9rem; }\n"
-        "}\n"
-        "</style>\n"
-        "<script>\n"
-        "var currentTab = 0;\n"
-        "function replyToPost(postId) {\n"
-        "  document.getElementById('reply_to').value = postId;\n"
-        "  document.getElementById('reply-form').scrollIntoView({behavior:'smooth'});\n"
-        "  document.getElementById('content').focus();\n"
-        "}\n"
-        "function toggleQuote(postId) {\n"
-        "  var quote = document.getElementById('quote-' + postId);\n"
-        "  if (quote) {\n"
-        "    quote.classList.toggle('expanded');\n"
-        "  }\n"
-        "}\n"
-        "function openKaomoji() {\n"
-        "  document.getElementById('kaomoji-modal').classList.add('show');\n"
-        "}\n"
-        "function closeKaomoji() {\n"
-        "  document.getElementById('kaomoji-modal').classList.remove('show');\n"
-        "}\n"
-        "function switchTab(index) {\n"
-        "  currentTab = index;\n"
-        "  var tabs = document.querySelectorAll('.kaomoji-tab');\n"
-        "  var categories = document.querySelectorAll('.kaomoji-category');\n"
-        "  tabs.forEach(function(tab, i) {\n"
-        "    if (i === index) { tab.classList.add('active'); } else { tab.classList.remove('active'); }\n"
-        "  });\n"
-        "  categories.forEach(function(cat, i) {\n"
-        "    if (i === index) { cat.classList.add('active'); } else { cat.classList.remove('active'); }\n"
-        "  });\n"
-        "}\n"
-        "function insertKaomoji(kaomoji) {\n"
-        "  var textarea = document.getElementById('content');\n"
-        "  var start = textarea.selectionStart;\n"
-        "  var end = textarea.selectionEnd;\n"
-        "  var text = textarea.value;\n"
-        "  textarea.value = text.substring(0, start) + kaomoji + text.substring(end);\n"
-        "  textarea.selectionStart = textarea.selectionEnd = start + kaomoji.length;\n"
-        "  textarea.focus();\n"
-        "  closeKaomoji();\n"
-        "}\n"
-        "window.onclick = function(event) {\n"
-        "  var modal = document.getElementById('kaomoji-modal');\n"
-        "  if (event.target === modal) { closeKaomoji(); }\n"
-        "}\n"
-        "function setLanguage(lang) {\n"
-        "  document.cookie = 'lang=' + lang + '; path=/; max-age=31536000';\n"
-        "  window.location.href = window.location.pathname + '?id=%lld&lang=' + lang;\n"
-        "}\n"
-        "</script>\n"
-        "</head>\n"
-        "<body>\n"
-        "<div class=\"container\">\n"
-        "<div class=\"header-card card\">\n"
-        "<h1 style=\"display:flex;justify-content:space-between;align-items:center;flex-wrap:wrap;\">\n"
-        "  <span>%s</span>\n"
-        "  <span style=\"font-size:0.875rem;font-weight:normal;\">\n"
-        "    <a href=\"#\" onclick=\"setLanguage('en'); return false;\" style=\"color:rgba(255,255,255,0.9);text-decoration:none;padding:6px 12px;border:1px solid rgba(255,255,255,0.5);border-radius:4px;margin-left:8px;%s\">English</a>\n"
-        "    <a href=\"#\" onclick=\"setLanguage('zh-cn'); return false;\" style=\"color:rgba(255,255,255,0.9);text-decoration:none;padding:6px 12px;border:1px solid rgba(255,255,255,0.5);border-radius:4px;margin-left:8px;%s\">中文</a>\n"
-        "  </span>\n"
-        "</h1>\n"
-        "<a href=\"/board?id=%lld\" class=\"nav-link\">← %s</a>\n"
-        "<a href=\"/\" class=\"nav-link\">🏠 %s</a>\n"
-        "</div>\n"
-        "<div class=\"op-post\">\n"
-        "<div class=\"author\">👤 %s</div>\n"
-        "<div class=\"content\">%s</div>\n"
-        "</div>\n"
-        "<h2>💬 %s</h2>\n",
-        escaped_subject_title ? escaped_subject_title : "Thread",
-        (long long)thread_id,
-        escaped_subject_h1 ? escaped_subject_h1 : "Thread",
-        (lang == LANG_EN ? "background:rgba(255,255,255,0.2);" : ""),
-        (lang == LANG_ZH_CN ? "background:rgba(255,255,255,0.2);" : ""),
-        (long long)thread->board_id,
-        i18n_get(lang, "back_to_board"),
-        i18n_get(lang, "all_boards"),
-        escaped_author ? escaped_author : i18n_get(lang, "anonymous"),
-        escaped_content ? escaped_content : "No content",
-        i18n_get(lang, "posts"));
-    
-    free(escaped_subject_title);
-    free(escaped_subject_h1);
-    free(escaped_author);
-    free(escaped_content);
+    if (!id_filter_may_exist(ID_FILTER_THREADS, thread_id)) {
+        const char *not_found = "Thread not found";
+        return http_response_create(404, "text/plain", not_found, strlen(not_found));
+    }
+    
+    thread_events_t *events = malloc(sizeof(thread_events_t));
+    if (!events) {
+        const char *err = "Out of memory";
+        return http_response_create(500, "text/plain", err, strlen(err));
+    }
+    events->thread_id = thread_id;
+    events->lang = lang;
+    
+    http_response_t *response = http_response_create_detached(200, "text/event-stream",
+                                                              thread_events_attach, events, free);
+    if (response && http_response_add_header(response, "Cache-Control", "no-cache") != 0) {
+        http_response_free(response);
+        return NULL;
+    }
+    return response;
+}
+
+/* GET /thread/{id}/since/{post_id} - posts newer than post_id, as the HTML
+ * fragments of the thread page or, with format=json, as JSON. Answers 304
+ * when nothing is new. */
+static http_response_t *thread_since_handler(http_request_t *req, int64_t thread_id,
+                                             int64_t since_id) {
+    language_t lang = i18n_get_language(req);
+    
+    if (!id_filter_may_exist(ID_FILTER_THREADS, thread_id)) {
+        const char *not_found = "Thread not found";
+        return http_response_create(404, "text/plain", not_found, strlen(not_found));
+    }
+    
+    char format[8] = "";
+    get_query_param(req->query_string, "format", format, sizeof(format));
+    int json = strcmp(format, "json") == 0;
     
     sqlite3_stmt *stmt = db_prepare(
-        "SELECT p.id, p.author, p.content, p.created_at, p.reply_to, "
-        "rp.id, rp.author, rp.content "
+        "SELECT p.id, p.author, COALESCE(p.content_html, " DB_ESCAPE_HTML_SQL("p.content") "), "
+        "p.created_at, p.reply_to, rp.id, rp.author, "
+        "COALESCE(rp.content_html, " DB_ESCAPE_HTML_SQL("rp.content") "), "
+        POST_ATTACHMENT_COLUMNS " "
         "FROM posts p "
         "LEFT JOIN posts rp ON p.reply_to = rp.id "
-        "WHERE p.thread_id = ? ORDER BY p.created_at ASC"
+        POST_ATTACHMENT_JOIN
+        "WHERE p.thread_id = ? AND p.id > ? ORDER BY p.id LIMIT ?"
     );
-    
-    if (stmt) {
-        sqlite3_bind_int64(stmt, 1, thread_id);
+    if (!stmt) {
+        const char *err = "Database error";
+        return http_response_create(500, "text/plain", err, strlen(err));
+    }
+    sqlite3_bind_int64(stmt, 1, thread_id);
+    sqlite3_bind_int64(stmt, 2, since_id);
+    sqlite3_bind_int(stmt, 3, THREAD_SINCE_LIMIT);
+    
+    render_buf_t out;
+    render_buf_init(&out, 4096);
+    int rc = json ? render_buf_append_str(&out, "{\"posts\":[") : 0;
+    int count = 0;
+    int64_t last_id = since_id;
+    
+    while (rc == 0 && db_step(stmt) == SQLITE_ROW) {
+        int64_t post_id = sqlite3_column_int64(stmt, 0);
+        int64_t reply_to = sqlite3_column_int64(stmt, 4);
+        post_view_t post = {
+            .lang = lang,
+            .id = post_id,
+            .author = (const char *)sqlite3_column_text(stmt, 1),
+            .content_html = (const char *)sqlite3_column_text(stmt, 2),
+            .quoted_id = reply_to > 0 ? sqlite3_column_int64(stmt, 5) : 0,
+            .quoted_author = (const char *)sqlite3_column_text(stmt, 6),
+            .quoted_content_html = (const char *)sqlite3_column_text(stmt, 7),
+        };
+        char url[128];
+        post_view_set_attachment(&post, stmt, 8, url, sizeof(url));
         
-        while (db_step(stmt) == SQLITE_ROW) {
-            int64_t post_id = sqlite3_column_int64(stmt, 0);
-            const char *author = (const char *)sqlite3_column_text(stmt, 1);
-            const char *content = (const char *)sqlite3_column_text(stmt, 2);
-            int64_t reply_to = sqlite3_column_int64(stmt, 4);
-            int64_t reply_to_id = sqlite3_column_int64(stmt, 5);
-            const char *reply_to_author = (const char *)sqlite3_column_text(stmt, 6);
-            const char *reply_to_content = (const char *)sqlite3_column_text(stmt, 7);
-            
-            char *escaped_author = render_escape_html(author ? author : "Anonymous");
-            char *escaped_content = render_escape_html(content ? content : "");
-            
-            len += snprintf(html + len, 32768 - len,
-                "<div class=\"post\" id=\"post-%lld\">\n"
-                "<div class=\"post-header\">\n"
-                "<div class=\"post-info\">\n"
-                "<span class=\"post-author\">%s</span>\n"
-                "<span class=\"post-id\">#%lld</span>",
-                (long long)post_id,
-                escaped_author ? escaped_author : "Anonymous",
-                (long long)post_id);
-            
-            if (reply_to > 0 && reply_to_id > 0) {
-                len += snprintf(html + len, 32768 - len,
-                    "<span class=\"quote-ref\" onclick=\"toggleQuote(%lld)\">&gt;&gt;%lld</span>",
-                    (long long)reply_to_id,
-                    (long long)reply_to_id);
+        if (json) {
+            rc |= render_buf_appendf(&out, "%s{\"id\":%lld,\"author\":", count > 0 ? "," : "",
+                                     (long long)post_id);
+            rc |= render_buf_append_json(&out, post.author);
+            rc |= render_buf_append_str(&out, ",\"content_html\":");
+            rc |= render_buf_append_json(&out, post.content_html);
+            rc |= render_buf_appendf(&out, ",\"reply_to\":%lld,\"created_at\":%lld,\"attachment\":",
+                                     (long long)post.quoted_id,
+                                     (long long)sqlite3_column_int64(stmt, 3));
+            if (post.attachment_url) {
+                rc |= render_buf_appendf(&out, "{\"url\":\"%s\",\"name\":", post.attachment_url);
+                rc |= render_buf_append_json(&out, post.attachment_name);
+                rc |= render_buf_appendf(&out, ",\"size\":%lld,\"width\":%d,\"height\":%d}}",
+                                         (long long)sqlite3_column_int64(stmt, 10),
+                                         post.attachment_width, post.attachment_height);
+            } else {
+                rc |= render_buf_append_str(&out, "null}");
             }
-            
-            len += snprintf(html + len, 65536 - len,
-                "</div>\n"
-                "<button class=\"reply-btn\" onclick=\"replyToPost(%lld)\">↩ %s</button>\n"
-                "</div>\n",
-                (long long)post_id,
-                i18n_get(lang, "reply"));
-            
-            if (reply_to > 0 && reply_to_id > 0 && reply_to_content) {
-                char *escaped_reply_author = render_escape_html(reply_to_author ? reply_to_author : "Anonymous");
-                char *escaped_reply_content = render_escape_html(reply_to_content);
-                
-                len += snprintf(html + len, 32768 - len,
-                    "<div class=\"quoted-post\" id=\"quote-%lld\">\n"
-                    "<strong>%s</strong> (#%lld): %s\n"
-                    "</div>\n",
-                    (long long)reply_to_id,
-                    escaped_reply_author ? escaped_reply_author : "Anonymous",
-                    (long long)reply_to_id,
-                    escaped_reply_content ? escaped_reply_content : "");
-                
-                free(escaped_reply_author);
-                free(escaped_reply_content);
+        } else if (render_buf_reserve(&out, 4096) != 0) {
+            rc = -1;
+        } else {
+            int cached = fragment_cache_get(post_id, lang, out.data + out.len,
+                                            out.cap - out.len + 1);
+            if (cached >= 0) {
+                out.len += (size_t)cached;
+            } else {
+                size_t start = out.len;
+                rc = tmpl_thread_post(&out, &post);
+                if (rc == 0) {
+                    fragment_cache_put(post_id, post.quoted_id, lang,
+                                       out.data + start, out.len - start);
+                }
             }
-            
-            len += snprintf(html + len, 32768 - len,
-                "<div class=\"post-content\">%s</div>\n"
-                "</div>\n",
-                escaped_content ? escaped_content : "");
-            
-            free(escaped_author);
-            free(escaped_content);
         }
-        db_finalize(stmt);
+        last_id = post_id;
+        count++;
     }
+    db_finalize(stmt);
     
-    len += snprintf(html + len, 65536 - len,
-        "<div class=\"card\" style=\"margin-top:24px;\">\n"
-        "<h2>✏️ %s</h2>\n"
-        "<form id=\"reply-form\" method=\"POST\" action=\"/post\">\n"
-        "<input type=\"hidden\" name=\"thread_id\" value=\"%lld\">\n"
-        "<input type=\"hidden\" id=\"reply_to\" name=\"reply_to\" value=\"\">\n"
-        "<div class=\"form-group\">\n"
-        "<label>%s</label>\n"
-        "<input type=\"text\" name=\"author\" placeholder=\"%s\">\n"
-        "</div>\n"
-        "<div class=\"form-group\">\n"
-        "<label>%s</label>\n"
-        "<textarea id=\"content\" name=\"content\" required></textarea>\n"
-        "</div>\n"
-        "<div style=\"margin-bottom:16px;\">\n"
-        "<button type=\"button\" class=\"kaomoji-btn\" onclick=\"openKaomoji()\">😊 %s</button>\n"
-        "</div>\n"
-        "<button type=\"submit\" class=\"btn\">%s</button>\n"
-        "</form>\n"
-        "</div>\n"
-        "<div id=\"kaomoji-modal\" class=\"kaomoji-modal\">\n"
-        "<div class=\"kaomoji-popup\">\n"
-        "<div class=\"kaomoji-header\">\n"
-        "<span class=\"kaomoji-title\">😊 %s</span>\n"
-        "<button class=\"kaomoji-close\" onclick=\"closeKaomoji()\">×</button>\n"
-        "</div>\n"
-        "<div class=\"kaomoji-tabs\">\n",
-        i18n_get(lang, "reply"),
-        (long long)thread_id,
-        i18n_get(lang, "name"),
-        i18n_get(lang, "anonymous"),
-        i18n_get(lang, "content"),
-        i18n_get(lang, "kaomoji"),
-        i18n_get(lang, "post_reply"),
-        i18n_get(lang, "kaomoji"));
-    
-    const kaomoji_category_t *categories2 = kaomoji_get_categories();
-    int categories_count2 = kaomoji_get_categories_count();
-    
-    for (int i = 0; i < categories_count2 && len < 65536 - 1024; i++) {
-        char *escaped_title = render_escape_html(categories2[i].title);
-        len += snprintf(html + len, 65536 - len,
-            "<button class=\"kaomoji-tab%s\" onclick=\"switchTab(%d)\">%s</button>\n",
-            (i == 0 ? " active" : ""),
-            i,
-            escaped_title ? escaped_title : categories2[i].title);
-        free(escaped_title);
-    }
-    
-    len += snprintf(html + len, 65536 - len, "</div>\n<div class=\"kaomoji-content\">\n");
-    
-    for (int i = 0; i < categories_count2 && len < 65536 - 1024; i++) {
-        len += snprintf(html + len, 65536 - len,
-            "<div class=\"kaomoji-category%s\">\n"
-            "<div class=\"kaomoji-items\">\n",
-            (i == 0 ? " active" : ""));
-        
-        for (int j = 0; j < categories2[i].count && len < 65536 - 512; j++) {
-            char *escaped_js = render_escape_js(categories2[i].items[j]);
-            char *escaped_html = render_escape_html(categories2[i].items[j]);
-            len += snprintf(html + len, 65536 - len,
-                "<span class=\"kaomoji-item\" onclick=\"insertKaomoji('%s')\">%s</span>\n",
-                escaped_js ? escaped_js : categories2[i].items[j],
-                escaped_html ? escaped_html : categories2[i].items[j]);
-            free(escaped_js);
-            free(escaped_html);
-        }
-        
-        len += snprintf(html + len, 65536 - len,
-            "</div>\n"
-            "</div>\n");
+    if (json && rc == 0) {
+        rc = render_buf_appendf(&out, "],\"last_id\":%lld}", (long long)last_id);
     }
     
-    len += snprintf(html + len, 65536 - len,
-        "</div>\n"
-        "</div>\n"
-        "</div>\n"
-        "</div>\n"
-        "</body>\n"
-        "</html>");
-    
-    thread_free(thread);
-    http_response_t *response = http_response_create(200, "text/html", html, len);
-    free(html);
+    http_response_t *response;
+    if (rc != 0) {
+        const char *err = "Out of memory";
+        response = http_response_create(500, "text/plain", err, strlen(err));
+    } else if (count == 0) {
+        response = http_response_create(304, json ? "application/json" : "text/html", NULL, 0);
+    } else {
+        response = http_response_create(200, json ? "application/json" : "text/html",
+                                        out.data, out.len);
+    }
+    render_buf_free(&out);
     return response;
 }
 
-http_response_t *thread_create_handler(http_request_t *req) {
-    language_t lang = i18n_get_language(req);
+/* GET /thread/{id}/... - per-thread endpoints. */
+http_response_t *thread_path_handler(http_request_t *req) {
+    long long thread_id = 0;
+    long long since_id = 0;
+    int consumed = 0;
+    if (sscanf(req->path, "/thread/%lld/%n", &thread_id, &consumed) == 1 && consumed > 0 &&
+        thread_id > 0) {
+        const char *rest = req->path + consumed;
+        if (strcmp(rest, "events") == 0) {
+            return thread_events_handler(req, thread_id);
+        }
+        int since_len = 0;
+        if (sscanf(rest, "since/%lld%n", &since_id, &since_len) == 1 &&
+            rest[since_len] == '\0' && since_id >= 0) {
+            return thread_since_handler(req, thread_id, since_id);
+        }
+    }
     
-    if (!req->body) {
-        char error_html[256];
-        snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: %s</h1></body></html>",
-            i18n_get(lang, "error"),
-            i18n_get(lang, "no_form_data"));
-        return http_response_create(400, "text/html", error_html, strlen(error_html));
+    const char *not_found = "404 Not Found";
+    return http_response_create(404, "text/plain", not_found, strlen(not_found));
+}
+
+/* Renders a freshly committed post once per language that has readers
+ * subscribed to its thread, and pushes it to them. */
+static void publish_post(int64_t thread_id, int64_t post_id) {
+    int wanted[2] = {
+        live_has_subscribers(thread_id, LANG_EN),
+        live_has_subscribers(thread_id, LANG_ZH_CN),
+    };
+    if (!wanted[LANG_EN] && !wanted[LANG_ZH_CN]) {
+        return;
     }
     
-    int64_t board_id = 1;
-    char subject[256] = {0};
-    char author[128] = "Anonymous";
-    char content[2048] = {0};
-    char decoded_value[2048];
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT p.author, COALESCE(p.content_html, " DB_ESCAPE_HTML_SQL("p.content") "), "
+        "p.reply_to, rp.id, rp.author, "
+        "COALESCE(rp.content_html, " DB_ESCAPE_HTML_SQL("rp.content") "), "
+        POST_ATTACHMENT_COLUMNS " "
+        "FROM posts p "
+        "LEFT JOIN posts rp ON p.reply_to = rp.id "
+        POST_ATTACHMENT_JOIN
+        "WHERE p.id = ?"
+    );
+    if (!stmt) {
+        return;
+    }
+    sqlite3_bind_int64(stmt, 1, post_id);
     
+    if (db_step(stmt) == SQLITE_ROW) {
+        post_view_t post = {
+            .id = post_id,
+            .author = (const char *)sqlite3_column_text(stmt, 0),
+            .content_html = (const char *)sqlite3_column_text(stmt, 1),
+            .quoted_id = sqlite3_column_int64(stmt, 2) > 0 ? sqlite3_column_int64(stmt, 3) : 0,
+            .quoted_author = (const char *)sqlite3_column_text(stmt, 4),
+            .quoted_content_html = (const char *)sqlite3_column_text(stmt, 5),
+        };
+        char url[128];
+        post_view_set_attachment(&post, stmt, 6, url, sizeof(url));
+        
+        render_buf_t html;
+        render_buf_init(&html, 2048);
+        for (int lang = LANG_EN; lang <= LANG_ZH_CN; lang++) {
+            if (!wanted[lang]) {
+                continue;
+            }
+            post.lang = (language_t)lang;
+            render_buf_reset(&html);
+            if (tmpl_thread_post(&html, &post) == 0) {
+                live_publish(thread_id, post.lang, "post", post_id, html.data, html.len);
+            }
+        }
+        render_buf_free(&html);
+    }
+    db_finalize(stmt);
+}
+
+/* Fields of the thread and reply forms. They arrive urlencoded, or as
+ * multipart/form-data when the form carries a file. */
+typedef struct {
+    int64_t board_id;
+    int64_t thread_id;
+    int64_t reply_to;
+    char subject[256];
+    char author[128];
+    char content[2048];
+} post_form_t;
+
+static void post_form_set(void *ctx, const char *name, const char *value) {
+    post_form_t *form = ctx;
+    if (strcmp(name, "board_id") == 0) {
+        form->board_id = atoll(value);
+    } else if (strcmp(name, "thread_id") == 0) {
+        form->thread_id = atoll(value);
+    } else if (strcmp(name, "reply_to") == 0) {
+        form->reply_to = atoll(value);
+    } else if (strcmp(name, "subject") == 0) {
+        snprintf(form->subject, sizeof(form->subject), "%s", value);
+    } else if (strcmp(name, "author") == 0 && value[0] != '\0') {
+        snprintf(form->author, sizeof(form->author), "%s", value);
+    } else if (strcmp(name, "content") == 0) {
+        snprintf(form->content, sizeof(form->content), "%s", value);
+    }
+}
+
+static http_response_t *form_error(language_t lang, int status, const char *message) {
+    char error_html[512];
+    snprintf(error_html, sizeof(error_html),
+        "<html><body><h1>%s: %s</h1></body></html>",
+        i18n_get(lang, "error"), message);
+    return http_response_create(status, "text/html", error_html, strlen(error_html));
+}
+
+/* Reads the submitted form into form, and an attached file, if any, into
+ * *file. Returns NULL, or the response to send instead. */
+static http_response_t *read_post_form(http_request_t *req, language_t lang,
+                                       post_form_t *form, upload_file_t **file) {
+    *file = NULL;
+    
+    if (req->content_type && strncasecmp(req->content_type, "multipart/form-data", 19) == 0) {
+        upload_status_t status = upload_parse_form(req, post_form_set, form, file);
+        if (status == UPLOAD_ERR_TOO_LARGE) {
+            return form_error(lang, 413, i18n_get(lang, "attachment_too_large"));
+        }
+        if (status == UPLOAD_ERR_IO) {
+            return form_error(lang, 500, i18n_get(lang, "attachment_failed"));
+        }
+        if (status != UPLOAD_OK) {
+            return form_error(lang, 400, i18n_get(lang, "no_form_data"));
+        }
+        return NULL;
+    }
+    
+    if (!req->body) {
+        return form_error(lang, 400, i18n_get(lang, "no_form_data"));
+    }
+    /* These routes admit upload-sized bodies, but only what fitted in the
+     * request buffer is in req->body; parsing that would drop fields. */
+    if (req->content_length > req->body_len) {
+        return form_error(lang, 413, i18n_get(lang, "form_too_large"));
+    }
     char *body_copy = strdup(req->body);
     if (!body_copy) {
-        char error_html[256];
-        snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: %s</h1></body></html>",
-            i18n_get(lang, "error"),
-            i18n_get(lang, "out_of_memory"));
-        return http_response_create(500, "text/html", error_html, strlen(error_html));
+        return form_error(lang, 500, i18n_get(lang, "out_of_memory"));
     }
     
+    char decoded_value[2048];
     char *token = strtok(body_copy, "&");
     while (token) {
         char *eq = strchr(token, '=');
         if (eq) {
             *eq = '\0';
-            char *key = token;
-            char *value = eq + 1;
-            
-            if (strcmp(key, "board_id") == 0) {
-                board_id = atoll(value);
-            } else if (strcmp(key, "subject") == 0) {
-                url_decode(subject, value, sizeof(subject));
-            } else if (strcmp(key, "author") == 0 && strlen(value) > 0) {
-                url_decode(decoded_value, value, sizeof(decoded_value));
-                if (strlen(decoded_value) > 0) {
-                    strncpy(author, decoded_value, sizeof(author) - 1);
-                }
-            } else if (strcmp(key, "content") == 0) {
-                url_decode(content, value, sizeof(content));
-            }
+            url_decode(decoded_value, eq + 1, sizeof(decoded_value));
+            post_form_set(form, token, decoded_value);
         }
         token = strtok(NULL, "&");
     }
     free(body_copy);
+    return NULL;
+}
+
+/* Reads the type and pixel size of an attached image from its header and
+ * adds it to the upload store, so pages render it from the attachments row
+ * alone. Files that are not images are refused. Returns NULL, or the
+ * response to send instead. */
+static http_response_t *store_attachment(upload_file_t *file, language_t lang,
+                                         post_attachment_t *attachment) {
+    media_info_t info;
+    int fd = open(file->temp_path, O_RDONLY);
+    int probed = fd >= 0 ? media_probe(fd, &info) : -1;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (probed != 0) {
+        return form_error(lang, 415, i18n_get(lang, "attachment_unsupported"));
+    }
     
-    sqlite3_stmt *stmt = db_prepare(
-        "INSERT INTO threads (board_id, subject) VALUES (?, ?)"
-    );
-    if (!stmt) {
-        char error_html[256];
-        snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: Failed to create thread</h1></body></html>",
-            i18n_get(lang, "error"));
-        return http_response_create(500, "text/html", error_html, strlen(error_html));
+    /* The served type follows the extension, so make it match the content. */
+    if (strcmp(static_file_content_type(file->filename), info.content_type) != 0) {
+        char *dot = strrchr(file->filename, '.');
+        size_t base = dot ? (size_t)(dot - file->filename) : strlen(file->filename);
+        size_t ext_len = strlen(info.extension);
+        if (base > sizeof(file->filename) - ext_len - 2) {
+            base = sizeof(file->filename) - ext_len - 2;
+        }
+        file->filename[base] = '.';
+        memcpy(file->filename + base + 1, info.extension, ext_len + 1);
     }
+    snprintf(file->content_type, sizeof(file->content_type), "%s", info.content_type);
     
-    sqlite3_bind_int64(stmt, 1, board_id);
-    sqlite3_bind_text(stmt, 2, subject, -1, SQLITE_TRANSIENT);
+    int deduplicated = 0;
+    if (upload_store(file, &deduplicated) != 0) {
+        return form_error(lang, 500, i18n_get(lang, "attachment_failed"));
+    }
     
-    int rc = db_step(stmt);
-    int64_t thread_id = sqlite3_last_insert_rowid(db_get_connection());
-    db_finalize(stmt);
+    attachment->hash = file->hash;
+    attachment->filename = file->filename;
+    attachment->content_type = file->content_type;
+    attachment->size = (int64_t)file->size;
+    attachment->width = info.width;
+    attachment->height = info.height;
+    return NULL;
+}
+
+http_response_t *thread_create_handler(http_request_t *req) {
+    language_t lang = i18n_get_language(req);
     
-    if (rc != SQLITE_DONE) {
+    post_form_t form = { .board_id = 1, .author = "Anonymous" };
+    upload_file_t *file = NULL;
+    http_response_t *error = read_post_form(req, lang, &form, &file);
+    if (error) {
+        return error;
+    }
+    
+    post_attachment_t attachment = {0};
+    if (file) {
+        error = store_attachment(file, lang, &attachment);
+        if (error) {
+            upload_file_free(file);
+            return error;
+        }
+    }
+    
+    int64_t thread_id = 0;
+    /* Escape once here instead of on every view. */
+    char *content_html = render_escape_html(form.content);
+    int rc = write_queue_create_thread(form.board_id, form.subject, form.author, form.content, content_html,
+                                       file ? &attachment : NULL, &thread_id, NULL);
+    free(content_html);
+    if (rc != 0 && file) {
+        upload_release(attachment.hash);
+    }
+    upload_file_free(file);
+    if (rc != 0) {
         char error_html[256];
         snprintf(error_html, sizeof(error_html),
             "<html><body><h1>%s: Failed to create thread</h1></body></html>",
@@ -1135,17 +934,7 @@ http_response_t *thread_create_handler(http_request_t *req) {
         return http_response_create(500, "text/html", error_html, strlen(error_html));
     }
     
-    sqlite3_stmt *post_stmt = db_prepare(
-        "INSERT INTO posts (thread_id, author, content, reply_to) VALUES (?, ?, ?, ?)"
-    );
-    if (post_stmt) {
-        sqlite3_bind_int64(post_stmt, 1, thread_id);
-        sqlite3_bind_text(post_stmt, 2, author, -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(post_stmt, 3, content, -1, SQLITE_TRANSIENT);
-        sqlite3_bind_null(post_stmt, 4);
-        db_step(post_stmt);
-        db_finalize(post_stmt);
-    }
+    suggest_add(thread_id, form.subject);
     
     char *html = malloc(1024);
     if (!html) {
@@ -1187,7 +976,7 @@ http_response_t *thread_create_handler(http_request_t *req) {
         i18n_get(lang, "thread_created_msg"),
         (long long)thread_id,
         i18n_get(lang, "view_thread"),
-        (long long)board_id,
+        (long long)form.board_id,
         i18n_get(lang, "back_to_board"));
     
     http_response_t *response = http_response_create(200, "text/html", html, len);
@@ -1198,88 +987,52 @@ http_response_t *thread_create_handler(http_request_t *req) {
 http_response_t *post_create_handler(http_request_t *req) {
     language_t lang = i18n_get_language(req);
     
-    if (!req->body) {
-        char error_html[256];
-        snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: %s</h1></body></html>",
-            i18n_get(lang, "error"),
-            i18n_get(lang, "no_form_data"));
-        return http_response_create(400, "text/html", error_html, strlen(error_html));
-    }
-    
-    int64_t thread_id = 0;
-    int64_t reply_to = 0;
-    char author[128] = "Anonymous";
-    char content[2048] = {0};
-    char decoded_value[2048];
-    
-    char *body_copy = strdup(req->body);
-    if (!body_copy) {
-        char error_html[256];
-        snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: %s</h1></body></html>",
-            i18n_get(lang, "error"),
-            i18n_get(lang, "out_of_memory"));
-        return http_response_create(500, "text/html", error_html, strlen(error_html));
-    }
-    
-    char *token = strtok(body_copy, "&");
-    while (token) {
-        char *eq = strchr(token, '=');
-        if (eq) {
-            *eq = '\0';
-            char *key = token;
-            char *value = eq + 1;
-            
-            if (strcmp(key, "thread_id") == 0) {
-                thread_id = atoll(value);
-            } else if (strcmp(key, "reply_to") == 0 && strlen(value) > 0) {
-                reply_to = atoll(value);
-            } else if (strcmp(key, "author") == 0 && strlen(value) > 0) {
-                url_decode(decoded_value, value, sizeof(decoded_value));
-                if (strlen(decoded_value) > 0) {
-                    strncpy(author, decoded_value, sizeof(author) - 1);
-                }
-            } else if (strcmp(key, "content") == 0) {
-                url_decode(content, value, sizeof(content));
-            }
-        }
-        token = strtok(NULL, "&");
+    post_form_t form = { .author = "Anonymous" };
+    upload_file_t *file = NULL;
+    http_response_t *error = read_post_form(req, lang, &form, &file);
+    if (error) {
+        return error;
     }
-    free(body_copy);
+    int64_t thread_id = form.thread_id;
     
     if (thread_id == 0) {
         char error_html[256];
         snprintf(error_html, sizeof(error_html),
             "<html><body><h1>%s: Invalid thread ID</h1></body></html>",
             i18n_get(lang, "error"));
+        upload_file_free(file);
         return http_response_create(400, "text/html", error_html, strlen(error_html));
     }
     
-    sqlite3_stmt *stmt = db_prepare(
-        "INSERT INTO posts (thread_id, author, content, reply_to) VALUES (?, ?, ?, ?)"
-    );
-    if (!stmt) {
-        char error_html[256];
+    if (!id_filter_may_exist(ID_FILTER_THREADS, thread_id)) {
+        char error_html[512];
         snprintf(error_html, sizeof(error_html),
-            "<html><body><h1>%s: Failed to create post</h1></body></html>",
-            i18n_get(lang, "error"));
-        return http_response_create(500, "text/html", error_html, strlen(error_html));
+            "<html><body><h1>%s</h1><a href=\"/\">%s</a></body></html>",
+            i18n_get(lang, "thread_not_found"),
+            i18n_get(lang, "back_to_boards"));
+        upload_file_free(file);
+        return http_response_create(404, "text/html", error_html, strlen(error_html));
     }
     
-    sqlite3_bind_int64(stmt, 1, thread_id);
-    sqlite3_bind_text(stmt, 2, author, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, content, -1, SQLITE_TRANSIENT);
-    if (reply_to > 0) {
-        sqlite3_bind_int64(stmt, 4, reply_to);
-    } else {
-        sqlite3_bind_null(stmt, 4);
+    post_attachment_t attachment = {0};
+    if (file) {
+        error = store_attachment(file, lang, &attachment);
+        if (error) {
+            upload_file_free(file);
+            return error;
+        }
     }
     
-    int rc = db_step(stmt);
-    db_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
+    char *content_html = render_escape_html(form.content);
+    int64_t post_id = 0;
+    int rc = write_queue_create_post(thread_id, form.reply_to, form.author, form.content,
+                                     content_html, file ? &attachment : NULL, &post_id);
+    free(content_html);
+    if (rc != 0 && file) {
+        upload_release(attachment.hash);
+    }
+    upload_file_free(file);
+    if (rc != 0) {
         char error_html[256];
         snprintf(error_html, sizeof(error_html),
             "<html><body><h1>%s: Failed to create post</h1></body></html>",
@@ -1287,6 +1040,8 @@ http_response_t *post_create_handler(http_request_t *req) {
         return http_response_create(500, "text/html", error_html, strlen(error_html));
     }
     
+    publish_post(thread_id, post_id);
+    
     char *html = malloc(1024);
     if (!html) {
         char error_html[256];
@@ -1332,33 +1087,18 @@ http_response_t *post_create_handler(http_request_t *req) {
     return response;
 }
 
-board_t *board_get_by_id(int64_t id) {
-    sqlite3_stmt *stmt = db_prepare("SELECT id, name, description FROM boards WHERE id = ?");
-    if (!stmt) {
-        return NULL;
-    }
-    
-    sqlite3_bind_int64(stmt, 1, id);
-    
-    board_t *board = NULL;
-    if (db_step(stmt) == SQLITE_ROW) {
-        board = malloc(sizeof(board_t));
-        if (board) {
-            board->id = sqlite3_column_int64(stmt, 0);
-            const char *name = (const char *)sqlite3_column_text(stmt, 1);
-            const char *desc = (const char *)sqlite3_column_text(stmt, 2);
-            board->name = name ? strdup(name) : NULL;
-            board->description = desc ? strdup(desc) : NULL;
-        }
-    }
-    
-    db_finalize(stmt);
-    return board;
+const board_t *board_get_by_id(int64_t id) {
+    return board_registry_get_by_id(id);
+}
+
+const board_t *board_get_by_name(const char *name) {
+    return board_registry_get_by_name(name);
 }
 
 thread_t *thread_get_by_id(int64_t id) {
     sqlite3_stmt *stmt = db_prepare(
-        "SELECT t.id, t.board_id, t.subject, p.content, p.author, t.created_at "
+        "SELECT t.id, t.board_id, t.subject, p.content, p.author, t.created_at, "
+        "COALESCE(p.content_html, " DB_ESCAPE_HTML_SQL("p.content") ") "
         "FROM threads t LEFT JOIN posts p ON t.id = p.thread_id "
         "WHERE t.id = ? ORDER BY p.id ASC LIMIT 1"
     );
@@ -1377,8 +1117,10 @@ thread_t *thread_get_by_id(int64_t id) {
             const char *subject = (const char *)sqlite3_column_text(stmt, 2);
             const char *content = (const char *)sqlite3_column_text(stmt, 3);
             const char *author = (const char *)sqlite3_column_text(stmt, 4);
+            const char *content_html = (const char *)sqlite3_column_text(stmt, 6);
             thread->subject = subject ? strdup(subject) : NULL;
             thread->content = content ? strdup(content) : NULL;
+            thread->content_html = content_html ? strdup(content_html) : NULL;
             thread->author = author ? strdup(author) : strdup("Anonymous");
             thread->created_at = sqlite3_column_int64(stmt, 5);
         }
@@ -1388,18 +1130,11 @@ thread_t *thread_get_by_id(int64_t id) {
     return thread;
 }
 
-void board_free(board_t *board) {
-    if (board) {
-        free(board->name);
-        free(board->description);
-        free(board);
-    }
-}
-
 void thread_free(thread_t *thread) {
     if (thread) {
         free(thread->subject);
         free(thread->content);
+        free(thread->content_html);
         free(thread->author);
         free(thread);
     }
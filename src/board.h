@@ -2,12 +2,16 @@
 #define BOARD_H
 
 #include "http.h"
+#include "i18n.h"
 #include <stdint.h>
 
+/* Borrowed view into the board registry; never freed by callers. */
 typedef struct {
     int64_t id;
-    char *name;
-    char *description;
+    const char *name;
+    const char *title;
+    const char *description;
+    int64_t created_at;
 } board_t;
 
 typedef struct {
@@ -15,6 +19,7 @@ typedef struct {
     int64_t board_id;
     char *subject;
     char *content;
+    char *content_html;             /* content escaped for HTML */
     char *author;
     int64_t created_at;
 } thread_t;
@@ -27,19 +32,74 @@ typedef struct {
     int64_t created_at;
 } post_t;
 
+/*
+ * Contexts for the page templates in templates/, which tools/tmplc compiles
+ * into tmpl_* functions. Field names and types here are what the templates
+ * can reference.
+ */
+typedef struct {
+    language_t lang;
+    int lang_en;
+    int lang_zh_cn;
+    int64_t id;
+    const char *name;
+    const char *description;
+    const char *kaomoji_picker_html;
+} board_page_t;
+
+typedef struct {
+    int64_t id;
+    const char *subject;
+    int64_t post_count;
+} thread_summary_t;
+
+typedef struct {
+    language_t lang;
+    int lang_en;
+    int lang_zh_cn;
+    int64_t id;
+    int64_t board_id;
+    const char *subject;
+    const char *author;
+    const char *content_html;
+    const char *kaomoji_picker_html;
+} thread_page_t;
+
+typedef struct {
+    language_t lang;
+    int64_t id;
+    const char *author;
+    const char *content_html;
+    int64_t quoted_id;              /* 0 when not a reply */
+    const char *quoted_author;
+    const char *quoted_content_html;
+    const char *attachment_url;     /* NULL when the post has no file */
+    const char *attachment_name;
+    int64_t attachment_kb;
+    int attachment_width;           /* pixels, read at upload */
+    int attachment_height;
+} post_view_t;
+
+/* Posts returned per /thread/{id}/since/{post_id} request; clients that
+ * are further behind ask again from the last id they received. */
+#define THREAD_SINCE_LIMIT 100
+
 void board_init(void);
+void board_shutdown(void);
 void board_register_routes(void);
 
 http_response_t *board_list_handler(http_request_t *req);
 http_response_t *board_create_handler(http_request_t *req);
 http_response_t *board_view_handler(http_request_t *req);
+http_response_t *board_path_handler(http_request_t *req);
 http_response_t *thread_view_handler(http_request_t *req);
+http_response_t *thread_path_handler(http_request_t *req);
 http_response_t *thread_create_handler(http_request_t *req);
 http_response_t *post_create_handler(http_request_t *req);
 
-board_t *board_get_by_id(int64_t id);
+const board_t *board_get_by_id(int64_t id);
+const board_t *board_get_by_name(const char *name);
 thread_t *thread_get_by_id(int64_t id);
-void board_free(board_t *board);
 void thread_free(thread_t *thread);
 void post_free(post_t *post);
 
@@ -0,0 +1,228 @@
+#define _POSIX_C_SOURCE 200809L
+#include "board_registry.h"
+#include "db.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* One allocation per board: the view followed by its strings. Entries are
+ * shared between snapshots and freed only at shutdown. */
+typedef struct board_entry {
+    board_t board;
+    struct board_entry *next;
+    char strings[];
+} board_entry_t;
+
+typedef struct snapshot {
+    size_t count;
+    const board_t **by_id;
+    const board_t **by_name;
+    struct snapshot *retired_next;
+} snapshot_t;
+
+static _Atomic(snapshot_t *) current_snapshot = NULL;
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static board_entry_t *all_entries = NULL;
+
+/* Replaced snapshots are kept until shutdown instead of waiting for a grace
+ * period: boards are created by hand, so this is a few small arrays. */
+static snapshot_t *retired_snapshots = NULL;
+
+static const board_t *find_by_id(const snapshot_t *snap, int64_t id) {
+    size_t lo = 0;
+    size_t hi = snap->count;
+    
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t mid_id = snap->by_id[mid]->id;
+        if (mid_id == id) {
+            return snap->by_id[mid];
+        }
+        if (mid_id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+static int compare_by_name(const void *a, const void *b) {
+    const board_t *board_a = *(const board_t *const *)a;
+    const board_t *board_b = *(const board_t *const *)b;
+    return strcmp(board_a->name, board_b->name);
+}
+
+static const char *copy_string(char **dst, const char *src) {
+    if (!src) {
+        return NULL;
+    }
+    
+    char *start = *dst;
+    size_t len = strlen(src) + 1;
+    memcpy(start, src, len);
+    *dst += len;
+    return start;
+}
+
+static const board_t *entry_create(sqlite3_stmt *stmt) {
+    const char *name = (const char *)sqlite3_column_text(stmt, 1);
+    const char *title = (const char *)sqlite3_column_text(stmt, 2);
+    const char *desc = (const char *)sqlite3_column_text(stmt, 3);
+    
+    size_t size = sizeof(board_entry_t) + strlen(name ? name : "") + 1;
+    size += title ? strlen(title) + 1 : 0;
+    size += desc ? strlen(desc) + 1 : 0;
+    
+    board_entry_t *entry = malloc(size);
+    if (!entry) {
+        return NULL;
+    }
+    
+    char *strings = entry->strings;
+    entry->board.id = sqlite3_column_int64(stmt, 0);
+    entry->board.name = copy_string(&strings, name ? name : "");
+    entry->board.title = copy_string(&strings, title);
+    entry->board.description = copy_string(&strings, desc);
+    entry->board.created_at = sqlite3_column_int64(stmt, 4);
+    
+    entry->next = all_entries;
+    all_entries = entry;
+    return &entry->board;
+}
+
+static snapshot_t *snapshot_create(size_t count) {
+    snapshot_t *snap = malloc(sizeof(snapshot_t) + 2 * count * sizeof(const board_t *));
+    if (!snap) {
+        return NULL;
+    }
+    
+    snap->count = 0;
+    snap->by_id = (const board_t **)(snap + 1);
+    snap->by_name = snap->by_id + count;
+    snap->retired_next = NULL;
+    return snap;
+}
+
+static int count_boards(void) {
+    sqlite3_stmt *stmt = db_prepare("SELECT COUNT(*) FROM boards");
+    if (!stmt) {
+        return -1;
+    }
+    
+    int count = db_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    db_finalize(stmt);
+    return count;
+}
+
+int board_registry_load(void) {
+    pthread_mutex_lock(&writer_mutex);
+    
+    int count = count_boards();
+    sqlite3_stmt *stmt = count >= 0 ? db_prepare(
+        "SELECT id, name, title, description, created_at FROM boards ORDER BY id"
+    ) : NULL;
+    if (!stmt) {
+        pthread_mutex_unlock(&writer_mutex);
+        fprintf(stderr, "Failed to load boards\n");
+        return -1;
+    }
+    
+    snapshot_t *snap = snapshot_create((size_t)count);
+    if (!snap) {
+        db_finalize(stmt);
+        pthread_mutex_unlock(&writer_mutex);
+        fprintf(stderr, "Failed to allocate board snapshot\n");
+        return -1;
+    }
+    
+    /* Rows never change once written, so boards already in the previous
+     * snapshot are reused and only new ones are allocated. */
+    snapshot_t *old = atomic_load(&current_snapshot);
+    while (snap->count < (size_t)count && db_step(stmt) == SQLITE_ROW) {
+        int64_t id = sqlite3_column_int64(stmt, 0);
+        const board_t *board = old ? find_by_id(old, id) : NULL;
+        if (!board) {
+            board = entry_create(stmt);
+        }
+        if (!board) {
+            break;
+        }
+        snap->by_id[snap->count++] = board;
+    }
+    db_finalize(stmt);
+    
+    if (snap->count < (size_t)count) {
+        free(snap);
+        pthread_mutex_unlock(&writer_mutex);
+        fprintf(stderr, "Failed to read boards\n");
+        return -1;
+    }
+    
+    memcpy(snap->by_name, snap->by_id, snap->count * sizeof(const board_t *));
+    qsort(snap->by_name, snap->count, sizeof(const board_t *), compare_by_name);
+    
+    atomic_store_explicit(&current_snapshot, snap, memory_order_release);
+    if (old) {
+        old->retired_next = retired_snapshots;
+        retired_snapshots = old;
+    }
+    
+    pthread_mutex_unlock(&writer_mutex);
+    printf("Board registry loaded: %zu boards\n", snap->count);
+    return 0;
+}
+
+void board_registry_shutdown(void) {
+    pthread_mutex_lock(&writer_mutex);
+    
+    free(atomic_exchange(&current_snapshot, NULL));
+    while (retired_snapshots) {
+        snapshot_t *next = retired_snapshots->retired_next;
+        free(retired_snapshots);
+        retired_snapshots = next;
+    }
+    while (all_entries) {
+        board_entry_t *next = all_entries->next;
+        free(all_entries);
+        all_entries = next;
+    }
+    
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+const board_t *board_registry_get_by_id(int64_t id) {
+    snapshot_t *snap = atomic_load_explicit(&current_snapshot, memory_order_acquire);
+    return snap ? find_by_id(snap, id) : NULL;
+}
+
+const board_t *board_registry_get_by_name(const char *name) {
+    snapshot_t *snap = atomic_load_explicit(&current_snapshot, memory_order_acquire);
+    if (!snap || !name) {
+        return NULL;
+    }
+    
+    size_t lo = 0;
+    size_t hi = snap->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(snap->by_name[mid]->name, name);
+        if (cmp == 0) {
+            return snap->by_name[mid];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+const board_t *const *board_registry_list(size_t *count) {
+    snapshot_t *snap = atomic_load_explicit(&current_snapshot, memory_order_acquire);
+    *count = snap ? snap->count : 0;
+    return snap ? snap->by_name : NULL;
+}
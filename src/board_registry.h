@@ -0,0 +1,26 @@
+#ifndef BOARD_REGISTRY_H
+#define BOARD_REGISTRY_H
+
+#include "board.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * All boards, held in memory as an immutable snapshot indexed by id and by
+ * name. board_registry_load() builds a new snapshot and swaps it in with
+ * one atomic store; readers never lock. Board rows are never updated, so a
+ * board_t handed out stays valid until board_registry_shutdown().
+ */
+
+/* Reads the boards table into a new snapshot and publishes it. Call after
+ * db_migrate() and again whenever a board is inserted. */
+int board_registry_load(void);
+void board_registry_shutdown(void);
+
+const board_t *board_registry_get_by_id(int64_t id);
+const board_t *board_registry_get_by_name(const char *name);
+
+/* Boards sorted by name, as of the latest snapshot. */
+const board_t *const *board_registry_list(size_t *count);
+
+#endif
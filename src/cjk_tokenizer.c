@@ -0,0 +1,215 @@
+#include "cjk_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    fts5_tokenizer inner_api;
+    Fts5Tokenizer *inner;
+} cjk_tokenizer_t;
+
+typedef int (*token_callback_t)(void *ctx, int tflags, const char *token,
+                                int token_len, int start, int end);
+
+/* Forwards unicode61 tokens for a sub-span with offsets rebased onto the
+ * whole text, so highlight() and snippet() point at the right bytes. */
+typedef struct {
+    void *ctx;
+    token_callback_t callback;
+    int base;
+} span_ctx_t;
+
+int cjk_decode_utf8(const unsigned char *s, int n, uint32_t *cp) {
+    unsigned char c = s[0];
+    
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    }
+    if ((c & 0xE0) == 0xC0 && n >= 2 && (s[1] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(c & 0x1F) << 6) | (s[1] & 0x3F);
+        return 2;
+    }
+    if ((c & 0xF0) == 0xE0 && n >= 3 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(c & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        return 3;
+    }
+    if ((c & 0xF8) == 0xF0 && n >= 4 && (s[1] & 0xC0) == 0x80 &&
+        (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(c & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+              ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        return 4;
+    }
+    
+    *cp = 0xFFFD;
+    return 1;
+}
+
+int cjk_is_cjk(uint32_t cp) {
+    if (cp < 0x3040) {
+        return 0;
+    }
+    return (cp >= 0x3040 && cp <= 0x30FF) ||      /* Hiragana, Katakana */
+           (cp >= 0x31F0 && cp <= 0x31FF) ||      /* Katakana extensions */
+           (cp >= 0x3400 && cp <= 0x4DBF) ||      /* CJK extension A */
+           (cp >= 0x4E00 && cp <= 0x9FFF) ||      /* CJK unified ideographs */
+           (cp >= 0xAC00 && cp <= 0xD7AF) ||      /* Hangul syllables */
+           (cp >= 0xF900 && cp <= 0xFAFF) ||      /* CJK compatibility */
+           (cp >= 0x20000 && cp <= 0x2FA1F);      /* CJK extensions B-F, supplement */
+}
+
+static int span_callback(void *ctx, int tflags, const char *token, int token_len,
+                         int start, int end) {
+    span_ctx_t *span = ctx;
+    return span->callback(span->ctx, tflags, token, token_len,
+                          start + span->base, end + span->base);
+}
+
+static int tokenize_span(cjk_tokenizer_t *tok, void *ctx, int flags,
+                         const char *text, int start, int end, token_callback_t callback) {
+    if (end <= start) {
+        return SQLITE_OK;
+    }
+    
+    span_ctx_t span = { ctx, callback, start };
+    return tok->inner_api.xTokenize(tok->inner, &span, flags, text + start, end - start,
+                                    span_callback);
+}
+
+static int cjk_create(void *user_data, const char **args, int nargs, Fts5Tokenizer **out) {
+    fts5_api *api = user_data;
+    void *inner_data = NULL;
+    
+    cjk_tokenizer_t *tok = calloc(1, sizeof(cjk_tokenizer_t));
+    if (!tok) {
+        return SQLITE_NOMEM;
+    }
+    
+    int rc = api->xFindTokenizer(api, "unicode61", &inner_data, &tok->inner_api);
+    if (rc == SQLITE_OK) {
+        rc = tok->inner_api.xCreate(inner_data, args, nargs, &tok->inner);
+    }
+    if (rc != SQLITE_OK) {
+        free(tok);
+        return rc;
+    }
+    
+    *out = (Fts5Tokenizer *)tok;
+    return SQLITE_OK;
+}
+
+static void cjk_delete(Fts5Tokenizer *handle) {
+    cjk_tokenizer_t *tok = (cjk_tokenizer_t *)handle;
+    if (tok) {
+        tok->inner_api.xDelete(tok->inner);
+        free(tok);
+    }
+}
+
+static int cjk_tokenize(Fts5Tokenizer *handle, void *ctx, int flags,
+                        const char *text, int text_len, token_callback_t callback) {
+    cjk_tokenizer_t *tok = (cjk_tokenizer_t *)handle;
+    const unsigned char *s = (const unsigned char *)text;
+    int span_start = 0;
+    int pos = 0;
+    
+    while (pos < text_len) {
+        /* Bytes below 0x80 and two-byte sequences (< U+0800) are never CJK. */
+        if (s[pos] < 0xE0) {
+            pos++;
+            continue;
+        }
+    
+        uint32_t cp;
+        int len = cjk_decode_utf8(s + pos, text_len - pos, &cp);
+        if (!cjk_is_cjk(cp)) {
+            pos += len;
+            continue;
+        }
+    
+        int rc = tokenize_span(tok, ctx, flags, text, span_start, pos, callback);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+    
+        /* Emit each character together with the one after it. */
+        int prev = pos;
+        int run_length = 1;
+        pos += len;
+    
+        while (pos < text_len && s[pos] >= 0xE0) {
+            len = cjk_decode_utf8(s + pos, text_len - pos, &cp);
+            if (!cjk_is_cjk(cp)) {
+                break;
+            }
+            rc = callback(ctx, 0, text + prev, pos + len - prev, prev, pos + len);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            prev = pos;
+            pos += len;
+            run_length++;
+        }
+    
+        /* Documents also index the run's last character on its own, which
+         * makes a one-character query a prefix match over the bigrams. A
+         * query only needs it when the run is a single character. */
+        if (run_length == 1 || !(flags & FTS5_TOKENIZE_QUERY)) {
+            rc = callback(ctx, 0, text + prev, pos - prev, prev, pos);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+    
+        span_start = pos;
+    }
+    
+    return tokenize_span(tok, ctx, flags, text, span_start, text_len, callback);
+}
+
+static fts5_api *get_fts5_api(sqlite3 *db) {
+    fts5_api *api = NULL;
+    sqlite3_stmt *stmt = NULL;
+    
+    if (sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &stmt, NULL) != SQLITE_OK) {
+        return NULL;
+    }
+    sqlite3_bind_pointer(stmt, 1, (void *)&api, "fts5_api_ptr", NULL);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return api;
+}
+
+int cjk_tokenizer_register(sqlite3 *db) {
+    static fts5_tokenizer cjk_api = { cjk_create, cjk_delete, cjk_tokenize };
+    
+    fts5_api *api = get_fts5_api(db);
+    if (!api) {
+        fprintf(stderr, "FTS5 is not available, cjk tokenizer not registered\n");
+        return -1;
+    }
+    
+    if (api->xCreateTokenizer(api, "cjk", api, &cjk_api, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to register cjk tokenizer: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    return 0;
+}
+
+static int cjk_auto_extension(sqlite3 *db, char **err_msg, const struct sqlite3_api_routines *routines) {
+    (void)err_msg;
+    (void)routines;
+    
+    /* A failure here must not make sqlite3_open fail; search_init reports
+     * the missing tokenizer when it creates the index. */
+    cjk_tokenizer_register(db);
+    return SQLITE_OK;
+}
+
+int cjk_tokenizer_install(void) {
+    if (sqlite3_auto_extension((void (*)(void))cjk_auto_extension) != SQLITE_OK) {
+        fprintf(stderr, "Failed to install cjk tokenizer\n");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef CJK_TOKENIZER_H
+#define CJK_TOKENIZER_H
+
+#include <stdint.h>
+#include "sqlite3.h"
+
+/*
+ * FTS5 tokenizer "cjk": runs of Han, Kana and Hangul are indexed as
+ * overlapping bigrams (plus the last character of each run, so single
+ * characters are searchable as a prefix); everything else goes through
+ * unicode61, with any tokenizer arguments passed on to it.
+ */
+
+/* Registers the tokenizer on every connection opened from now on; call
+ * before db_init(). */
+int cjk_tokenizer_install(void);
+
+/* Registers the tokenizer on one connection. */
+int cjk_tokenizer_register(sqlite3 *db);
+
+/* Decodes one UTF-8 sequence from s (n bytes available). Returns its length;
+ * invalid bytes decode to U+FFFD with length 1. */
+int cjk_decode_utf8(const unsigned char *s, int n, uint32_t *cp);
+
+/* Non-zero for code points that are bigrammed instead of split into words. */
+int cjk_is_cjk(uint32_t cp);
+
+#endif
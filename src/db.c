@@ -7,8 +7,55 @@
 #include <errno.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
-static sqlite3 *db_conn = NULL;
+#define DB_MAX_READERS 64
+#define DB_MMAP_AUTO (-1)
+#define DB_MMAP_MIN (64LL * 1024 * 1024)
+#define DB_MMAP_MAX (2LL * 1024 * 1024 * 1024 - 65536)
+#define DB_MIGRATE_BATCH 1000
+
+/*
+ * Storage profiles. "safe" keeps the historical settings (no mmap, SQLite's
+ * default 2000 KiB cache); "read-heavy" maps the whole file so reads are
+ * served from the page cache without read() syscalls. cache_size follows
+ * SQLite's convention: negative values are KiB.
+ *
+ * Every connection has its own cache and up to DB_MAX_READERS readers may
+ * open besides the writer, so memory is bounded by 65 times cache_size.
+ * Mapped pages bypass the cache, so read-heavy keeps it small: at most
+ * 260 MB in all, and only if every reader fills its cache.
+ */
+static const db_profile_t profiles[] = {
+    {"safe",       0,            -2000, 0, 4096},
+    {"read-heavy", DB_MMAP_AUTO, -4096, 1, 8192},
+};
+
+static const db_profile_t *active_profile = &profiles[0];
+static long long effective_mmap_size = 0;
+
+/*
+ * Connection pool: one dedicated writer connection shared by all threads
+ * (serialised by writer_mutex) plus one read connection per thread, opened
+ * lazily on first use. Under WAL the readers never block each other or the
+ * writer.
+ */
+static char db_file[512];
+static sqlite3 *writer_conn = NULL;
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sqlite3 *reader_pool[DB_MAX_READERS];
+static size_t reader_count = 0;
+static unsigned int pool_generation = 0;
+static atomic_llong last_write_time = 0;
+
+static _Thread_local sqlite3 *thread_reader = NULL;
+static _Thread_local unsigned int thread_reader_generation = 0;
+static _Thread_local int thread_writer_depth = 0;
+static _Thread_local sqlite3_int64 thread_lock_changes = 0;
 
 static int ensure_directory_exists(const char *path) {
     char *path_copy = strdup(path);
@@ -34,70 +81,264 @@ static int ensure_directory_exists(const char *path) {
     return 0;
 }
 
+static void apply_connection_pragmas(sqlite3 *conn) {
+    char *err_msg = NULL;
+    
+    sqlite3_busy_timeout(conn, DB_BUSY_TIMEOUT_MS);
+    
+    int rc = sqlite3_exec(conn, "PRAGMA synchronous=NORMAL;", NULL, NULL, &err_msg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to set synchronous mode: %s\n", err_msg);
+        sqlite3_free(err_msg);
+    }
+    
+    char sql[128];
+    snprintf(sql, sizeof(sql),
+             "PRAGMA mmap_size=%lld; PRAGMA cache_size=%d; PRAGMA temp_store=%s;",
+             effective_mmap_size, active_profile->cache_size,
+             active_profile->temp_store_memory ? "MEMORY" : "DEFAULT");
+    
+    rc = sqlite3_exec(conn, sql, NULL, NULL, &err_msg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to apply storage profile: %s\n", err_msg);
+        sqlite3_free(err_msg);
+    }
+}
+
+/* Maps the current file plus room to double, so a growing database stays
+ * fully mapped until the next restart. */
+static long long auto_mmap_size(const char *path) {
+    struct stat st;
+    long long size = DB_MMAP_MIN;
+    
+    if (stat(path, &st) == 0 && (long long)st.st_size * 2 > size) {
+        size = (long long)st.st_size * 2;
+    }
+    if (size > DB_MMAP_MAX) {
+        size = DB_MMAP_MAX;
+    }
+    return size;
+}
+
+int db_set_profile(const char *name) {
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            active_profile = &profiles[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const db_profile_t *db_get_profile(void) {
+    return active_profile;
+}
+
+static int query_pragma_int(sqlite3 *conn, const char *sql, long long *value) {
+    sqlite3_stmt *stmt = NULL;
+    int rc = -1;
+    
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        *value = sqlite3_column_int64(stmt, 0);
+        rc = 0;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+static void report_storage_settings(sqlite3 *conn) {
+    long long page_size = 0, mmap_size = 0, cache_size = 0, temp_store = 0;
+    
+    query_pragma_int(conn, "PRAGMA page_size;", &page_size);
+    query_pragma_int(conn, "PRAGMA mmap_size;", &mmap_size);
+    query_pragma_int(conn, "PRAGMA cache_size;", &cache_size);
+    query_pragma_int(conn, "PRAGMA temp_store;", &temp_store);
+    
+    printf("Storage profile: %s (page_size=%lld, mmap_size=%lld MB, cache_size=%lld %s, temp_store=%s)\n",
+           active_profile->name,
+           page_size,
+           mmap_size / (1024 * 1024),
+           cache_size < 0 ? -cache_size : cache_size,
+           cache_size < 0 ? "KiB" : "pages",
+           temp_store == 2 ? "memory" : temp_store == 1 ? "file" : "default");
+}
+
+static sqlite3 *open_connection(const char *path) {
+    sqlite3 *conn = NULL;
+    int rc = sqlite3_open_v2(path, &conn,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                             NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to open database: %s\n",
+                conn ? sqlite3_errmsg(conn) : sqlite3_errstr(rc));
+        sqlite3_close(conn);
+        return NULL;
+    }
+    
+    apply_connection_pragmas(conn);
+    return conn;
+}
+
+static sqlite3 *reader_connection(void) {
+    if (thread_reader && thread_reader_generation == pool_generation) {
+        return thread_reader;
+    }
+    
+    pthread_mutex_lock(&pool_mutex);
+    
+    if (!writer_conn) {
+        pthread_mutex_unlock(&pool_mutex);
+        return NULL;
+    }
+    
+    if (reader_count >= DB_MAX_READERS) {
+        pthread_mutex_unlock(&pool_mutex);
+        fprintf(stderr, "Database connection pool exhausted (%d readers)\n", DB_MAX_READERS);
+        return NULL;
+    }
+    
+    sqlite3 *conn = open_connection(db_file);
+    if (conn) {
+        reader_pool[reader_count++] = conn;
+        thread_reader = conn;
+        thread_reader_generation = pool_generation;
+    }
+    
+    pthread_mutex_unlock(&pool_mutex);
+    return conn;
+}
+
 int db_init(const char *db_path) {
     if (!db_path || strlen(db_path) == 0) {
         fprintf(stderr, "Invalid database path\n");
         return -1;
     }
     
+    if (strlen(db_path) >= sizeof(db_file)) {
+        fprintf(stderr, "Database path too long\n");
+        return -1;
+    }
+    
     if (ensure_directory_exists(db_path) != 0) {
         fprintf(stderr, "Failed to ensure database directory exists\n");
         return -1;
     }
     
-    int rc = sqlite3_open(db_path, &db_conn);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to open database: %s\n", sqlite3_errmsg(db_conn));
-        sqlite3_close(db_conn);
-        db_conn = NULL;
+    effective_mmap_size = active_profile->mmap_size == DB_MMAP_AUTO
+        ? auto_mmap_size(db_path)
+        : active_profile->mmap_size;
+    
+    sqlite3 *conn = open_connection(db_path);
+    if (!conn) {
         return -1;
     }
     
-    sqlite3_busy_timeout(db_conn, 5000);
-    
     char *err_msg = NULL;
-    rc = sqlite3_exec(db_conn, "PRAGMA journal_mode=WAL;", NULL, NULL, &err_msg);
+    char sql[64];
+    
+    /* page_size and auto_vacuum only take effect on a brand-new file, so
+     * they must run before the WAL switch writes the header; existing
+     * databases keep what they were created with. */
+    snprintf(sql, sizeof(sql), "PRAGMA page_size=%d;", active_profile->page_size);
+    int rc = sqlite3_exec(conn, sql, NULL, NULL, &err_msg);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to set WAL mode: %s\n", err_msg);
+        fprintf(stderr, "Failed to set page size: %s\n", err_msg);
         sqlite3_free(err_msg);
     }
     
-    rc = sqlite3_exec(db_conn, "PRAGMA synchronous=NORMAL;", NULL, NULL, &err_msg);
+    rc = sqlite3_exec(conn, "PRAGMA auto_vacuum=INCREMENTAL;", NULL, NULL, &err_msg);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to set synchronous mode: %s\n", err_msg);
+        fprintf(stderr, "Failed to set auto_vacuum: %s\n", err_msg);
         sqlite3_free(err_msg);
     }
     
-    rc = sqlite3_exec(db_conn, "PRAGMA mmap_size=0;", NULL, NULL, &err_msg);
+    rc = sqlite3_exec(conn, "PRAGMA journal_mode=WAL;", NULL, NULL, &err_msg);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to disable mmap: %s\n", err_msg);
+        fprintf(stderr, "Failed to set WAL mode: %s\n", err_msg);
         sqlite3_free(err_msg);
     }
     
-    printf("Database initialized: %s\n", db_path);
+    pthread_mutex_lock(&pool_mutex);
+    strcpy(db_file, db_path);
+    writer_conn = conn;
+    reader_count = 0;
+    pthread_mutex_unlock(&pool_mutex);
+    
+    printf("Database initialized: %s (threadsafe=%d)\n", db_path, sqlite3_threadsafe());
+    report_storage_settings(conn);
     return 0;
 }
 
 void db_close(void) {
-    if (db_conn) {
-        sqlite3_close(db_conn);
-        db_conn = NULL;
+    pthread_mutex_lock(&pool_mutex);
+    
+    for (size_t i = 0; i < reader_count; i++) {
+        sqlite3_close(reader_pool[i]);
+        reader_pool[i] = NULL;
+    }
+    reader_count = 0;
+    pool_generation++;
+    
+    if (writer_conn) {
+        sqlite3_close(writer_conn);
+        writer_conn = NULL;
         printf("Database connection closed\n");
     }
+    
+    pthread_mutex_unlock(&pool_mutex);
 }
 
 sqlite3 *db_get_connection(void) {
-    return db_conn;
+    if (thread_writer_depth > 0) {
+        return writer_conn;
+    }
+    return reader_connection();
+}
+
+void db_write_lock(void) {
+    if (thread_writer_depth++ == 0) {
+        pthread_mutex_lock(&writer_mutex);
+        thread_lock_changes = writer_conn ? sqlite3_total_changes64(writer_conn) : 0;
+    }
+}
+
+void db_write_unlock(void) {
+    if (thread_writer_depth <= 0) {
+        fprintf(stderr, "db_write_unlock called without holding the writer\n");
+        return;
+    }
+    if (--thread_writer_depth == 0) {
+        /* Only row changes count: checkpoints and vacuum steps take the
+         * lock too, and must not make an idle database look busy. */
+        if (writer_conn && sqlite3_total_changes64(writer_conn) != thread_lock_changes) {
+            atomic_store(&last_write_time, (long long)time(NULL));
+        }
+        pthread_mutex_unlock(&writer_mutex);
+    }
+}
+
+time_t db_last_write_time(void) {
+    return (time_t)atomic_load(&last_write_time);
+}
+
+const char *db_get_path(void) {
+    return db_file;
 }
 
 int db_exec(const char *sql) {
-    if (!db_conn) {
+    if (!writer_conn) {
         fprintf(stderr, "Database not initialized\n");
         return -1;
     }
     
+    db_write_lock();
+    
     char *err_msg = NULL;
-    int rc = sqlite3_exec(db_conn, sql, NULL, NULL, &err_msg);
+    int rc = sqlite3_exec(writer_conn, sql, NULL, NULL, &err_msg);
+    
+    db_write_unlock();
+    
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL error: %s\n", err_msg);
         sqlite3_free(err_msg);
@@ -106,18 +347,48 @@ int db_exec(const char *sql) {
     return 0;
 }
 
+static sqlite3_stmt *prepare_on_writer(const char *sql) {
+    db_write_lock();
+    
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(writer_conn, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(writer_conn));
+        db_write_unlock();
+        return NULL;
+    }
+    if (!stmt) {
+        db_write_unlock();
+    }
+    return stmt;
+}
+
 sqlite3_stmt *db_prepare(const char *sql) {
-    if (!db_conn) {
+    if (!writer_conn) {
         fprintf(stderr, "Database not initialized\n");
         return NULL;
     }
     
+    if (thread_writer_depth > 0) {
+        return prepare_on_writer(sql);
+    }
+    
+    sqlite3 *conn = reader_connection();
+    if (!conn) {
+        return NULL;
+    }
+    
     sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(db_conn, sql, -1, &stmt, NULL);
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db_conn));
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(conn));
         return NULL;
     }
+    
+    if (stmt && !sqlite3_stmt_readonly(stmt)) {
+        sqlite3_finalize(stmt);
+        return prepare_on_writer(sql);
+    }
     return stmt;
 }
 
@@ -130,10 +401,150 @@ int db_step(sqlite3_stmt *stmt) {
 
 void db_finalize(sqlite3_stmt *stmt) {
     if (stmt) {
+        sqlite3 *conn = sqlite3_db_handle(stmt);
         sqlite3_finalize(stmt);
+        if (conn == writer_conn) {
+            db_write_unlock();
+        }
     }
 }
 
+int64_t db_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int get_user_version(void) {
+    long long version = 0;
+    db_write_lock();
+    query_pragma_int(db_get_connection(), "PRAGMA user_version;", &version);
+    db_write_unlock();
+    return (int)version;
+}
+
+static int set_user_version(int version) {
+    char sql[64];
+    snprintf(sql, sizeof(sql), "PRAGMA user_version=%d;", version);
+    return db_exec(sql);
+}
+
+/*
+ * Schema 1: created_at/expires_at used to be DATETIME text. Rewrite them in
+ * place as Unix milliseconds, DB_MIGRATE_BATCH rows per transaction so the
+ * write lock is never held for long on a large database.
+ */
+static int migrate_timestamps(void) {
+    static const char *const columns[][2] = {
+        {"boards", "created_at"},
+        {"threads", "created_at"},
+        {"posts", "created_at"},
+        {"admin_users", "created_at"},
+        {"admin_sessions", "created_at"},
+        {"admin_sessions", "expires_at"},
+    };
+    char sql[512];
+    long long converted = 0;
+    
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+        const char *table = columns[i][0];
+        const char *column = columns[i][1];
+        
+        snprintf(sql, sizeof(sql),
+                 "UPDATE %s SET %s = COALESCE(CAST(ROUND((julianday(%s) - 2440587.5) * 86400000) AS INTEGER), 0) "
+                 "WHERE rowid IN (SELECT rowid FROM %s WHERE typeof(%s) = 'text' LIMIT %d);",
+                 table, column, column, table, column, DB_MIGRATE_BATCH);
+        
+        for (;;) {
+            db_write_lock();
+            sqlite3 *conn = db_get_connection();
+            char *err_msg = NULL;
+            int rc = sqlite3_exec(conn, sql, NULL, NULL, &err_msg);
+            int changed = sqlite3_changes(conn);
+            db_write_unlock();
+            
+            if (rc != SQLITE_OK) {
+                fprintf(stderr, "Failed to convert %s.%s: %s\n", table, column, err_msg);
+                sqlite3_free(err_msg);
+                return -1;
+            }
+            if (changed == 0) {
+                break;
+            }
+            converted += changed;
+        }
+    }
+    
+    if (converted > 0) {
+        printf("Converted %lld timestamps to Unix milliseconds\n", converted);
+    }
+    return 0;
+}
+
+static int column_exists(const char *table, const char *column) {
+    char sql[128];
+    snprintf(sql, sizeof(sql), "SELECT 1 FROM pragma_table_info('%s') WHERE name = ?", table);
+    
+    sqlite3_stmt *stmt = db_prepare(sql);
+    if (!stmt) {
+        return 0;
+    }
+    sqlite3_bind_text(stmt, 1, column, -1, SQLITE_STATIC);
+    int exists = db_step(stmt) == SQLITE_ROW;
+    db_finalize(stmt);
+    return exists;
+}
+
+/*
+ * Schema 2: posts.content_html stores the escaped content so thread pages
+ * can emit it as is. Older rows are filled in DB_MIGRATE_BATCH at a time.
+ */
+static int migrate_content_html(void) {
+    if (!column_exists("posts", "content_html") &&
+        db_exec("ALTER TABLE posts ADD COLUMN content_html TEXT;") != 0) {
+        return -1;
+    }
+    
+    /* Walk rowid ranges so each batch starts where the last one ended
+     * instead of rescanning rows that are already filled. */
+    sqlite3_stmt *stmt = db_prepare("SELECT COALESCE(MAX(rowid), 0) FROM posts");
+    if (!stmt) {
+        return -1;
+    }
+    int64_t max_rowid = db_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+    db_finalize(stmt);
+    
+    const char *sql =
+        "UPDATE posts SET content_html = " DB_ESCAPE_HTML_SQL("content") " "
+        "WHERE rowid > ? AND rowid <= ? AND content_html IS NULL";
+    long long filled = 0;
+    
+    for (int64_t start = 0; start < max_rowid; start += DB_MIGRATE_BATCH) {
+        db_write_lock();
+        sqlite3 *conn = db_get_connection();
+        sqlite3_stmt *update = NULL;
+        int rc = sqlite3_prepare_v2(conn, sql, -1, &update, NULL);
+        if (rc == SQLITE_OK) {
+            sqlite3_bind_int64(update, 1, start);
+            sqlite3_bind_int64(update, 2, start + DB_MIGRATE_BATCH);
+            rc = sqlite3_step(update);
+            filled += sqlite3_changes(conn);
+        }
+        sqlite3_finalize(update);
+        db_write_unlock();
+        
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "Failed to fill posts.content_html: %s\n", sqlite3_errmsg(conn));
+            return -1;
+        }
+    }
+    
+    if (filled > 0) {
+        printf("Filled content_html for %lld posts\n", filled);
+    }
+    return 0;
+}
+
 int db_migrate(void) {
     printf("Running database migrations...\n");
     
@@ -143,13 +554,13 @@ int db_migrate(void) {
         "    name TEXT NOT NULL UNIQUE,"
         "    title TEXT NOT NULL,"
         "    description TEXT,"
-        "    created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL ")"
         ");"
         "CREATE TABLE IF NOT EXISTS threads ("
         "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "    board_id INTEGER NOT NULL,"
         "    subject TEXT NOT NULL,"
-        "    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL "),"
         "    FOREIGN KEY (board_id) REFERENCES boards(id)"
         ");"
         "CREATE TABLE IF NOT EXISTS posts ("
@@ -157,8 +568,9 @@ int db_migrate(void) {
         "    thread_id INTEGER NOT NULL,"
         "    author TEXT,"
         "    content TEXT NOT NULL,"
+        "    content_html TEXT,"
         "    reply_to INTEGER,"
-        "    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL "),"
         "    FOREIGN KEY (thread_id) REFERENCES threads(id),"
         "    FOREIGN KEY (reply_to) REFERENCES posts(id)"
         ");"
@@ -166,15 +578,42 @@ int db_migrate(void) {
         "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "    username TEXT NOT NULL UNIQUE,"
         "    password TEXT NOT NULL,"
-        "    created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL ")"
         ");"
         "CREATE TABLE IF NOT EXISTS admin_sessions ("
         "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "    user_id INTEGER NOT NULL,"
         "    token TEXT NOT NULL UNIQUE,"
-        "    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "    expires_at DATETIME NOT NULL,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL "),"
+        "    expires_at INTEGER NOT NULL,"
         "    FOREIGN KEY (user_id) REFERENCES admin_users(id)"
+        ");"
+        "CREATE TABLE IF NOT EXISTS uploads ("
+        "    hash TEXT PRIMARY KEY,"
+        "    size INTEGER NOT NULL,"
+        "    content_type TEXT NOT NULL,"
+        "    ref_count INTEGER NOT NULL DEFAULT 1,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL ")"
+        ");"
+        "CREATE TABLE IF NOT EXISTS upload_sessions ("
+        "    id TEXT PRIMARY KEY,"
+        "    length INTEGER NOT NULL,"
+        "    filename TEXT NOT NULL,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL "),"
+        "    expires_at INTEGER NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS attachments ("
+        "    id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "    post_id INTEGER NOT NULL,"
+        "    hash TEXT NOT NULL,"
+        "    filename TEXT NOT NULL,"
+        "    content_type TEXT NOT NULL,"
+        "    size INTEGER NOT NULL,"
+        "    width INTEGER,"
+        "    height INTEGER,"
+        "    created_at INTEGER NOT NULL DEFAULT (" DB_NOW_MS_SQL "),"
+        "    FOREIGN KEY (post_id) REFERENCES posts(id),"
+        "    FOREIGN KEY (hash) REFERENCES uploads(hash)"
         ");";
     
     int rc = db_exec(create_tables_sql);
@@ -183,6 +622,36 @@ int db_migrate(void) {
         return -1;
     }
     
+    int version = get_user_version();
+    if (version < 1) {
+        if (migrate_timestamps() != 0 || set_user_version(1) != 0) {
+            fprintf(stderr, "Failed to migrate timestamps\n");
+            return -1;
+        }
+    }
+    if (version < 2) {
+        if (migrate_content_html() != 0 || set_user_version(2) != 0) {
+            fprintf(stderr, "Failed to migrate post content\n");
+            return -1;
+        }
+    }
+    
+    /* (parent, created_at, id) lets list queries walk the index in order and
+     * page with a keyset instead of OFFSET. (thread_id, id) serves the
+     * "posts since" range scan polled by open thread pages. */
+    rc = db_exec(
+        "CREATE INDEX IF NOT EXISTS idx_threads_board_created ON threads (board_id, created_at, id);"
+        "CREATE INDEX IF NOT EXISTS idx_posts_thread_created ON posts (thread_id, created_at, id);"
+        "CREATE INDEX IF NOT EXISTS idx_posts_thread_id ON posts (thread_id, id);"
+        "CREATE INDEX IF NOT EXISTS idx_admin_sessions_expires ON admin_sessions (expires_at);"
+        "CREATE INDEX IF NOT EXISTS idx_upload_sessions_expires ON upload_sessions (expires_at);"
+        "CREATE UNIQUE INDEX IF NOT EXISTS idx_attachments_post ON attachments (post_id);"
+    );
+    if (rc != 0) {
+        fprintf(stderr, "Failed to create indexes\n");
+        return -1;
+    }
+    
     const char *check_admin_sql = "SELECT COUNT(*) FROM admin_users";
     sqlite3_stmt *stmt = db_prepare(check_admin_sql);
     int admin_count = 0;
@@ -196,7 +665,8 @@ int db_migrate(void) {
     if (admin_count == 0) {
         printf("Creating default admin user (username: admin, password: admin)\n");
         const char *insert_admin_sql = 
-            "INSERT INTO admin_users (username, password) VALUES ('admin', 'admin')";
+            "INSERT INTO admin_users (username, password, created_at) "
+            "VALUES ('admin', 'admin', " DB_NOW_MS_SQL ")";
         db_exec(insert_admin_sql);
     }
     
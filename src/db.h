@@ -3,17 +3,63 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include "sqlite3.h"
 
+typedef struct {
+    const char *name;
+    long long mmap_size;    /* bytes; -1 sizes the mapping to the database file */
+    int cache_size;         /* PRAGMA cache_size value per connection */
+    int temp_store_memory;
+    int page_size;          /* only applied when the database file is created */
+} db_profile_t;
+
+/* Selects a storage profile by name ("safe", "read-heavy"); call before
+ * db_init. Returns -1 for an unknown name. */
+int db_set_profile(const char *name);
+const db_profile_t *db_get_profile(void);
+
+/* How long every connection waits for a lock before SQLITE_BUSY. */
+#define DB_BUSY_TIMEOUT_MS 5000
+
 int db_init(const char *db_path);
 void db_close(void);
+
+/* Returns the writer connection while the calling thread holds the write
+ * lock, otherwise the calling thread's own read connection. */
 sqlite3 *db_get_connection(void);
 
+/* Serialise access to the writer connection. Recursive per thread, so a
+ * caller can wrap BEGIN/COMMIT around statements prepared with db_prepare. */
+void db_write_lock(void);
+void db_write_unlock(void);
+
+/* Time the write lock was last released after rows were inserted, updated
+ * or deleted; used to detect idle periods. */
+time_t db_last_write_time(void);
+const char *db_get_path(void);
+
+/* db_exec always runs on the writer. db_prepare uses the thread's reader and
+ * moves non-read-only statements to the writer, holding the write lock until
+ * the statement is passed to db_finalize. */
 int db_exec(const char *sql);
 sqlite3_stmt *db_prepare(const char *sql);
 int db_step(sqlite3_stmt *stmt);
 void db_finalize(sqlite3_stmt *stmt);
 
+/* Timestamps (created_at, expires_at) are INTEGER Unix milliseconds. Inserts
+ * should set them explicitly: databases migrated from the old DATETIME
+ * schema still carry a text CURRENT_TIMESTAMP column default. */
+#define DB_NOW_MS_SQL "CAST(ROUND((julianday('now') - 2440587.5) * 86400000) AS INTEGER)"
+int64_t db_now_ms(void);
+
+/* posts.content_html holds content escaped exactly like render_escape_html()
+ * at write time. This is the same escaping in SQL, for the backfill and for
+ * rows written without it. */
+#define DB_ESCAPE_HTML_SQL(column) \
+    "replace(replace(replace(replace(replace(" column ", '&', '&amp;'), " \
+    "'<', '&lt;'), '>', '&gt;'), '\"', '&quot;'), '''', '&#39;')"
+
 int db_migrate(void);
 
 #endif
@@ -0,0 +1,231 @@
+#include "fragment_cache.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHARD_COUNT 16
+#define SHARD_BUCKETS 1024
+
+typedef struct fragment {
+    int64_t post_id;
+    int64_t quoted_id;
+    language_t lang;
+    size_t len;
+    struct fragment *hash_next;
+    struct fragment *lru_prev;      /* towards the most recently used */
+    struct fragment *lru_next;
+    char html[];
+} fragment_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    fragment_t *buckets[SHARD_BUCKETS];
+    fragment_t *lru_head;
+    fragment_t *lru_tail;
+    size_t bytes;
+    size_t max_bytes;
+    int64_t hits;
+    int64_t misses;
+    int64_t evictions;
+    int64_t entries;
+} shard_t;
+
+static shard_t shards[SHARD_COUNT];
+static int cache_ready = 0;
+
+static uint64_t fragment_hash(int64_t post_id, language_t lang) {
+    return ((uint64_t)post_id * 2 + (uint64_t)lang) * 0x9E3779B97F4A7C15ULL;
+}
+
+static shard_t *shard_for(uint64_t hash) {
+    return &shards[hash >> 60];
+}
+
+static size_t fragment_size(const fragment_t *fragment) {
+    return sizeof(fragment_t) + fragment->len;
+}
+
+static void lru_unlink(shard_t *shard, fragment_t *fragment) {
+    if (fragment->lru_prev) {
+        fragment->lru_prev->lru_next = fragment->lru_next;
+    } else {
+        shard->lru_head = fragment->lru_next;
+    }
+    if (fragment->lru_next) {
+        fragment->lru_next->lru_prev = fragment->lru_prev;
+    } else {
+        shard->lru_tail = fragment->lru_prev;
+    }
+    fragment->lru_prev = NULL;
+    fragment->lru_next = NULL;
+}
+
+static void lru_push_front(shard_t *shard, fragment_t *fragment) {
+    fragment->lru_prev = NULL;
+    fragment->lru_next = shard->lru_head;
+    if (shard->lru_head) {
+        shard->lru_head->lru_prev = fragment;
+    } else {
+        shard->lru_tail = fragment;
+    }
+    shard->lru_head = fragment;
+}
+
+static fragment_t **find_slot(shard_t *shard, uint64_t hash, int64_t post_id, language_t lang) {
+    fragment_t **slot = &shard->buckets[hash & (SHARD_BUCKETS - 1)];
+    while (*slot && ((*slot)->post_id != post_id || (*slot)->lang != lang)) {
+        slot = &(*slot)->hash_next;
+    }
+    return slot;
+}
+
+static void remove_fragment(shard_t *shard, fragment_t *fragment) {
+    uint64_t hash = fragment_hash(fragment->post_id, fragment->lang);
+    fragment_t **slot = find_slot(shard, hash, fragment->post_id, fragment->lang);
+    if (*slot == fragment) {
+        *slot = fragment->hash_next;
+    }
+    lru_unlink(shard, fragment);
+    shard->bytes -= fragment_size(fragment);
+    shard->entries--;
+    free(fragment);
+}
+
+int fragment_cache_init(size_t max_bytes) {
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        memset(&shards[i], 0, sizeof(shard_t));
+        pthread_mutex_init(&shards[i].mutex, NULL);
+        shards[i].max_bytes = max_bytes / SHARD_COUNT;
+    }
+    cache_ready = 1;
+    
+    printf("Fragment cache initialized (%zu KB)\n", max_bytes / 1024);
+    return 0;
+}
+
+void fragment_cache_shutdown(void) {
+    if (!cache_ready) {
+        return;
+    }
+    cache_ready = 0;
+    
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        shard_t *shard = &shards[i];
+        while (shard->lru_head) {
+            remove_fragment(shard, shard->lru_head);
+        }
+        pthread_mutex_destroy(&shard->mutex);
+    }
+}
+
+int fragment_cache_get(int64_t post_id, language_t lang, char *dst, size_t dst_size) {
+    if (!cache_ready) {
+        return -1;
+    }
+    
+    uint64_t hash = fragment_hash(post_id, lang);
+    shard_t *shard = shard_for(hash);
+    int result = -1;
+    
+    pthread_mutex_lock(&shard->mutex);
+    fragment_t *fragment = *find_slot(shard, hash, post_id, lang);
+    if (fragment && fragment->len < dst_size) {
+        memcpy(dst, fragment->html, fragment->len);
+        dst[fragment->len] = '\0';
+        result = (int)fragment->len;
+        lru_unlink(shard, fragment);
+        lru_push_front(shard, fragment);
+        shard->hits++;
+    } else {
+        shard->misses++;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    
+    return result;
+}
+
+void fragment_cache_put(int64_t post_id, int64_t quoted_id, language_t lang,
+                        const char *html, size_t len) {
+    if (!cache_ready) {
+        return;
+    }
+    
+    uint64_t hash = fragment_hash(post_id, lang);
+    shard_t *shard = shard_for(hash);
+    
+    /* One oversized post must not flush the whole shard. */
+    if (sizeof(fragment_t) + len > shard->max_bytes / 8) {
+        return;
+    }
+    
+    fragment_t *fragment = malloc(sizeof(fragment_t) + len);
+    if (!fragment) {
+        return;
+    }
+    fragment->post_id = post_id;
+    fragment->quoted_id = quoted_id;
+    fragment->lang = lang;
+    fragment->len = len;
+    memcpy(fragment->html, html, len);
+    
+    pthread_mutex_lock(&shard->mutex);
+    
+    fragment_t **slot = find_slot(shard, hash, post_id, lang);
+    if (*slot) {
+        remove_fragment(shard, *slot);
+        slot = find_slot(shard, hash, post_id, lang);
+    }
+    fragment->hash_next = NULL;
+    *slot = fragment;
+    lru_push_front(shard, fragment);
+    shard->bytes += fragment_size(fragment);
+    shard->entries++;
+    
+    while (shard->bytes > shard->max_bytes && shard->lru_tail != fragment) {
+        remove_fragment(shard, shard->lru_tail);
+        shard->evictions++;
+    }
+    
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+void fragment_cache_invalidate(int64_t post_id) {
+    if (!cache_ready) {
+        return;
+    }
+    
+    /* Quoting fragments can live in any shard, so walk them all. This only
+     * runs on moderation actions. */
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        shard_t *shard = &shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        fragment_t *fragment = shard->lru_head;
+        while (fragment) {
+            fragment_t *next = fragment->lru_next;
+            if (fragment->post_id == post_id || fragment->quoted_id == post_id) {
+                remove_fragment(shard, fragment);
+            }
+            fragment = next;
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
+
+void fragment_cache_get_stats(fragment_cache_stats_t *stats) {
+    memset(stats, 0, sizeof(fragment_cache_stats_t));
+    if (!cache_ready) {
+        return;
+    }
+    
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        shard_t *shard = &shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->entries;
+        stats->bytes += (int64_t)shard->bytes;
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
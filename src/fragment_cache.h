@@ -0,0 +1,43 @@
+#ifndef FRAGMENT_CACHE_H
+#define FRAGMENT_CACHE_H
+
+#include "i18n.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * LRU cache of rendered post HTML keyed by (post id, language). Posts never
+ * change once written, so entries only leave the cache when the byte budget
+ * is exceeded or a post is invalidated. The cache is split into shards with
+ * their own lock and an equal share of the budget.
+ */
+
+#define FRAGMENT_CACHE_DEFAULT_BYTES (8 * 1024 * 1024)
+
+typedef struct {
+    int64_t hits;
+    int64_t misses;
+    int64_t evictions;
+    int64_t entries;
+    int64_t bytes;                  /* fragments plus bookkeeping */
+} fragment_cache_stats_t;
+
+int fragment_cache_init(size_t max_bytes);
+void fragment_cache_shutdown(void);
+
+/* Copies the cached fragment into dst. Returns its length, or -1 when it is
+ * not cached or does not fit in dst_size. */
+int fragment_cache_get(int64_t post_id, language_t lang, char *dst, size_t dst_size);
+
+/* Caches a fragment for post_id. quoted_id is the post whose text the
+ * fragment quotes (0 for none), so invalidating it drops this one too. */
+void fragment_cache_put(int64_t post_id, int64_t quoted_id, language_t lang,
+                        const char *html, size_t len);
+
+/* Drops every fragment showing post_id's text, in all languages. Call when
+ * moderation changes or removes a post. */
+void fragment_cache_invalidate(int64_t post_id);
+
+void fragment_cache_get_stats(fragment_cache_stats_t *stats);
+
+#endif
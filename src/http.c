@@ -1,27 +1,72 @@
+#define _POSIX_C_SOURCE 200809L
 #include "http.h"
 #include "router.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <sys/socket.h>
-#include <sys/select.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
 
-#define BUFFER_SIZE 8192
-#define BACKLOG 10
+#define HEADER_BUFFER_SIZE 8192
+/* Room for the headers plus any body the default route limit admits. */
+#define BUFFER_SIZE (HEADER_BUFFER_SIZE + ROUTER_MAX_BODY)
+#define BACKLOG 128
+#define WORKER_COUNT 8
+#define CLIENT_QUEUE_SIZE 256
+#define BODY_READ_TIMEOUT_S 30
+#define SEND_TIMEOUT_S 30
+#define LINGER_TIMEOUT_S 2
+#define LINGER_MAX_BYTES (1024 * 1024)
+#define LINGER_MAX_SOCKETS 256
+#define CONTINUE_RESPONSE "HTTP/1.1 100 Continue\r\n\r\n"
+
+struct http_writer {
+    int fd;
+    int chunked;                    /* 0 for HTTP/1.0 clients; close ends the body */
+    int failed;
+};
 
 static int server_fd = -1;
 static uint16_t server_port = 0;
 
+/* Accepted sockets waiting for a worker. The accept loop blocks when the
+ * queue is full, which pushes back onto the listen backlog. */
+static int client_queue[CLIENT_QUEUE_SIZE];
+static size_t queue_head = 0;
+static size_t queue_count = 0;
+static int queue_closed = 0;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+
+/* Refused connections still receiving a body, drained by the accept loop
+ * until the client stops sending or the deadline passes. Workers only
+ * append; the accept loop removes. */
+typedef struct {
+    int fd;
+    time_t deadline;
+    size_t drained;
+} lingering_t;
+
+static lingering_t lingering[LINGER_MAX_SOCKETS];
+static int lingering_count = 0;
+static pthread_mutex_t lingering_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static const char *get_status_message(int status_code) {
     switch (status_code) {
         case 200: return "OK";
         case 201: return "Created";
         case 204: return "No Content";
+        case 206: return "Partial Content";
         case 301: return "Moved Permanently";
         case 302: return "Found";
         case 304: return "Not Modified";
@@ -30,6 +75,10 @@ static const char *get_status_message(int status_code) {
         case 403: return "Forbidden";
         case 404: return "Not Found";
         case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 416: return "Range Not Satisfiable";
         case 500: return "Internal Server Error";
         case 502: return "Bad Gateway";
         case 503: return "Service Unavailable";
@@ -80,9 +129,9 @@ int http_server_init(uint16_t port) {
 }
 
 static int parse_request_line(const char *line, http_request_t *req) {
-    static char method[16];
-    static char path[1024];
-    static char query[1024];
+    static _Thread_local char method[16];
+    static _Thread_local char path[1024];
+    static _Thread_local char query[1024];
     
     char *space1 = strchr(line, ' ');
     if (!space1) return -1;
@@ -121,7 +170,61 @@ static int parse_request_line(const char *line, http_request_t *req) {
     return 0;
 }
 
-static void send_response(int client_fd, http_response_t *response) {
+static int write_all(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t written = writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+int http_writer_write(http_writer_t *writer, const char *data, size_t len) {
+    if (writer->failed) {
+        return -1;
+    }
+    if (len == 0) {
+        /* An empty chunk would end the body. */
+        return 0;
+    }
+    
+    char size_line[32];
+    struct iovec iov[3];
+    int iovcnt = 0;
+    
+    if (writer->chunked) {
+        int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+        iov[iovcnt].iov_base = size_line;
+        iov[iovcnt++].iov_len = (size_t)size_len;
+    }
+    iov[iovcnt].iov_base = (void *)data;
+    iov[iovcnt++].iov_len = len;
+    if (writer->chunked) {
+        iov[iovcnt].iov_base = "\r\n";
+        iov[iovcnt++].iov_len = 2;
+    }
+    
+    if (write_all(writer->fd, iov, iovcnt) != 0) {
+        writer->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int http_response_send(int client_fd, http_response_t *response, int chunked, int head) {
     char header[2048];
     int header_len;
     
@@ -135,39 +238,209 @@ static void send_response(int client_fd, http_response_t *response) {
         content_type = content_type_with_charset;
     }
     
+    char length_header[64];
+    if (response->detach) {
+        length_header[0] = '\0';
+    } else if (!response->stream) {
+        snprintf(length_header, sizeof(length_header), "Content-Length: %zu\r\n", response->body_len);
+    } else if (chunked) {
+        snprintf(length_header, sizeof(length_header), "Transfer-Encoding: chunked\r\n");
+    } else {
+        length_header[0] = '\0';
+    }
+    
+    const char *extra_headers = response->headers ? response->headers : "";
+    
     if (response->set_cookie) {
         header_len = snprintf(header, sizeof(header),
                              "HTTP/1.1 %d %s\r\n"
                              "Content-Type: %s\r\n"
-                             "Content-Length: %zu\r\n"
+                             "%s"
+                             "%s"
                              "Set-Cookie: %s\r\n"
                              "Connection: close\r\n"
                              "\r\n",
                              response->status_code,
                              status_msg,
                              content_type,
-                             response->body_len,
+                             length_header,
+                             extra_headers,
                              response->set_cookie);
     } else {
         header_len = snprintf(header, sizeof(header),
                              "HTTP/1.1 %d %s\r\n"
                              "Content-Type: %s\r\n"
-                             "Content-Length: %zu\r\n"
+                             "%s"
+                             "%s"
                              "Connection: close\r\n"
                              "\r\n",
                              response->status_code,
                              status_msg,
                              content_type,
-                             response->body_len);
+                             length_header,
+                             extra_headers);
+    }
+    if (header_len < 0 || (size_t)header_len >= sizeof(header)) {
+        fprintf(stderr, "HTTP: response headers too long\n");
+        return 0;
+    }
+    
+    struct iovec iov[2];
+    int iovcnt = 0;
+    iov[iovcnt].iov_base = header;
+    iov[iovcnt++].iov_len = (size_t)header_len;
+    if (!head && !response->stream && !response->detach && response->body && response->body_len > 0) {
+        iov[iovcnt].iov_base = response->body;
+        iov[iovcnt++].iov_len = response->body_len;
+    }
+    if (write_all(client_fd, iov, iovcnt) != 0) {
+        return 0;
+    }
+    
+    if (response->detach) {
+        response->detach(client_fd, response->stream_ctx);
+        return 1;
+    }
+    
+    if (response->stream && !head) {
+        http_writer_t writer = { client_fd, chunked, 0 };
+        if (response->stream(&writer, response->stream_ctx) == 0 && !writer.failed && chunked) {
+            struct iovec last = { "0\r\n\r\n", 5 };
+            write_all(client_fd, &last, 1);
+        }
+    }
+    return 0;
+}
+
+/* Copies the value of the header called name (matched without regard to
+ * case, at the start of a line) into buf. Returns buf, or NULL when the
+ * header is missing or does not fit. */
+static const char *copy_header(const char *headers, const char *headers_end,
+                               const char *name, char *buf, size_t size) {
+    size_t name_len = strlen(name);
+    const char *line = headers;
+    while (line < headers_end) {
+        const char *line_end = strstr(line, "\r\n");
+        if (!line_end || line_end > headers_end) {
+            line_end = headers_end;
+        }
+        if ((size_t)(line_end - line) > name_len && strncasecmp(line, name, name_len) == 0) {
+            const char *value = line + name_len;
+            while (value < line_end && *value == ' ') {
+                value++;
+            }
+            size_t len = (size_t)(line_end - value);
+            if (len >= size) {
+                return NULL;
+            }
+            memcpy(buf, value, len);
+            buf[len] = '\0';
+            return buf;
+        }
+        line = line_end + 2;
+    }
+    return NULL;
+}
+
+long http_request_read_body(http_request_t *req, char *buf, size_t len) {
+    http_body_t *body = req->body_reader;
+    if (!body || len == 0) {
+        return 0;
     }
     
-    write(client_fd, header, header_len);
+    if (body->buffered_len > 0) {
+        size_t take = len < body->buffered_len ? len : body->buffered_len;
+        memcpy(buf, body->buffered, take);
+        body->buffered += take;
+        body->buffered_len -= take;
+        return (long)take;
+    }
     
-    if (response->body && response->body_len > 0) {
-        write(client_fd, response->body, response->body_len);
+    if (body->remaining == 0) {
+        return 0;
+    }
+    if (len > body->remaining) {
+        len = body->remaining;
+    }
+    for (;;) {
+        ssize_t n = read(body->fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        body->remaining -= (size_t)n;
+        return (long)n;
+    }
+}
+
+/* Reads and drops what has arrived without waiting for more. Returns 1
+ * once the socket can be closed: the client finished sending, went away
+ * or sent LINGER_MAX_BYTES. */
+static int lingering_drain(lingering_t *conn) {
+    char discard[4096];
+    for (;;) {
+        ssize_t n = recv(conn->fd, discard, sizeof(discard), MSG_DONTWAIT);
+        if (n > 0) {
+            conn->drained += (size_t)n;
+            if (conn->drained >= LINGER_MAX_BYTES) {
+                return 1;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : 1;
     }
 }
 
+/* Closes a connection whose request body was refused. A client that did
+ * not wait for 100 Continue may still be sending it, and closing with
+ * unread data resets the connection, which can destroy the response
+ * before the client reads it. So stop writing, drop what has arrived,
+ * and leave the rest to the accept loop rather than holding a worker. */
+static void lingering_close(int client_fd) {
+    shutdown(client_fd, SHUT_WR);
+    
+    lingering_t conn = { client_fd, time(NULL) + LINGER_TIMEOUT_S, 0 };
+    if (lingering_drain(&conn)) {
+        close(client_fd);
+        return;
+    }
+    
+    pthread_mutex_lock(&lingering_mutex);
+    int queued = lingering_count < LINGER_MAX_SOCKETS;
+    if (queued) {
+        lingering[lingering_count++] = conn;
+    }
+    pthread_mutex_unlock(&lingering_mutex);
+    if (!queued) {
+        close(client_fd);
+    }
+}
+
+/* Drains the first polled lingering connections, whose poll results are
+ * in fds, and closes those that are done or past their deadline. */
+static void lingering_step(const struct pollfd *fds, int polled) {
+    time_t now = time(NULL);
+    pthread_mutex_lock(&lingering_mutex);
+    /* Entries are only appended meanwhile, so the first polled still
+     * match fds. Walking down keeps that true as done ones are removed. */
+    for (int i = polled - 1; i >= 0; i--) {
+        int done = now >= lingering[i].deadline;
+        if (!done && fds[i].revents) {
+            done = lingering_drain(&lingering[i]);
+        }
+        if (done) {
+            close(lingering[i].fd);
+            lingering[i] = lingering[--lingering_count];
+        }
+    }
+    pthread_mutex_unlock(&lingering_mutex);
+}
+
 static void handle_client(int client_fd) {
     char buffer[BUFFER_SIZE];
     ssize_t bytes_read;
@@ -177,6 +450,11 @@ static void handle_client(int client_fd) {
     memset(&req, 0, sizeof(req));
     memset(buffer, 0, sizeof(buffer));
     
+    /* A client that stops reading may hold this worker only so long;
+     * streamed pages and files sent by the worker block on it. */
+    struct timeval send_timeout = { SEND_TIMEOUT_S, 0 };
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+    
     bytes_read = read(client_fd, buffer, sizeof(buffer) - 1);
     if (bytes_read <= 0) {
         close(client_fd);
@@ -189,7 +467,7 @@ static void handle_client(int client_fd) {
     if (!line_end) {
         const char *bad_request = "400 Bad Request";
         response = http_response_create(400, "text/plain", bad_request, strlen(bad_request));
-        send_response(client_fd, response);
+        http_response_send(client_fd, response, 0, 0);
         http_response_free(response);
         close(client_fd);
         return;
@@ -197,10 +475,13 @@ static void handle_client(int client_fd) {
     
     *line_end = '\0';
     
+    /* HTTP/1.0 clients cannot read chunked bodies. */
+    int chunked = strstr(buffer, " HTTP/1.0") == NULL;
+    
     if (parse_request_line(buffer, &req) < 0) {
         const char *bad_request = "400 Bad Request";
         response = http_response_create(400, "text/plain", bad_request, strlen(bad_request));
-        send_response(client_fd, response);
+        http_response_send(client_fd, response, 0, 0);
         http_response_free(response);
         close(client_fd);
         return;
@@ -210,11 +491,11 @@ static void handle_client(int client_fd) {
     char *body_start = strstr(headers_start, "\r\n\r\n");
     char *headers_end = body_start ? body_start : buffer + bytes_read;
     
-    if (body_start) {
-        body_start += 4;
-        size_t body_len = bytes_read - (body_start - buffer);
-        req.body = body_start;
-        req.body_len = body_len;
+    char length_buffer[32];
+    int has_length = copy_header(headers_start, headers_end, "Content-Length:",
+                                 length_buffer, sizeof(length_buffer)) != NULL;
+    if (has_length) {
+        req.content_length = (size_t)strtoull(length_buffer, NULL, 10);
     }
     
     char *content_type = strstr(headers_start, "Content-Type:");
@@ -223,7 +504,7 @@ static void handle_client(int client_fd) {
         while (*content_type == ' ') content_type++;
         char *type_end = strstr(content_type, "\r\n");
         if (type_end) {
-            static char ct_buffer[128];
+            static _Thread_local char ct_buffer[128];
             size_t ct_len = type_end - content_type;
             if (ct_len < sizeof(ct_buffer)) {
                 memcpy(ct_buffer, content_type, ct_len);
@@ -233,13 +514,28 @@ static void handle_client(int client_fd) {
         }
     }
     
+    static _Thread_local char range_buffer[128];
+    static _Thread_local char if_modified_since_buffer[64];
+    req.range = copy_header(headers_start, headers_end, "Range:",
+                            range_buffer, sizeof(range_buffer));
+    req.if_modified_since = copy_header(headers_start, headers_end, "If-Modified-Since:",
+                                        if_modified_since_buffer,
+                                        sizeof(if_modified_since_buffer));
+    
+    static _Thread_local char upload_length_buffer[32];
+    static _Thread_local char upload_offset_buffer[32];
+    req.upload_length = copy_header(headers_start, headers_end, "Upload-Length:",
+                                    upload_length_buffer, sizeof(upload_length_buffer));
+    req.upload_offset = copy_header(headers_start, headers_end, "Upload-Offset:",
+                                    upload_offset_buffer, sizeof(upload_offset_buffer));
+    
     char *cookie_header = strstr(headers_start, "Cookie:");
     if (cookie_header && cookie_header < headers_end) {
         cookie_header += 7;
         while (*cookie_header == ' ') cookie_header++;
         char *cookie_end = strstr(cookie_header, "\r\n");
         if (cookie_end) {
-            static char cookie_buffer[512];
+            static _Thread_local char cookie_buffer[512];
             size_t cookie_len = cookie_end - cookie_header;
             if (cookie_len < sizeof(cookie_buffer)) {
                 memcpy(cookie_buffer, cookie_header, cookie_len);
@@ -249,14 +545,123 @@ static void handle_client(int client_fd) {
         }
     }
     
-    response = router_dispatch(&req);
+    /* Refuse on the headers alone, before any more of the body is read;
+     * a client waiting on Expect: 100-continue then never sends it. */
+    const route_t *route = router_match(&req);
+    response = route ? router_admit(route, &req) : router_handle(NULL, &req);
+    if (response) {
+        http_response_send(client_fd, response, chunked, strcmp(req.method, "HEAD") == 0);
+        http_response_free(response);
+        size_t buffered = body_start ? (size_t)(buffer + bytes_read - (body_start + 4)) : 0;
+        if (req.content_length > buffered) {
+            lingering_close(client_fd);
+        } else {
+            close(client_fd);
+        }
+        return;
+    }
+    
+    char expect_buffer[32];
+    if (chunked && copy_header(headers_start, headers_end, "Expect:",
+                               expect_buffer, sizeof(expect_buffer)) &&
+        strcasecmp(expect_buffer, "100-continue") == 0 && req.content_length > 0) {
+        struct iovec iov = { (void *)CONTINUE_RESPONSE, strlen(CONTINUE_RESPONSE) };
+        if (write_all(client_fd, &iov, 1) != 0) {
+            close(client_fd);
+            return;
+        }
+    }
+    
+    /* A stalled client may hold this worker only so long. */
+    struct timeval timeout = { BODY_READ_TIMEOUT_S, 0 };
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     
+    http_body_t body_reader = { client_fd, NULL, 0, 0 };
+    if (body_start) {
+        body_start += 4;
+        size_t body_len = bytes_read - (body_start - buffer);
+        
+        /* Finish bodies that fit in the buffer, so form handlers see them
+         * whole even when they arrive in several segments. */
+        while (body_len < req.content_length &&
+               (size_t)bytes_read < sizeof(buffer) - 1) {
+            ssize_t n = read(client_fd, buffer + bytes_read, sizeof(buffer) - 1 - bytes_read);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            bytes_read += n;
+            body_len += (size_t)n;
+        }
+        if (has_length && body_len > req.content_length) {
+            body_len = req.content_length;
+        }
+        body_start[body_len] = '\0';
+        
+        req.body = body_start;
+        req.body_len = body_len;
+        body_reader.buffered = body_start;
+        body_reader.buffered_len = body_len;
+        body_reader.remaining = has_length ? req.content_length - body_len : 0;
+    }
+    req.body_reader = &body_reader;
+    
+    response = router_handle(route, &req);
+    
+    int detached = 0;
     if (response) {
-        send_response(client_fd, response);
+        detached = http_response_send(client_fd, response, chunked, strcmp(req.method, "HEAD") == 0);
         http_response_free(response);
     }
     
-    close(client_fd);
+    if (!detached) {
+        close(client_fd);
+    }
+}
+
+static int queue_push(int client_fd) {
+    pthread_mutex_lock(&queue_mutex);
+    while (queue_count == CLIENT_QUEUE_SIZE && !queue_closed) {
+        pthread_cond_wait(&queue_not_full, &queue_mutex);
+    }
+    if (queue_closed) {
+        pthread_mutex_unlock(&queue_mutex);
+        return -1;
+    }
+    client_queue[(queue_head + queue_count) % CLIENT_QUEUE_SIZE] = client_fd;
+    queue_count++;
+    pthread_cond_signal(&queue_not_empty);
+    pthread_mutex_unlock(&queue_mutex);
+    return 0;
+}
+
+static int queue_pop(void) {
+    pthread_mutex_lock(&queue_mutex);
+    while (queue_count == 0 && !queue_closed) {
+        pthread_cond_wait(&queue_not_empty, &queue_mutex);
+    }
+    if (queue_count == 0) {
+        pthread_mutex_unlock(&queue_mutex);
+        return -1;
+    }
+    int client_fd = client_queue[queue_head];
+    queue_head = (queue_head + 1) % CLIENT_QUEUE_SIZE;
+    queue_count--;
+    pthread_cond_signal(&queue_not_full);
+    pthread_mutex_unlock(&queue_mutex);
+    return client_fd;
+}
+
+static void *worker_main(void *arg) {
+    (void)arg;
+    
+    int client_fd;
+    while ((client_fd = queue_pop()) >= 0) {
+        handle_client(client_fd);
+    }
+    return NULL;
 }
 
 void http_server_run(volatile int *keep_running) {
@@ -265,34 +670,61 @@ void http_server_run(volatile int *keep_running) {
         return;
     }
     
-    printf("HTTP server running on port %u\n", server_port);
+    pthread_t workers[WORKER_COUNT];
+    size_t worker_count = 0;
+    
+    queue_head = 0;
+    queue_count = 0;
+    queue_closed = 0;
+    
+    for (size_t i = 0; i < WORKER_COUNT; i++) {
+        if (pthread_create(&workers[worker_count], NULL, worker_main, NULL) != 0) {
+            fprintf(stderr, "Failed to start worker thread: %s\n", strerror(errno));
+            continue;
+        }
+        worker_count++;
+    }
+    
+    if (worker_count == 0) {
+        fprintf(stderr, "No worker threads available\n");
+        return;
+    }
+    
+    printf("HTTP server running on port %u (%zu workers)\n", server_port, worker_count);
     printf("Press Ctrl+C to stop\n");
     
+    static struct pollfd fds[LINGER_MAX_SOCKETS + 1];
     while (*keep_running) {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
         int client_fd;
         
-        fd_set read_fds;
-        struct timeval tv;
-        
-        FD_ZERO(&read_fds);
-        FD_SET(server_fd, &read_fds);
-        
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
+        /* The listening socket first, then the lingering connections. */
+        fds[0].fd = server_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        pthread_mutex_lock(&lingering_mutex);
+        int polled = lingering_count;
+        for (int i = 0; i < polled; i++) {
+            fds[i + 1].fd = lingering[i].fd;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+        pthread_mutex_unlock(&lingering_mutex);
         
-        int select_result = select(server_fd + 1, &read_fds, NULL, NULL, &tv);
+        int poll_result = poll(fds, (nfds_t)polled + 1, 1000);
         
-        if (select_result < 0) {
+        if (poll_result < 0) {
             if (errno == EINTR) {
                 continue;
             }
-            fprintf(stderr, "select() error: %s\n", strerror(errno));
+            fprintf(stderr, "poll() error: %s\n", strerror(errno));
             break;
         }
         
-        if (select_result == 0) {
+        lingering_step(fds + 1, polled);
+        
+        if (!(fds[0].revents & POLLIN)) {
             continue;
         }
         
@@ -305,8 +737,26 @@ void http_server_run(volatile int *keep_running) {
             continue;
         }
         
-        handle_client(client_fd);
+        if (queue_push(client_fd) != 0) {
+            close(client_fd);
+        }
     }
+    
+    pthread_mutex_lock(&queue_mutex);
+    queue_closed = 1;
+    pthread_cond_broadcast(&queue_not_empty);
+    pthread_cond_broadcast(&queue_not_full);
+    pthread_mutex_unlock(&queue_mutex);
+    
+    for (size_t i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    
+    pthread_mutex_lock(&lingering_mutex);
+    while (lingering_count > 0) {
+        close(lingering[--lingering_count].fd);
+    }
+    pthread_mutex_unlock(&lingering_mutex);
 }
 
 void http_server_shutdown(void) {
@@ -326,6 +776,11 @@ http_response_t *http_response_create(int status_code, const char *content_type,
     response->status_code = status_code;
     response->content_type = content_type;
     response->set_cookie = NULL;
+    response->headers = NULL;
+    response->stream = NULL;
+    response->detach = NULL;
+    response->stream_ctx = NULL;
+    response->stream_free = NULL;
     
     if (body && body_len > 0) {
         response->body = malloc(body_len);
@@ -344,14 +799,64 @@ http_response_t *http_response_create(int status_code, const char *content_type,
     return response;
 }
 
+http_response_t *http_response_create_stream(int status_code, const char *content_type,
+                                             http_stream_fn stream, void *ctx,
+                                             void (*free_ctx)(void *ctx)) {
+    http_response_t *response = http_response_create(status_code, content_type, NULL, 0);
+    if (!response) {
+        if (free_ctx) {
+            free_ctx(ctx);
+        }
+        return NULL;
+    }
+    
+    response->stream = stream;
+    response->stream_ctx = ctx;
+    response->stream_free = free_ctx;
+    return response;
+}
+
+http_response_t *http_response_create_detached(int status_code, const char *content_type,
+                                               http_detach_fn detach, void *ctx,
+                                               void (*free_ctx)(void *ctx)) {
+    http_response_t *response = http_response_create(status_code, content_type, NULL, 0);
+    if (!response) {
+        if (free_ctx) {
+            free_ctx(ctx);
+        }
+        return NULL;
+    }
+    
+    response->detach = detach;
+    response->stream_ctx = ctx;
+    response->stream_free = free_ctx;
+    return response;
+}
+
+int http_response_add_header(http_response_t *response, const char *name, const char *value) {
+    size_t old_len = response->headers ? strlen(response->headers) : 0;
+    size_t add_len = strlen(name) + strlen(value) + 4;
+    char *headers = realloc(response->headers, old_len + add_len + 1);
+    if (!headers) {
+        return -1;
+    }
+    snprintf(headers + old_len, add_len + 1, "%s: %s\r\n", name, value);
+    response->headers = headers;
+    return 0;
+}
+
 void http_response_free(http_response_t *response) {
     if (response) {
+        if (response->stream_free) {
+            response->stream_free(response->stream_ctx);
+        }
         if (response->body) {
             free(response->body);
         }
         if (response->set_cookie) {
             free(response->set_cookie);
         }
+        free(response->headers);
         free(response);
     }
 }
@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct http_body http_body_t;
+
 typedef struct {
     const char *method;
     const char *path;
@@ -12,14 +14,54 @@ typedef struct {
     size_t body_len;
     const char *content_type;
     const char *cookies;
+    const char *range;              /* Range header, or NULL */
+    const char *if_modified_since;  /* If-Modified-Since header, or NULL */
+    const char *upload_length;      /* Upload-Length header, or NULL */
+    const char *upload_offset;      /* Upload-Offset header, or NULL */
+    size_t content_length;          /* from Content-Length, 0 when absent */
+    http_body_t *body_reader;       /* see http_request_read_body() */
 } http_request_t;
 
+/* Where the rest of a request body comes from. Set up by the server for
+ * each request; tests fill one in to feed handlers a body. */
+struct http_body {
+    int fd;
+    const char *buffered;           /* body bytes read with the headers */
+    size_t buffered_len;
+    size_t remaining;               /* bytes still expected from fd */
+};
+
+/* Reads up to len bytes of the request body: first what arrived with the
+ * headers, then from the socket, stopping at Content-Length. body and
+ * body_len only hold what fitted in the request buffer, so handlers that
+ * accept large bodies read them here instead. Returns the byte count, 0
+ * at the end of the body, or -1 when the client stalls or goes away. */
+long http_request_read_body(http_request_t *req, char *buf, size_t len);
+
+/*
+ * Streaming responses. Instead of a body, the handler returns a stream
+ * callback that http_response_send() runs once the headers are out. Each
+ * http_writer_write() goes to the client as one chunk of a chunked
+ * transfer, so the page head can leave before the rest is rendered.
+ */
+typedef struct http_writer http_writer_t;
+typedef int (*http_stream_fn)(http_writer_t *writer, void *ctx);
+
+/* Takes over a connection once the headers are sent, for responses that
+ * outlive the request such as event streams. The new owner closes it. */
+typedef void (*http_detach_fn)(int client_fd, void *ctx);
+
 typedef struct {
     int status_code;
     const char *content_type;
     char *body;
     size_t body_len;
     char *set_cookie;
+    char *headers;                  /* extra "Name: value\r\n" lines, or NULL */
+    http_stream_fn stream;          /* NULL for a buffered body */
+    http_detach_fn detach;          /* NULL unless the socket is handed off */
+    void *stream_ctx;               /* passed to stream or detach */
+    void (*stream_free)(void *ctx); /* releases stream_ctx, may be NULL */
 } http_response_t;
 
 int http_server_init(uint16_t port);
@@ -29,4 +71,33 @@ void http_server_shutdown(void);
 http_response_t *http_response_create(int status_code, const char *content_type, const char *body, size_t body_len);
 void http_response_free(http_response_t *response);
 
+/* Creates a response whose body is produced by stream(writer, ctx). The
+ * callback returns 0, or -1 to abort; an aborted response is cut off
+ * without its final chunk so clients see it as incomplete. free_ctx runs
+ * when the response is freed, whether or not the stream ran. */
+http_response_t *http_response_create_stream(int status_code, const char *content_type,
+                                             http_stream_fn stream, void *ctx,
+                                             void (*free_ctx)(void *ctx));
+
+/* Creates a response whose connection is passed to detach(fd, ctx) after
+ * the headers. Unless a Content-Length header is added, the body is
+ * unframed and ends when the new owner closes the socket. free_ctx runs
+ * when the response is freed. */
+http_response_t *http_response_create_detached(int status_code, const char *content_type,
+                                               http_detach_fn detach, void *ctx,
+                                               void (*free_ctx)(void *ctx));
+
+/* Appends a "name: value" header line. Returns 0, or -1 when memory runs
+ * out. */
+int http_response_add_header(http_response_t *response, const char *name, const char *value);
+
+/* Writes response to client_fd: headers, then the body, stream or hand-off.
+ * chunked is 0 for HTTP/1.0 clients, whose streamed bodies go out raw and
+ * end at close; a response to HEAD gets its headers only. Returns 1 when
+ * the connection was handed off and must stay open. */
+int http_response_send(int client_fd, http_response_t *response, int chunked, int head);
+
+/* Sends len bytes as one chunk. Returns 0, or -1 when the client is gone. */
+int http_writer_write(http_writer_t *writer, const char *data, size_t len);
+
 #endif
@@ -54,6 +54,11 @@ static const translation_t translations[] = {
     {"thread_not_found", "Thread Not Found", "主题未找到"},
     {"out_of_memory", "Out of memory", "内存不足"},
     {"no_form_data", "No form data", "没有表单数据"},
+    {"form_too_large", "Form data too large", "表单数据过大"},
+    {"attachment", "Image (optional)", "图片（可选）"},
+    {"attachment_unsupported", "Attachments must be PNG, JPEG, GIF or WebP images", "附件必须是 PNG、JPEG、GIF 或 WebP 图片"},
+    {"attachment_too_large", "Attachment too large", "附件过大"},
+    {"attachment_failed", "Failed to store attachment", "保存附件失败"},
     {"required_fields", "Name and title are required", "名称和标题为必填项"},
     {"admin_only", "Only administrators can create boards.", "只有管理员可以创建版块。"},
     {"statistics", "Statistics", "统计信息"},
@@ -84,6 +89,12 @@ static const translation_t translations[] = {
     {"language", "Language", "语言"},
     {"english", "English", "英文"},
     {"chinese", "中文（简体）", "中文（简体）"},
+    {"search", "Search", "搜索"},
+    {"search_placeholder", "Search posts and threads", "搜索帖子和主题"},
+    {"matching_threads", "Matching Threads", "匹配的主题"},
+    {"no_results", "No results found.", "未找到结果。"},
+    {"prev_page", "Previous", "上一页"},
+    {"next_page", "Next", "下一页"},
     {NULL, NULL, NULL}
 };
 
@@ -92,7 +103,7 @@ static char *get_cookie_value(const char *cookies, const char *name) {
         return NULL;
     }
     
-    static char value[64];
+    static _Thread_local char value[64];
     char search_name[64];
     snprintf(search_name, sizeof(search_name), "%s=", name);
     
@@ -0,0 +1,166 @@
+#include "id_filter.h"
+#include "db.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Bitmaps are split into lazily allocated 8 KB segments of 65536 ids, so
+ * the filter grows with the id space. Ids past the last segment are always
+ * reported as possibly existing. */
+#define SEGMENT_BITS 65536
+#define SEGMENT_WORDS (SEGMENT_BITS / 64)
+#define MAX_SEGMENTS 16384
+
+#define MISS_CACHE_BITS 12
+#define MISS_CACHE_SLOTS (1 << MISS_CACHE_BITS)
+
+typedef atomic_uint_fast64_t bitmap_word_t;
+
+typedef struct {
+    atomic_int_fast64_t key;
+    atomic_int_fast64_t expires_at;
+} miss_slot_t;
+
+static _Atomic(bitmap_word_t *) segments[2][MAX_SEGMENTS];
+static atomic_int filter_loaded = 0;
+static miss_slot_t miss_cache[MISS_CACHE_SLOTS];
+
+static int64_t miss_key(id_filter_kind_t kind, int64_t id) {
+    return (id << 1) | (int64_t)kind;
+}
+
+static miss_slot_t *miss_slot(int64_t key) {
+    uint64_t hash = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+    return &miss_cache[hash >> (64 - MISS_CACHE_BITS)];
+}
+
+static bitmap_word_t *get_segment(id_filter_kind_t kind, size_t index, int create) {
+    bitmap_word_t *segment = atomic_load_explicit(&segments[kind][index], memory_order_acquire);
+    if (segment || !create) {
+        return segment;
+    }
+    
+    bitmap_word_t *fresh = calloc(SEGMENT_WORDS, sizeof(bitmap_word_t));
+    if (!fresh) {
+        return NULL;
+    }
+    if (!atomic_compare_exchange_strong(&segments[kind][index], &segment, fresh)) {
+        /* Another writer installed it first; segment now holds theirs. */
+        free(fresh);
+        return segment;
+    }
+    return fresh;
+}
+
+void id_filter_add(id_filter_kind_t kind, int64_t id) {
+    if (id <= 0 || id / SEGMENT_BITS >= MAX_SEGMENTS) {
+        return;
+    }
+    
+    bitmap_word_t *segment = get_segment(kind, (size_t)(id / SEGMENT_BITS), 1);
+    if (!segment) {
+        return;
+    }
+    
+    uint64_t bit = (uint64_t)(id % SEGMENT_BITS);
+    atomic_fetch_or_explicit(&segment[bit / 64], 1ULL << (bit % 64), memory_order_release);
+    
+    /* A miss recorded before the insert must not hide the new row. */
+    int64_t key = miss_key(kind, id);
+    miss_slot_t *slot = miss_slot(key);
+    if (atomic_load(&slot->key) == key) {
+        atomic_store(&slot->key, 0);
+    }
+}
+
+int id_filter_may_exist(id_filter_kind_t kind, int64_t id) {
+    if (id <= 0) {
+        return 0;
+    }
+    if (!atomic_load_explicit(&filter_loaded, memory_order_acquire)) {
+        return 1;
+    }
+    
+    if (id / SEGMENT_BITS < MAX_SEGMENTS) {
+        bitmap_word_t *segment = get_segment(kind, (size_t)(id / SEGMENT_BITS), 0);
+        uint64_t bit = (uint64_t)(id % SEGMENT_BITS);
+        if (!segment ||
+            !(atomic_load_explicit(&segment[bit / 64], memory_order_acquire) & (1ULL << (bit % 64)))) {
+            return 0;
+        }
+    }
+    
+    int64_t key = miss_key(kind, id);
+    miss_slot_t *slot = miss_slot(key);
+    if (atomic_load(&slot->key) == key && atomic_load(&slot->expires_at) > db_now_ms()) {
+        return 0;
+    }
+    return 1;
+}
+
+void id_filter_record_miss(id_filter_kind_t kind, int64_t id) {
+    if (id <= 0) {
+        return;
+    }
+    
+    int64_t key = miss_key(kind, id);
+    miss_slot_t *slot = miss_slot(key);
+    atomic_store(&slot->key, 0);
+    atomic_store(&slot->expires_at, db_now_ms() + ID_FILTER_NEGATIVE_TTL_MS);
+    atomic_store(&slot->key, key);
+}
+
+static int load_ids(id_filter_kind_t kind, const char *sql) {
+    sqlite3_stmt *stmt = db_prepare(sql);
+    if (!stmt) {
+        return -1;
+    }
+    
+    int count = 0;
+    int rc;
+    while ((rc = db_step(stmt)) == SQLITE_ROW) {
+        id_filter_add(kind, sqlite3_column_int64(stmt, 0));
+        count++;
+    }
+    db_finalize(stmt);
+    return rc == SQLITE_DONE ? count : -1;
+}
+
+static size_t allocated_segments(void) {
+    size_t count = 0;
+    for (int kind = 0; kind < 2; kind++) {
+        for (size_t i = 0; i < MAX_SEGMENTS; i++) {
+            if (atomic_load(&segments[kind][i])) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+int id_filter_init(void) {
+    int threads = load_ids(ID_FILTER_THREADS, "SELECT id FROM threads");
+    int posts = load_ids(ID_FILTER_POSTS, "SELECT id FROM posts");
+    if (threads < 0 || posts < 0) {
+        fprintf(stderr, "Failed to load id filter\n");
+        return -1;
+    }
+    
+    atomic_store_explicit(&filter_loaded, 1, memory_order_release);
+    printf("Id filter loaded: %d threads, %d posts (%zu KB)\n", threads, posts,
+           allocated_segments() * SEGMENT_WORDS * sizeof(bitmap_word_t) / 1024);
+    return 0;
+}
+
+void id_filter_shutdown(void) {
+    atomic_store(&filter_loaded, 0);
+    
+    for (int kind = 0; kind < 2; kind++) {
+        for (size_t i = 0; i < MAX_SEGMENTS; i++) {
+            free(atomic_exchange(&segments[kind][i], NULL));
+        }
+    }
+    for (size_t i = 0; i < MISS_CACHE_SLOTS; i++) {
+        atomic_store(&miss_cache[i].key, 0);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef ID_FILTER_H
+#define ID_FILTER_H
+
+#include <stdint.h>
+
+/*
+ * Existence bitmaps over thread and post ids, so requests for ids that were
+ * never created are answered without a query. Ids come from AUTOINCREMENT
+ * and are dense, so one bit per id is exact and smaller than a Bloom filter
+ * of the same accuracy. Ids that were created and later deleted still have
+ * their bit set; a short-lived negative cache catches repeated misses on
+ * those.
+ */
+
+typedef enum {
+    ID_FILTER_THREADS,
+    ID_FILTER_POSTS
+} id_filter_kind_t;
+
+#define ID_FILTER_NEGATIVE_TTL_MS 30000
+
+/* Loads every thread and post id. Call after db_migrate(). */
+int id_filter_init(void);
+void id_filter_shutdown(void);
+
+/* Marks a committed id as existing. Safe to call from any thread. */
+void id_filter_add(id_filter_kind_t kind, int64_t id);
+
+/* Returns 0 only when the id certainly does not exist; 1 means look it up. */
+int id_filter_may_exist(id_filter_kind_t kind, int64_t id);
+
+/* Records that a lookup found nothing, so the next ID_FILTER_NEGATIVE_TTL_MS
+ * worth of requests for it skip the database. */
+void id_filter_record_miss(id_filter_kind_t kind, int64_t id);
+
+#endif
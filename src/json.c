@@ -0,0 +1,107 @@
+#include "json.h"
+#include <string.h>
+
+void json_writer_init(json_writer_t *w, render_buf_t *out) {
+    w->out = out;
+    w->depth = 0;
+    w->has_values = 0;
+    w->after_key = 0;
+}
+
+/* Writes the comma that goes before a new value or key, if any. */
+static int separate(json_writer_t *w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return 0;
+    }
+    uint32_t bit = 1u << w->depth;
+    if (w->has_values & bit) {
+        return render_buf_append(w->out, ",", 1);
+    }
+    w->has_values |= bit;
+    return 0;
+}
+
+static int open_container(json_writer_t *w, char bracket) {
+    if (w->depth + 1 >= JSON_MAX_DEPTH || separate(w) != 0) {
+        return -1;
+    }
+    w->depth++;
+    w->has_values &= ~(1u << w->depth);
+    return render_buf_append(w->out, &bracket, 1);
+}
+
+static int close_container(json_writer_t *w, char bracket) {
+    if (w->depth == 0) {
+        return -1;
+    }
+    w->depth--;
+    return render_buf_append(w->out, &bracket, 1);
+}
+
+int json_begin_object(json_writer_t *w) {
+    return open_container(w, '{');
+}
+
+int json_end_object(json_writer_t *w) {
+    return close_container(w, '}');
+}
+
+int json_begin_array(json_writer_t *w) {
+    return open_container(w, '[');
+}
+
+int json_end_array(json_writer_t *w) {
+    return close_container(w, ']');
+}
+
+int json_key(json_writer_t *w, const char *key) {
+    if (separate(w) != 0 || render_buf_append_json(w->out, key) != 0 ||
+        render_buf_append(w->out, ":", 1) != 0) {
+        return -1;
+    }
+    w->after_key = 1;
+    return 0;
+}
+
+int json_string(json_writer_t *w, const char *value) {
+    if (separate(w) != 0) {
+        return -1;
+    }
+    return render_buf_append_json(w->out, value);
+}
+
+int json_int(json_writer_t *w, int64_t value) {
+    if (separate(w) != 0) {
+        return -1;
+    }
+    return render_buf_append_int(w->out, value);
+}
+
+int json_bool(json_writer_t *w, int value) {
+    if (separate(w) != 0) {
+        return -1;
+    }
+    return value ? render_buf_append(w->out, "true", 4) : render_buf_append(w->out, "false", 5);
+}
+
+int json_null(json_writer_t *w) {
+    if (separate(w) != 0) {
+        return -1;
+    }
+    return render_buf_append(w->out, "null", 4);
+}
+
+int json_field_string(json_writer_t *w, const char *key, const char *value) {
+    if (json_key(w, key) != 0) {
+        return -1;
+    }
+    return json_string(w, value);
+}
+
+int json_field_int(json_writer_t *w, const char *key, int64_t value) {
+    if (json_key(w, key) != 0) {
+        return -1;
+    }
+    return json_int(w, value);
+}
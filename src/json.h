@@ -0,0 +1,44 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "render.h"
+#include <stdint.h>
+
+/*
+ * Streaming JSON writer. Values are appended straight to a render buffer as
+ * they are produced, with strings escaped in place by the render escape
+ * kernels, so a response never exists as a tree and rows can be written as
+ * they come out of sqlite3_step(). The writer only tracks where commas go;
+ * callers are trusted to nest calls correctly.
+ */
+
+/* Objects and arrays may nest this deep. */
+#define JSON_MAX_DEPTH 32
+
+typedef struct {
+    render_buf_t *out;
+    int depth;
+    uint32_t has_values;            /* bit n: level n already holds a value */
+    int after_key;
+} json_writer_t;
+
+void json_writer_init(json_writer_t *w, render_buf_t *out);
+
+/* Every call returns 0, or -1 when memory runs out or nesting is too deep. */
+int json_begin_object(json_writer_t *w);
+int json_end_object(json_writer_t *w);
+int json_begin_array(json_writer_t *w);
+int json_end_array(json_writer_t *w);
+int json_key(json_writer_t *w, const char *key);
+
+/* NULL strings are written as null. */
+int json_string(json_writer_t *w, const char *value);
+int json_int(json_writer_t *w, int64_t value);
+int json_bool(json_writer_t *w, int value);
+int json_null(json_writer_t *w);
+
+/* A key followed by its value. */
+int json_field_string(json_writer_t *w, const char *key, const char *value);
+int json_field_int(json_writer_t *w, const char *key, int64_t value);
+
+#endif
@@ -89,7 +89,7 @@ void kaomoji_render_picker(char *buffer, int buffer_size, int *offset) {
             "<div style=\"display:flex;flex-wrap:wrap;gap:8px;\">\n",
             categories[i].title);
         
-        for (int j = 0; j < categories[i].count; j++) {
+        for (int j = 0; j < categories[i].items_count; j++) {
             len += snprintf(buffer + len, buffer_size - len,
                 "<button type=\"button\" onclick=\"insertKaomoji('%s')\" "
                 "style=\"padding:8px 12px;border:1px solid var(--divider);border-radius:4px;"
@@ -4,9 +4,15 @@
 typedef struct {
     const char *title;
     const char **items;
-    int count;
+    int items_count;
 } kaomoji_category_t;
 
+/* Context for the kaomoji_picker template. */
+typedef struct {
+    const kaomoji_category_t *categories;
+    int categories_count;
+} kaomoji_picker_t;
+
 const kaomoji_category_t *kaomoji_get_categories(void);
 int kaomoji_get_categories_count(void);
 void kaomoji_render_picker(char *buffer, int buffer_size, int *offset);
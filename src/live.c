@@ -0,0 +1,318 @@
+#define _POSIX_C_SOURCE 200809L
+#include "live.h"
+#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define LIVE_BUCKETS 256
+
+typedef struct subscriber {
+    int fd;
+    int64_t thread_id;
+    language_t lang;
+    render_buf_t pending;           /* bytes not yet written */
+    size_t sent;                    /* prefix of pending already written */
+    int64_t last_write_ms;
+    int dropped;
+    struct subscriber *thread_next; /* same hash bucket */
+} subscriber_t;
+
+static pthread_mutex_t live_mutex = PTHREAD_MUTEX_INITIALIZER;
+static subscriber_t *buckets[LIVE_BUCKETS];
+static subscriber_t *subscribers[LIVE_MAX_SUBSCRIBERS];
+static int subscriber_count = 0;
+static int live_running = 0;
+static int live_stopping = 0;
+static int wake_fds[2] = { -1, -1 };
+static pthread_t live_thread;
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static subscriber_t **bucket_for(int64_t thread_id) {
+    return &buckets[((uint64_t)thread_id * 0x9E3779B97F4A7C15ULL) >> 56];
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void wake_loop(void) {
+    char byte = 1;
+    if (write(wake_fds[1], &byte, 1) < 0) {
+        /* The pipe is full, so a wakeup is already pending. */
+    }
+}
+
+/* Appends to a subscriber's queue, or marks it dropped when it is too far
+ * behind. Caller holds live_mutex. */
+static void queue_bytes(subscriber_t *sub, const char *data, size_t len) {
+    if (sub->dropped) {
+        return;
+    }
+    if (sub->pending.len - sub->sent + len > LIVE_MAX_PENDING ||
+        render_buf_append(&sub->pending, data, len) != 0) {
+        sub->dropped = 1;
+    }
+}
+
+/* Writes as much as the socket takes without blocking. Caller holds
+ * live_mutex. */
+static void flush_subscriber(subscriber_t *sub) {
+    while (!sub->dropped && sub->sent < sub->pending.len) {
+        ssize_t written = send(sub->fd, sub->pending.data + sub->sent,
+                               sub->pending.len - sub->sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                sub->dropped = 1;
+            }
+            return;
+        }
+        sub->sent += (size_t)written;
+        sub->last_write_ms = now_ms();
+    }
+    if (sub->sent == sub->pending.len) {
+        render_buf_reset(&sub->pending);
+        sub->sent = 0;
+    }
+}
+
+/* Caller holds live_mutex. */
+static void remove_subscriber(int slot) {
+    subscriber_t *sub = subscribers[slot];
+    subscriber_t **link = bucket_for(sub->thread_id);
+    while (*link != sub) {
+        link = &(*link)->thread_next;
+    }
+    *link = sub->thread_next;
+    
+    subscribers[slot] = subscribers[--subscriber_count];
+    subscribers[subscriber_count] = NULL;
+    
+    close(sub->fd);
+    render_buf_free(&sub->pending);
+    free(sub);
+}
+
+static void *live_main(void *arg) {
+    (void)arg;
+    
+    static struct pollfd fds[LIVE_MAX_SUBSCRIBERS + 1];
+    static subscriber_t *polled[LIVE_MAX_SUBSCRIBERS];
+    char scratch[512];
+    
+    pthread_mutex_lock(&live_mutex);
+    while (!live_stopping) {
+        fds[0].fd = wake_fds[0];
+        fds[0].events = POLLIN;
+        nfds_t count = 1;
+        for (int i = 0; i < subscriber_count; i++) {
+            subscriber_t *sub = subscribers[i];
+            polled[count - 1] = sub;
+            fds[count].fd = sub->fd;
+            fds[count].events = POLLIN | (sub->sent < sub->pending.len ? POLLOUT : 0);
+            fds[count].revents = 0;
+            count++;
+        }
+        pthread_mutex_unlock(&live_mutex);
+    
+        int ready = poll(fds, count, LIVE_KEEPALIVE_MS / 2);
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "Live: poll() error: %s\n", strerror(errno));
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            while (read(wake_fds[0], scratch, sizeof(scratch)) > 0) {
+            }
+        }
+    
+        pthread_mutex_lock(&live_mutex);
+    
+        /* Only this thread removes subscribers, so every polled pointer is
+         * still valid. */
+        for (nfds_t i = 1; ready > 0 && i < count; i++) {
+            subscriber_t *sub = polled[i - 1];
+            short revents = fds[i].revents;
+            if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                sub->dropped = 1;
+            } else if (revents & POLLIN) {
+                /* Readers send nothing after the request; end of stream
+                 * means the browser went away. */
+                ssize_t n = recv(sub->fd, scratch, sizeof(scratch), 0);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    sub->dropped = 1;
+                }
+            }
+        }
+    
+        int64_t now = now_ms();
+        for (int i = subscriber_count - 1; i >= 0; i--) {
+            subscriber_t *sub = subscribers[i];
+            if (!sub->dropped && sub->sent == sub->pending.len &&
+                now - sub->last_write_ms >= LIVE_KEEPALIVE_MS) {
+                queue_bytes(sub, ": keepalive\n\n", 13);
+            }
+            flush_subscriber(sub);
+            if (sub->dropped) {
+                remove_subscriber(i);
+            }
+        }
+    }
+    pthread_mutex_unlock(&live_mutex);
+    return NULL;
+}
+
+int live_start(void) {
+    if (pipe(wake_fds) != 0) {
+        fprintf(stderr, "Failed to create live update wake pipe: %s\n", strerror(errno));
+        return -1;
+    }
+    set_nonblocking(wake_fds[0]);
+    set_nonblocking(wake_fds[1]);
+    
+    live_stopping = 0;
+    if (pthread_create(&live_thread, NULL, live_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start live update thread: %s\n", strerror(errno));
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        wake_fds[0] = wake_fds[1] = -1;
+        return -1;
+    }
+    
+    live_running = 1;
+    printf("Live updates started (up to %d subscribers)\n", LIVE_MAX_SUBSCRIBERS);
+    return 0;
+}
+
+void live_stop(void) {
+    if (!live_running) {
+        return;
+    }
+    
+    pthread_mutex_lock(&live_mutex);
+    live_stopping = 1;
+    pthread_mutex_unlock(&live_mutex);
+    wake_loop();
+    pthread_join(live_thread, NULL);
+    
+    pthread_mutex_lock(&live_mutex);
+    while (subscriber_count > 0) {
+        remove_subscriber(subscriber_count - 1);
+    }
+    live_running = 0;
+    pthread_mutex_unlock(&live_mutex);
+    
+    close(wake_fds[0]);
+    close(wake_fds[1]);
+    wake_fds[0] = wake_fds[1] = -1;
+}
+
+int live_subscribe(int client_fd, int64_t thread_id, language_t lang) {
+    subscriber_t *sub = calloc(1, sizeof(subscriber_t));
+    if (!sub || set_nonblocking(client_fd) != 0) {
+        free(sub);
+        close(client_fd);
+        return -1;
+    }
+    sub->fd = client_fd;
+    sub->thread_id = thread_id;
+    sub->lang = lang;
+    sub->last_write_ms = now_ms();
+    render_buf_init(&sub->pending, 256);
+    
+    char hello[32];
+    int hello_len = snprintf(hello, sizeof(hello), "retry: %d\n\n", LIVE_RETRY_MS);
+    
+    pthread_mutex_lock(&live_mutex);
+    if (!live_running || subscriber_count >= LIVE_MAX_SUBSCRIBERS) {
+        pthread_mutex_unlock(&live_mutex);
+        render_buf_free(&sub->pending);
+        free(sub);
+        close(client_fd);
+        return -1;
+    }
+    queue_bytes(sub, hello, (size_t)hello_len);
+    subscriber_t **bucket = bucket_for(thread_id);
+    sub->thread_next = *bucket;
+    *bucket = sub;
+    subscribers[subscriber_count++] = sub;
+    pthread_mutex_unlock(&live_mutex);
+    
+    wake_loop();
+    return 0;
+}
+
+int live_has_subscribers(int64_t thread_id, language_t lang) {
+    int found = 0;
+    pthread_mutex_lock(&live_mutex);
+    for (subscriber_t *sub = *bucket_for(thread_id); sub && !found; sub = sub->thread_next) {
+        found = sub->thread_id == thread_id && sub->lang == lang;
+    }
+    pthread_mutex_unlock(&live_mutex);
+    return found;
+}
+
+void live_publish(int64_t thread_id, language_t lang, const char *event,
+                  int64_t id, const char *data, size_t len) {
+    render_buf_t message;
+    if (render_buf_init(&message, len + 64) != 0) {
+        return;
+    }
+    
+    /* Every line of data needs its own "data:" field. */
+    int rc = render_buf_appendf(&message, "event: %s\nid: %lld\n", event, (long long)id);
+    size_t start = 0;
+    while (rc == 0 && start < len) {
+        const char *newline = memchr(data + start, '\n', len - start);
+        size_t end = newline ? (size_t)(newline - data) : len;
+        rc |= render_buf_append(&message, "data: ", 6);
+        rc |= render_buf_append(&message, data + start, end - start);
+        rc |= render_buf_append(&message, "\n", 1);
+        start = end + 1;
+    }
+    rc |= render_buf_append(&message, "\n", 1);
+    if (rc != 0) {
+        render_buf_free(&message);
+        return;
+    }
+    
+    int queued = 0;
+    pthread_mutex_lock(&live_mutex);
+    for (subscriber_t *sub = *bucket_for(thread_id); sub; sub = sub->thread_next) {
+        if (sub->thread_id == thread_id && sub->lang == lang) {
+            queue_bytes(sub, message.data, message.len);
+            queued = 1;
+        }
+    }
+    pthread_mutex_unlock(&live_mutex);
+    
+    if (queued) {
+        wake_loop();
+    }
+    render_buf_free(&message);
+}
+
+int live_subscriber_count(void) {
+    pthread_mutex_lock(&live_mutex);
+    int count = subscriber_count;
+    pthread_mutex_unlock(&live_mutex);
+    return count;
+}
@@ -0,0 +1,43 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include "i18n.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Server-Sent Events for open thread pages. After the response headers are
+ * sent, an HTTP worker hands the socket to the live module, and from then
+ * on one event loop thread polls every subscriber. An idle reader costs a
+ * descriptor and a small buffer, not a worker. Publishing only appends to
+ * per-subscriber buffers and wakes the loop. A reader that falls more than
+ * LIVE_MAX_PENDING bytes behind is dropped instead of stalling the poster;
+ * its browser reconnects on its own.
+ */
+
+#define LIVE_MAX_SUBSCRIBERS 1024
+#define LIVE_MAX_PENDING (256 * 1024)
+#define LIVE_KEEPALIVE_MS 15000
+#define LIVE_RETRY_MS 5000
+
+int live_start(void);
+
+/* Closes every subscriber connection. Call after http_server_shutdown(). */
+void live_stop(void);
+
+/* Takes ownership of client_fd, whose response headers are already sent,
+ * and subscribes it to thread_id. Returns 0, or -1 after closing it. */
+int live_subscribe(int client_fd, int64_t thread_id, language_t lang);
+
+/* Returns 1 when anyone reading thread_id in lang is subscribed, so
+ * publishers can skip rendering for empty threads. */
+int live_has_subscribers(int64_t thread_id, language_t lang);
+
+/* Queues "event: <event>" with the given id and data for every subscriber
+ * of thread_id reading lang. data may span lines. Never blocks on sockets. */
+void live_publish(int64_t thread_id, language_t lang, const char *event,
+                  int64_t id, const char *data, size_t len);
+
+int live_subscriber_count(void);
+
+#endif
@@ -4,9 +4,23 @@
 #include "render.h"
 #include "admin.h"
 #include "board.h"
+#include "board_registry.h"
+#include "live.h"
+#include "api.h"
+#include "static_file.h"
 #include "upload.h"
+#include "upload_session.h"
+#include "write_queue.h"
+#include "maintenance.h"
+#include "search.h"
+#include "cjk_tokenizer.h"
+#include "suggest.h"
+#include "id_filter.h"
+#include "fragment_cache.h"
+#include "template.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
 
 #define DEFAULT_PORT 8080
@@ -19,9 +33,40 @@ void signal_handler(int signum) {
     keep_running = 0;
 }
 
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--storage-profile=safe|read-heavy] [--rebuild-search]\n", prog);
+    printf("\n");
+    printf("  --rebuild-search     Rebuild the full-text search index and exit\n");
+    printf("\n");
+    printf("Environment:\n");
+    printf("  APP_STORAGE_PROFILE  Storage profile used when no option is given\n");
+}
+
 int main(int argc, char *argv[]) {
     uint16_t port = DEFAULT_PORT;
     const char *db_path = DEFAULT_DB_PATH;
+    const char *storage_profile = getenv("APP_STORAGE_PROFILE");
+    int rebuild_search = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--storage-profile=", 18) == 0) {
+            storage_profile = argv[i] + 18;
+        } else if (strcmp(argv[i], "--rebuild-search") == 0) {
+            rebuild_search = 1;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (storage_profile && storage_profile[0] && db_set_profile(storage_profile) != 0) {
+        fprintf(stderr, "Unknown storage profile: %s\n", storage_profile);
+        return 1;
+    }
     
     printf("=== Cosmopolitan Web Application ===\n");
     printf("Build: %s %s\n", __DATE__, __TIME__);
@@ -29,6 +74,12 @@ int main(int argc, char *argv[]) {
     
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    /* A client that disconnects mid-stream must fail the write, not kill us. */
+    signal(SIGPIPE, SIG_IGN);
+    
+    if (cjk_tokenizer_install() != 0) {
+        return 1;
+    }
     
     if (db_init(db_path) != 0) {
         fprintf(stderr, "Failed to initialize database\n");
@@ -41,19 +92,71 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    if (search_init() != 0) {
+        fprintf(stderr, "Failed to initialize search index\n");
+        db_close();
+        return 1;
+    }
+    
+    if (rebuild_search) {
+        int rc = search_rebuild();
+        db_close();
+        return rc == 0 ? 0 : 1;
+    }
+    
+    if (suggest_init() != 0) {
+        fprintf(stderr, "Warning: subject suggestions disabled\n");
+    }
+    
+    if (id_filter_init() != 0) {
+        fprintf(stderr, "Warning: every thread lookup will query the database\n");
+    }
+    
+    fragment_cache_init(FRAGMENT_CACHE_DEFAULT_BYTES);
+    render_init();
+    
     router_init();
     
     board_init();
     board_register_routes();
     
+    if (write_queue_start() != 0) {
+        fprintf(stderr, "Failed to start write queue\n");
+        router_cleanup();
+        db_close();
+        return 1;
+    }
+    
+    if (live_start() != 0) {
+        fprintf(stderr, "Warning: live thread updates disabled\n");
+    }
+    
+    if (static_file_start() != 0) {
+        fprintf(stderr, "Warning: uploads will be sent by HTTP workers\n");
+    }
+    
+    if (maintenance_start() != 0) {
+        fprintf(stderr, "Warning: background maintenance disabled\n");
+    }
+    
     admin_init();
     admin_register_routes();
     
     upload_init("./uploads");
     upload_register_routes();
+    upload_session_init("./uploads");
+    upload_session_register_routes();
+    
+    search_register_routes();
+    suggest_register_routes();
+    api_register_routes();
     
     if (http_server_init(port) != 0) {
         fprintf(stderr, "Failed to initialize HTTP server\n");
+        live_stop();
+        static_file_stop();
+        maintenance_stop();
+        write_queue_stop();
         router_cleanup();
         db_close();
         return 1;
@@ -68,6 +171,16 @@ int main(int argc, char *argv[]) {
     
     printf("\nShutting down...\n");
     http_server_shutdown();
+    live_stop();
+    static_file_stop();
+    maintenance_stop();
+    write_queue_stop();
+    suggest_shutdown();
+    board_shutdown();
+    board_registry_shutdown();
+    id_filter_shutdown();
+    fragment_cache_shutdown();
+    template_shutdown();
     router_cleanup();
     db_close();
     
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+#include "maintenance.h"
+#include "db.h"
+#include "upload_session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define MAINT_INTERVAL_SEC 5
+#define MAINT_IDLE_SEC 30
+#define MAINT_VACUUM_PAGES 256
+#define MAINT_VACUUM_STEPS 16
+#define MAINT_JOURNAL_SIZE_LIMIT (64 * 1024 * 1024)
+#define MAINT_TRUNCATE_BUSY_MS 10
+
+static pthread_t maint_thread;
+static pthread_mutex_t maint_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t maint_wakeup = PTHREAD_COND_INITIALIZER;
+static int maint_running = 0;
+static int maint_stopping = 0;
+static maintenance_stats_t maint_stats;
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t wal_file_size(void) {
+    char wal_path[600];
+    snprintf(wal_path, sizeof(wal_path), "%s-wal", db_get_path());
+
+    struct stat st;
+    if (stat(wal_path, &st) != 0) {
+        return 0;
+    }
+    return (int64_t)st.st_size;
+}
+
+static int pragma_int(const char *sql) {
+    int value = 0;
+    sqlite3_stmt *stmt = db_prepare(sql);
+    if (stmt) {
+        if (db_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int(stmt, 0);
+        }
+        db_finalize(stmt);
+    }
+    return value;
+}
+
+static void run_checkpoint(int mode) {
+    int log_frames = 0;
+    int checkpointed = 0;
+
+    int64_t start = now_us();
+    int rc;
+    if (mode == SQLITE_CHECKPOINT_TRUNCATE) {
+        /* TRUNCATE has to wait out writers, so take the write lock for it
+         * and let queued inserts wait instead of busy-looping. Readers, such
+         * as a page still streaming, can hold it up too; give them a few
+         * milliseconds rather than the connection's full busy timeout, then
+         * settle for a PASSIVE pass outside the lock. */
+        db_write_lock();
+        sqlite3 *conn = db_get_connection();
+        sqlite3_busy_timeout(conn, MAINT_TRUNCATE_BUSY_MS);
+        rc = sqlite3_wal_checkpoint_v2(conn, NULL, mode, &log_frames, &checkpointed);
+        sqlite3_busy_timeout(conn, DB_BUSY_TIMEOUT_MS);
+        db_write_unlock();
+
+        if (rc == SQLITE_BUSY) {
+            mode = SQLITE_CHECKPOINT_PASSIVE;
+        }
+    }
+    if (mode == SQLITE_CHECKPOINT_PASSIVE) {
+        rc = sqlite3_wal_checkpoint_v2(db_get_connection(), NULL, mode, &log_frames, &checkpointed);
+    }
+    int64_t elapsed = now_us() - start;
+
+    if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+        fprintf(stderr, "Maintenance: checkpoint failed: %s\n", sqlite3_errstr(rc));
+        return;
+    }
+
+    pthread_mutex_lock(&maint_mutex);
+    maint_stats.checkpoints++;
+    if (mode == SQLITE_CHECKPOINT_TRUNCATE) {
+        maint_stats.truncations++;
+    }
+    maint_stats.last_checkpoint_us = elapsed;
+    maint_stats.total_checkpoint_us += elapsed;
+    if (elapsed > maint_stats.max_checkpoint_us) {
+        maint_stats.max_checkpoint_us = elapsed;
+    }
+    maint_stats.last_wal_frames = log_frames;
+    maint_stats.last_checkpointed_frames = checkpointed;
+    pthread_mutex_unlock(&maint_mutex);
+}
+
+static void run_incremental_vacuum(void) {
+    char sql[64];
+    snprintf(sql, sizeof(sql), "PRAGMA incremental_vacuum(%d);", MAINT_VACUUM_PAGES);
+
+    for (int step = 0; step < MAINT_VACUUM_STEPS; step++) {
+        int free_pages = pragma_int("PRAGMA freelist_count;");
+        if (free_pages <= 0) {
+            break;
+        }
+
+        /* Each step takes and releases the write lock, so a posting burst
+         * only ever waits behind one small step. */
+        if (db_exec(sql) != 0) {
+            break;
+        }
+
+        int freed = free_pages - pragma_int("PRAGMA freelist_count;");
+        if (freed <= 0) {
+            break;
+        }
+
+        pthread_mutex_lock(&maint_mutex);
+        maint_stats.vacuumed_pages += freed;
+        pthread_mutex_unlock(&maint_mutex);
+    }
+}
+
+static void maintenance_pass(void) {
+    int64_t wal_bytes = wal_file_size();
+    int idle = time(NULL) - db_last_write_time() >= MAINT_IDLE_SEC;
+
+    if (wal_bytes > 0) {
+        run_checkpoint(idle ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE);
+    }
+
+    if (idle && maint_stats.auto_vacuum_mode == 2) {
+        run_incremental_vacuum();
+    }
+
+    /* Abandoned uploads may never see another session created. */
+    upload_session_sweep();
+
+    pthread_mutex_lock(&maint_mutex);
+    maint_stats.wal_bytes = wal_file_size();
+    pthread_mutex_unlock(&maint_mutex);
+}
+
+static void *maintenance_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&maint_mutex);
+    while (!maint_stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += MAINT_INTERVAL_SEC;
+
+        while (!maint_stopping) {
+            if (pthread_cond_timedwait(&maint_wakeup, &maint_mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (maint_stopping) {
+            break;
+        }
+
+        pthread_mutex_unlock(&maint_mutex);
+        maintenance_pass();
+        pthread_mutex_lock(&maint_mutex);
+    }
+    pthread_mutex_unlock(&maint_mutex);
+    return NULL;
+}
+
+int maintenance_start(void) {
+    char sql[64];
+
+    /* Checkpoints now belong to this thread, not to whichever commit happens
+     * to cross the auto-checkpoint threshold. */
+    db_exec("PRAGMA wal_autocheckpoint=0;");
+    snprintf(sql, sizeof(sql), "PRAGMA journal_size_limit=%d;", MAINT_JOURNAL_SIZE_LIMIT);
+    db_exec(sql);
+
+    memset(&maint_stats, 0, sizeof(maint_stats));
+    maint_stats.auto_vacuum_mode = pragma_int("PRAGMA auto_vacuum;");
+    if (maint_stats.auto_vacuum_mode != 2) {
+        printf("Maintenance: auto_vacuum is not INCREMENTAL, free pages will not be reclaimed "
+               "(run VACUUM offline after PRAGMA auto_vacuum=INCREMENTAL to enable)\n");
+    }
+
+    maint_stopping = 0;
+    if (pthread_create(&maint_thread, NULL, maintenance_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start maintenance thread: %s\n", strerror(errno));
+        db_exec("PRAGMA wal_autocheckpoint=1000;");
+        return -1;
+    }
+
+    maint_running = 1;
+    printf("Maintenance thread started (checkpoint every %ds, idle after %ds)\n",
+           MAINT_INTERVAL_SEC, MAINT_IDLE_SEC);
+    return 0;
+}
+
+void maintenance_stop(void) {
+    if (!maint_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&maint_mutex);
+    maint_stopping = 1;
+    pthread_cond_signal(&maint_wakeup);
+    pthread_mutex_unlock(&maint_mutex);
+
+    pthread_join(maint_thread, NULL);
+    maint_running = 0;
+}
+
+void maintenance_get_stats(maintenance_stats_t *stats) {
+    pthread_mutex_lock(&maint_mutex);
+    *stats = maint_stats;
+    pthread_mutex_unlock(&maint_mutex);
+}
@@ -0,0 +1,28 @@
+#ifndef MAINTENANCE_H
+#define MAINTENANCE_H
+
+#include <stdint.h>
+
+/*
+ * Background database maintenance: WAL checkpoints and incremental vacuum
+ * run on their own thread so request handlers never pay for them.
+ */
+
+typedef struct {
+    int64_t wal_bytes;              /* size of the -wal file at the last pass */
+    int64_t checkpoints;            /* PASSIVE + TRUNCATE checkpoints run */
+    int64_t truncations;            /* TRUNCATE checkpoints run while idle */
+    int64_t last_checkpoint_us;
+    int64_t max_checkpoint_us;
+    int64_t total_checkpoint_us;
+    int last_wal_frames;            /* frames in the WAL at the last checkpoint */
+    int last_checkpointed_frames;
+    int64_t vacuumed_pages;
+    int auto_vacuum_mode;           /* 0 none, 1 full, 2 incremental */
+} maintenance_stats_t;
+
+int maintenance_start(void);
+void maintenance_stop(void);
+void maintenance_get_stats(maintenance_stats_t *stats);
+
+#endif
@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+#include "media.h"
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/* JPEG segments skipped before giving up on finding the frame header. */
+#define JPEG_MAX_SEGMENTS 1024
+
+typedef struct {
+    int fd;
+    const unsigned char *data;      /* NULL when reading from fd */
+    size_t len;
+} source_t;
+
+static int read_at(const source_t *src, int64_t pos, unsigned char *buf, size_t len) {
+    if (pos < 0) {
+        return -1;
+    }
+    if (src->data) {
+        if ((uint64_t)pos > src->len || len > src->len - (size_t)pos) {
+            return -1;
+        }
+        memcpy(buf, src->data + pos, len);
+        return 0;
+    }
+    
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = pread(src->fd, buf + got, len - got, (off_t)(pos + (int64_t)got));
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+static uint32_t be16(const unsigned char *p) {
+    return (uint32_t)p[0] << 8 | p[1];
+}
+
+static uint32_t be32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint32_t le16(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t le24(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+}
+
+static int found(media_info_t *info, const char *type, const char *ext,
+                 uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0 || width > MEDIA_MAX_SIDE || height > MEDIA_MAX_SIDE) {
+        return -1;
+    }
+    info->content_type = type;
+    info->extension = ext;
+    info->width = (int)width;
+    info->height = (int)height;
+    return 0;
+}
+
+/* Walks the marker segments up to the first start-of-frame, which holds
+ * the size. EXIF and ICC segments can be long, so they are skipped by
+ * their length instead of read. */
+static int probe_jpeg(const source_t *src, media_info_t *info) {
+    unsigned char b[7];
+    int64_t pos = 2;
+    
+    for (int i = 0; i < JPEG_MAX_SEGMENTS; i++) {
+        if (read_at(src, pos, b, 2) != 0 || b[0] != 0xFF) {
+            return -1;
+        }
+        unsigned char marker = b[1];
+        if (marker == 0xFF) {
+            pos++;                  /* fill byte */
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;               /* no length field */
+            continue;
+        }
+        if (marker == 0xD8 || marker == 0xD9 || marker == 0xDA) {
+            return -1;              /* image data before any frame header */
+        }
+        
+        if (read_at(src, pos + 2, b, 2) != 0 || be16(b) < 2) {
+            return -1;
+        }
+        uint32_t length = be16(b);
+        
+        /* SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC). */
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 7 || read_at(src, pos + 4, b, 5) != 0) {
+                return -1;
+            }
+            return found(info, "image/jpeg", "jpg", be16(b + 3), be16(b + 1));
+        }
+        pos += 2 + length;
+    }
+    return -1;
+}
+
+static int probe(const source_t *src, media_info_t *info) {
+    unsigned char h[30];
+    memset(h, 0, sizeof(h));
+    memset(info, 0, sizeof(*info));
+    
+    /* Short files only match signatures that fit in them. */
+    size_t len = sizeof(h);
+    while (len > 0 && read_at(src, 0, h, len) != 0) {
+        len = len > 12 ? 12 : len > 2 ? 2 : 0;
+    }
+    
+    if (len >= 24 && memcmp(h, "\x89PNG\r\n\x1a\n", 8) == 0 && memcmp(h + 12, "IHDR", 4) == 0) {
+        return found(info, "image/png", "png", be32(h + 16), be32(h + 20));
+    }
+    if (len >= 12 && (memcmp(h, "GIF87a", 6) == 0 || memcmp(h, "GIF89a", 6) == 0)) {
+        return found(info, "image/gif", "gif", le16(h + 6), le16(h + 8));
+    }
+    if (len >= 30 && memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WEBP", 4) == 0) {
+        if (memcmp(h + 12, "VP8 ", 4) == 0 && memcmp(h + 23, "\x9d\x01\x2a", 3) == 0) {
+            return found(info, "image/webp", "webp", le16(h + 26) & 0x3fff, le16(h + 28) & 0x3fff);
+        }
+        if (memcmp(h + 12, "VP8L", 4) == 0 && h[20] == 0x2f) {
+            uint32_t bits = (uint32_t)h[21] | (uint32_t)h[22] << 8 |
+                            (uint32_t)h[23] << 16 | (uint32_t)h[24] << 24;
+            return found(info, "image/webp", "webp", (bits & 0x3fff) + 1, ((bits >> 14) & 0x3fff) + 1);
+        }
+        if (memcmp(h + 12, "VP8X", 4) == 0) {
+            return found(info, "image/webp", "webp", le24(h + 24) + 1, le24(h + 27) + 1);
+        }
+        return -1;
+    }
+    if (len >= 2 && h[0] == 0xFF && h[1] == 0xD8) {
+        return probe_jpeg(src, info);
+    }
+    return -1;
+}
+
+int media_probe(int fd, media_info_t *info) {
+    source_t src = { fd, NULL, 0 };
+    return probe(&src, info);
+}
+
+int media_probe_buffer(const unsigned char *data, size_t len, media_info_t *info) {
+    source_t src = { -1, data, len };
+    return probe(&src, info);
+}
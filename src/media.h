@@ -0,0 +1,30 @@
+#ifndef MEDIA_H
+#define MEDIA_H
+
+#include <stddef.h>
+
+/*
+ * Image header probing for attachments. The type comes from the file's
+ * signature rather than its name, and the pixel size from the header, so
+ * both are read once at upload and pages never open the file again. Only
+ * the first few bytes are read, except for JPEG, whose size follows any
+ * metadata segments; those are skipped by their lengths.
+ */
+
+#define MEDIA_MAX_SIDE 65535
+
+typedef struct {
+    const char *content_type;       /* e.g. "image/png" */
+    const char *extension;          /* matching extension, e.g. "png" */
+    int width;
+    int height;
+} media_info_t;
+
+/* Probes the file open on fd. Returns 0 for a PNG, GIF, JPEG or WebP image
+ * with a plausible size, -1 otherwise. */
+int media_probe(int fd, media_info_t *info);
+
+/* Same, for an image already in memory. */
+int media_probe_buffer(const unsigned char *data, size_t len, media_info_t *info);
+
+#endif
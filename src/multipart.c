@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+#include "multipart.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MULTIPART_HAVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define MULTIPART_HAVE_SSE2 0
+#endif
+
+#if MULTIPART_HAVE_SSE2
+
+/* Compares the needle's first and last bytes against 16 candidate
+ * positions at once and runs memcmp() only where both match. */
+size_t multipart_find(const char *haystack, size_t haystack_len,
+                      const char *needle, size_t needle_len) {
+    if (needle_len == 0 || needle_len > haystack_len) {
+        return haystack_len;
+    }
+    
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t limit = haystack_len - needle_len + 1;
+    size_t i = 0;
+    
+    for (; i + 16 <= limit; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(haystack + i + needle_len - 1));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(haystack + pos + 1, needle + 1, needle_len - 1) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    for (; i < limit; i++) {
+        if (haystack[i] == needle[0] && memcmp(haystack + i, needle, needle_len) == 0) {
+            return i;
+        }
+    }
+    return haystack_len;
+}
+
+#else
+
+size_t multipart_find(const char *haystack, size_t haystack_len,
+                      const char *needle, size_t needle_len) {
+    if (needle_len == 0 || needle_len > haystack_len) {
+        return haystack_len;
+    }
+    
+    size_t limit = haystack_len - needle_len + 1;
+    size_t i = 0;
+    while (i < limit) {
+        const char *hit = memchr(haystack + i, needle[0], limit - i);
+        if (!hit) {
+            break;
+        }
+        i = (size_t)(hit - haystack);
+        if (memcmp(hit, needle, needle_len) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return haystack_len;
+}
+
+#endif
+
+/* Finds name=value or name="value" in a header parameter list. */
+static int get_param(const char *params, const char *name, char *dst, size_t size) {
+    size_t name_len = strlen(name);
+    const char *p = params;
+    
+    while ((p = strchr(p, ';')) != NULL) {
+        p++;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (strncasecmp(p, name, name_len) != 0 || p[name_len] != '=') {
+            continue;
+        }
+        const char *value = p + name_len + 1;
+        const char *end;
+        if (*value == '"') {
+            value++;
+            end = strchr(value, '"');
+            if (!end) {
+                return -1;
+            }
+        } else {
+            end = value + strcspn(value, "; \t");
+        }
+        size_t len = (size_t)(end - value);
+        if (len >= size) {
+            return -1;
+        }
+        memcpy(dst, value, len);
+        dst[len] = '\0';
+        return 0;
+    }
+    return -1;
+}
+
+int multipart_get_boundary(const char *content_type, char *boundary, size_t size) {
+    if (!content_type || strncasecmp(content_type, "multipart/form-data", 19) != 0) {
+        return -1;
+    }
+    if (get_param(content_type + 19, "boundary", boundary, size) != 0 ||
+        boundary[0] == '\0' || strlen(boundary) > MULTIPART_MAX_BOUNDARY) {
+        return -1;
+    }
+    return 0;
+}
+
+int multipart_parser_init(multipart_parser_t *parser, const char *content_type,
+                          const multipart_callbacks_t *callbacks, void *ctx) {
+    char boundary[MULTIPART_MAX_BOUNDARY + 1];
+    if (multipart_get_boundary(content_type, boundary, sizeof(boundary)) != 0) {
+        return -1;
+    }
+    
+    parser->state = MULTIPART_PREAMBLE;
+    parser->callbacks = *callbacks;
+    parser->ctx = ctx;
+    parser->delimiter_len = (size_t)snprintf(parser->delimiter, sizeof(parser->delimiter),
+                                             "\r\n--%s", boundary);
+    
+    /* The first delimiter may open the body without a line break before
+     * it; seeding one lets a single search handle both cases. */
+    memcpy(parser->buf, "\r\n", 2);
+    parser->len = 2;
+    return 0;
+}
+
+/* Splits one header block (without its final blank line) into part. */
+static int parse_part_headers(char *headers, multipart_part_t *part) {
+    memset(part, 0, sizeof(*part));
+    int has_disposition = 0;
+    
+    char *line = headers;
+    while (line && *line) {
+        char *next = strstr(line, "\r\n");
+        if (next) {
+            *next = '\0';
+            next += 2;
+        }
+        char *colon = strchr(line, ':');
+        if (colon) {
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ' || *value == '\t') {
+                value++;
+            }
+            if (strcasecmp(line, "Content-Disposition") == 0) {
+                if (strncasecmp(value, "form-data", 9) != 0 ||
+                    get_param(value, "name", part->name, sizeof(part->name)) != 0) {
+                    return -1;
+                }
+                /* Optional; too long a name is treated as no file name. */
+                if (get_param(value, "filename", part->filename, sizeof(part->filename)) != 0) {
+                    part->filename[0] = '\0';
+                }
+                has_disposition = 1;
+            } else if (strcasecmp(line, "Content-Type") == 0) {
+                snprintf(part->content_type, sizeof(part->content_type), "%s", value);
+            }
+        }
+        line = next;
+    }
+    return has_disposition ? 0 : -1;
+}
+
+/* Consumes what it can from the window. Returns the bytes consumed, or
+ * -1 on error. Anything not consumed needs more input. */
+static long parse_window(multipart_parser_t *parser) {
+    size_t pos = 0;
+    
+    while (pos < parser->len) {
+        char *data = parser->buf + pos;
+        size_t avail = parser->len - pos;
+        
+        switch (parser->state) {
+            case MULTIPART_PREAMBLE: {
+                size_t hit = multipart_find(data, avail, parser->delimiter, parser->delimiter_len);
+                if (hit == avail) {
+                    /* Keep a possible partial delimiter at the end. */
+                    if (avail >= parser->delimiter_len) {
+                        pos += avail - parser->delimiter_len + 1;
+                    }
+                    return (long)pos;
+                }
+                pos += hit + parser->delimiter_len;
+                parser->state = MULTIPART_AFTER_DELIMITER;
+                break;
+            }
+            
+            case MULTIPART_AFTER_DELIMITER:
+                if (avail < 2) {
+                    return (long)pos;
+                }
+                if (data[0] == '-' && data[1] == '-') {
+                    parser->state = MULTIPART_DONE;
+                } else if (data[0] == '\r' && data[1] == '\n') {
+                    parser->state = MULTIPART_HEADERS;
+                } else {
+                    return -1;
+                }
+                pos += 2;
+                break;
+            
+            case MULTIPART_HEADERS: {
+                size_t end = multipart_find(data, avail, "\r\n\r\n", 4);
+                if (end == avail) {
+                    /* A part with no headers at all is malformed too. */
+                    if (avail > MULTIPART_MAX_HEADERS) {
+                        return -1;
+                    }
+                    return (long)pos;
+                }
+                data[end] = '\0';
+                multipart_part_t part;
+                if (parse_part_headers(data, &part) != 0 ||
+                    (parser->callbacks.on_part_begin &&
+                     parser->callbacks.on_part_begin(parser->ctx, &part) != 0)) {
+                    return -1;
+                }
+                pos += end + 4;
+                parser->state = MULTIPART_BODY;
+                break;
+            }
+            
+            case MULTIPART_BODY: {
+                size_t hit = multipart_find(data, avail, parser->delimiter, parser->delimiter_len);
+                size_t emit = hit;
+                if (hit == avail) {
+                    emit = avail >= parser->delimiter_len ? avail - parser->delimiter_len + 1 : 0;
+                }
+                if (emit > 0 && parser->callbacks.on_part_data &&
+                    parser->callbacks.on_part_data(parser->ctx, data, emit) != 0) {
+                    return -1;
+                }
+                pos += emit;
+                if (hit == avail) {
+                    return (long)pos;
+                }
+                if (parser->callbacks.on_part_end && parser->callbacks.on_part_end(parser->ctx) != 0) {
+                    return -1;
+                }
+                pos += parser->delimiter_len;
+                parser->state = MULTIPART_AFTER_DELIMITER;
+                break;
+            }
+            
+            case MULTIPART_DONE:
+                /* The epilogue is ignored. */
+                return (long)parser->len;
+            
+            case MULTIPART_FAILED:
+                return -1;
+        }
+    }
+    return (long)pos;
+}
+
+int multipart_parser_feed(multipart_parser_t *parser, const char *data, size_t len) {
+    while (len > 0) {
+        if (parser->state == MULTIPART_FAILED) {
+            return -1;
+        }
+        
+        size_t take = sizeof(parser->buf) - parser->len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(parser->buf + parser->len, data, take);
+        parser->len += take;
+        data += take;
+        len -= take;
+        
+        long consumed = parse_window(parser);
+        if (consumed < 0) {
+            parser->state = MULTIPART_FAILED;
+            return -1;
+        }
+        parser->len -= (size_t)consumed;
+        memmove(parser->buf, parser->buf + consumed, parser->len);
+    }
+    return 0;
+}
+
+int multipart_parser_finish(multipart_parser_t *parser) {
+    return parser->state == MULTIPART_DONE ? 0 : -1;
+}
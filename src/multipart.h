@@ -0,0 +1,70 @@
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <stddef.h>
+
+/*
+ * Incremental multipart/form-data parser. Body bytes are fed in pieces of
+ * any size as they come off the socket; part headers are parsed and part
+ * contents are passed to callbacks as they are found, so a file part is
+ * never held in memory. The parser keeps one fixed window, which bounds
+ * its memory whatever the body size. Delimiters are found with an SSE2
+ * search on x86-64 and memchr() elsewhere.
+ */
+
+#define MULTIPART_BUFFER_SIZE (64 * 1024)
+#define MULTIPART_MAX_HEADERS 8192
+#define MULTIPART_MAX_BOUNDARY 70
+
+typedef struct {
+    char name[128];                 /* form field name */
+    char filename[256];             /* empty unless the part is a file */
+    char content_type[128];         /* empty when not given */
+} multipart_part_t;
+
+/* Callbacks return 0 to continue or -1 to abort parsing. */
+typedef struct {
+    int (*on_part_begin)(void *ctx, const multipart_part_t *part);
+    int (*on_part_data)(void *ctx, const char *data, size_t len);
+    int (*on_part_end)(void *ctx);
+} multipart_callbacks_t;
+
+typedef enum {
+    MULTIPART_PREAMBLE,
+    MULTIPART_AFTER_DELIMITER,
+    MULTIPART_HEADERS,
+    MULTIPART_BODY,
+    MULTIPART_DONE,
+    MULTIPART_FAILED
+} multipart_state_t;
+
+typedef struct {
+    multipart_state_t state;
+    multipart_callbacks_t callbacks;
+    void *ctx;
+    char delimiter[MULTIPART_MAX_BOUNDARY + 5];  /* "\r\n--" boundary */
+    size_t delimiter_len;
+    char buf[MULTIPART_BUFFER_SIZE];
+    size_t len;
+} multipart_parser_t;
+
+/* Copies the boundary parameter of a multipart/form-data Content-Type
+ * into boundary. Returns 0, or -1 if there is none or it is too long. */
+int multipart_get_boundary(const char *content_type, char *boundary, size_t size);
+
+/* Returns 0, or -1 when content_type has no usable boundary. */
+int multipart_parser_init(multipart_parser_t *parser, const char *content_type,
+                          const multipart_callbacks_t *callbacks, void *ctx);
+
+/* Parses len more bytes. Returns 0, or -1 on malformed input or when a
+ * callback aborted. */
+int multipart_parser_feed(multipart_parser_t *parser, const char *data, size_t len);
+
+/* Returns 0 when the closing delimiter was seen, -1 for a truncated body. */
+int multipart_parser_finish(multipart_parser_t *parser);
+
+/* Offset of the first occurrence of needle in haystack, or haystack_len. */
+size_t multipart_find(const char *haystack, size_t haystack_len,
+                      const char *needle, size_t needle_len);
+
+#endif
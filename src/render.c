@@ -1,13 +1,41 @@
 #include "render.h"
+#include "template.h"
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RENDER_HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define RENDER_HAVE_X86_KERNELS 0
+#endif
+
 render_result_t *render_template(const char *template_name, void *data) {
-    printf("Rendering template: %s (stub)\n", template_name);
+    const template_t *tmpl = template_find(template_name);
+    if (!tmpl) {
+        fprintf(stderr, "Unknown template: %s\n", template_name);
+        return NULL;
+    }
+    
+    render_result_t *result = malloc(sizeof(render_result_t));
+    render_buf_t buf;
+    if (!result || render_buf_init(&buf, 4096) != 0) {
+        free(result);
+        return NULL;
+    }
+    
+    if (template_render(tmpl, data, &buf) != 0) {
+        render_buf_free(&buf);
+        free(result);
+        return NULL;
+    }
     
-    const char *html = "<html><body>Template stub</body></html>";
-    return render_html(html, strlen(html));
+    result->html = buf.data;
+    result->len = buf.len;
+    return result;
 }
 
 render_result_t *render_html(const char *html, size_t len) {
@@ -38,47 +66,352 @@ void render_free(render_result_t *result) {
     }
 }
 
+/*
+ * Escaping. A scan kernel finds the next byte that needs escaping; the run
+ * before it is copied in one memcpy. x86-64 builds carry SSE2 and AVX2
+ * kernels and pick one at runtime, so the same binary (including a
+ * Cosmopolitan APE) runs on any CPU.
+ */
+
+typedef size_t (*scan_fn_t)(const char *s, size_t len);
+
+typedef struct {
+    const char *name;
+    scan_fn_t scan_html;
+    scan_fn_t scan_js;
+    scan_fn_t scan_json;
+} escape_kernel_t;
+
+static const unsigned char html_special[256] = {
+    ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1, ['\''] = 1
+};
+
+static const unsigned char js_special[256] = {
+    ['\\'] = 1, ['\''] = 1, ['"'] = 1, ['\n'] = 1, ['\r'] = 1, ['\t'] = 1
+};
+
+/* Quote, backslash and every control character. */
+static const unsigned char json_special[256] = {
+    [0x00] = 1, [0x01] = 1, [0x02] = 1, [0x03] = 1, [0x04] = 1, [0x05] = 1, [0x06] = 1, [0x07] = 1,
+    [0x08] = 1, [0x09] = 1, [0x0a] = 1, [0x0b] = 1, [0x0c] = 1, [0x0d] = 1, [0x0e] = 1, [0x0f] = 1,
+    [0x10] = 1, [0x11] = 1, [0x12] = 1, [0x13] = 1, [0x14] = 1, [0x15] = 1, [0x16] = 1, [0x17] = 1,
+    [0x18] = 1, [0x19] = 1, [0x1a] = 1, [0x1b] = 1, [0x1c] = 1, [0x1d] = 1, [0x1e] = 1, [0x1f] = 1,
+    ['"'] = 1, ['\\'] = 1
+};
+
+static size_t scan_html_scalar(const char *s, size_t len) {
+    size_t i = 0;
+    while (i < len && !html_special[(unsigned char)s[i]]) {
+        i++;
+    }
+    return i;
+}
+
+static size_t scan_js_scalar(const char *s, size_t len) {
+    size_t i = 0;
+    while (i < len && !js_special[(unsigned char)s[i]]) {
+        i++;
+    }
+    return i;
+}
+
+static size_t scan_json_scalar(const char *s, size_t len) {
+    size_t i = 0;
+    while (i < len && !json_special[(unsigned char)s[i]]) {
+        i++;
+    }
+    return i;
+}
+
+#if RENDER_HAVE_X86_KERNELS
+
+static size_t scan_html_sse2(const char *s, size_t len) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i apos = _mm_set1_epi8('\'');
+    size_t i = 0;
+    
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, quot)));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, apos));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return i + scan_html_scalar(s + i, len - i);
+}
+
+static size_t scan_js_sse2(const char *s, size_t len) {
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i apos = _mm_set1_epi8('\'');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    size_t i = 0;
+    
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, apos)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, quot), _mm_cmpeq_epi8(v, newline)));
+        hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return i + scan_js_scalar(s + i, len - i);
+}
+
+/* Control characters are the bytes where max(v, 0x1f) == 0x1f unsigned. */
+static size_t scan_json_sse2(const char *s, size_t len) {
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1f);
+    size_t i = 0;
+    
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quot), _mm_cmpeq_epi8(v, backslash)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(v, control_max), control_max));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return i + scan_json_scalar(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_html_avx2(const char *s, size_t len) {
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i apos = _mm256_set1_epi8('\'');
+    size_t i = 0;
+    
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, lt)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, gt), _mm256_cmpeq_epi8(v, quot)));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, apos));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + scan_html_sse2(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_js_avx2(const char *s, size_t len) {
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i apos = _mm256_set1_epi8('\'');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    size_t i = 0;
+    
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, backslash), _mm256_cmpeq_epi8(v, apos)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, quot), _mm256_cmpeq_epi8(v, newline)));
+        hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, tab)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + scan_js_sse2(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_json_avx2(const char *s, size_t len) {
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control_max = _mm256_set1_epi8(0x1f);
+    size_t i = 0;
+    
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quot), _mm256_cmpeq_epi8(v, backslash)),
+                                      _mm256_cmpeq_epi8(_mm256_max_epu8(v, control_max), control_max));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i + scan_json_sse2(s + i, len - i);
+}
+
+#endif
+
+/* Best first; selection takes the first one the CPU supports. */
+static const escape_kernel_t escape_kernels[] = {
+#if RENDER_HAVE_X86_KERNELS
+    { "avx2", scan_html_avx2, scan_js_avx2, scan_json_avx2 },
+    { "sse2", scan_html_sse2, scan_js_sse2, scan_json_sse2 },
+#endif
+    { "scalar", scan_html_scalar, scan_js_scalar, scan_json_scalar },
+};
+
+#define ESCAPE_KERNEL_COUNT (sizeof(escape_kernels) / sizeof(escape_kernels[0]))
+
+static _Atomic(const escape_kernel_t *) active_kernel = NULL;
+
+static int kernel_supported(const escape_kernel_t *kernel) {
+#if RENDER_HAVE_X86_KERNELS
+    if (strcmp(kernel->name, "avx2") == 0) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    (void)kernel;
+    return 1;
+}
+
+static const escape_kernel_t *get_kernel(void) {
+    const escape_kernel_t *kernel = atomic_load_explicit(&active_kernel, memory_order_relaxed);
+    if (!kernel) {
+        for (size_t i = 0; i < ESCAPE_KERNEL_COUNT && !kernel; i++) {
+            if (kernel_supported(&escape_kernels[i])) {
+                kernel = &escape_kernels[i];
+            }
+        }
+        atomic_store_explicit(&active_kernel, kernel, memory_order_relaxed);
+    }
+    return kernel;
+}
+
+void render_init(void) {
+    printf("Render: %s escape kernel\n", get_kernel()->name);
+}
+
+int render_set_escape_kernel(const char *name) {
+    for (size_t i = 0; i < ESCAPE_KERNEL_COUNT; i++) {
+        if (strcmp(escape_kernels[i].name, name) == 0 && kernel_supported(&escape_kernels[i])) {
+            atomic_store_explicit(&active_kernel, &escape_kernels[i], memory_order_relaxed);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *render_escape_kernel_name(void) {
+    return get_kernel()->name;
+}
+
+static size_t html_entity(char *dst, char c) {
+    switch (c) {
+        case '&': memcpy(dst, "&amp;", 5); return 5;
+        case '<': memcpy(dst, "&lt;", 4); return 4;
+        case '>': memcpy(dst, "&gt;", 4); return 4;
+        case '"': memcpy(dst, "&quot;", 6); return 6;
+        default: memcpy(dst, "&#39;", 5); return 5;
+    }
+}
+
+static size_t js_escape(char *dst, char c) {
+    dst[0] = '\\';
+    switch (c) {
+        case '\n': dst[1] = 'n'; break;
+        case '\r': dst[1] = 'r'; break;
+        case '\t': dst[1] = 't'; break;
+        default: dst[1] = c; break;
+    }
+    return 2;
+}
+
+static size_t json_escape(char *dst, char c) {
+    static const char hex[] = "0123456789abcdef";
+    dst[0] = '\\';
+    switch (c) {
+        case '"': dst[1] = '"'; return 2;
+        case '\\': dst[1] = '\\'; return 2;
+        case '\n': dst[1] = 'n'; return 2;
+        case '\r': dst[1] = 'r'; return 2;
+        case '\t': dst[1] = 't'; return 2;
+        default:
+            memcpy(dst + 1, "u00", 3);
+            dst[4] = hex[(unsigned char)c >> 4];
+            dst[5] = hex[(unsigned char)c & 0xf];
+            return 6;
+    }
+}
+
+size_t render_escape_html_into(char *dst, const char *src, size_t len) {
+    scan_fn_t scan = get_kernel()->scan_html;
+    size_t i = 0;
+    size_t j = 0;
+    
+    while (i < len) {
+        size_t run = scan(src + i, len - i);
+        memcpy(dst + j, src + i, run);
+        i += run;
+        j += run;
+        if (i < len) {
+            j += html_entity(dst + j, src[i++]);
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
+size_t render_escape_js_into(char *dst, const char *src, size_t len) {
+    scan_fn_t scan = get_kernel()->scan_js;
+    size_t i = 0;
+    size_t j = 0;
+    
+    while (i < len) {
+        size_t run = scan(src + i, len - i);
+        memcpy(dst + j, src + i, run);
+        i += run;
+        j += run;
+        if (i < len) {
+            j += js_escape(dst + j, src[i++]);
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
+size_t render_escape_json_into(char *dst, const char *src, size_t len) {
+    scan_fn_t scan = get_kernel()->scan_json;
+    size_t i = 0;
+    size_t j = 0;
+    
+    while (i < len) {
+        size_t run = scan(src + i, len - i);
+        memcpy(dst + j, src + i, run);
+        i += run;
+        j += run;
+        if (i < len) {
+            j += json_escape(dst + j, src[i++]);
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
 char *render_escape_html(const char *str) {
     if (!str) {
         return NULL;
     }
     
     size_t len = strlen(str);
-    char *escaped = malloc(len * 6 + 1);
+    char *escaped = malloc(len * RENDER_ESCAPE_MAX_EXPANSION + 1);
     if (!escaped) {
         return NULL;
     }
     
-    size_t j = 0;
-    for (size_t i = 0; i < len; i++) {
-        switch (str[i]) {
-            case '&':
-                escaped[j++] = '&'; escaped[j++] = 'a'; escaped[j++] = 'm';
-                escaped[j++] = 'p'; escaped[j++] = ';';
-                break;
-            case '<':
-                escaped[j++] = '&'; escaped[j++] = 'l'; escaped[j++] = 't';
-                escaped[j++] = ';';
-                break;
-            case '>':
-                escaped[j++] = '&'; escaped[j++] = 'g'; escaped[j++] = 't';
-                escaped[j++] = ';';
-                break;
-            case '"':
-                escaped[j++] = '&'; escaped[j++] = 'q'; escaped[j++] = 'u';
-                escaped[j++] = 'o'; escaped[j++] = 't'; escaped[j++] = ';';
-                break;
-            case '\'':
-                escaped[j++] = '&'; escaped[j++] = '#'; escaped[j++] = '3';
-                escaped[j++] = '9'; escaped[j++] = ';';
-                break;
-            default:
-                escaped[j++] = str[i];
-                break;
-        }
-    }
-    escaped[j] = '\0';
-    
+    render_escape_html_into(escaped, str, len);
     return escaped;
 }
 
@@ -88,38 +421,140 @@ char *render_escape_js(const char *str) {
     }
     
     size_t len = strlen(str);
-    char *escaped = malloc(len * 6 + 1);
+    char *escaped = malloc(len * 2 + 1);
     if (!escaped) {
         return NULL;
     }
     
-    size_t j = 0;
-    for (size_t i = 0; i < len; i++) {
-        switch (str[i]) {
-            case '\\':
-                escaped[j++] = '\\'; escaped[j++] = '\\';
-                break;
-            case '\'':
-                escaped[j++] = '\\'; escaped[j++] = '\'';
-                break;
-            case '"':
-                escaped[j++] = '\\'; escaped[j++] = '"';
-                break;
-            case '\n':
-                escaped[j++] = '\\'; escaped[j++] = 'n';
-                break;
-            case '\r':
-                escaped[j++] = '\\'; escaped[j++] = 'r';
-                break;
-            case '\t':
-                escaped[j++] = '\\'; escaped[j++] = 't';
-                break;
-            default:
-                escaped[j++] = str[i];
-                break;
+    render_escape_js_into(escaped, str, len);
+    return escaped;
+}
+
+int render_buf_init(render_buf_t *buf, size_t capacity) {
+    buf->data = malloc(capacity + 1);
+    buf->len = 0;
+    buf->cap = buf->data ? capacity : 0;
+    if (!buf->data) {
+        return -1;
+    }
+    buf->data[0] = '\0';
+    return 0;
+}
+
+void render_buf_free(render_buf_t *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+void render_buf_reset(render_buf_t *buf) {
+    buf->len = 0;
+    if (buf->data) {
+        buf->data[0] = '\0';
+    }
+}
+
+int render_buf_reserve(render_buf_t *buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) {
+        return 0;
+    }
+    
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra) {
+        cap *= 2;
+    }
+    
+    char *data = realloc(buf->data, cap + 1);
+    if (!data) {
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+int render_buf_append(render_buf_t *buf, const char *data, size_t len) {
+    if (render_buf_reserve(buf, len) != 0) {
+        return -1;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return 0;
+}
+
+int render_buf_append_str(render_buf_t *buf, const char *str) {
+    return render_buf_append(buf, str, strlen(str));
+}
+
+int render_buf_appendf(render_buf_t *buf, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int needed = vsnprintf(buf->data + buf->len, buf->cap - buf->len + 1, fmt, args);
+    va_end(args);
+    if (needed < 0) {
+        return -1;
+    }
+    
+    if ((size_t)needed > buf->cap - buf->len) {
+        if (render_buf_reserve(buf, (size_t)needed) != 0) {
+            buf->data[buf->len] = '\0';
+            return -1;
         }
+        va_start(args, fmt);
+        vsnprintf(buf->data + buf->len, buf->cap - buf->len + 1, fmt, args);
+        va_end(args);
+    }
+    buf->len += (size_t)needed;
+    return 0;
+}
+
+int render_buf_append_html(render_buf_t *buf, const char *str) {
+    size_t len = strlen(str);
+    if (render_buf_reserve(buf, len * RENDER_ESCAPE_MAX_EXPANSION) != 0) {
+        return -1;
+    }
+    buf->len += render_escape_html_into(buf->data + buf->len, str, len);
+    return 0;
+}
+
+int render_buf_append_js(render_buf_t *buf, const char *str) {
+    size_t len = strlen(str);
+    if (render_buf_reserve(buf, len * 2) != 0) {
+        return -1;
+    }
+    buf->len += render_escape_js_into(buf->data + buf->len, str, len);
+    return 0;
+}
+
+int render_buf_append_json(render_buf_t *buf, const char *str) {
+    if (!str) {
+        return render_buf_append(buf, "null", 4);
     }
-    escaped[j] = '\0';
     
-    return escaped;
+    size_t len = strlen(str);
+    if (render_buf_reserve(buf, len * RENDER_ESCAPE_MAX_EXPANSION + 2) != 0) {
+        return -1;
+    }
+    buf->data[buf->len++] = '"';
+    buf->len += render_escape_json_into(buf->data + buf->len, str, len);
+    buf->data[buf->len++] = '"';
+    buf->data[buf->len] = '\0';
+    return 0;
+}
+
+int render_buf_append_int(render_buf_t *buf, int64_t value) {
+    char digits[24];
+    size_t pos = sizeof(digits);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+    return render_buf_append(buf, digits + pos, sizeof(digits) - pos);
 }
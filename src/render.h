@@ -2,17 +2,59 @@
 #define RENDER_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct {
     char *html;
     size_t len;
 } render_result_t;
 
+/* Renders a template registered with template_register(); data must match
+ * the schema it was registered with. NULL if the name is unknown. */
 render_result_t *render_template(const char *template_name, void *data);
 render_result_t *render_html(const char *html, size_t len);
 void render_free(render_result_t *result);
 
+/* Growable output buffer; data is always NUL-terminated. Append functions
+ * return 0, or -1 when memory runs out. */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} render_buf_t;
+
+/* Escaping never grows text by more than this factor. */
+#define RENDER_ESCAPE_MAX_EXPANSION 6
+
+/* Picks the fastest escape kernel for this CPU and logs it. */
+void render_init(void);
+
+/* Forces a kernel ("avx2", "sse2", "scalar"); -1 if this build or CPU
+ * lacks it. For tests and benchmarks. */
+int render_set_escape_kernel(const char *name);
+const char *render_escape_kernel_name(void);
+
 char *render_escape_html(const char *str);
 char *render_escape_js(const char *str);
 
+/* Escape len bytes of src into dst, which must have room for
+ * len * RENDER_ESCAPE_MAX_EXPANSION + 1 bytes. Return the output length. */
+size_t render_escape_html_into(char *dst, const char *src, size_t len);
+size_t render_escape_js_into(char *dst, const char *src, size_t len);
+size_t render_escape_json_into(char *dst, const char *src, size_t len);
+
+int render_buf_init(render_buf_t *buf, size_t capacity);
+void render_buf_free(render_buf_t *buf);
+void render_buf_reset(render_buf_t *buf);
+int render_buf_reserve(render_buf_t *buf, size_t extra);
+int render_buf_append(render_buf_t *buf, const char *data, size_t len);
+int render_buf_append_str(render_buf_t *buf, const char *str);
+int render_buf_appendf(render_buf_t *buf, const char *fmt, ...);
+int render_buf_append_html(render_buf_t *buf, const char *str);
+int render_buf_append_js(render_buf_t *buf, const char *str);
+int render_buf_append_int(render_buf_t *buf, int64_t value);
+
+/* Appends str as a quoted JSON string; NULL becomes null. */
+int render_buf_append_json(render_buf_t *buf, const char *str);
+
 #endif
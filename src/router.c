@@ -7,13 +7,15 @@
 
 static route_t routes[MAX_ROUTES];
 static size_t route_count = 0;
+static int (*auth_check)(http_request_t *req) = NULL;
 
 void router_init(void) {
     route_count = 0;
     printf("Router initialized\n");
 }
 
-void router_add_route(const char *method, const char *path, route_handler_t handler) {
+void router_add_limited_route(const char *method, const char *path, route_handler_t handler,
+                              size_t max_body, int flags) {
     if (route_count >= MAX_ROUTES) {
         fprintf(stderr, "Router: maximum routes exceeded\n");
         return;
@@ -22,24 +24,70 @@ void router_add_route(const char *method, const char *path, route_handler_t hand
     routes[route_count].method = method;
     routes[route_count].path = path;
     routes[route_count].handler = handler;
+    routes[route_count].max_body = max_body;
+    routes[route_count].flags = flags;
     route_count++;
     
     printf("Route added: %s %s\n", method, path);
 }
 
-http_response_t *router_dispatch(http_request_t *req) {
+void router_add_route(const char *method, const char *path, route_handler_t handler) {
+    router_add_limited_route(method, path, handler, ROUTER_MAX_BODY, 0);
+}
+
+void router_set_auth_check(int (*check)(http_request_t *req)) {
+    auth_check = check;
+}
+
+/* A route path ending in '*' matches any request path with that prefix. */
+static int path_matches(const char *route_path, const char *path) {
+    size_t len = strlen(route_path);
+    if (len > 0 && route_path[len - 1] == '*') {
+        return strncmp(route_path, path, len - 1) == 0;
+    }
+    return strcmp(route_path, path) == 0;
+}
+
+const route_t *router_match(const http_request_t *req) {
     for (size_t i = 0; i < route_count; i++) {
         if (strcmp(req->method, routes[i].method) == 0 &&
-            strcmp(req->path, routes[i].path) == 0) {
-            return routes[i].handler(req);
+            path_matches(routes[i].path, req->path)) {
+            return &routes[i];
         }
     }
+    return NULL;
+}
+
+http_response_t *router_admit(const route_t *route, http_request_t *req) {
+    if (!route) {
+        return NULL;
+    }
+    if ((route->flags & ROUTE_AUTH) && !(auth_check && auth_check(req))) {
+        const char *unauthorized = "Authentication required";
+        return http_response_create(401, "text/plain", unauthorized, strlen(unauthorized));
+    }
+    if (req->content_length > route->max_body) {
+        const char *too_large = "Request body too large";
+        return http_response_create(413, "text/plain", too_large, strlen(too_large));
+    }
+    return NULL;
+}
+
+http_response_t *router_handle(const route_t *route, http_request_t *req) {
+    if (route) {
+        return route->handler(req);
+    }
     
     const char *not_found = "404 Not Found";
     return http_response_create(404, "text/plain", not_found, strlen(not_found));
 }
 
+http_response_t *router_dispatch(http_request_t *req) {
+    return router_handle(router_match(req), req);
+}
+
 void router_cleanup(void) {
     route_count = 0;
+    auth_check = NULL;
     printf("Router cleaned up\n");
 }
@@ -2,17 +2,46 @@
 #define ROUTER_H
 
 #include "http.h"
+#include <stddef.h>
 
 typedef http_response_t *(*route_handler_t)(http_request_t *req);
 
+/* Bodies declared larger than this are refused with 413 before they are
+ * read, unless the route was added with its own limit. The server buffers
+ * bodies of up to this size whole in req->body; routes with a larger
+ * limit read the rest with http_request_read_body(). */
+#define ROUTER_MAX_BODY (8 * 1024)
+
+#define ROUTE_AUTH 0x1                  /* refused with 401 without a session */
+
 typedef struct {
     const char *method;
     const char *path;
     route_handler_t handler;
+    size_t max_body;                    /* largest Content-Length accepted */
+    int flags;                          /* ROUTE_* */
 } route_t;
 
 void router_init(void);
 void router_add_route(const char *method, const char *path, route_handler_t handler);
+
+/* Adds a route that accepts bodies up to max_body bytes. */
+void router_add_limited_route(const char *method, const char *path, route_handler_t handler,
+                              size_t max_body, int flags);
+
+/* Sets the check used for ROUTE_AUTH routes; without one they are refused. */
+void router_set_auth_check(int (*check)(http_request_t *req));
+
+/* The route for req, or NULL. */
+const route_t *router_match(const http_request_t *req);
+
+/* Decides from the headers alone whether route takes req: returns NULL to
+ * go ahead, or a 401 or 413 response to send without reading the body. */
+http_response_t *router_admit(const route_t *route, http_request_t *req);
+
+/* Runs route's handler, or answers 404 when route is NULL. */
+http_response_t *router_handle(const route_t *route, http_request_t *req);
+
 http_response_t *router_dispatch(http_request_t *req);
 void router_cleanup(void);
 
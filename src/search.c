@@ -0,0 +1,449 @@
+#define _POSIX_C_SOURCE 200809L
+#include "search.h"
+#include "router.h"
+#include "db.h"
+#include "render.h"
+#include "i18n.h"
+#include "html_template.h"
+#include "utils.h"
+#include "cjk_tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SEARCH_QUERY_MAX 256
+#define SEARCH_MAX_PAGE 50
+#define SEARCH_THREAD_HITS 5
+
+static const char *search_schema_sql =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS posts_fts USING fts5("
+    "    content, content='posts', content_rowid='id', tokenize='cjk'"
+    ");"
+    "CREATE VIRTUAL TABLE IF NOT EXISTS threads_fts USING fts5("
+    "    subject, content='threads', content_rowid='id', tokenize='cjk'"
+    ");"
+    "CREATE TRIGGER IF NOT EXISTS posts_fts_insert AFTER INSERT ON posts BEGIN"
+    "    INSERT INTO posts_fts (rowid, content) VALUES (new.id, new.content);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS posts_fts_delete AFTER DELETE ON posts BEGIN"
+    "    INSERT INTO posts_fts (posts_fts, rowid, content) VALUES ('delete', old.id, old.content);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS posts_fts_update AFTER UPDATE OF content ON posts BEGIN"
+    "    INSERT INTO posts_fts (posts_fts, rowid, content) VALUES ('delete', old.id, old.content);"
+    "    INSERT INTO posts_fts (rowid, content) VALUES (new.id, new.content);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS threads_fts_insert AFTER INSERT ON threads BEGIN"
+    "    INSERT INTO threads_fts (rowid, subject) VALUES (new.id, new.subject);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS threads_fts_delete AFTER DELETE ON threads BEGIN"
+    "    INSERT INTO threads_fts (threads_fts, rowid, subject) VALUES ('delete', old.id, old.subject);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS threads_fts_update AFTER UPDATE OF subject ON threads BEGIN"
+    "    INSERT INTO threads_fts (threads_fts, rowid, subject) VALUES ('delete', old.id, old.subject);"
+    "    INSERT INTO threads_fts (rowid, subject) VALUES (new.id, new.subject);"
+    "END;";
+
+/* Returns 1 if the index exists with the current tokenizer, 0 if it is
+ * missing, -1 if it was built with an older tokenizer. */
+static int fts_table_state(void) {
+    int state = 0;
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'posts_fts'"
+    );
+    if (stmt) {
+        if (db_step(stmt) == SQLITE_ROW) {
+            const char *sql = (const char *)sqlite3_column_text(stmt, 0);
+            state = sql && strstr(sql, "tokenize='cjk'") ? 1 : -1;
+        }
+        db_finalize(stmt);
+    }
+    return state;
+}
+
+int search_init(void) {
+    int state = fts_table_state();
+    
+    if (state < 0) {
+        printf("Search index uses an old tokenizer, recreating...\n");
+        if (db_exec("DROP TABLE posts_fts; DROP TABLE threads_fts;") != 0) {
+            return -1;
+        }
+    }
+    
+    if (db_exec(search_schema_sql) != 0) {
+        fprintf(stderr, "Failed to create search index (is SQLite built with FTS5?)\n");
+        return -1;
+    }
+    
+    if (state != 1) {
+        printf("Search index created, indexing existing posts...\n");
+        if (search_rebuild() != 0) {
+            return -1;
+        }
+    }
+    
+    printf("Search module initialized\n");
+    return 0;
+}
+
+int search_rebuild(void) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    int rc = db_exec(
+        "INSERT INTO posts_fts (posts_fts) VALUES ('rebuild');"
+        "INSERT INTO threads_fts (threads_fts) VALUES ('rebuild');"
+        "INSERT INTO posts_fts (posts_fts) VALUES ('optimize');"
+        "INSERT INTO threads_fts (threads_fts) VALUES ('optimize');"
+    );
+    if (rc != 0) {
+        fprintf(stderr, "Failed to rebuild search index\n");
+        return -1;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Search index rebuilt in %.1f ms\n",
+           (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0);
+    return 0;
+}
+
+int search_build_match(const char *input, char *out, size_t out_size) {
+    size_t len = 0;
+    int terms = 0;
+    
+    if (out_size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    
+    const char *p = input;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+    
+        const char *word = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+            p++;
+        }
+        const char *word_end = p;
+    
+        int prefix = 0;
+        if (word_end - word > 1 && word_end[-1] == '*') {
+            prefix = 1;
+            word_end--;
+        }
+        
+        /* CJK text is indexed as bigrams, so a lone character can only be
+         * found as the prefix of one. */
+        uint32_t cp;
+        int cp_len = cjk_decode_utf8((const unsigned char *)word, (int)(word_end - word), &cp);
+        if (cp_len == word_end - word && cjk_is_cjk(cp)) {
+            prefix = 1;
+        }
+    
+        /* Worst case every byte is a doubled quote, plus quotes, '*' and space. */
+        size_t need = (size_t)(word_end - word) * 2 + 4;
+        if (len + need >= out_size) {
+            break;
+        }
+    
+        if (terms > 0) {
+            out[len++] = ' ';
+        }
+        out[len++] = '"';
+        for (const char *c = word; c < word_end; c++) {
+            if (*c == '"') {
+                out[len++] = '"';
+            }
+            out[len++] = *c;
+        }
+        out[len++] = '"';
+        if (prefix) {
+            out[len++] = '*';
+        }
+        out[len] = '\0';
+        terms++;
+    }
+    
+    return terms;
+}
+
+static int collect_hits(sqlite3_stmt *stmt, int limit, search_hit_t **hits) {
+    search_hit_t *list = calloc(limit > 0 ? limit : 1, sizeof(search_hit_t));
+    if (!list) {
+        db_finalize(stmt);
+        return -1;
+    }
+    
+    int count = 0;
+    int rc = SQLITE_DONE;
+    while (count < limit && (rc = db_step(stmt)) == SQLITE_ROW) {
+        const char *subject = (const char *)sqlite3_column_text(stmt, 2);
+        const char *snippet = (const char *)sqlite3_column_text(stmt, 3);
+    
+        list[count].post_id = sqlite3_column_int64(stmt, 0);
+        list[count].thread_id = sqlite3_column_int64(stmt, 1);
+        list[count].subject = strdup(subject ? subject : "");
+        list[count].snippet = strdup(snippet ? snippet : "");
+        count++;
+    }
+    
+    if (count == 0 && rc != SQLITE_DONE && rc != SQLITE_ROW) {
+        fprintf(stderr, "Search query failed: %s\n", sqlite3_errmsg(db_get_connection()));
+        db_finalize(stmt);
+        free(list);
+        return -1;
+    }
+    
+    db_finalize(stmt);
+    *hits = list;
+    return count;
+}
+
+int search_posts(const char *match, int offset, int limit, search_hit_t **hits) {
+    /* The inner query lets FTS5 produce rows already ordered by rank, so
+     * snippets are built only for the requested page. */
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT p.id, p.thread_id, t.subject, f.snip FROM ("
+        "    SELECT rowid, rank, snippet(posts_fts, 0, char(1), char(2), '…', 24) AS snip"
+        "    FROM posts_fts WHERE posts_fts MATCH ? ORDER BY rank LIMIT ? OFFSET ?"
+        ") f "
+        "JOIN posts p ON p.id = f.rowid "
+        "JOIN threads t ON t.id = p.thread_id "
+        "ORDER BY f.rank"
+    );
+    if (!stmt) {
+        return -1;
+    }
+    
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, limit);
+    sqlite3_bind_int(stmt, 3, offset);
+    return collect_hits(stmt, limit, hits);
+}
+
+int search_threads(const char *match, int limit, search_hit_t **hits) {
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT 0, rowid, subject, highlight(threads_fts, 0, char(1), char(2)) "
+        "FROM threads_fts WHERE threads_fts MATCH ? ORDER BY rank LIMIT ?"
+    );
+    if (!stmt) {
+        return -1;
+    }
+    
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, limit);
+    return collect_hits(stmt, limit, hits);
+}
+
+void search_hits_free(search_hit_t *hits, int count) {
+    if (!hits) {
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        free(hits[i].subject);
+        free(hits[i].snippet);
+    }
+    free(hits);
+}
+
+void search_register_routes(void) {
+    router_add_route("GET", "/search", search_handler);
+}
+
+/* Escapes a snippet and turns the match markers into <mark> tags. */
+static char *highlight_html(const char *snippet) {
+    char *escaped = render_escape_html(snippet);
+    if (!escaped) {
+        return NULL;
+    }
+    
+    size_t marks = 0;
+    for (const char *c = escaped; *c; c++) {
+        if (*c == SEARCH_MARK_START[0] || *c == SEARCH_MARK_END[0]) {
+            marks++;
+        }
+    }
+    
+    char *html = malloc(strlen(escaped) + marks * 7 + 1);
+    if (!html) {
+        free(escaped);
+        return NULL;
+    }
+    
+    char *out = html;
+    for (const char *c = escaped; *c; c++) {
+        if (*c == SEARCH_MARK_START[0]) {
+            memcpy(out, "<mark>", 6);
+            out += 6;
+        } else if (*c == SEARCH_MARK_END[0]) {
+            memcpy(out, "</mark>", 7);
+            out += 7;
+        } else {
+            *out++ = *c;
+        }
+    }
+    *out = '\0';
+    
+    free(escaped);
+    return html;
+}
+
+static void url_encode(char *dst, const char *src, size_t dst_size) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t j = 0;
+    
+    for (const unsigned char *c = (const unsigned char *)src; *c && j + 4 < dst_size; c++) {
+        if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+            (*c >= '0' && *c <= '9') || *c == '-' || *c == '_' || *c == '.') {
+            dst[j++] = *c;
+        } else {
+            dst[j++] = '%';
+            dst[j++] = hex[*c >> 4];
+            dst[j++] = hex[*c & 15];
+        }
+    }
+    dst[j] = '\0';
+}
+
+/* Appends the shared page header (or footer), which html_template.c
+ * renders into a fixed buffer. */
+static int append_chrome(render_buf_t *out, const char *title, language_t lang, int header) {
+    char chrome[8192];
+    int len = 0;
+    if (header) {
+        html_render_header(chrome, sizeof(chrome), &len, title, lang);
+    } else {
+        html_render_footer(chrome, sizeof(chrome), &len);
+    }
+    if (len < 0 || (size_t)len >= sizeof(chrome)) {
+        return -1;
+    }
+    return render_buf_append(out, chrome, (size_t)len);
+}
+
+static http_response_t *search_response(render_buf_t *out, int rc) {
+    http_response_t *response;
+    if (rc != 0) {
+        const char *err = "<html><body><h1>Error: Out of memory</h1></body></html>";
+        response = http_response_create(500, "text/html", err, strlen(err));
+    } else {
+        response = http_response_create(200, "text/html", out->data, out->len);
+    }
+    render_buf_free(out);
+    return response;
+}
+
+http_response_t *search_handler(http_request_t *req) {
+    language_t lang = i18n_get_language(req);
+    
+    char query[SEARCH_QUERY_MAX] = "";
+    char page_str[16] = "";
+    get_query_param(req->query_string, "q", query, sizeof(query));
+    get_query_param(req->query_string, "page", page_str, sizeof(page_str));
+    
+    int page = atoi(page_str);
+    if (page < 1) {
+        page = 1;
+    }
+    if (page > SEARCH_MAX_PAGE) {
+        page = SEARCH_MAX_PAGE;
+    }
+    
+    render_buf_t out;
+    render_buf_init(&out, 16384);
+    int rc = append_chrome(&out, i18n_get(lang, "search"), lang, 1);
+    rc |= render_buf_appendf(&out,
+        "<div class=\"card header-card\">\n"
+        "<h1>🔍 %s</h1>\n"
+        "<a href=\"/\" class=\"nav-link\">%s</a>\n"
+        "</div>\n"
+        "<form method=\"GET\" action=\"/search\" class=\"card\">\n"
+        "<input type=\"text\" name=\"q\" value=\"",
+        i18n_get(lang, "search"),
+        i18n_get(lang, "back_to_boards"));
+    rc |= render_buf_append_html(&out, query);
+    rc |= render_buf_appendf(&out,
+        "\" required>\n"
+        "<button type=\"submit\" class=\"btn\">%s</button>\n"
+        "</form>\n",
+        i18n_get(lang, "search"));
+    
+    char match[SEARCH_QUERY_MAX * 2 + 8];
+    if (search_build_match(query, match, sizeof(match)) == 0) {
+        rc |= append_chrome(&out, NULL, lang, 0);
+        return search_response(&out, rc);
+    }
+    
+    search_hit_t *hits = NULL;
+    int count;
+    
+    if (page == 1) {
+        count = search_threads(match, SEARCH_THREAD_HITS, &hits);
+        if (count > 0) {
+            rc |= render_buf_appendf(&out,
+                "<div class=\"card\">\n<h2>%s</h2>\n<ul>\n",
+                i18n_get(lang, "matching_threads"));
+            for (int i = 0; i < count; i++) {
+                char *subject = highlight_html(hits[i].snippet);
+                rc |= render_buf_appendf(&out, "<li><a href=\"/thread?id=%lld\">",
+                                         (long long)hits[i].thread_id);
+                rc |= render_buf_append_str(&out, subject ? subject : "");
+                rc |= render_buf_append_str(&out, "</a></li>\n");
+                free(subject);
+            }
+            rc |= render_buf_append_str(&out, "</ul>\n</div>\n");
+        }
+        search_hits_free(hits, count);
+        hits = NULL;
+    }
+    
+    /* One extra row tells us whether a next page exists without a COUNT. */
+    int fetched = search_posts(match, (page - 1) * SEARCH_PAGE_SIZE, SEARCH_PAGE_SIZE + 1, &hits);
+    int has_next = fetched > SEARCH_PAGE_SIZE;
+    count = has_next ? SEARCH_PAGE_SIZE : fetched;
+    
+    if (count <= 0) {
+        rc |= render_buf_appendf(&out,
+            "<div class=\"card\"><p>%s</p></div>\n",
+            i18n_get(lang, "no_results"));
+    }
+    
+    for (int i = 0; i < count; i++) {
+        char *snippet = highlight_html(hits[i].snippet);
+        rc |= render_buf_appendf(&out, "<div class=\"card\">\n<a href=\"/thread?id=%lld#post-%lld\">",
+                                 (long long)hits[i].thread_id,
+                                 (long long)hits[i].post_id);
+        rc |= render_buf_append_html(&out, hits[i].subject);
+        rc |= render_buf_appendf(&out, "</a> <span>#%lld</span>\n<p>",
+                                 (long long)hits[i].post_id);
+        rc |= render_buf_append_str(&out, snippet ? snippet : "");
+        rc |= render_buf_append_str(&out, "</p>\n</div>\n");
+        free(snippet);
+    }
+    search_hits_free(hits, fetched);
+    
+    char encoded[SEARCH_QUERY_MAX * 3 + 1];
+    url_encode(encoded, query, sizeof(encoded));
+    
+    rc |= render_buf_append_str(&out, "<div class=\"card\">\n");
+    if (page > 1) {
+        rc |= render_buf_appendf(&out,
+            "<a href=\"/search?q=%s&amp;page=%d\">&laquo; %s</a>\n",
+            encoded, page - 1, i18n_get(lang, "prev_page"));
+    }
+    if (has_next && page < SEARCH_MAX_PAGE) {
+        rc |= render_buf_appendf(&out,
+            "<a href=\"/search?q=%s&amp;page=%d\">%s &raquo;</a>\n",
+            encoded, page + 1, i18n_get(lang, "next_page"));
+    }
+    rc |= render_buf_append_str(&out, "</div>\n");
+    rc |= append_chrome(&out, NULL, lang, 0);
+    
+    return search_response(&out, rc);
+}
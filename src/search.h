@@ -0,0 +1,51 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "http.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Full-text search over posts.content and threads.subject using FTS5
+ * external-content tables (posts_fts, threads_fts). The indexes hold only
+ * the inverted lists; triggers on posts/threads keep them in sync. Both use
+ * the "cjk" tokenizer, so cjk_tokenizer_install() must run before db_init().
+ */
+
+/* Snippets returned by search_posts() mark matched terms with these bytes;
+ * escape the text first, then replace them with markup. */
+#define SEARCH_MARK_START "\x01"
+#define SEARCH_MARK_END "\x02"
+
+#define SEARCH_PAGE_SIZE 20
+
+typedef struct {
+    int64_t post_id;
+    int64_t thread_id;
+    char *subject;
+    char *snippet;
+} search_hit_t;
+
+/* Creates the FTS tables and triggers; indexes existing rows the first time
+ * the tables are created. Call after db_migrate(). */
+int search_init(void);
+
+/* Re-reads every post and thread into the indexes. */
+int search_rebuild(void);
+
+/* Turns free text into an FTS5 query: every word becomes a quoted phrase so
+ * user input can never be parsed as FTS5 syntax; a trailing '*' is kept as a
+ * prefix search, and a single CJK character always becomes one. Returns
+ * the number of terms, 0 when nothing is searchable. */
+int search_build_match(const char *input, char *out, size_t out_size);
+
+/* Best-ranked posts first. Fetches up to limit hits into *hits (caller frees
+ * with search_hits_free). Returns the hit count or -1 on error. */
+int search_posts(const char *match, int offset, int limit, search_hit_t **hits);
+int search_threads(const char *match, int limit, search_hit_t **hits);
+void search_hits_free(search_hit_t *hits, int count);
+
+void search_register_routes(void);
+http_response_t *search_handler(http_request_t *req);
+
+#endif
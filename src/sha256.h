@@ -0,0 +1,29 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SHA-256 (FIPS 180-4), fed incrementally so uploads are hashed while
+ * they stream to disk.
+ */
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE (SHA256_DIGEST_SIZE * 2 + 1)
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;                /* bytes hashed so far */
+    uint8_t block[64];
+    size_t block_len;
+} sha256_t;
+
+void sha256_init(sha256_t *ctx);
+void sha256_update(sha256_t *ctx, const void *data, size_t len);
+void sha256_final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/* Lowercase hex of digest, NUL-terminated. */
+void sha256_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char hex[SHA256_HEX_SIZE]);
+
+#endif
@@ -0,0 +1,572 @@
+#define _POSIX_C_SOURCE 200809L
+#include "static_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/sendfile.h>
+
+#define STATIC_PATH_MAX 512
+
+typedef struct {
+    char path[STATIC_PATH_MAX];
+    uint64_t hash;
+    int fd;
+    int refs;                       /* transfers using fd, plus one while cached */
+    int64_t size;
+    time_t mtime;
+    uint64_t last_used;
+} cached_file_t;
+
+typedef struct {
+    int sock;
+    cached_file_t *file;
+    off_t offset;
+    off_t end;                      /* one past the last byte to send */
+    int64_t last_progress_ms;
+} transfer_t;
+
+/* What the detached response hands to the sender. */
+typedef struct {
+    cached_file_t *file;
+    off_t offset;
+    off_t end;
+} file_body_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cached_file_t *cache[STATIC_FD_CACHE_SIZE];
+static uint64_t cache_clock = 0;
+
+static pthread_mutex_t sender_mutex = PTHREAD_MUTEX_INITIALIZER;
+static transfer_t *transfers[STATIC_MAX_TRANSFERS];
+static int transfer_count = 0;
+static int sender_running = 0;
+static int sender_stopping = 0;
+static int wake_fds[2] = { -1, -1 };
+static pthread_t sender_thread;
+
+static const struct {
+    const char *extension;
+    const char *type;
+} content_types[] = {
+    { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" },
+    { "png", "image/png" },
+    { "gif", "image/gif" },
+    { "webp", "image/webp" },
+    { "avif", "image/avif" },
+    { "mp4", "video/mp4" },
+    { "webm", "video/webm" },
+    { "mp3", "audio/mpeg" },
+    { "ogg", "audio/ogg" },
+    { "opus", "audio/ogg" },
+    { "flac", "audio/flac" },
+    { "txt", "text/plain; charset=utf-8" },
+    { "pdf", "application/pdf" },
+};
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash = (hash ^ *p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void wake_sender(void) {
+    char byte = 1;
+    if (write(wake_fds[1], &byte, 1) < 0) {
+        /* The pipe is full, so a wakeup is already pending. */
+    }
+}
+
+/* Drops one reference; the last one closes the descriptor. Caller holds
+ * cache_mutex. */
+static void unref_locked(cached_file_t *file) {
+    if (--file->refs == 0) {
+        close(file->fd);
+        free(file);
+    }
+}
+
+static void file_release(cached_file_t *file) {
+    if (file) {
+        pthread_mutex_lock(&cache_mutex);
+        unref_locked(file);
+        pthread_mutex_unlock(&cache_mutex);
+    }
+}
+
+/* Returns a referenced entry for path, reusing the cached descriptor when
+ * the file is still linked. Files replaced in place are seen through the
+ * same descriptor; fstat() refreshes their size and time. */
+static cached_file_t *file_acquire(const char *path) {
+    uint64_t hash = hash_path(path);
+    struct stat st;
+    
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < STATIC_FD_CACHE_SIZE; i++) {
+        cached_file_t *file = cache[i];
+        if (!file || file->hash != hash || strcmp(file->path, path) != 0) {
+            continue;
+        }
+        if (fstat(file->fd, &st) == 0 && st.st_nlink > 0) {
+            file->size = st.st_size;
+            file->mtime = st.st_mtime;
+            file->last_used = ++cache_clock;
+            file->refs++;
+            pthread_mutex_unlock(&cache_mutex);
+            return file;
+        }
+        /* Deleted since it was cached. */
+        cache[i] = NULL;
+        unref_locked(file);
+        break;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    
+    cached_file_t *file = calloc(1, sizeof(cached_file_t));
+    if (!file) {
+        close(fd);
+        return NULL;
+    }
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    file->hash = hash;
+    file->fd = fd;
+    file->size = st.st_size;
+    file->mtime = st.st_mtime;
+    file->refs = 2;
+    
+    /* Take a free slot, or evict the least recently used entry. A
+     * transfer still holding the evicted one keeps it open. */
+    pthread_mutex_lock(&cache_mutex);
+    file->last_used = ++cache_clock;
+    int victim = 0;
+    for (int i = 0; i < STATIC_FD_CACHE_SIZE; i++) {
+        if (!cache[i]) {
+            victim = i;
+            break;
+        }
+        if (cache[i]->last_used < cache[victim]->last_used) {
+            victim = i;
+        }
+    }
+    if (cache[victim]) {
+        unref_locked(cache[victim]);
+    }
+    cache[victim] = file;
+    pthread_mutex_unlock(&cache_mutex);
+    return file;
+}
+
+/* Sends until the socket would block. Returns 1 when the transfer is
+ * finished, 0 when it should wait for POLLOUT and -1 when it failed. */
+static int transfer_step(transfer_t *transfer) {
+    while (transfer->offset < transfer->end) {
+        ssize_t sent = sendfile(transfer->sock, transfer->file->fd, &transfer->offset,
+                                (size_t)(transfer->end - transfer->offset));
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        if (sent == 0) {
+            /* The file shrank under us. */
+            return -1;
+        }
+        transfer->last_progress_ms = now_ms();
+    }
+    return 1;
+}
+
+static void transfer_finish(transfer_t *transfer) {
+    close(transfer->sock);
+    file_release(transfer->file);
+    free(transfer);
+}
+
+static void *sender_main(void *arg) {
+    (void)arg;
+    
+    static struct pollfd fds[STATIC_MAX_TRANSFERS + 1];
+    char scratch[64];
+    
+    pthread_mutex_lock(&sender_mutex);
+    while (!sender_stopping) {
+        fds[0].fd = wake_fds[0];
+        fds[0].events = POLLIN;
+        nfds_t count = 1;
+        for (int i = 0; i < transfer_count; i++) {
+            fds[count].fd = transfers[i]->sock;
+            fds[count].events = POLLOUT;
+            fds[count].revents = 0;
+            count++;
+        }
+        int polled = transfer_count;
+        pthread_mutex_unlock(&sender_mutex);
+    
+        int ready = poll(fds, count, 1000);
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "Static files: poll() error: %s\n", strerror(errno));
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            while (read(wake_fds[0], scratch, sizeof(scratch)) > 0) {
+            }
+        }
+    
+        pthread_mutex_lock(&sender_mutex);
+    
+        /* New transfers are only appended, so the first `polled` entries
+         * are the ones in fds. Walk backwards so removal keeps indexes. */
+        int64_t now = now_ms();
+        for (int i = polled - 1; i >= 0; i--) {
+            transfer_t *transfer = transfers[i];
+            short revents = fds[i + 1].revents;
+            int state = 0;
+            if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                state = -1;
+            } else if (revents & POLLOUT) {
+                state = transfer_step(transfer);
+            } else if (now - transfer->last_progress_ms >= STATIC_STALL_TIMEOUT_MS) {
+                state = -1;
+            }
+            if (state != 0) {
+                transfers[i] = transfers[--transfer_count];
+                transfers[transfer_count] = NULL;
+                transfer_finish(transfer);
+            }
+        }
+    }
+    pthread_mutex_unlock(&sender_mutex);
+    return NULL;
+}
+
+int static_file_start(void) {
+    if (pipe(wake_fds) != 0) {
+        fprintf(stderr, "Failed to create static file wake pipe: %s\n", strerror(errno));
+        return -1;
+    }
+    set_nonblocking(wake_fds[0]);
+    set_nonblocking(wake_fds[1]);
+    
+    sender_stopping = 0;
+    if (pthread_create(&sender_thread, NULL, sender_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start static file sender: %s\n", strerror(errno));
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        wake_fds[0] = wake_fds[1] = -1;
+        return -1;
+    }
+    
+    sender_running = 1;
+    printf("Static file sender started (up to %d transfers, %d cached descriptors)\n",
+           STATIC_MAX_TRANSFERS, STATIC_FD_CACHE_SIZE);
+    return 0;
+}
+
+void static_file_stop(void) {
+    if (sender_running) {
+        pthread_mutex_lock(&sender_mutex);
+        sender_stopping = 1;
+        pthread_mutex_unlock(&sender_mutex);
+        wake_sender();
+        pthread_join(sender_thread, NULL);
+        
+        pthread_mutex_lock(&sender_mutex);
+        while (transfer_count > 0) {
+            transfer_count--;
+            transfer_finish(transfers[transfer_count]);
+            transfers[transfer_count] = NULL;
+        }
+        sender_running = 0;
+        pthread_mutex_unlock(&sender_mutex);
+        
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        wake_fds[0] = wake_fds[1] = -1;
+    }
+    
+    pthread_mutex_lock(&cache_mutex);
+    for (int i = 0; i < STATIC_FD_CACHE_SIZE; i++) {
+        if (cache[i]) {
+            unref_locked(cache[i]);
+            cache[i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+static void file_body_free(void *ctx) {
+    file_body_t *body = ctx;
+    file_release(body->file);
+    free(body);
+}
+
+/* Runs on the worker once the headers are out. Whatever the socket takes
+ * right away is sent here; the rest goes to the sender thread. */
+static void file_body_attach(int client_fd, void *ctx) {
+    file_body_t *body = ctx;
+    transfer_t *transfer = calloc(1, sizeof(transfer_t));
+    if (!transfer) {
+        close(client_fd);
+        return;
+    }
+    transfer->sock = client_fd;
+    transfer->file = body->file;
+    transfer->offset = body->offset;
+    transfer->end = body->end;
+    transfer->last_progress_ms = now_ms();
+    body->file = NULL;
+    
+    int blocking = 0;
+    pthread_mutex_lock(&sender_mutex);
+    if (!sender_running || transfer_count >= STATIC_MAX_TRANSFERS) {
+        blocking = 1;
+    }
+    pthread_mutex_unlock(&sender_mutex);
+    
+    /* Without the sender, the worker sends the whole file itself, but
+     * drops a client that stalls as long as the sender would. */
+    if (!blocking && set_nonblocking(client_fd) != 0) {
+        blocking = 1;
+    }
+    if (blocking) {
+        struct timeval timeout = { STATIC_STALL_TIMEOUT_MS / 1000, 0 };
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+    int state = transfer_step(transfer);
+    if (state != 0 || blocking) {
+        transfer_finish(transfer);
+        return;
+    }
+    
+    pthread_mutex_lock(&sender_mutex);
+    if (sender_running && !sender_stopping && transfer_count < STATIC_MAX_TRANSFERS) {
+        transfers[transfer_count++] = transfer;
+        transfer = NULL;
+    }
+    pthread_mutex_unlock(&sender_mutex);
+    
+    if (transfer) {
+        transfer_finish(transfer);
+    } else {
+        wake_sender();
+    }
+}
+
+int static_file_parse_range(const char *header, int64_t size, int64_t *start, int64_t *end) {
+    if (strncmp(header, "bytes=", 6) != 0 || strchr(header, ',')) {
+        return 1;
+    }
+    const char *spec = header + 6;
+    char *rest;
+    
+    if (*spec == '-') {
+        /* Suffix range: the last N bytes. */
+        long long suffix = strtoll(spec + 1, &rest, 10);
+        if (rest == spec + 1 || *rest != '\0' || suffix < 0) {
+            return 1;
+        }
+        if (suffix == 0 || size == 0) {
+            return -1;
+        }
+        *start = suffix >= size ? 0 : size - suffix;
+        *end = size - 1;
+        return 0;
+    }
+    
+    if (*spec < '0' || *spec > '9') {
+        return 1;
+    }
+    long long first = strtoll(spec, &rest, 10);
+    if (*rest != '-') {
+        return 1;
+    }
+    const char *last_str = rest + 1;
+    long long last = size - 1;
+    if (*last_str != '\0') {
+        if (*last_str < '0' || *last_str > '9') {
+            return 1;
+        }
+        last = strtoll(last_str, &rest, 10);
+        if (*rest != '\0' || last < first) {
+            return 1;
+        }
+    }
+    if (first >= size) {
+        return -1;
+    }
+    *start = first;
+    *end = last >= size ? size - 1 : last;
+    return 0;
+}
+
+const char *static_file_content_type(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *dot = strrchr(slash ? slash : path, '.');
+    if (dot) {
+        for (size_t i = 0; i < sizeof(content_types) / sizeof(content_types[0]); i++) {
+            if (strcasecmp(dot + 1, content_types[i].extension) == 0) {
+                return content_types[i].type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+/* Rejects empty names, absolute paths and any segment starting with '.',
+ * which covers "..", "." and hidden files. */
+static int path_is_safe(const char *rel_path) {
+    if (*rel_path == '\0' || *rel_path == '/') {
+        return 0;
+    }
+    for (const char *segment = rel_path; segment; ) {
+        if (*segment == '.' || *segment == '/' || *segment == '\0') {
+            return 0;
+        }
+        const char *slash = strchr(segment, '/');
+        segment = slash ? slash + 1 : NULL;
+    }
+    return strchr(rel_path, '\\') == NULL;
+}
+
+static http_response_t *plain_error(int status, const char *message) {
+    return http_response_create(status, "text/plain", message, strlen(message));
+}
+
+http_response_t *static_file_serve(http_request_t *req, const char *root, const char *rel_path,
+                                   const char *content_type) {
+    char path[STATIC_PATH_MAX];
+    if (!path_is_safe(rel_path) ||
+        snprintf(path, sizeof(path), "%s/%s", root, rel_path) >= (int)sizeof(path)) {
+        return plain_error(404, "404 Not Found");
+    }
+    
+    cached_file_t *file = file_acquire(path);
+    if (!file) {
+        return plain_error(404, "404 Not Found");
+    }
+    if (!content_type) {
+        content_type = static_file_content_type(rel_path);
+    }
+    int64_t size = file->size;
+    
+    char last_modified[64];
+    struct tm tm;
+    gmtime_r(&file->mtime, &tm);
+    strftime(last_modified, sizeof(last_modified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    
+    char value[96];
+    http_response_t *response;
+    
+    if (req->if_modified_since && strcmp(req->if_modified_since, last_modified) == 0) {
+        file_release(file);
+        response = http_response_create(304, content_type, NULL, 0);
+        if (response && http_response_add_header(response, "Last-Modified", last_modified) != 0) {
+            http_response_free(response);
+            response = NULL;
+        }
+        return response;
+    }
+    
+    int64_t start = 0;
+    int64_t end = size - 1;
+    int range = req->range ? static_file_parse_range(req->range, size, &start, &end) : 1;
+    if (range < 0) {
+        file_release(file);
+        response = plain_error(416, "416 Range Not Satisfiable");
+        snprintf(value, sizeof(value), "bytes */%lld", (long long)size);
+        if (response && http_response_add_header(response, "Content-Range", value) != 0) {
+            http_response_free(response);
+            response = NULL;
+        }
+        return response;
+    }
+    if (range > 0) {
+        start = 0;
+        end = size - 1;
+    }
+    
+    /* A full sender would leave the download to the worker. */
+    pthread_mutex_lock(&sender_mutex);
+    int full = sender_running && transfer_count >= STATIC_MAX_TRANSFERS;
+    pthread_mutex_unlock(&sender_mutex);
+    if (full) {
+        file_release(file);
+        response = plain_error(503, "503 Service Unavailable");
+        if (response && http_response_add_header(response, "Retry-After", "1") != 0) {
+            http_response_free(response);
+            response = NULL;
+        }
+        return response;
+    }
+    
+    file_body_t *body = malloc(sizeof(file_body_t));
+    if (!body) {
+        file_release(file);
+        return plain_error(500, "Out of memory");
+    }
+    body->file = file;
+    body->offset = (off_t)start;
+    body->end = (off_t)(end + 1);
+    
+    response = http_response_create_detached(range == 0 ? 206 : 200, content_type,
+                                             file_body_attach, body, file_body_free);
+    if (!response) {
+        return NULL;
+    }
+    
+    int rc = 0;
+    snprintf(value, sizeof(value), "%lld", (long long)(end + 1 - start));
+    rc |= http_response_add_header(response, "Content-Length", value);
+    if (range == 0) {
+        snprintf(value, sizeof(value), "bytes %lld-%lld/%lld",
+                 (long long)start, (long long)end, (long long)size);
+        rc |= http_response_add_header(response, "Content-Range", value);
+    }
+    rc |= http_response_add_header(response, "Accept-Ranges", "bytes");
+    rc |= http_response_add_header(response, "Last-Modified", last_modified);
+    rc |= http_response_add_header(response, "X-Content-Type-Options", "nosniff");
+    if (rc != 0) {
+        http_response_free(response);
+        return NULL;
+    }
+    return response;
+}
+
+int static_file_transfer_count(void) {
+    pthread_mutex_lock(&sender_mutex);
+    int count = transfer_count;
+    pthread_mutex_unlock(&sender_mutex);
+    return count;
+}
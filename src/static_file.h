@@ -0,0 +1,45 @@
+#ifndef STATIC_FILE_H
+#define STATIC_FILE_H
+
+#include "http.h"
+#include <stdint.h>
+
+/*
+ * Static files served with sendfile(). Open descriptors of recently served
+ * files are kept in a small cache, so hot files cost neither a path lookup
+ * nor an open(). After the headers, the connection is handed to one sender
+ * thread that polls every transfer and calls sendfile() whenever a socket
+ * can take more, so file bytes never pass through user space and a slow
+ * download does not hold an HTTP worker.
+ */
+
+#define STATIC_FD_CACHE_SIZE 128
+#define STATIC_MAX_TRANSFERS 1024
+#define STATIC_STALL_TIMEOUT_MS 60000
+
+/* Starts the sender thread. Without it, files are sent by the worker. */
+int static_file_start(void);
+
+/* Aborts running transfers and closes every cached descriptor. Call after
+ * http_server_shutdown(). */
+void static_file_stop(void);
+
+/* Serves root/rel_path for req, honouring Range and If-Modified-Since.
+ * Answers 503 while the sender already runs STATIC_MAX_TRANSFERS.
+ * rel_path may contain subdirectories but no segment starting with '.'.
+ * content_type NULL picks one from rel_path's extension. */
+http_response_t *static_file_serve(http_request_t *req, const char *root, const char *rel_path,
+                                   const char *content_type);
+
+/* Parses a "bytes=" Range header against a file of size bytes into an
+ * inclusive [start, end]. Returns 0 for a usable range, 1 when the header
+ * should be ignored (malformed or multiple ranges) and -1 when it cannot
+ * be satisfied. */
+int static_file_parse_range(const char *header, int64_t size, int64_t *start, int64_t *end);
+
+/* MIME type for a file name, from its extension. */
+const char *static_file_content_type(const char *path);
+
+int static_file_transfer_count(void);
+
+#endif
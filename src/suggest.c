@@ -0,0 +1,560 @@
+#define _POSIX_C_SOURCE 200809L
+#include "suggest.h"
+#include "router.h"
+#include "db.h"
+#include "utils.h"
+#include "render.h"
+#include "json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define SUGGEST_MAX_ENTRIES 50000
+#define SUGGEST_REBUILD_ENTRIES 40000
+#define SUGGEST_KEY_MAX 64
+#define SUGGEST_WORDS 4
+#define SUGGEST_QUERY_MAX 256
+
+typedef struct {
+    int64_t thread_id;
+    char *subject;
+} suggest_entry_t;
+
+typedef struct {
+    int count;
+    const suggest_entry_t *entries[SUGGEST_TOP_K];
+} suggest_top_t;
+
+typedef struct suggest_node suggest_node_t;
+
+/* Immutable once published; sorted by the first byte of each child label. */
+typedef struct {
+    int count;
+    suggest_node_t *nodes[];
+} suggest_children_t;
+
+struct suggest_node {
+    _Atomic(suggest_children_t *) children;
+    _Atomic(suggest_top_t *) top;
+    size_t label_len;
+    char label[];
+};
+
+typedef struct {
+    suggest_node_t *root;
+    suggest_entry_t **entries;
+    size_t entry_count;
+} suggest_trie_t;
+
+static _Atomic(suggest_trie_t *) current_trie = NULL;
+
+/* Writer side: one thread mutates at a time. */
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void **retired = NULL;
+static size_t retired_count = 0;
+static size_t retired_capacity = 0;
+
+/*
+ * Grace periods: a reader registers in the counter for the epoch it saw.
+ * The writer bumps the epoch after unlinking nodes and waits for the old
+ * epoch's readers to leave before freeing them.
+ */
+static atomic_uint_fast64_t read_epoch = 0;
+static atomic_int active_readers[2];
+
+static uint64_t read_begin(void) {
+    for (;;) {
+        uint64_t epoch = atomic_load(&read_epoch);
+        atomic_fetch_add(&active_readers[epoch & 1], 1);
+        if (atomic_load(&read_epoch) == epoch) {
+            return epoch;
+        }
+        atomic_fetch_sub(&active_readers[epoch & 1], 1);
+    }
+}
+
+static void read_end(uint64_t epoch) {
+    atomic_fetch_sub(&active_readers[epoch & 1], 1);
+}
+
+static void synchronize_readers(void) {
+    uint64_t epoch = atomic_fetch_add(&read_epoch, 1);
+    while (atomic_load(&active_readers[epoch & 1]) > 0) {
+        sched_yield();
+    }
+}
+
+static void retire(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (retired_count == retired_capacity) {
+        size_t capacity = retired_capacity ? retired_capacity * 2 : 64;
+        void **grown = realloc(retired, capacity * sizeof(void *));
+        if (!grown) {
+            /* Leaking is safer than freeing memory a reader may hold. */
+            return;
+        }
+        retired = grown;
+        retired_capacity = capacity;
+    }
+    retired[retired_count++] = ptr;
+}
+
+static void reclaim_retired(void) {
+    if (retired_count == 0) {
+        return;
+    }
+    synchronize_readers();
+    for (size_t i = 0; i < retired_count; i++) {
+        free(retired[i]);
+    }
+    retired_count = 0;
+}
+
+/* Lowercases ASCII and collapses whitespace so keys and queries compare
+ * byte for byte. */
+static size_t normalize(const char *src, char *dst, size_t dst_size) {
+    size_t len = 0;
+    int pending_space = 0;
+    
+    while (*src == ' ' || *src == '\t' || *src == '\r' || *src == '\n') {
+        src++;
+    }
+    
+    for (; *src && len + 1 < dst_size; src++) {
+        unsigned char c = (unsigned char)*src;
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pending_space = 1;
+            continue;
+        }
+        if (pending_space) {
+            if (len + 2 >= dst_size) {
+                break;
+            }
+            dst[len++] = ' ';
+            pending_space = 0;
+        }
+        dst[len++] = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : (char)c;
+    }
+    
+    dst[len] = '\0';
+    return len;
+}
+
+static suggest_node_t *node_create(const char *label, size_t label_len) {
+    suggest_node_t *node = malloc(sizeof(suggest_node_t) + label_len);
+    if (!node) {
+        return NULL;
+    }
+    atomic_init(&node->children, NULL);
+    atomic_init(&node->top, NULL);
+    node->label_len = label_len;
+    memcpy(node->label, label, label_len);
+    return node;
+}
+
+static void node_free(suggest_node_t *node) {
+    suggest_children_t *children = atomic_load(&node->children);
+    if (children) {
+        for (int i = 0; i < children->count; i++) {
+            node_free(children->nodes[i]);
+        }
+        free(children);
+    }
+    free(atomic_load(&node->top));
+    free(node);
+}
+
+static void trie_free(suggest_trie_t *trie) {
+    if (!trie) {
+        return;
+    }
+    if (trie->root) {
+        node_free(trie->root);
+    }
+    for (size_t i = 0; i < trie->entry_count; i++) {
+        free(trie->entries[i]->subject);
+        free(trie->entries[i]);
+    }
+    free(trie->entries);
+    free(trie);
+}
+
+static int child_index(const suggest_children_t *children, unsigned char first) {
+    if (!children) {
+        return -1;
+    }
+    int lo = 0;
+    int hi = children->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        unsigned char c = (unsigned char)children->nodes[mid]->label[0];
+        if (c == first) {
+            return mid;
+        }
+        if (c < first) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+/* Publishes a copy of the parent's child table with one slot replaced or,
+ * when index is -1, with the node inserted in order. */
+static int publish_child(suggest_node_t *parent, int index, suggest_node_t *node) {
+    suggest_children_t *old = atomic_load(&parent->children);
+    int old_count = old ? old->count : 0;
+    int new_count = index < 0 ? old_count + 1 : old_count;
+    
+    suggest_children_t *table = malloc(sizeof(suggest_children_t) +
+                                       new_count * sizeof(suggest_node_t *));
+    if (!table) {
+        return -1;
+    }
+    table->count = new_count;
+    
+    if (index >= 0) {
+        memcpy(table->nodes, old->nodes, old_count * sizeof(suggest_node_t *));
+        table->nodes[index] = node;
+    } else {
+        int j = 0;
+        int placed = 0;
+        for (int i = 0; i < old_count; i++) {
+            if (!placed && (unsigned char)old->nodes[i]->label[0] > (unsigned char)node->label[0]) {
+                table->nodes[j++] = node;
+                placed = 1;
+            }
+            table->nodes[j++] = old->nodes[i];
+        }
+        if (!placed) {
+            table->nodes[j++] = node;
+        }
+    }
+    
+    atomic_store(&parent->children, table);
+    retire(old);
+    return 0;
+}
+
+/* Puts the entry in front of the node's newest-first list. */
+static int publish_top(suggest_node_t *node, const suggest_entry_t *entry) {
+    suggest_top_t *old = atomic_load(&node->top);
+    suggest_top_t *top = malloc(sizeof(suggest_top_t));
+    if (!top) {
+        return -1;
+    }
+    
+    top->count = 0;
+    top->entries[top->count++] = entry;
+    for (int i = 0; old && i < old->count && top->count < SUGGEST_TOP_K; i++) {
+        if (old->entries[i]->thread_id == entry->thread_id) {
+            continue;
+        }
+        top->entries[top->count++] = old->entries[i];
+    }
+    
+    atomic_store(&node->top, top);
+    retire(old);
+    return 0;
+}
+
+static int trie_insert_key(suggest_trie_t *trie, const char *key, size_t key_len,
+                           const suggest_entry_t *entry) {
+    suggest_node_t *node = trie->root;
+    size_t pos = 0;
+    
+    while (pos < key_len) {
+        suggest_children_t *children = atomic_load(&node->children);
+        int index = child_index(children, (unsigned char)key[pos]);
+    
+        if (index < 0) {
+            suggest_node_t *leaf = node_create(key + pos, key_len - pos);
+            if (!leaf) {
+                return -1;
+            }
+            publish_top(leaf, entry);
+            if (publish_child(node, -1, leaf) != 0) {
+                node_free(leaf);
+                return -1;
+            }
+            return 0;
+        }
+    
+        suggest_node_t *child = children->nodes[index];
+        size_t common = 0;
+        while (common < child->label_len && pos + common < key_len &&
+               child->label[common] == key[pos + common]) {
+            common++;
+        }
+    
+        if (common < child->label_len) {
+            /* Split the edge: a new node for the shared part, and a copy of
+             * the child with the remaining label that keeps its subtree. */
+            suggest_node_t *mid = node_create(child->label, common);
+            suggest_node_t *rest = node_create(child->label + common, child->label_len - common);
+            suggest_top_t *mid_top = malloc(sizeof(suggest_top_t));
+            suggest_children_t *mid_children = malloc(sizeof(suggest_children_t) + sizeof(suggest_node_t *));
+            if (!mid || !rest || !mid_top || !mid_children) {
+                free(mid);
+                free(rest);
+                free(mid_top);
+                free(mid_children);
+                return -1;
+            }
+    
+            suggest_top_t *child_top = atomic_load(&child->top);
+            if (child_top) {
+                *mid_top = *child_top;
+            } else {
+                mid_top->count = 0;
+            }
+            atomic_init(&rest->children, atomic_load(&child->children));
+            atomic_init(&rest->top, child_top);
+            mid_children->count = 1;
+            mid_children->nodes[0] = rest;
+            atomic_init(&mid->children, mid_children);
+            atomic_init(&mid->top, mid_top);
+    
+            publish_child(node, index, mid);
+            /* Only the node struct goes; its children and top now belong
+             * to rest. */
+            retire(child);
+            child = mid;
+        }
+    
+        publish_top(child, entry);
+        pos += common;
+        node = child;
+    }
+    
+    return 0;
+}
+
+static int trie_add(suggest_trie_t *trie, int64_t thread_id, const char *subject) {
+    if (trie->entry_count >= SUGGEST_MAX_ENTRIES) {
+        return -1;
+    }
+    
+    suggest_entry_t *entry = malloc(sizeof(suggest_entry_t));
+    if (!entry) {
+        return -1;
+    }
+    entry->thread_id = thread_id;
+    entry->subject = strdup(subject);
+    if (!entry->subject) {
+        free(entry);
+        return -1;
+    }
+    trie->entries[trie->entry_count++] = entry;
+    
+    char key[SUGGEST_KEY_MAX + 1];
+    size_t key_len = normalize(subject, key, sizeof(key));
+    
+    /* Index the whole subject and the start of its first few words. */
+    size_t start = 0;
+    for (int word = 0; word < SUGGEST_WORDS && start < key_len; word++) {
+        trie_insert_key(trie, key + start, key_len - start, entry);
+        const char *space = memchr(key + start, ' ', key_len - start);
+        if (!space) {
+            break;
+        }
+        start = (size_t)(space - key) + 1;
+    }
+    
+    return 0;
+}
+
+static suggest_trie_t *trie_create(void) {
+    suggest_trie_t *trie = calloc(1, sizeof(suggest_trie_t));
+    if (!trie) {
+        return NULL;
+    }
+    trie->root = node_create("", 0);
+    trie->entries = malloc(SUGGEST_MAX_ENTRIES * sizeof(suggest_entry_t *));
+    if (!trie->root || !trie->entries) {
+        trie_free(trie);
+        return NULL;
+    }
+    return trie;
+}
+
+/* Loads the newest threads oldest first, so each node ends up holding its
+ * newest matches. */
+static suggest_trie_t *trie_build(int limit) {
+    suggest_trie_t *trie = trie_create();
+    if (!trie) {
+        return NULL;
+    }
+    
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT id, subject FROM (SELECT id, subject FROM threads ORDER BY id DESC LIMIT ?) "
+        "ORDER BY id ASC"
+    );
+    if (stmt) {
+        sqlite3_bind_int(stmt, 1, limit);
+        while (db_step(stmt) == SQLITE_ROW) {
+            const char *subject = (const char *)sqlite3_column_text(stmt, 1);
+            trie_add(trie, sqlite3_column_int64(stmt, 0), subject ? subject : "");
+        }
+        db_finalize(stmt);
+    }
+    
+    return trie;
+}
+
+int suggest_init(void) {
+    suggest_trie_t *trie = trie_build(SUGGEST_REBUILD_ENTRIES);
+    if (!trie) {
+        fprintf(stderr, "Failed to build suggestion trie\n");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&writer_mutex);
+    suggest_trie_t *old = atomic_exchange(&current_trie, trie);
+    synchronize_readers();
+    trie_free(old);
+    pthread_mutex_unlock(&writer_mutex);
+    
+    printf("Suggestion trie built (%zu subjects)\n", trie->entry_count);
+    return 0;
+}
+
+void suggest_shutdown(void) {
+    pthread_mutex_lock(&writer_mutex);
+    suggest_trie_t *old = atomic_exchange(&current_trie, NULL);
+    reclaim_retired();
+    synchronize_readers();
+    trie_free(old);
+    free(retired);
+    retired = NULL;
+    retired_capacity = 0;
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+void suggest_add(int64_t thread_id, const char *subject) {
+    if (!subject) {
+        return;
+    }
+    
+    pthread_mutex_lock(&writer_mutex);
+    
+    suggest_trie_t *trie = atomic_load(&current_trie);
+    if (trie && trie->entry_count >= SUGGEST_MAX_ENTRIES) {
+        /* Full: start over from the newest threads, which already include
+         * this one since it is committed before we are called. */
+        suggest_trie_t *fresh = trie_build(SUGGEST_REBUILD_ENTRIES);
+        if (fresh) {
+            atomic_store(&current_trie, fresh);
+            reclaim_retired();
+            synchronize_readers();
+            trie_free(trie);
+            pthread_mutex_unlock(&writer_mutex);
+            return;
+        }
+    }
+    
+    if (trie) {
+        trie_add(trie, thread_id, subject);
+        reclaim_retired();
+    }
+    
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+/* Copies src into dst, cut before any UTF-8 sequence that does not fit. */
+static void copy_subject(char *dst, size_t dst_size, const char *src) {
+    size_t len = strlen(src);
+    if (len >= dst_size) {
+        len = dst_size - 1;
+        while (len > 0 && ((unsigned char)src[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+int suggest_lookup(const char *prefix, suggest_result_t *results, int max_results) {
+    char key[SUGGEST_KEY_MAX + 1];
+    size_t key_len = normalize(prefix, key, sizeof(key));
+    if (key_len == 0 || max_results <= 0) {
+        return 0;
+    }
+    
+    int count = 0;
+    uint64_t epoch = read_begin();
+    
+    suggest_trie_t *trie = atomic_load(&current_trie);
+    suggest_node_t *node = trie ? trie->root : NULL;
+    size_t pos = 0;
+    
+    while (node && pos < key_len) {
+        suggest_children_t *children = atomic_load(&node->children);
+        int index = child_index(children, (unsigned char)key[pos]);
+        if (index < 0) {
+            node = NULL;
+            break;
+        }
+    
+        suggest_node_t *child = children->nodes[index];
+        size_t n = child->label_len;
+        if (n > key_len - pos) {
+            n = key_len - pos;
+        }
+        if (memcmp(child->label, key + pos, n) != 0) {
+            node = NULL;
+            break;
+        }
+        pos += n;
+        node = child;
+    }
+    
+    suggest_top_t *top = node ? atomic_load(&node->top) : NULL;
+    for (int i = 0; top && i < top->count && count < max_results; i++) {
+        results[count].thread_id = top->entries[i]->thread_id;
+        copy_subject(results[count].subject, sizeof(results[count].subject),
+                     top->entries[i]->subject);
+        count++;
+    }
+    
+    read_end(epoch);
+    return count;
+}
+
+void suggest_register_routes(void) {
+    router_add_route("GET", "/suggest", suggest_handler);
+}
+
+http_response_t *suggest_handler(http_request_t *req) {
+    char query[SUGGEST_QUERY_MAX] = "";
+    get_query_param(req->query_string, "q", query, sizeof(query));
+    
+    suggest_result_t results[SUGGEST_TOP_K];
+    int count = suggest_lookup(query, results, SUGGEST_TOP_K);
+    
+    render_buf_t out;
+    json_writer_t json;
+    render_buf_init(&out, 64 + count * 300);
+    json_writer_init(&json, &out);
+    
+    int rc = json_begin_array(&json);
+    for (int i = 0; i < count; i++) {
+        rc |= json_begin_object(&json);
+        rc |= json_field_int(&json, "id", results[i].thread_id);
+        rc |= json_field_string(&json, "subject", results[i].subject);
+        rc |= json_end_object(&json);
+    }
+    rc |= json_end_array(&json);
+    
+    http_response_t *response = rc == 0
+        ? http_response_create(200, "application/json", out.data, out.len)
+        : http_response_create(500, "text/plain", "Out of memory", 13);
+    render_buf_free(&out);
+    return response;
+}
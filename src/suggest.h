@@ -0,0 +1,36 @@
+#ifndef SUGGEST_H
+#define SUGGEST_H
+
+#include "http.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Thread subject autocomplete served from an in-memory radix trie. Every
+ * node keeps the SUGGEST_TOP_K newest threads below it, so a lookup is one
+ * walk down the trie. Readers never lock: nodes are published with atomic
+ * pointer swaps and replaced parts are freed only after a grace period.
+ */
+
+#define SUGGEST_TOP_K 8
+
+typedef struct {
+    int64_t thread_id;
+    char subject[256];
+} suggest_result_t;
+
+/* Builds the trie from the newest threads. Call after db_migrate(). */
+int suggest_init(void);
+void suggest_shutdown(void);
+
+/* Indexes a newly created thread. Safe to call from any thread. */
+void suggest_add(int64_t thread_id, const char *subject);
+
+/* Case-insensitive (ASCII) match against the start of the subject or of
+ * any of its first words. Returns the number of results, newest first. */
+int suggest_lookup(const char *prefix, suggest_result_t *results, int max_results);
+
+void suggest_register_routes(void);
+http_response_t *suggest_handler(http_request_t *req);
+
+#endif
@@ -0,0 +1,465 @@
+#define _POSIX_C_SOURCE 200809L
+#include "template.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    OP_TEXT,                        /* literal span of the text blob */
+    OP_ESCAPE,                      /* TEMPLATE_TEXT field */
+    OP_RAW,                         /* TEMPLATE_RAW field */
+    OP_INT,                         /* TEMPLATE_INT field */
+    OP_IF,                          /* jump to arg when the field is falsy */
+    OP_JUMP,                        /* jump to arg */
+    OP_EACH,                        /* enter a loop, or jump to arg if empty */
+    OP_NEXT                         /* next item: jump to arg, or leave */
+} op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t type;                   /* field type, for OP_IF */
+    uint8_t depth;                  /* scopes above the innermost */
+    uint32_t offset;                /* field offset, or text offset */
+    uint32_t arg;                   /* text length, or jump target */
+    const template_schema_t *item;  /* item layout, for OP_EACH */
+} instr_t;
+
+struct template {
+    char *name;
+    instr_t *code;
+    size_t code_len;
+    size_t code_cap;
+    char *text;
+    size_t text_len;
+    size_t text_cap;
+    struct template *next;
+};
+
+typedef struct {
+    int is_each;
+    size_t start;                   /* the #if or #each instruction */
+    size_t else_jump;               /* OP_JUMP ending the true branch, or 0 */
+} block_t;
+
+typedef struct {
+    template_t *tmpl;
+    const template_schema_t *scopes[TEMPLATE_MAX_DEPTH + 1];
+    int scope_count;
+    block_t blocks[64];
+    int block_count;
+    size_t label;                   /* latest jump target; text is not merged across it */
+    int line;
+} compiler_t;
+
+static template_t *registry = NULL;
+
+static int emit(compiler_t *c, instr_t instr) {
+    template_t *tmpl = c->tmpl;
+    if (tmpl->code_len == tmpl->code_cap) {
+        size_t cap = tmpl->code_cap ? tmpl->code_cap * 2 : 64;
+        instr_t *code = realloc(tmpl->code, cap * sizeof(instr_t));
+        if (!code) {
+            return -1;
+        }
+        tmpl->code = code;
+        tmpl->code_cap = cap;
+    }
+    tmpl->code[tmpl->code_len++] = instr;
+    return 0;
+}
+
+static int emit_text(compiler_t *c, const char *text, size_t len) {
+    template_t *tmpl = c->tmpl;
+    
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\n') {
+            c->line++;
+        }
+    }
+    if (len == 0) {
+        return 0;
+    }
+    
+    if (tmpl->text_len + len > tmpl->text_cap) {
+        size_t cap = tmpl->text_cap ? tmpl->text_cap : 1024;
+        while (cap < tmpl->text_len + len) {
+            cap *= 2;
+        }
+        char *blob = realloc(tmpl->text, cap);
+        if (!blob) {
+            return -1;
+        }
+        tmpl->text = blob;
+        tmpl->text_cap = cap;
+    }
+    
+    /* Text right after text (a comment between them) extends the span. */
+    instr_t *last = tmpl->code_len ? &tmpl->code[tmpl->code_len - 1] : NULL;
+    memcpy(tmpl->text + tmpl->text_len, text, len);
+    if (last && last->op == OP_TEXT && last->offset + last->arg == tmpl->text_len &&
+        c->label != tmpl->code_len) {
+        last->arg += (uint32_t)len;
+        tmpl->text_len += len;
+        return 0;
+    }
+    
+    instr_t instr = { .op = OP_TEXT, .offset = (uint32_t)tmpl->text_len, .arg = (uint32_t)len };
+    tmpl->text_len += len;
+    return emit(c, instr);
+}
+
+static int compile_error(compiler_t *c, const char *msg, const char *tag, size_t tag_len) {
+    fprintf(stderr, "Template %s:%d: %s '%.*s'\n", c->tmpl->name, c->line, msg,
+            (int)tag_len, tag);
+    return -1;
+}
+
+static const template_field_t *resolve(compiler_t *c, const char *name, size_t len,
+                                       uint8_t *depth) {
+    for (int s = c->scope_count - 1; s >= 0; s--) {
+        const template_schema_t *schema = c->scopes[s];
+        for (size_t i = 0; i < schema->field_count; i++) {
+            const template_field_t *field = &schema->fields[i];
+            if (strlen(field->name) == len && memcmp(field->name, name, len) == 0) {
+                *depth = (uint8_t)(c->scope_count - 1 - s);
+                return field;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Splits "keyword arg" into the keyword and its trimmed argument. */
+static int tag_is(const char *tag, size_t len, const char *keyword,
+                  const char **arg, size_t *arg_len) {
+    size_t kw_len = strlen(keyword);
+    if (len < kw_len || memcmp(tag, keyword, kw_len) != 0) {
+        return 0;
+    }
+    if (len == kw_len) {
+        *arg = tag + len;
+        *arg_len = 0;
+        return 1;
+    }
+    if (!isspace((unsigned char)tag[kw_len])) {
+        return 0;
+    }
+    
+    *arg = tag + kw_len;
+    *arg_len = len - kw_len;
+    while (*arg_len > 0 && isspace((unsigned char)**arg)) {
+        (*arg)++;
+        (*arg_len)--;
+    }
+    return 1;
+}
+
+static int compile_open(compiler_t *c, int is_each, const char *arg, size_t arg_len,
+                        const char *tag, size_t tag_len) {
+    uint8_t depth;
+    const template_field_t *field = resolve(c, arg, arg_len, &depth);
+    if (!field) {
+        return compile_error(c, "unknown field in", tag, tag_len);
+    }
+    if (is_each && field->type != TEMPLATE_LIST) {
+        return compile_error(c, "not a list in", tag, tag_len);
+    }
+    if (c->block_count == (int)(sizeof(c->blocks) / sizeof(c->blocks[0])) ||
+        (is_each && c->scope_count > TEMPLATE_MAX_DEPTH)) {
+        return compile_error(c, "blocks nested too deep at", tag, tag_len);
+    }
+    
+    block_t *block = &c->blocks[c->block_count++];
+    block->is_each = is_each;
+    block->start = c->tmpl->code_len;
+    block->else_jump = 0;
+    
+    instr_t instr = {
+        .op = is_each ? OP_EACH : OP_IF,
+        .type = (uint8_t)field->type,
+        .depth = depth,
+        .offset = (uint32_t)field->offset,
+        .item = field->item
+    };
+    if (is_each) {
+        c->scopes[c->scope_count++] = field->item;
+    }
+    return emit(c, instr);
+}
+
+static int compile_tag(compiler_t *c, const char *tag, size_t len) {
+    template_t *tmpl = c->tmpl;
+    const char *arg;
+    size_t arg_len;
+    
+    if (len > 0 && tag[0] == '!') {
+        return 0;
+    }
+    if (tag_is(tag, len, "#if", &arg, &arg_len)) {
+        return compile_open(c, 0, arg, arg_len, tag, len);
+    }
+    if (tag_is(tag, len, "#each", &arg, &arg_len)) {
+        return compile_open(c, 1, arg, arg_len, tag, len);
+    }
+    
+    block_t *block = c->block_count ? &c->blocks[c->block_count - 1] : NULL;
+    
+    if (len == 4 && memcmp(tag, "else", 4) == 0) {
+        if (!block || block->is_each || block->else_jump) {
+            return compile_error(c, "unexpected", tag, len);
+        }
+        block->else_jump = tmpl->code_len;
+        if (emit(c, (instr_t){ .op = OP_JUMP }) != 0) {
+            return -1;
+        }
+        tmpl->code[block->start].arg = (uint32_t)tmpl->code_len;
+        c->label = tmpl->code_len;
+        return 0;
+    }
+    if (len == 3 && memcmp(tag, "/if", 3) == 0) {
+        if (!block || block->is_each) {
+            return compile_error(c, "unexpected", tag, len);
+        }
+        size_t patch = block->else_jump ? block->else_jump : block->start;
+        tmpl->code[patch].arg = (uint32_t)tmpl->code_len;
+        c->label = tmpl->code_len;
+        c->block_count--;
+        return 0;
+    }
+    if (len == 5 && memcmp(tag, "/each", 5) == 0) {
+        if (!block || !block->is_each) {
+            return compile_error(c, "unexpected", tag, len);
+        }
+        instr_t next = { .op = OP_NEXT, .arg = (uint32_t)(block->start + 1) };
+        if (emit(c, next) != 0) {
+            return -1;
+        }
+        tmpl->code[block->start].arg = (uint32_t)tmpl->code_len;
+        c->label = tmpl->code_len;
+        c->block_count--;
+        c->scope_count--;
+        return 0;
+    }
+    
+    uint8_t depth;
+    const template_field_t *field = resolve(c, tag, len, &depth);
+    if (!field) {
+        return compile_error(c, "unknown field", tag, len);
+    }
+    
+    instr_t instr = { .depth = depth, .offset = (uint32_t)field->offset };
+    switch (field->type) {
+        case TEMPLATE_TEXT: instr.op = OP_ESCAPE; break;
+        case TEMPLATE_RAW: instr.op = OP_RAW; break;
+        case TEMPLATE_INT: instr.op = OP_INT; break;
+        default:
+            return compile_error(c, "field cannot be output", tag, len);
+    }
+    return emit(c, instr);
+}
+
+template_t *template_compile(const char *name, const char *source,
+                             const template_schema_t *schema) {
+    template_t *tmpl = calloc(1, sizeof(template_t));
+    if (!tmpl) {
+        return NULL;
+    }
+    tmpl->name = strdup(name);
+    
+    compiler_t c = { .tmpl = tmpl, .scope_count = 1, .label = (size_t)-1, .line = 1 };
+    c.scopes[0] = schema;
+    
+    const char *p = source;
+    int rc = tmpl->name ? 0 : -1;
+    while (rc == 0 && *p) {
+        const char *open = strstr(p, "{{");
+        if (!open) {
+            rc = emit_text(&c, p, strlen(p));
+            break;
+        }
+        
+        const char *close = strstr(open + 2, "}}");
+        if (!close) {
+            rc = compile_error(&c, "unclosed tag", open, strnlen(open, 16));
+            break;
+        }
+        
+        const char *tag = open + 2;
+        const char *end = close;
+        while (tag < end && isspace((unsigned char)*tag)) {
+            tag++;
+        }
+        while (end > tag && isspace((unsigned char)end[-1])) {
+            end--;
+        }
+        
+        /* A block tag or comment alone on its line takes the line with it,
+         * so templates can be indented without adding blank lines. */
+        const char *line_start = open;
+        while (line_start > p && (line_start[-1] == ' ' || line_start[-1] == '\t')) {
+            line_start--;
+        }
+        const char *line_end = close + 2;
+        while (*line_end == ' ' || *line_end == '\t' || *line_end == '\r') {
+            line_end++;
+        }
+        int standalone = strchr("#/!", *tag) != NULL ||
+                         (end - tag == 4 && memcmp(tag, "else", 4) == 0);
+        standalone = standalone && (line_start == source || line_start[-1] == '\n') &&
+                     (*line_end == '\n' || *line_end == '\0');
+        
+        rc = emit_text(&c, p, (size_t)((standalone ? line_start : open) - p));
+        if (rc == 0) {
+            rc = compile_tag(&c, tag, (size_t)(end - tag));
+        }
+        if (standalone && *line_end == '\n') {
+            c.line++;
+            p = line_end + 1;
+        } else {
+            p = standalone ? line_end : close + 2;
+        }
+    }
+    
+    if (rc == 0 && c.block_count > 0) {
+        block_t *block = &c.blocks[c.block_count - 1];
+        rc = compile_error(&c, "missing close for", block->is_each ? "#each" : "#if",
+                           block->is_each ? 5 : 3);
+    }
+    if (rc != 0) {
+        template_destroy(tmpl);
+        return NULL;
+    }
+    return tmpl;
+}
+
+void template_destroy(template_t *tmpl) {
+    if (!tmpl) {
+        return;
+    }
+    free(tmpl->name);
+    free(tmpl->code);
+    free(tmpl->text);
+    free(tmpl);
+}
+
+static int field_truthy(const char *field, uint8_t type) {
+    switch (type) {
+        case TEMPLATE_TEXT:
+        case TEMPLATE_RAW: {
+            const char *str = *(const char *const *)field;
+            return str && str[0];
+        }
+        case TEMPLATE_INT:
+            return *(const int64_t *)field != 0;
+        case TEMPLATE_BOOL:
+            return *(const int *)field != 0;
+        case TEMPLATE_LIST:
+            return ((const template_list_t *)field)->count > 0;
+    }
+    return 0;
+}
+
+int template_render(const template_t *tmpl, const void *data, render_buf_t *out) {
+    const char *bases[TEMPLATE_MAX_DEPTH + 1];
+    struct {
+        const template_list_t *list;
+        size_t size;
+        size_t index;
+    } loops[TEMPLATE_MAX_DEPTH];
+    int top = 0;
+    int rc = 0;
+    size_t pc = 0;
+    
+    bases[0] = data;
+    while (pc < tmpl->code_len) {
+        const instr_t *instr = &tmpl->code[pc];
+        const char *field = instr->op == OP_TEXT ? NULL : bases[top - instr->depth] + instr->offset;
+    
+        switch (instr->op) {
+            case OP_TEXT:
+                rc |= render_buf_append(out, tmpl->text + instr->offset, instr->arg);
+                break;
+            case OP_ESCAPE: {
+                const char *str = *(const char *const *)field;
+                if (str) {
+                    rc |= render_buf_append_html(out, str);
+                }
+                break;
+            }
+            case OP_RAW: {
+                const char *str = *(const char *const *)field;
+                if (str) {
+                    rc |= render_buf_append_str(out, str);
+                }
+                break;
+            }
+            case OP_INT:
+                rc |= render_buf_appendf(out, "%lld", (long long)*(const int64_t *)field);
+                break;
+            case OP_IF:
+                if (!field_truthy(field, instr->type)) {
+                    pc = instr->arg;
+                    continue;
+                }
+                break;
+            case OP_JUMP:
+                pc = instr->arg;
+                continue;
+            case OP_EACH: {
+                const template_list_t *list = (const template_list_t *)field;
+                if (list->count == 0) {
+                    pc = instr->arg;
+                    continue;
+                }
+                loops[top].list = list;
+                loops[top].size = instr->item->size;
+                loops[top].index = 0;
+                bases[++top] = list->items;
+                break;
+            }
+            case OP_NEXT:
+                if (++loops[top - 1].index < loops[top - 1].list->count) {
+                    bases[top] = (const char *)loops[top - 1].list->items +
+                                 loops[top - 1].index * loops[top - 1].size;
+                    pc = instr->arg;
+                    continue;
+                }
+                top--;
+                break;
+        }
+        pc++;
+    }
+    
+    return rc ? -1 : 0;
+}
+
+const template_t *template_register(const char *name, const char *source,
+                                    const template_schema_t *schema) {
+    template_t *tmpl = template_compile(name, source, schema);
+    if (!tmpl) {
+        fprintf(stderr, "Failed to compile template %s\n", name);
+        return NULL;
+    }
+    
+    tmpl->next = registry;
+    registry = tmpl;
+    return tmpl;
+}
+
+const template_t *template_find(const char *name) {
+    for (template_t *tmpl = registry; tmpl; tmpl = tmpl->next) {
+        if (strcmp(tmpl->name, name) == 0) {
+            return tmpl;
+        }
+    }
+    return NULL;
+}
+
+void template_shutdown(void) {
+    while (registry) {
+        template_t *next = registry->next;
+        template_destroy(registry);
+        registry = next;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include "render.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Runtime templates. A template is compiled once, against a schema that
+ * describes the C struct it renders, into a flat list of instructions:
+ * literal spans, field output, conditionals and loops. Field names are
+ * resolved to struct offsets at compile time, so rendering only copies
+ * text and reads fields.
+ *
+ * Syntax:
+ *   {{field}}                  output a field; text fields are HTML-escaped
+ *   {{#if field}} {{else}} {{/if}}
+ *   {{#each list}} {{/each}}   fields inside resolve against the list item
+ *                              first, then against enclosing scopes
+ *   {{! comment}}
+ */
+
+typedef enum {
+    TEMPLATE_TEXT,                  /* const char *, escaped on output */
+    TEMPLATE_RAW,                   /* const char *, trusted markup */
+    TEMPLATE_INT,                   /* int64_t */
+    TEMPLATE_BOOL,                  /* int; only usable in #if */
+    TEMPLATE_LIST                   /* template_list_t */
+} template_type_t;
+
+typedef struct template_schema template_schema_t;
+
+typedef struct {
+    const char *name;
+    template_type_t type;
+    size_t offset;
+    const template_schema_t *item;  /* item layout for TEMPLATE_LIST */
+} template_field_t;
+
+struct template_schema {
+    size_t size;
+    const template_field_t *fields;
+    size_t field_count;
+};
+
+/* A contiguous array of items described by the field's item schema. */
+typedef struct {
+    const void *items;
+    size_t count;
+} template_list_t;
+
+#define TEMPLATE_FIELD(type, member, kind) \
+    { #member, kind, offsetof(type, member), NULL }
+#define TEMPLATE_LIST_FIELD(type, member, item_schema) \
+    { #member, TEMPLATE_LIST, offsetof(type, member), &(item_schema) }
+#define TEMPLATE_SCHEMA(type, field_array) \
+    { sizeof(type), field_array, sizeof(field_array) / sizeof((field_array)[0]) }
+
+/* Loops may nest this deep. */
+#define TEMPLATE_MAX_DEPTH 8
+
+typedef struct template template_t;
+
+/* Compiles source against schema. Errors name the template and line and
+ * return NULL. */
+template_t *template_compile(const char *name, const char *source,
+                             const template_schema_t *schema);
+void template_destroy(template_t *tmpl);
+
+/* Appends the rendered template to out. Returns 0, or -1 when memory runs
+ * out. data must point to a struct of the compiled schema. */
+int template_render(const template_t *tmpl, const void *data, render_buf_t *out);
+
+/* Named templates for render_template(). Registering compiles the source;
+ * call at startup. */
+const template_t *template_register(const char *name, const char *source,
+                                    const template_schema_t *schema);
+const template_t *template_find(const char *name);
+void template_shutdown(void);
+
+#endif
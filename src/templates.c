@@ -0,0 +1,174 @@
+#include "templates.h"
+
+/*
+ * Page templates, compiled by template_register() at startup. See
+ * template.h for the syntax.
+ */
+
+/* board_list_page_t in board.c */
+const char template_board_list[] =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "<meta charset=\"UTF-8\">\n"
+    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+    "<title>{{page_title}}</title>\n"
+    "<style>\n"
+    ":root {\n"
+    "  --primary: #1976d2;\n"
+    "  --primary-dark: #1565c0;\n"
+    "  --primary-light: #42a5f5;\n"
+    "  --accent: #ff4081;\n"
+    "  --text-primary: rgba(0,0,0,0.87);\n"
+    "  --text-secondary: rgba(0,0,0,0.54);\n"
+    "  --divider: rgba(0,0,0,0.12);\n"
+    "  --background: #fafafa;\n"
+    "  --surface: #ffffff;\n"
+    "  --error: #f44336;\n"
+    "}\n"
+    "* { box-sizing: border-box; margin: 0; padding: 0; }\n"
+    "body {\n"
+    "  font-family: 'Roboto', 'Segoe UI', Arial, sans-serif, 'Microsoft YaHei', 'SimHei';\n"
+    "  background: var(--background);\n"
+    "  color: var(--text-primary);\n"
+    "  line-height: 1.6;\n"
+    "  padding: 16px;\n"
+    "}\n"
+    ".container { max-width: 1200px; margin: 0 auto; }\n"
+    ".card {\n"
+    "  background: var(--surface);\n"
+    "  border-radius: 4px;\n"
+    "  box-shadow: 0 2px 4px rgba(0,0,0,0.1);\n"
+    "  padding: 16px;\n"
+    "  margin-bottom: 16px;\n"
+    "}\n"
+    ".card:hover { box-shadow: 0 4px 8px rgba(0,0,0,0.15); transition: box-shadow 0.3s; }\n"
+    "h1 {\n"
+    "  font-size: 2rem;\n"
+    "  font-weight: 500;\n"
+    "  margin-bottom: 24px;\n"
+    "  color: var(--primary);\n"
+    "  display: flex;\n"
+    "  justify-content: space-between;\n"
+    "  align-items: center;\n"
+    "  flex-wrap: wrap;\n"
+    "}\n"
+    "@media (max-width: 768px) { h1 { font-size: 1.5rem; } }\n"
+    ".lang-switch { font-size: 0.875rem; font-weight: normal; }\n"
+    ".lang-switch a { color: var(--primary); text-decoration: none; padding: 6px 12px;\n"
+    "  border: 1px solid var(--primary); border-radius: 4px; margin-left: 8px; transition: all 0.2s; }\n"
+    ".lang-switch a:hover { background: var(--primary); color: white; }\n"
+    ".lang-switch a.active { background: var(--primary); color: white; }\n"
+    ".board-list { list-style: none; }\n"
+    ".board-item {\n"
+    "  display: block;\n"
+    "  padding: 16px;\n"
+    "  background: var(--surface);\n"
+    "  border-radius: 4px;\n"
+    "  margin-bottom: 12px;\n"
+    "  box-shadow: 0 1px 3px rgba(0,0,0,0.1);\n"
+    "  transition: all 0.2s;\n"
+    "}\n"
+    ".board-item:hover {\n"
+    "  box-shadow: 0 4px 8px rgba(0,0,0,0.15);\n"
+    "  transform: translateY(-2px);\n"
+    "}\n"
+    ".board-link {\n"
+    "  color: var(--primary);\n"
+    "  text-decoration: none;\n"
+    "  font-size: 1.25rem;\n"
+    "  font-weight: 500;\n"
+    "  display: block;\n"
+    "  margin-bottom: 8px;\n"
+    "}\n"
+    ".board-desc {\n"
+    "  color: var(--text-secondary);\n"
+    "  font-size: 0.875rem;\n"
+    "  display: block;\n"
+    "}\n"
+    ".btn {\n"
+    "  background: var(--primary);\n"
+    "  color: white;\n"
+    "  border: none;\n"
+    "  padding: 10px 24px;\n"
+    "  border-radius: 4px;\n"
+    "  font-size: 0.875rem;\n"
+    "  font-weight: 500;\n"
+    "  text-transform: uppercase;\n"
+    "  cursor: pointer;\n"
+    "  box-shadow: 0 2px 4px rgba(0,0,0,0.2);\n"
+    "  transition: all 0.2s;\n"
+    "  min-height: 48px;\n"
+    "}\n"
+    ".btn:hover { background: var(--primary-dark); box-shadow: 0 4px 8px rgba(0,0,0,0.3); }\n"
+    ".btn:active { box-shadow: 0 1px 2px rgba(0,0,0,0.2); }\n"
+    "@media (max-width: 768px) { .btn { width: 100%; } }\n"
+    "input[type=\"text\"], textarea {\n"
+    "  width: 100%;\n"
+    "  padding: 12px 16px;\n"
+    "  margin: 8px 0;\n"
+    "  border: 1px solid var(--divider);\n"
+    "  border-radius: 4px;\n"
+    "  font-size: 1rem;\n"
+    "  font-family: inherit;\n"
+    "  background: var(--surface);\n"
+    "  transition: border-color 0.2s;\n"
+    "}\n"
+    "input:focus, textarea:focus {\n"
+    "  outline: none;\n"
+    "  border-color: var(--primary);\n"
+    "  box-shadow: 0 0 0 2px rgba(25,118,210,0.1);\n"
+    "}\n"
+    "textarea { min-height: 120px; resize: vertical; }\n"
+    "</style>\n"
+    "<script>\n"
+    "function setLanguage(lang) {\n"
+    "  document.cookie = 'lang=' + lang + '; path=/; max-age=31536000';\n"
+    "  window.location.href = '/?lang=' + lang;\n"
+    "}\n"
+    "</script>\n"
+    "</head>\n"
+    "<body>\n"
+    "<div class=\"container\">\n"
+    "<h1>\n"
+    "  <span>📋 {{page_title}}</span>\n"
+    "  <span class=\"lang-switch\">\n"
+    "    <a href=\"#\" onclick=\"setLanguage('en'); return false;\" class=\"{{#if lang_en}}active{{/if}}\">English</a>\n"
+    "    <a href=\"#\" onclick=\"setLanguage('zh-cn'); return false;\" class=\"{{#if lang_zh_cn}}active{{/if}}\">中文</a>\n"
+    "  </span>\n"
+    "</h1>\n"
+    "<form method=\"GET\" action=\"/search\" class=\"card\">\n"
+    "<input type=\"text\" name=\"q\" placeholder=\"{{search_placeholder}}\" required>\n"
+    "<button type=\"submit\" class=\"btn\">{{search_label}}</button>\n"
+    "</form>\n"
+    "<ul class=\"board-list\">\n"
+    "{{#each boards}}\n"
+    "<li class=\"board-item\">\n"
+    "<a href=\"/board?id={{id}}\" class=\"board-link\">{{name}} - {{#if title}}{{title}}{{else}}No Title{{/if}}</a>\n"
+    "<span class=\"board-desc\">{{description}}</span>\n"
+    "</li>\n"
+    "{{/each}}\n"
+    "</ul>\n"
+    "{{#if is_admin}}\n"
+    "<div class=\"card\" style=\"margin-top:24px;\">\n"
+    "<h2 style=\"font-size:1.5rem;margin-bottom:16px;\">{{create_new_board}}</h2>\n"
+    "<form method=\"POST\" action=\"/board/create\">\n"
+    "<div style=\"margin-bottom:16px;\">\n"
+    "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">{{name_label}}</label>\n"
+    "<input type=\"text\" name=\"name\" required>\n"
+    "</div>\n"
+    "<div style=\"margin-bottom:16px;\">\n"
+    "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">{{title_label}}</label>\n"
+    "<input type=\"text\" name=\"title\" required>\n"
+    "</div>\n"
+    "<div style=\"margin-bottom:16px;\">\n"
+    "<label style=\"display:block;margin-bottom:4px;font-weight:500;\">{{description_label}}</label>\n"
+    "<textarea name=\"description\"></textarea>\n"
+    "</div>\n"
+    "<button type=\"submit\" class=\"btn\">{{create_board_label}}</button>\n"
+    "</form>\n"
+    "</div>\n"
+    "{{/if}}\n"
+    "</div>\n"
+    "</body>\n"
+    "</html>";
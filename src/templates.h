@@ -0,0 +1,7 @@
+#ifndef TEMPLATES_H
+#define TEMPLATES_H
+
+/* Sources of the built-in page templates. */
+extern const char template_board_list[];
+
+#endif
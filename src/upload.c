@@ -1,13 +1,33 @@
 #define _POSIX_C_SOURCE 200809L
 #include "upload.h"
 #include "router.h"
+#include "static_file.h"
+#include "multipart.h"
+#include "db.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <errno.h>
 
 static char upload_directory[256] = "./uploads";
+static char temp_directory[280] = "./uploads/.tmp";
+
+typedef struct {
+    upload_file_t *file;
+    int fd;                         /* open while inside the file part */
+    int done;                       /* the file part has ended */
+    upload_status_t status;
+    sha256_t hash;
+    upload_field_fn on_field;
+    void *field_ctx;
+    int in_field;                   /* inside a part without a filename */
+    char field_name[128];
+    char field_value[UPLOAD_FIELD_MAX + 1];
+    size_t field_len;
+} receive_ctx_t;
 
 void upload_init(const char *upload_dir) {
     if (upload_dir) {
@@ -25,12 +45,65 @@ void upload_init(const char *upload_dir) {
         }
     }
     
+    snprintf(temp_directory, sizeof(temp_directory), "%s/.tmp", upload_directory);
+    if (mkdir(temp_directory, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: Failed to create upload staging directory %s: %s\n",
+                temp_directory, strerror(errno));
+    }
+    
     printf("Upload module initialized, directory: %s\n", upload_directory);
 }
 
 void upload_register_routes(void) {
     router_add_route("GET", "/upload", upload_handler);
-    router_add_route("POST", "/upload", upload_handler);
+    router_add_limited_route("POST", "/upload", upload_handler, UPLOAD_MAX_BODY, ROUTE_AUTH);
+    router_add_route("GET", "/uploads/*", upload_serve_handler);
+}
+
+static int is_hash(const char *s, size_t len) {
+    if (len != SHA256_HEX_SIZE - 1) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!((s[i] >= '0' && s[i] <= '9') || (s[i] >= 'a' && s[i] <= 'f'))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void upload_hash_path(const char *hash, char *path, size_t size) {
+    snprintf(path, size, "%.2s/%.2s/%.*s", hash, hash + 2, SHA256_HEX_SIZE - 1, hash);
+}
+
+void upload_url(const char *hash, const char *filename, char *url, size_t size) {
+    char path[80];
+    upload_hash_path(hash, path, sizeof(path));
+    
+    /* Keep an extension only when it maps to a type, so the stored name
+     * decides how the file is served, not what the uploader called it. */
+    const char *ext = filename ? strrchr(filename, '.') : NULL;
+    if (ext && (strlen(ext) > 8 ||
+                strcmp(static_file_content_type(filename), "application/octet-stream") == 0)) {
+        ext = NULL;
+    }
+    snprintf(url, size, "/uploads/%s%s", path, ext ? ext : "");
+}
+
+/* GET /uploads/ab/cd/{hash}[.ext] - a stored file, sent with sendfile().
+ * Other names are files saved before uploads were content-addressed. */
+http_response_t *upload_serve_handler(http_request_t *req) {
+    const char *name = req->path + strlen("/uploads/");
+    const char *hash = name + 6;
+    size_t hash_len = strcspn(hash, ".");
+    
+    if (strlen(name) > 6 && name[2] == '/' && name[5] == '/' && is_hash(hash, hash_len) &&
+        strncmp(name, hash, 2) == 0 && strncmp(name + 3, hash + 2, 2) == 0) {
+        char path[80];
+        upload_hash_path(hash, path, sizeof(path));
+        return static_file_serve(req, upload_directory, path, static_file_content_type(name));
+    }
+    return static_file_serve(req, upload_directory, name, NULL);
 }
 
 http_response_t *upload_handler(http_request_t *req) {
@@ -52,16 +125,24 @@ http_response_t *upload_handler(http_request_t *req) {
         return http_response_create(200, "text/html", html, strlen(html));
     }
     
-    upload_file_t *file = upload_parse_multipart(req);
-    if (!file) {
-        const char *html = "<html><body><h1>Upload Failed</h1><p>No file data received</p><a href=\"/upload\">Try Again</a></body></html>";
-        return http_response_create(400, "text/html", html, strlen(html));
+    upload_file_t *file = NULL;
+    upload_status_t status = upload_parse_multipart(req, &file);
+    if (status != UPLOAD_OK) {
+        int code = status == UPLOAD_ERR_TOO_LARGE ? 413 : status == UPLOAD_ERR_IO ? 500 : 400;
+        const char *reason = status == UPLOAD_ERR_TOO_LARGE ? "File too large"
+                           : status == UPLOAD_ERR_IO ? "Failed to store file"
+                           : "No file data received";
+        char html[512];
+        snprintf(html, sizeof(html),
+            "<html><body><h1>Upload Failed</h1><p>%s</p>"
+            "<a href=\"/upload\">Try Again</a></body></html>", reason);
+        return http_response_create(code, "text/html", html, strlen(html));
     }
     
-    char save_path[512];
-    snprintf(save_path, sizeof(save_path), "%s/%s", upload_directory, file->filename);
-    
-    int result = upload_save_file(file, save_path);
+    int deduplicated = 0;
+    char url[160];
+    int result = upload_store(file, &deduplicated);
+    upload_url(file->hash, file->filename, url, sizeof(url));
     upload_file_free(file);
     
     char *html = malloc(1024);
@@ -73,10 +154,11 @@ http_response_t *upload_handler(http_request_t *req) {
     if (result == 0) {
         snprintf(html, 1024,
             "<html><body><h1>Upload Successful</h1>"
-            "<p>File saved to: %s</p>"
+            "<p>File available at: <a href=\"%s\">%s</a></p>"
+            "<p>%s</p>"
             "<a href=\"/upload\">Upload Another</a> | "
             "<a href=\"/\">Home</a></body></html>",
-            save_path);
+            url, url, deduplicated ? "An identical file was already stored." : "");
         http_response_t *response = http_response_create(200, "text/html", html, strlen(html));
         free(html);
         return response;
@@ -91,60 +173,296 @@ http_response_t *upload_handler(http_request_t *req) {
     }
 }
 
-upload_file_t *upload_parse_multipart(http_request_t *req) {
-    printf("Parsing multipart upload (basic implementation)\n");
+void upload_sanitize_filename(const char *name, char *dst, size_t size) {
+    const char *base = name;
+    for (const char *p = name; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            base = p + 1;
+        }
+    }
+    while (*base == '.') {
+        base++;
+    }
     
-    if (!req->body || req->body_len == 0) {
-        return NULL;
+    size_t len = 0;
+    for (; *base && len + 1 < size; base++) {
+        char c = *base;
+        int safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_';
+        dst[len++] = safe ? c : '_';
+    }
+    dst[len] = '\0';
+    if (len == 0) {
+        snprintf(dst, size, "upload.dat");
+    }
+}
+
+static int on_part_begin(void *ctx, const multipart_part_t *part) {
+    receive_ctx_t *rc = ctx;
+    if (part->filename[0] == '\0') {
+        if (rc->on_field) {
+            snprintf(rc->field_name, sizeof(rc->field_name), "%s", part->name);
+            rc->field_len = 0;
+            rc->in_field = 1;
+        }
+        return 0;
+    }
+    if (rc->done) {
+        return 0;
     }
     
-    upload_file_t *file = malloc(sizeof(upload_file_t));
-    if (!file) {
-        return NULL;
+    upload_file_t *file = rc->file;
+    upload_sanitize_filename(part->filename, file->filename, sizeof(file->filename));
+    snprintf(file->content_type, sizeof(file->content_type), "%s",
+             part->content_type[0] ? part->content_type : "application/octet-stream");
+    snprintf(file->temp_path, sizeof(file->temp_path), "%s/upload-XXXXXX", temp_directory);
+    rc->fd = mkstemp(file->temp_path);
+    if (rc->fd < 0) {
+        fprintf(stderr, "Failed to create upload staging file: %s\n", strerror(errno));
+        file->temp_path[0] = '\0';
+        rc->status = UPLOAD_ERR_IO;
+        return -1;
+    }
+    /* mkstemp() creates 0600; stored files are world-readable. */
+    fchmod(rc->fd, 0644);
+    sha256_init(&rc->hash);
+    return 0;
+}
+
+static int on_part_data(void *ctx, const char *data, size_t len) {
+    receive_ctx_t *rc = ctx;
+    if (rc->in_field) {
+        size_t room = UPLOAD_FIELD_MAX - rc->field_len;
+        size_t take = len < room ? len : room;
+        memcpy(rc->field_value + rc->field_len, data, take);
+        rc->field_len += take;
+        return 0;
+    }
+    if (rc->fd < 0) {
+        return 0;
     }
+    if (rc->file->size + len > UPLOAD_MAX_BYTES) {
+        rc->status = UPLOAD_ERR_TOO_LARGE;
+        return -1;
+    }
+    sha256_update(&rc->hash, data, len);
+    while (len > 0) {
+        ssize_t written = write(rc->fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Failed to write upload: %s\n", strerror(errno));
+            rc->status = UPLOAD_ERR_IO;
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+        rc->file->size += (uint64_t)written;
+    }
+    return 0;
+}
+
+static int on_part_end(void *ctx) {
+    receive_ctx_t *rc = ctx;
+    if (rc->in_field) {
+        rc->field_value[rc->field_len] = '\0';
+        rc->in_field = 0;
+        rc->on_field(rc->field_ctx, rc->field_name, rc->field_value);
+        return 0;
+    }
+    if (rc->fd >= 0) {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        sha256_final(&rc->hash, digest);
+        sha256_hex(digest, rc->file->hash);
+        close(rc->fd);
+        rc->fd = -1;
+        rc->done = 1;
+    }
+    return 0;
+}
+
+upload_status_t upload_parse_multipart(http_request_t *req, upload_file_t **out) {
+    upload_status_t status = upload_parse_form(req, NULL, NULL, out);
+    if (status == UPLOAD_OK && !*out) {
+        return UPLOAD_ERR_NO_FILE;
+    }
+    return status;
+}
+
+upload_status_t upload_parse_form(http_request_t *req, upload_field_fn on_field, void *ctx,
+                                  upload_file_t **out) {
+    *out = NULL;
     
-    file->filename = strdup("uploaded_file.dat");
-    file->content_type = strdup("application/octet-stream");
-    file->size = req->body_len;
-    file->data = malloc(file->size);
+    if (req->content_length > UPLOAD_MAX_BODY) {
+        return UPLOAD_ERR_TOO_LARGE;
+    }
     
-    if (!file->data) {
-        upload_file_free(file);
-        return NULL;
+    upload_file_t *file = calloc(1, sizeof(upload_file_t));
+    multipart_parser_t *parser = malloc(sizeof(multipart_parser_t));
+    char *chunk = malloc(UPLOAD_READ_CHUNK);
+    receive_ctx_t rc = { .file = file, .fd = -1, .status = UPLOAD_OK,
+                         .on_field = on_field, .field_ctx = ctx };
+    multipart_callbacks_t callbacks = { on_part_begin, on_part_data, on_part_end };
+    
+    if (!file || !parser || !chunk) {
+        rc.status = UPLOAD_ERR_IO;
+    } else if (multipart_parser_init(parser, req->content_type, &callbacks, &rc) != 0) {
+        rc.status = UPLOAD_ERR_MALFORMED;
+    } else {
+        long n;
+        while ((n = http_request_read_body(req, chunk, UPLOAD_READ_CHUNK)) > 0) {
+            if (multipart_parser_feed(parser, chunk, (size_t)n) != 0) {
+                if (rc.status == UPLOAD_OK) {
+                    rc.status = UPLOAD_ERR_MALFORMED;
+                }
+                break;
+            }
+        }
+        if (rc.status == UPLOAD_OK) {
+            if (n < 0 || multipart_parser_finish(parser) != 0) {
+                rc.status = UPLOAD_ERR_MALFORMED;
+            }
+        }
+    }
+    
+    if (rc.fd >= 0) {
+        close(rc.fd);
     }
+    free(chunk);
+    free(parser);
     
-    memcpy(file->data, req->body, file->size);
-    return file;
+    if (rc.status != UPLOAD_OK || !rc.done) {
+        upload_file_free(file);
+        return rc.status;
+    }
+    *out = file;
+    return UPLOAD_OK;
 }
 
-int upload_save_file(upload_file_t *file, const char *save_path) {
-    if (!file || !file->data || !save_path) {
+/* Creates the two shard directories above a stored file. */
+static int make_shard_dirs(const char *hash) {
+    char dir[300];
+    snprintf(dir, sizeof(dir), "%s/%.2s", upload_directory, hash);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    snprintf(dir, sizeof(dir), "%s/%.2s/%.2s", upload_directory, hash, hash + 2);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+int upload_store(upload_file_t *file, int *deduplicated) {
+    *deduplicated = 0;
+    if (!file || !file->temp_path[0] || !is_hash(file->hash, strlen(file->hash))) {
+        return -1;
+    }
+    
+    char rel_path[80];
+    char final_path[400];
+    upload_hash_path(file->hash, rel_path, sizeof(rel_path));
+    snprintf(final_path, sizeof(final_path), "%s/%s", upload_directory, rel_path);
+    
+    /* The write lock keeps the row and the file on disk in step with a
+     * concurrent upload_release() of the same hash. */
+    db_write_lock();
+    
+    int existing = -1;
+    sqlite3_stmt *stmt = db_prepare("UPDATE uploads SET ref_count = ref_count + 1 WHERE hash = ?");
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, file->hash, -1, SQLITE_STATIC);
+        if (db_step(stmt) == SQLITE_DONE) {
+            existing = sqlite3_changes(sqlite3_db_handle(stmt)) > 0;
+        }
+        db_finalize(stmt);
+    }
+    if (existing < 0) {
+        db_write_unlock();
         return -1;
     }
     
-    FILE *fp = fopen(save_path, "wb");
-    if (!fp) {
-        fprintf(stderr, "Failed to open file for writing: %s\n", save_path);
+    struct stat st;
+    if (existing && stat(final_path, &st) == 0) {
+        /* Already stored: the new reference is the whole upload. */
+        unlink(file->temp_path);
+        file->temp_path[0] = '\0';
+        *deduplicated = 1;
+        db_write_unlock();
+        printf("File deduplicated: %s (%llu bytes)\n", rel_path, (unsigned long long)file->size);
+        return 0;
+    }
+    
+    if (make_shard_dirs(file->hash) != 0 || rename(file->temp_path, final_path) != 0) {
+        fprintf(stderr, "Failed to move upload to %s: %s\n", final_path, strerror(errno));
+        if (existing) {
+            /* Undo the reference taken above. */
+            upload_release(file->hash);
+        }
+        db_write_unlock();
         return -1;
     }
+    file->temp_path[0] = '\0';
     
-    size_t written = fwrite(file->data, 1, file->size, fp);
-    fclose(fp);
+    int rc = 0;
+    if (!existing) {
+        stmt = db_prepare(
+            "INSERT INTO uploads (hash, size, content_type, ref_count, created_at) "
+            "VALUES (?, ?, ?, 1, " DB_NOW_MS_SQL ")");
+        if (stmt) {
+            sqlite3_bind_text(stmt, 1, file->hash, -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, (sqlite3_int64)file->size);
+            sqlite3_bind_text(stmt, 3, file->content_type, -1, SQLITE_STATIC);
+        }
+        if (db_step(stmt) != SQLITE_DONE) {
+            fprintf(stderr, "Failed to record upload %s\n", file->hash);
+            unlink(final_path);
+            rc = -1;
+        }
+        db_finalize(stmt);
+    }
+    db_write_unlock();
     
-    if (written != file->size) {
-        fprintf(stderr, "Failed to write complete file\n");
+    if (rc == 0) {
+        printf("File stored: %s (%llu bytes)\n", rel_path, (unsigned long long)file->size);
+    }
+    return rc;
+}
+
+int upload_release(const char *hash) {
+    if (!hash || !is_hash(hash, strlen(hash))) {
         return -1;
     }
     
-    printf("File saved successfully: %s (%zu bytes)\n", save_path, file->size);
-    return 0;
+    db_write_lock();
+    int rc = -1;
+    sqlite3_stmt *stmt = db_prepare("UPDATE uploads SET ref_count = ref_count - 1 WHERE hash = ?");
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, hash, -1, SQLITE_STATIC);
+        rc = db_step(stmt) == SQLITE_DONE ? 0 : -1;
+        db_finalize(stmt);
+    }
+    
+    stmt = rc == 0 ? db_prepare("DELETE FROM uploads WHERE hash = ? AND ref_count <= 0") : NULL;
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, hash, -1, SQLITE_STATIC);
+        if (db_step(stmt) == SQLITE_DONE && sqlite3_changes(sqlite3_db_handle(stmt)) > 0) {
+            char path[400];
+            snprintf(path, sizeof(path), "%s/%.2s/%.2s/%s", upload_directory, hash, hash + 2, hash);
+            unlink(path);
+        }
+        db_finalize(stmt);
+    }
+    db_write_unlock();
+    return rc;
 }
 
 void upload_file_free(upload_file_t *file) {
     if (file) {
-        free(file->filename);
-        free(file->content_type);
-        free(file->data);
+        if (file->temp_path[0]) {
+            unlink(file->temp_path);
+        }
         free(file);
     }
 }
@@ -2,22 +2,84 @@
 #define UPLOAD_H
 
 #include "http.h"
+#include "sha256.h"
 #include <stddef.h>
 #include <stdint.h>
 
+/*
+ * Uploads arrive as multipart/form-data and are parsed while they are read
+ * from the socket. The first file part is written to a temporary file under
+ * <upload dir>/.tmp in fixed-size chunks, so memory use per upload does not
+ * depend on the file size, and hashed with SHA-256 on the way.
+ *
+ * Stored files are content-addressed: a file with hash h lives at
+ * <upload dir>/h[0..1]/h[2..3]/h, and the uploads table counts references
+ * to it. Storing a file that is already there only bumps its count and
+ * drops the staging copy.
+ */
+
+#define UPLOAD_MAX_BYTES (64 * 1024 * 1024)
+#define UPLOAD_READ_CHUNK (64 * 1024)
+#define UPLOAD_FIELD_MAX 8192           /* longer text fields are cut */
+/* Largest body of a request carrying a file: the file, the other form
+ * fields and the multipart framing. */
+#define UPLOAD_MAX_BODY (UPLOAD_MAX_BYTES + 64 * 1024)
+
 typedef struct {
-    char *filename;
-    char *content_type;
-    uint8_t *data;
-    size_t size;
+    char filename[256];             /* client file name, made safe for disk */
+    char content_type[128];
+    char temp_path[512];            /* empty once stored */
+    uint64_t size;
+    char hash[SHA256_HEX_SIZE];     /* hex SHA-256, set once fully received */
 } upload_file_t;
 
+typedef enum {
+    UPLOAD_OK,
+    UPLOAD_ERR_MALFORMED,           /* not multipart, or a broken body */
+    UPLOAD_ERR_NO_FILE,
+    UPLOAD_ERR_TOO_LARGE,
+    UPLOAD_ERR_IO
+} upload_status_t;
+
 void upload_init(const char *upload_dir);
 void upload_register_routes(void);
 
 http_response_t *upload_handler(http_request_t *req);
-upload_file_t *upload_parse_multipart(http_request_t *req);
-int upload_save_file(upload_file_t *file, const char *save_path);
+http_response_t *upload_serve_handler(http_request_t *req);
+
+/* Called for each text part of a form, in order. */
+typedef void (*upload_field_fn)(void *ctx, const char *name, const char *value);
+
+/* Reads the whole request body. On UPLOAD_OK, *file holds the first file
+ * part in a temporary file; free it with upload_file_free(). */
+upload_status_t upload_parse_multipart(http_request_t *req, upload_file_t **file);
+
+/* Like upload_parse_multipart(), for forms where the file is optional: a
+ * body without a file part succeeds with *file NULL. Text parts go to
+ * on_field, cut to UPLOAD_FIELD_MAX bytes. */
+upload_status_t upload_parse_form(http_request_t *req, upload_field_fn on_field, void *ctx,
+                                  upload_file_t **file);
+
+/* Keeps the last path component of name and replaces anything but
+ * letters, digits, '.', '-' and '_', so it is safe to create and serve. */
+void upload_sanitize_filename(const char *name, char *dst, size_t size);
+
+/* Adds a reference to file's content, moving the temporary file into the
+ * store unless the content is already there. Sets *deduplicated to 1 in
+ * that case. Returns 0 or -1. */
+int upload_store(upload_file_t *file, int *deduplicated);
+
+/* Drops one reference; the last one deletes the stored file. */
+int upload_release(const char *hash);
+
+/* Path of a stored file relative to the upload directory: "ab/cd/<hash>". */
+void upload_hash_path(const char *hash, char *path, size_t size);
+
+/* Public URL of a stored file: "/uploads/ab/cd/<hash>" plus the extension
+ * of filename when it names a known media type. */
+void upload_url(const char *hash, const char *filename, char *url, size_t size);
+
+/* Deletes the temporary file, if it was never saved, and frees file. */
 void upload_file_free(upload_file_t *file);
 
 #endif
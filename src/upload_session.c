@@ -0,0 +1,528 @@
+#define _POSIX_C_SOURCE 200809L
+#include "upload_session.h"
+#include "upload.h"
+#include "router.h"
+#include "static_file.h"
+#include "sha256.h"
+#include "db.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define SESSION_PREFIX "/upload/sessions/"
+#define MAX_ACTIVE_PATCHES 64
+#define MAX_EXPIRED_PER_SWEEP 256
+
+typedef struct {
+    int64_t length;
+    char filename[256];
+} session_t;
+
+static char partial_directory[280] = "./uploads/.partial";
+
+/* Sessions with a PATCH or DELETE running, so two requests never write the
+ * same partial file. */
+static pthread_mutex_t active_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char active_ids[MAX_ACTIVE_PATCHES][UPLOAD_SESSION_ID_LEN + 1];
+static int64_t last_sweep_ms = 0;
+
+static int is_session_id(const char *id) {
+    if (strlen(id) != UPLOAD_SESSION_ID_LEN) {
+        return 0;
+    }
+    for (const char *p = id; *p; p++) {
+        if (!((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'f'))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Session ids are the only credential for a session, so they come from
+ * the kernel's random source rather than rand(). */
+static int make_session_id(char *id) {
+    static const char hex[] = "0123456789abcdef";
+    unsigned char raw[UPLOAD_SESSION_ID_LEN / 2];
+    
+    int fd = open("/dev/urandom", O_RDONLY);
+    ssize_t n = fd >= 0 ? read(fd, raw, sizeof(raw)) : -1;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (n != (ssize_t)sizeof(raw)) {
+        fprintf(stderr, "Failed to read /dev/urandom for an upload session id\n");
+        return -1;
+    }
+    for (size_t i = 0; i < sizeof(raw); i++) {
+        id[i * 2] = hex[raw[i] >> 4];
+        id[i * 2 + 1] = hex[raw[i] & 0x0f];
+    }
+    id[UPLOAD_SESSION_ID_LEN] = '\0';
+    return 0;
+}
+
+static void partial_path(const char *id, char *path, size_t size) {
+    snprintf(path, size, "%s/%s", partial_directory, id);
+}
+
+/* Parses a non-negative decimal header value. */
+static int parse_size(const char *value, int64_t *out) {
+    if (!value || *value == '\0') {
+        return -1;
+    }
+    int64_t n = 0;
+    for (const char *p = value; *p; p++) {
+        if (*p < '0' || *p > '9' || n > (INT64_MAX - 9) / 10) {
+            return -1;
+        }
+        n = n * 10 + (*p - '0');
+    }
+    *out = n;
+    return 0;
+}
+
+static int claim_session(const char *id) {
+    int claimed = 0;
+    int free_slot = -1;
+    pthread_mutex_lock(&active_mutex);
+    for (int i = 0; i < MAX_ACTIVE_PATCHES; i++) {
+        if (active_ids[i][0] == '\0') {
+            if (free_slot < 0) {
+                free_slot = i;
+            }
+        } else if (strcmp(active_ids[i], id) == 0) {
+            free_slot = -1;
+            break;
+        }
+    }
+    if (free_slot >= 0) {
+        memcpy(active_ids[free_slot], id, UPLOAD_SESSION_ID_LEN + 1);
+        claimed = 1;
+    }
+    pthread_mutex_unlock(&active_mutex);
+    return claimed;
+}
+
+static void release_session(const char *id) {
+    pthread_mutex_lock(&active_mutex);
+    for (int i = 0; i < MAX_ACTIVE_PATCHES; i++) {
+        if (strcmp(active_ids[i], id) == 0) {
+            active_ids[i][0] = '\0';
+            break;
+        }
+    }
+    pthread_mutex_unlock(&active_mutex);
+}
+
+/* Returns 1 and fills session for a live session, 0 when there is none and
+ * -1 on a database error. */
+static int load_session(const char *id, session_t *session) {
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT length, filename FROM upload_sessions WHERE id = ? AND expires_at > ?");
+    if (!stmt) {
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, id, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, db_now_ms());
+    
+    int found = 0;
+    int rc = db_step(stmt);
+    if (rc == SQLITE_ROW) {
+        session->length = sqlite3_column_int64(stmt, 0);
+        const char *filename = (const char *)sqlite3_column_text(stmt, 1);
+        snprintf(session->filename, sizeof(session->filename), "%s", filename ? filename : "");
+        found = 1;
+    } else if (rc != SQLITE_DONE) {
+        found = -1;
+    }
+    db_finalize(stmt);
+    return found;
+}
+
+static int run_session_update(const char *sql, const char *id, int64_t value) {
+    sqlite3_stmt *stmt = db_prepare(sql);
+    if (!stmt) {
+        return -1;
+    }
+    if (value >= 0) {
+        sqlite3_bind_int64(stmt, 1, value);
+        sqlite3_bind_text(stmt, 2, id, -1, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_text(stmt, 1, id, -1, SQLITE_STATIC);
+    }
+    int rc = db_step(stmt) == SQLITE_DONE ? 0 : -1;
+    db_finalize(stmt);
+    return rc;
+}
+
+static int delete_session(const char *id) {
+    return run_session_update("DELETE FROM upload_sessions WHERE id = ?", id, -1);
+}
+
+static int touch_session(const char *id) {
+    return run_session_update("UPDATE upload_sessions SET expires_at = ? WHERE id = ?", id,
+                              db_now_ms() + UPLOAD_SESSION_TTL_MS);
+}
+
+static http_response_t *text_response(int status, const char *message) {
+    http_response_t *response = http_response_create(status, "text/plain", message, strlen(message));
+    if (response) {
+        http_response_add_header(response, "Cache-Control", "no-store");
+    }
+    return response;
+}
+
+static http_response_t *offset_response(int status, int64_t offset, int64_t length) {
+    http_response_t *response = http_response_create(status, "text/plain", NULL, 0);
+    if (response) {
+        char value[32];
+        snprintf(value, sizeof(value), "%lld", (long long)offset);
+        http_response_add_header(response, "Upload-Offset", value);
+        snprintf(value, sizeof(value), "%lld", (long long)length);
+        http_response_add_header(response, "Upload-Length", value);
+        http_response_add_header(response, "Cache-Control", "no-store");
+    }
+    return response;
+}
+
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int hash_file(const char *path, char *chunk, char hex[SHA256_HEX_SIZE]) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    sha256_t ctx;
+    sha256_init(&ctx);
+    ssize_t n;
+    while ((n = read(fd, chunk, UPLOAD_READ_CHUNK)) > 0 || (n < 0 && errno == EINTR)) {
+        if (n > 0) {
+            sha256_update(&ctx, chunk, (size_t)n);
+        }
+    }
+    close(fd);
+    if (n < 0) {
+        return -1;
+    }
+    
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_final(&ctx, digest);
+    sha256_hex(digest, hex);
+    return 0;
+}
+
+/* Moves a complete partial file into the upload store and ends the
+ * session. Caller has claimed it. */
+static http_response_t *finish_session(const char *id, const session_t *session,
+                                       const char *path, char *chunk) {
+    upload_file_t file;
+    memset(&file, 0, sizeof(file));
+    snprintf(file.filename, sizeof(file.filename), "%s", session->filename);
+    snprintf(file.content_type, sizeof(file.content_type), "%s",
+             static_file_content_type(session->filename));
+    snprintf(file.temp_path, sizeof(file.temp_path), "%s", path);
+    file.size = (uint64_t)session->length;
+    
+    /* The bytes may have arrived over days and restarts, so the hash is
+     * taken from the finished file in one pass rather than carried along. */
+    int deduplicated = 0;
+    if (hash_file(path, chunk, file.hash) != 0 || upload_store(&file, &deduplicated) != 0) {
+        fprintf(stderr, "Failed to store resumable upload %s\n", id);
+        return text_response(500, "Failed to store file");
+    }
+    delete_session(id);
+    
+    char url[160];
+    upload_url(file.hash, file.filename, url, sizeof(url));
+    http_response_t *response = offset_response(201, session->length, session->length);
+    if (response) {
+        http_response_add_header(response, "Location", url);
+    }
+    return response;
+}
+
+static http_response_t *patch_session(http_request_t *req, const char *id,
+                                      const session_t *session) {
+    int64_t offset;
+    if (parse_size(req->upload_offset, &offset) != 0) {
+        return text_response(400, "Upload-Offset required");
+    }
+    if (!claim_session(id)) {
+        return text_response(409, "Upload already in progress");
+    }
+    
+    char path[400];
+    partial_path(id, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_APPEND);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        release_session(id);
+        return text_response(404, "Upload not found");
+    }
+    
+    /* The partial file's size is the only record of progress. */
+    if ((int64_t)st.st_size != offset) {
+        close(fd);
+        release_session(id);
+        return offset_response(409, (int64_t)st.st_size, session->length);
+    }
+    if ((int64_t)req->content_length > session->length - offset) {
+        close(fd);
+        release_session(id);
+        return text_response(413, "Data past Upload-Length");
+    }
+    
+    char *chunk = malloc(UPLOAD_READ_CHUNK);
+    if (!chunk) {
+        close(fd);
+        release_session(id);
+        return text_response(500, "Out of memory");
+    }
+    
+    /* Whatever arrives is kept even if the client goes away mid-request;
+     * it resumes from the new size. */
+    int failed = 0;
+    long n;
+    while ((n = http_request_read_body(req, chunk, UPLOAD_READ_CHUNK)) > 0) {
+        if (offset + n > session->length || write_all(fd, chunk, (size_t)n) != 0) {
+            failed = 1;
+            break;
+        }
+        offset += n;
+    }
+    close(fd);
+    
+    http_response_t *response;
+    if (failed) {
+        fprintf(stderr, "Failed to write resumable upload %s: %s\n", id, strerror(errno));
+        response = text_response(500, "Failed to write upload");
+    } else if (offset == session->length) {
+        response = finish_session(id, session, path, chunk);
+    } else {
+        touch_session(id);
+        response = offset_response(204, offset, session->length);
+    }
+    
+    free(chunk);
+    release_session(id);
+    return response;
+}
+
+/* Removes the session and its partial file. Caller has claimed it. */
+static void remove_session(const char *id) {
+    char path[400];
+    partial_path(id, path, sizeof(path));
+    unlink(path);
+    delete_session(id);
+}
+
+int upload_session_expire(void) {
+    char (*ids)[UPLOAD_SESSION_ID_LEN + 1] = malloc(MAX_EXPIRED_PER_SWEEP * sizeof(*ids));
+    if (!ids) {
+        return -1;
+    }
+    
+    sqlite3_stmt *stmt = db_prepare("SELECT id FROM upload_sessions WHERE expires_at <= ? LIMIT ?");
+    if (!stmt) {
+        free(ids);
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, db_now_ms());
+    sqlite3_bind_int(stmt, 2, MAX_EXPIRED_PER_SWEEP);
+    int count = 0;
+    while (db_step(stmt) == SQLITE_ROW) {
+        const char *id = (const char *)sqlite3_column_text(stmt, 0);
+        if (id && is_session_id(id)) {
+            memcpy(ids[count++], id, UPLOAD_SESSION_ID_LEN + 1);
+        }
+    }
+    db_finalize(stmt);
+    
+    int removed = 0;
+    for (int i = 0; i < count; i++) {
+        /* A session being written right now was just touched; leave it. */
+        if (claim_session(ids[i])) {
+            remove_session(ids[i]);
+            release_session(ids[i]);
+            removed++;
+        }
+    }
+    free(ids);
+    
+    if (removed > 0) {
+        printf("Expired %d abandoned upload session(s)\n", removed);
+    }
+    return removed;
+}
+
+void upload_session_sweep(void) {
+    int64_t now = db_now_ms();
+    int due = 0;
+    pthread_mutex_lock(&active_mutex);
+    if (now - last_sweep_ms >= UPLOAD_SESSION_SWEEP_MS) {
+        last_sweep_ms = now;
+        due = 1;
+    }
+    pthread_mutex_unlock(&active_mutex);
+    if (due) {
+        upload_session_expire();
+    }
+}
+
+/* Deletes partial files left without a session, e.g. by a crash between
+ * creating the file and recording the session. */
+static void remove_orphans(void) {
+    DIR *dir = opendir(partial_directory);
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    session_t session;
+    while ((entry = readdir(dir)) != NULL) {
+        if (is_session_id(entry->d_name) && load_session(entry->d_name, &session) == 0) {
+            char path[400];
+            partial_path(entry->d_name, path, sizeof(path));
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+void upload_session_init(const char *upload_dir) {
+    snprintf(partial_directory, sizeof(partial_directory), "%s/.partial",
+             upload_dir ? upload_dir : "./uploads");
+    if (mkdir(partial_directory, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: Failed to create resumable upload directory %s: %s\n",
+                partial_directory, strerror(errno));
+    }
+    
+    last_sweep_ms = db_now_ms();
+    upload_session_expire();
+    remove_orphans();
+    
+    printf("Resumable uploads initialized, staging directory: %s\n", partial_directory);
+}
+
+void upload_session_register_routes(void) {
+    router_add_limited_route("POST", "/upload/sessions", upload_session_create_handler,
+                             ROUTER_MAX_BODY, ROUTE_AUTH);
+    router_add_limited_route("HEAD", SESSION_PREFIX "*", upload_session_handler,
+                             ROUTER_MAX_BODY, ROUTE_AUTH);
+    router_add_limited_route("PATCH", SESSION_PREFIX "*", upload_session_handler,
+                             UPLOAD_SESSION_MAX_BYTES, ROUTE_AUTH);
+    router_add_limited_route("DELETE", SESSION_PREFIX "*", upload_session_handler,
+                             ROUTER_MAX_BODY, ROUTE_AUTH);
+}
+
+/* POST /upload/sessions?filename={name} with Upload-Length. */
+http_response_t *upload_session_create_handler(http_request_t *req) {
+    int64_t length;
+    if (parse_size(req->upload_length, &length) != 0 || length <= 0) {
+        return text_response(400, "Upload-Length required");
+    }
+    if (length > UPLOAD_SESSION_MAX_BYTES) {
+        return text_response(413, "File too large");
+    }
+    
+    upload_session_sweep();
+    
+    char name[256] = "";
+    char filename[256];
+    get_query_param(req->query_string, "filename", name, sizeof(name));
+    upload_sanitize_filename(name, filename, sizeof(filename));
+    
+    char id[UPLOAD_SESSION_ID_LEN + 1];
+    char path[400];
+    if (make_session_id(id) != 0) {
+        return text_response(500, "Failed to create upload");
+    }
+    partial_path(id, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create partial upload %s: %s\n", path, strerror(errno));
+        return text_response(500, "Failed to create upload");
+    }
+    close(fd);
+    
+    sqlite3_stmt *stmt = db_prepare(
+        "INSERT INTO upload_sessions (id, length, filename, created_at, expires_at) "
+        "VALUES (?, ?, ?, " DB_NOW_MS_SQL ", ?)");
+    if (stmt) {
+        sqlite3_bind_text(stmt, 1, id, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, length);
+        sqlite3_bind_text(stmt, 3, filename, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, db_now_ms() + UPLOAD_SESSION_TTL_MS);
+    }
+    int rc = db_step(stmt);
+    db_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        unlink(path);
+        return text_response(500, "Failed to create upload");
+    }
+    
+    char location[64];
+    snprintf(location, sizeof(location), SESSION_PREFIX "%s", id);
+    http_response_t *response = offset_response(201, 0, length);
+    if (response) {
+        http_response_add_header(response, "Location", location);
+    }
+    return response;
+}
+
+/* HEAD, PATCH and DELETE /upload/sessions/{id}. */
+http_response_t *upload_session_handler(http_request_t *req) {
+    const char *id = req->path + strlen(SESSION_PREFIX);
+    session_t session;
+    int found = is_session_id(id) ? load_session(id, &session) : 0;
+    if (found < 0) {
+        return text_response(500, "Database error");
+    }
+    if (found == 0) {
+        return text_response(404, "Upload not found");
+    }
+    
+    if (strcmp(req->method, "PATCH") == 0) {
+        return patch_session(req, id, &session);
+    }
+    
+    if (strcmp(req->method, "DELETE") == 0) {
+        if (!claim_session(id)) {
+            return text_response(409, "Upload already in progress");
+        }
+        remove_session(id);
+        release_session(id);
+        return http_response_create(204, "text/plain", NULL, 0);
+    }
+    
+    char path[400];
+    struct stat st;
+    partial_path(id, path, sizeof(path));
+    if (stat(path, &st) != 0) {
+        return text_response(404, "Upload not found");
+    }
+    return offset_response(200, (int64_t)st.st_size, session.length);
+}
@@ -0,0 +1,45 @@
+#ifndef UPLOAD_SESSION_H
+#define UPLOAD_SESSION_H
+
+#include "http.h"
+#include <stdint.h>
+
+/*
+ * Resumable uploads. A client declares the file size once, then sends the
+ * bytes in any number of PATCH requests, each starting at the offset the
+ * server already has. The partial file lives in <upload dir>/.partial and
+ * its size is the offset, so a dropped connection loses only the bytes in
+ * flight and HEAD tells the client where to resume. The last byte moves
+ * the file into the upload store.
+ *
+ *   POST  /upload/sessions?filename=x   Upload-Length: n  -> 201, Location
+ *   HEAD  /upload/sessions/{id}         -> Upload-Offset, Upload-Length
+ *   PATCH /upload/sessions/{id}         Upload-Offset: k, bytes k..
+ *   DELETE /upload/sessions/{id}        abandons the upload
+ *
+ * Sessions not written to for UPLOAD_SESSION_TTL_MS are removed together
+ * with their partial files, swept by the maintenance thread and when a
+ * session is created.
+ */
+
+#define UPLOAD_SESSION_MAX_BYTES (1024LL * 1024 * 1024)
+#define UPLOAD_SESSION_TTL_MS (24LL * 60 * 60 * 1000)
+#define UPLOAD_SESSION_SWEEP_MS (10LL * 60 * 1000)
+#define UPLOAD_SESSION_ID_LEN 32
+
+/* Creates the staging directory and removes expired sessions. */
+void upload_session_init(const char *upload_dir);
+void upload_session_register_routes(void);
+
+http_response_t *upload_session_create_handler(http_request_t *req);
+http_response_t *upload_session_handler(http_request_t *req);
+
+/* Deletes expired sessions and their partial files. Returns the number
+ * removed, or -1 on a database error. */
+int upload_session_expire(void);
+
+/* Runs upload_session_expire() if the last sweep was at least
+ * UPLOAD_SESSION_SWEEP_MS ago. Safe to call often, from any thread. */
+void upload_session_sweep(void);
+
+#endif
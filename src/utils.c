@@ -34,7 +34,7 @@ char *get_cookie_value(const char *cookies, const char *name) {
         return NULL;
     }
     
-    static char value[256];
+    static _Thread_local char value[256];
     char search_name[64];
     snprintf(search_name, sizeof(search_name), "%s=", name);
     
@@ -63,8 +63,44 @@ char *get_cookie_value(const char *cookies, const char *name) {
     return value;
 }
 
+/* Copies the url-decoded value of name from a query string into dst.
+ * Returns 0 when the parameter is present, -1 otherwise. */
+int get_query_param(const char *query, const char *name, char *dst, size_t dst_size) {
+    if (!query || !name || dst_size == 0) {
+        return -1;
+    }
+    
+    size_t name_len = strlen(name);
+    const char *p = query;
+    
+    while (*p) {
+        const char *end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        
+        if (len > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            size_t value_len = len - name_len - 1;
+            char *raw = malloc(value_len + 1);
+            if (!raw) {
+                return -1;
+            }
+            memcpy(raw, p + name_len + 1, value_len);
+            raw[value_len] = '\0';
+            url_decode(dst, raw, dst_size);
+            free(raw);
+            return 0;
+        }
+        
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    
+    return -1;
+}
+
 char *generate_random_token(int length) {
-    static char token[256];
+    static _Thread_local char token[256];
     static const char charset[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
     
     if (length >= 256) {
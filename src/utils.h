@@ -5,6 +5,7 @@
 
 void url_decode(char *dst, const char *src, size_t dst_size);
 char *get_cookie_value(const char *cookies, const char *name);
+int get_query_param(const char *query, const char *name, char *dst, size_t dst_size);
 char *generate_random_token(int length);
 
 #endif
@@ -0,0 +1,373 @@
+#define _POSIX_C_SOURCE 200809L
+#include "write_queue.h"
+#include "db.h"
+#include "id_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#define WRITE_QUEUE_BATCH_MAX 128
+#define WRITE_QUEUE_BATCH_WINDOW_MS 2
+
+typedef enum {
+    WRITE_JOB_THREAD,
+    WRITE_JOB_POST
+} write_job_type_t;
+
+typedef struct write_job {
+    write_job_type_t type;
+    int64_t board_id;
+    int64_t thread_id;
+    int64_t reply_to;
+    const char *subject;
+    const char *author;
+    const char *content;
+    const char *content_html;
+    const post_attachment_t *attachment;
+
+    int64_t result_thread_id;
+    int64_t result_post_id;
+    int status;
+    int done;
+
+    struct write_job *next;
+} write_job_t;
+
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t batch_done = PTHREAD_COND_INITIALIZER;
+static write_job_t *queue_head = NULL;
+static write_job_t *queue_tail = NULL;
+static size_t queue_length = 0;
+static int queue_running = 0;
+static int queue_stopping = 0;
+static pthread_t writer_thread;
+
+/* Only touched while holding the database write lock. */
+static sqlite3_stmt *insert_thread_stmt = NULL;
+static sqlite3_stmt *insert_post_stmt = NULL;
+static sqlite3_stmt *insert_attachment_stmt = NULL;
+
+static int prepare_statements(sqlite3 *conn) {
+    if (!insert_thread_stmt &&
+        sqlite3_prepare_v3(conn, "INSERT INTO threads (board_id, subject, created_at) VALUES (?, ?, ?)",
+                           -1, SQLITE_PREPARE_PERSISTENT, &insert_thread_stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Write queue: failed to prepare thread insert: %s\n", sqlite3_errmsg(conn));
+        return -1;
+    }
+    if (!insert_post_stmt &&
+        sqlite3_prepare_v3(conn, "INSERT INTO posts (thread_id, author, content, content_html, reply_to, created_at) "
+                           "VALUES (?, ?, ?, ?, ?, ?)",
+                           -1, SQLITE_PREPARE_PERSISTENT, &insert_post_stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Write queue: failed to prepare post insert: %s\n", sqlite3_errmsg(conn));
+        return -1;
+    }
+    if (!insert_attachment_stmt &&
+        sqlite3_prepare_v3(conn, "INSERT INTO attachments (post_id, hash, filename, content_type, size, "
+                           "width, height, created_at) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+                           -1, SQLITE_PREPARE_PERSISTENT, &insert_attachment_stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Write queue: failed to prepare attachment insert: %s\n", sqlite3_errmsg(conn));
+        return -1;
+    }
+    return 0;
+}
+
+static void finalize_statements(void) {
+    db_write_lock();
+    sqlite3_finalize(insert_thread_stmt);
+    sqlite3_finalize(insert_post_stmt);
+    sqlite3_finalize(insert_attachment_stmt);
+    insert_thread_stmt = NULL;
+    insert_post_stmt = NULL;
+    insert_attachment_stmt = NULL;
+    db_write_unlock();
+}
+
+static int insert_attachment(int64_t post_id, const post_attachment_t *attachment) {
+    sqlite3_stmt *stmt = insert_attachment_stmt;
+
+    sqlite3_bind_int64(stmt, 1, post_id);
+    sqlite3_bind_text(stmt, 2, attachment->hash, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, attachment->filename, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, attachment->content_type, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 5, attachment->size);
+    if (attachment->width > 0) {
+        sqlite3_bind_int(stmt, 6, attachment->width);
+        sqlite3_bind_int(stmt, 7, attachment->height);
+    } else {
+        sqlite3_bind_null(stmt, 6);
+        sqlite3_bind_null(stmt, 7);
+    }
+    sqlite3_bind_int64(stmt, 8, db_now_ms());
+
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+static int insert_post(sqlite3 *conn, int64_t thread_id, write_job_t *job) {
+    sqlite3_stmt *stmt = insert_post_stmt;
+
+    sqlite3_bind_int64(stmt, 1, thread_id);
+    sqlite3_bind_text(stmt, 2, job->author, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, job->content, -1, SQLITE_STATIC);
+    if (job->content_html) {
+        sqlite3_bind_text(stmt, 4, job->content_html, -1, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_null(stmt, 4);
+    }
+    if (job->type == WRITE_JOB_POST && job->reply_to > 0) {
+        sqlite3_bind_int64(stmt, 5, job->reply_to);
+    } else {
+        sqlite3_bind_null(stmt, 5);
+    }
+    sqlite3_bind_int64(stmt, 6, db_now_ms());
+
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    if (rc != SQLITE_DONE) {
+        return -1;
+    }
+    job->result_post_id = sqlite3_last_insert_rowid(conn);
+    return job->attachment ? insert_attachment(job->result_post_id, job->attachment) : 0;
+}
+
+static int execute_job(sqlite3 *conn, write_job_t *job) {
+    if (job->type == WRITE_JOB_THREAD) {
+        sqlite3_stmt *stmt = insert_thread_stmt;
+        sqlite3_bind_int64(stmt, 1, job->board_id);
+        sqlite3_bind_text(stmt, 2, job->subject, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 3, db_now_ms());
+
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        if (rc != SQLITE_DONE) {
+            return -1;
+        }
+
+        job->result_thread_id = sqlite3_last_insert_rowid(conn);
+        return insert_post(conn, job->result_thread_id, job);
+    }
+
+    job->result_thread_id = job->thread_id;
+    return insert_post(conn, job->thread_id, job);
+}
+
+/*
+ * Runs a whole batch in one transaction. Each job gets its own savepoint so
+ * one failing insert does not take the rest of the batch down with it.
+ */
+static void run_batch(write_job_t *batch) {
+    db_write_lock();
+    sqlite3 *conn = db_get_connection();
+
+    int ok = conn && prepare_statements(conn) == 0 &&
+             sqlite3_exec(conn, "BEGIN IMMEDIATE", NULL, NULL, NULL) == SQLITE_OK;
+
+    if (ok) {
+        for (write_job_t *job = batch; job; job = job->next) {
+            sqlite3_exec(conn, "SAVEPOINT write_job", NULL, NULL, NULL);
+            job->status = execute_job(conn, job);
+            if (job->status != 0) {
+                fprintf(stderr, "Write queue: insert failed: %s\n", sqlite3_errmsg(conn));
+                sqlite3_exec(conn, "ROLLBACK TO write_job", NULL, NULL, NULL);
+            }
+            sqlite3_exec(conn, "RELEASE write_job", NULL, NULL, NULL);
+        }
+
+        if (sqlite3_exec(conn, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Write queue: commit failed: %s\n", sqlite3_errmsg(conn));
+            sqlite3_exec(conn, "ROLLBACK", NULL, NULL, NULL);
+            ok = 0;
+        }
+    }
+
+    db_write_unlock();
+
+    for (write_job_t *job = batch; job; job = job->next) {
+        if (!ok) {
+            job->status = -1;
+        } else if (job->status == 0) {
+            if (job->type == WRITE_JOB_THREAD) {
+                id_filter_add(ID_FILTER_THREADS, job->result_thread_id);
+            }
+            id_filter_add(ID_FILTER_POSTS, job->result_post_id);
+        }
+    }
+}
+
+static write_job_t *take_batch(void) {
+    write_job_t *batch = queue_head;
+    write_job_t *last = queue_head;
+    size_t count = 1;
+
+    while (count < WRITE_QUEUE_BATCH_MAX && last->next) {
+        last = last->next;
+        count++;
+    }
+
+    queue_head = last->next;
+    if (!queue_head) {
+        queue_tail = NULL;
+    }
+    queue_length -= count;
+    last->next = NULL;
+    return batch;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&queue_mutex);
+    for (;;) {
+        while (!queue_head && !queue_stopping) {
+            pthread_cond_wait(&queue_not_empty, &queue_mutex);
+        }
+        if (!queue_head) {
+            break;
+        }
+
+        /* Give concurrent writers a moment to join this commit. */
+        if (queue_length < WRITE_QUEUE_BATCH_MAX && !queue_stopping) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += WRITE_QUEUE_BATCH_WINDOW_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (queue_length < WRITE_QUEUE_BATCH_MAX && !queue_stopping) {
+                if (pthread_cond_timedwait(&queue_not_empty, &queue_mutex, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+        }
+
+        write_job_t *batch = take_batch();
+        pthread_mutex_unlock(&queue_mutex);
+
+        run_batch(batch);
+
+        pthread_mutex_lock(&queue_mutex);
+        for (write_job_t *job = batch; job; ) {
+            write_job_t *next = job->next;
+            job->done = 1;
+            job = next;
+        }
+        pthread_cond_broadcast(&batch_done);
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    return NULL;
+}
+
+int write_queue_start(void) {
+    pthread_mutex_lock(&queue_mutex);
+    queue_stopping = 0;
+    pthread_mutex_unlock(&queue_mutex);
+
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start write queue thread: %s\n", strerror(errno));
+        return -1;
+    }
+
+    queue_running = 1;
+    printf("Write queue started (batch window %dms, max %d)\n",
+           WRITE_QUEUE_BATCH_WINDOW_MS, WRITE_QUEUE_BATCH_MAX);
+    return 0;
+}
+
+void write_queue_stop(void) {
+    if (queue_running) {
+        pthread_mutex_lock(&queue_mutex);
+        queue_stopping = 1;
+        pthread_cond_broadcast(&queue_not_empty);
+        pthread_mutex_unlock(&queue_mutex);
+
+        pthread_join(writer_thread, NULL);
+        queue_running = 0;
+    }
+
+    finalize_statements();
+}
+
+static int submit(write_job_t *job) {
+    job->status = -1;
+    job->done = 0;
+    job->next = NULL;
+
+    pthread_mutex_lock(&queue_mutex);
+
+    if (!queue_running || queue_stopping) {
+        /* No writer thread (tests, shutdown): commit inline as a batch of one. */
+        pthread_mutex_unlock(&queue_mutex);
+        run_batch(job);
+        return job->status;
+    }
+
+    if (queue_tail) {
+        queue_tail->next = job;
+    } else {
+        queue_head = job;
+    }
+    queue_tail = job;
+    queue_length++;
+    pthread_cond_signal(&queue_not_empty);
+
+    while (!job->done) {
+        pthread_cond_wait(&batch_done, &queue_mutex);
+    }
+
+    pthread_mutex_unlock(&queue_mutex);
+    return job->status;
+}
+
+int write_queue_create_thread(int64_t board_id, const char *subject,
+                              const char *author, const char *content,
+                              const char *content_html,
+                              const post_attachment_t *attachment,
+                              int64_t *thread_id, int64_t *post_id) {
+    write_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.type = WRITE_JOB_THREAD;
+    job.board_id = board_id;
+    job.subject = subject;
+    job.author = author;
+    job.content = content;
+    job.content_html = content_html;
+    job.attachment = attachment;
+
+    int rc = submit(&job);
+    if (rc == 0) {
+        if (thread_id) *thread_id = job.result_thread_id;
+        if (post_id) *post_id = job.result_post_id;
+    }
+    return rc;
+}
+
+int write_queue_create_post(int64_t thread_id, int64_t reply_to,
+                            const char *author, const char *content,
+                            const char *content_html,
+                            const post_attachment_t *attachment, int64_t *post_id) {
+    write_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.type = WRITE_JOB_POST;
+    job.thread_id = thread_id;
+    job.reply_to = reply_to;
+    job.author = author;
+    job.content = content;
+    job.content_html = content_html;
+    job.attachment = attachment;
+
+    int rc = submit(&job);
+    if (rc == 0 && post_id) {
+        *post_id = job.result_post_id;
+    }
+    return rc;
+}
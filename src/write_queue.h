@@ -0,0 +1,45 @@
+#ifndef WRITE_QUEUE_H
+#define WRITE_QUEUE_H
+
+#include <stdint.h>
+
+/*
+ * Group-commit queue for thread and post inserts. Callers block until the
+ * dedicated writer thread has committed the batch containing their insert;
+ * all inserts that arrive within one batch window share a single
+ * transaction and WAL commit.
+ */
+
+/* A file stored in the upload store, linked to the post in the same
+ * transaction. width and height are 0 for files that are not images. */
+typedef struct {
+    const char *hash;
+    const char *filename;
+    const char *content_type;
+    int64_t size;
+    int width;
+    int height;
+} post_attachment_t;
+
+int write_queue_start(void);
+
+/* Drains pending jobs and releases the cached statements; call before
+ * db_close(). */
+void write_queue_stop(void);
+
+/* Inserts a thread together with its opening post. content_html is the
+ * escaped content stored next to it (NULL leaves it to readers), and
+ * attachment may be NULL. Returns 0 on success. */
+int write_queue_create_thread(int64_t board_id, const char *subject,
+                              const char *author, const char *content,
+                              const char *content_html,
+                              const post_attachment_t *attachment,
+                              int64_t *thread_id, int64_t *post_id);
+
+/* Inserts a reply; reply_to <= 0 means no quoted post. Returns 0 on success. */
+int write_queue_create_post(int64_t thread_id, int64_t reply_to,
+                            const char *author, const char *content,
+                            const char *content_html,
+                            const post_attachment_t *attachment, int64_t *post_id);
+
+#endif
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "board.h"
+#include "db.h"
+#include "cjk_tokenizer.h"
+
+#define TEST_DB_PATH "test_board.db"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void cleanup_test_db(void) {
+    unlink(TEST_DB_PATH);
+}
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+/* Thread 1 gets posts 1-3, created out of id order, with post 2 of
+ * thread 2 in between. */
+static void setup_db(void) {
+    cleanup_test_db();
+    assert(cjk_tokenizer_install() == 0);
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec(
+        "INSERT INTO boards (id, name, title) VALUES (1, 'tech', 'Technology');"
+        "INSERT INTO threads (id, board_id, subject) VALUES (1, 1, 'Delta');"
+        "INSERT INTO threads (id, board_id, subject) VALUES (2, 1, 'Other');"
+        "INSERT INTO posts (id, thread_id, author, content, created_at) "
+        "VALUES (1, 1, 'ann', 'first', 1000);"
+        "INSERT INTO posts (id, thread_id, author, content, created_at) "
+        "VALUES (2, 2, 'bob', 'elsewhere', 1500);"
+        "INSERT INTO posts (id, thread_id, author, content, created_at) "
+        "VALUES (3, 1, 'cat', 'say \"hi\"', 3000);"
+        "INSERT INTO posts (id, thread_id, author, content, created_at) "
+        "VALUES (4, 1, 'dan', 'last', 2000);"
+    ) == 0);
+}
+
+static http_response_t *since(const char *path, const char *query) {
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "GET";
+    req.path = path;
+    req.query_string = query;
+    return thread_path_handler(&req);
+}
+
+/* Copies the response body into a NUL-terminated buffer. */
+static const char *body_of(const http_response_t *response) {
+    static char body[65536];
+    size_t len = response->body_len < sizeof(body) - 1 ? response->body_len : sizeof(body) - 1;
+    memcpy(body, response->body ? response->body : "", len);
+    body[len] = '\0';
+    return body;
+}
+
+void test_since_not_modified(void) {
+    test_start("Nothing newer answers 304");
+    
+    setup_db();
+    
+    http_response_t *html = since("/thread/1/since/4", NULL);
+    http_response_t *json = since("/thread/1/since/4", "format=json");
+    int ok = html && html->status_code == 304 && html->body_len == 0 &&
+             json && json->status_code == 304 && json->body_len == 0;
+    http_response_free(html);
+    http_response_free(json);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Expected 304 with an empty body");
+    }
+}
+
+void test_since_newer_posts(void) {
+    test_start("Only newer posts of the thread, in id order");
+    
+    setup_db();
+    
+    http_response_t *response = since("/thread/1/since/1", NULL);
+    int ok = response && response->status_code == 200;
+    const char *body = ok ? body_of(response) : "";
+    const char *post3 = strstr(body, "id=\"post-3\"");
+    const char *post4 = strstr(body, "id=\"post-4\"");
+    ok = ok && post3 && post4 && post3 < post4 &&
+         !strstr(body, "id=\"post-1\"") && !strstr(body, "id=\"post-2\"");
+    printf("  Fragments for posts 3 and 4 only: %s\n", ok ? "yes" : "no");
+    http_response_free(response);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Wrong posts or order");
+    }
+}
+
+void test_since_limit(void) {
+    test_start("At most THREAD_SINCE_LIMIT posts per request");
+    
+    setup_db();
+    assert(db_exec("BEGIN;") == 0);
+    for (int i = 0; i < THREAD_SINCE_LIMIT + 20; i++) {
+        assert(db_exec("INSERT INTO posts (thread_id, author, content, created_at) "
+                       "VALUES (1, 'eve', 'more', 4000);") == 0);
+    }
+    assert(db_exec("COMMIT;") == 0);
+    
+    /* Posts 5 onwards belong to thread 1. */
+    http_response_t *response = since("/thread/1/since/4", "format=json");
+    int ok = response && response->status_code == 200;
+    const char *body = ok ? body_of(response) : "";
+    int count = 0;
+    for (const char *p = body; (p = strstr(p, "{\"id\":")) != NULL; p++) {
+        count++;
+    }
+    char last_id[32];
+    snprintf(last_id, sizeof(last_id), "],\"last_id\":%d}", 4 + THREAD_SINCE_LIMIT);
+    ok = ok && count == THREAD_SINCE_LIMIT && strstr(body, last_id) != NULL;
+    printf("  Posts returned: %d\n", count);
+    http_response_free(response);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Limit not applied");
+    }
+}
+
+void test_since_json(void) {
+    test_start("JSON shape");
+    
+    setup_db();
+    
+    http_response_t *response = since("/thread/1/since/1", "format=json");
+    int ok = response && response->status_code == 200 &&
+             strcmp(response->content_type, "application/json") == 0;
+    const char *body = ok ? body_of(response) : "";
+    printf("  %s\n", body);
+    ok = ok && strcmp(body,
+        "{\"posts\":["
+        "{\"id\":3,\"author\":\"cat\",\"content_html\":\"say &quot;hi&quot;\","
+        "\"reply_to\":0,\"created_at\":3000,\"attachment\":null},"
+        "{\"id\":4,\"author\":\"dan\",\"content_html\":\"last\","
+        "\"reply_to\":0,\"created_at\":2000,\"attachment\":null}"
+        "],\"last_id\":4}") == 0;
+    http_response_free(response);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected JSON");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Board Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_since_not_modified();
+    test_since_newer_posts();
+    test_since_limit();
+    test_since_json();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
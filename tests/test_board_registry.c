@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "db.h"
+#include "board_registry.h"
+#include "router.h"
+
+#define TEST_DB_PATH "test_board_registry.db"
+#define READER_THREADS 4
+#define ADDED_BOARDS 200
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void cleanup_test_db(void) {
+    unlink(TEST_DB_PATH);
+}
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+void test_lookup(void) {
+    test_start("Lookup by id and by name");
+    
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec(
+        "INSERT INTO boards (name, title, description) VALUES ('tech', 'Technology', 'Programming');"
+        "INSERT INTO boards (name, title) VALUES ('art', 'Art');"
+        "INSERT INTO boards (name, title) VALUES ('music', 'Music');"
+    ) == 0);
+    
+    int ok = board_registry_load() == 0;
+    
+    const board_t *tech = board_registry_get_by_id(1);
+    const board_t *art = board_registry_get_by_name("art");
+    ok = ok && tech && strcmp(tech->name, "tech") == 0 &&
+         strcmp(tech->title, "Technology") == 0 &&
+         strcmp(tech->description, "Programming") == 0;
+    ok = ok && art && art->id == 2 && art->description == NULL;
+    ok = ok && board_registry_get_by_id(4) == NULL &&
+         board_registry_get_by_name("missing") == NULL;
+    
+    size_t count;
+    const board_t *const *boards = board_registry_list(&count);
+    ok = ok && count == 3 && strcmp(boards[0]->name, "art") == 0 &&
+         strcmp(boards[1]->name, "music") == 0 && strcmp(boards[2]->name, "tech") == 0;
+    
+    /* A reload keeps existing views and adds the new board. */
+    assert(db_exec("INSERT INTO boards (name, title) VALUES ('books', 'Books')") == 0);
+    ok = ok && board_registry_load() == 0;
+    ok = ok && board_registry_get_by_id(1) == tech && board_registry_get_by_name("art") == art;
+    const board_t *books = board_registry_get_by_name("books");
+    ok = ok && books && books->id == 4;
+    boards = board_registry_list(&count);
+    ok = ok && count == 4 && boards[1] == books;
+    
+    board_registry_shutdown();
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected lookup result");
+    }
+}
+
+static http_response_t *prefix_handler(http_request_t *req) {
+    (void)req;
+    return http_response_create(200, "text/plain", "prefix", 6);
+}
+
+static http_response_t *exact_handler(http_request_t *req) {
+    (void)req;
+    return http_response_create(200, "text/plain", "exact", 5);
+}
+
+void test_prefix_routes(void) {
+    test_start("Prefix routes");
+    
+    router_init();
+    router_add_route("GET", "/b", exact_handler);
+    router_add_route("GET", "/b/*", prefix_handler);
+    
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "GET";
+    
+    const char *paths[] = { "/b", "/b/tech/", "/b/", "/board" };
+    const char *expected[] = { "exact", "prefix", "prefix", NULL };
+    int ok = 1;
+    for (int i = 0; i < 4; i++) {
+        req.path = paths[i];
+        http_response_t *resp = router_dispatch(&req);
+        if (expected[i]) {
+            ok = ok && resp->status_code == 200 &&
+                 memcmp(resp->body, expected[i], strlen(expected[i])) == 0;
+        } else {
+            ok = ok && resp->status_code == 404;
+        }
+        http_response_free(resp);
+    }
+    router_cleanup();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Route matched the wrong handler");
+    }
+}
+
+static atomic_int stop_readers = 0;
+static atomic_int reader_errors = 0;
+
+static void *reader_main(void *arg) {
+    (void)arg;
+    
+    while (!atomic_load(&stop_readers)) {
+        size_t count;
+        const board_t *const *boards = board_registry_list(&count);
+        for (size_t i = 1; i < count; i++) {
+            if (strcmp(boards[i - 1]->name, boards[i]->name) >= 0) {
+                atomic_fetch_add(&reader_errors, 1);
+            }
+        }
+        
+        const board_t *board = board_registry_get_by_name("general");
+        if (!board || board->id != 1 || strcmp(board->title, "General") != 0) {
+            atomic_fetch_add(&reader_errors, 1);
+        }
+    }
+    return NULL;
+}
+
+void test_concurrent_readers(void) {
+    test_start("Concurrent readers during reloads");
+    
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec("INSERT INTO boards (name, title) VALUES ('general', 'General')") == 0);
+    assert(board_registry_load() == 0);
+    
+    pthread_t readers[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_create(&readers[i], NULL, reader_main, NULL);
+    }
+    
+    char sql[128];
+    for (int i = 0; i < ADDED_BOARDS; i++) {
+        snprintf(sql, sizeof(sql), "INSERT INTO boards (name, title) VALUES ('board%03d', 'Board')", i);
+        db_exec(sql);
+        board_registry_load();
+    }
+    
+    atomic_store(&stop_readers, 1);
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+    
+    size_t count;
+    board_registry_list(&count);
+    int ok = atomic_load(&reader_errors) == 0 && count == ADDED_BOARDS + 1;
+    printf("  Reader errors: %d, boards: %zu\n", atomic_load(&reader_errors), count);
+    
+    board_registry_shutdown();
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Readers saw inconsistent data");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Board Registry Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_lookup();
+    test_prefix_routes();
+    test_concurrent_readers();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
 
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
@@ -10,6 +12,7 @@
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
 #include "db.h"
+#include "write_queue.h"
 
 #define TEST_DB_PATH "test_db_wrapper.db"
 
@@ -181,6 +184,122 @@ void test_db_migrate(void) {
     }
 }
 
+void test_db_migrate_timestamps(void) {
+    test_start("DB migrate DATETIME text to Unix milliseconds");
+    
+    cleanup_test_db();
+    
+    int rc = db_init(TEST_DB_PATH);
+    assert(rc == 0);
+    
+    /* Old schema with text timestamps, as written by earlier releases. */
+    rc = db_exec(
+        "CREATE TABLE boards (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL UNIQUE,"
+        " title TEXT NOT NULL, description TEXT, created_at DATETIME DEFAULT CURRENT_TIMESTAMP);"
+        "CREATE TABLE threads (id INTEGER PRIMARY KEY AUTOINCREMENT, board_id INTEGER NOT NULL,"
+        " subject TEXT NOT NULL, created_at DATETIME DEFAULT CURRENT_TIMESTAMP);"
+        "CREATE TABLE admin_sessions (id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL,"
+        " token TEXT NOT NULL UNIQUE, created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        " expires_at DATETIME NOT NULL);"
+        "INSERT INTO boards (name, title, created_at) VALUES ('b', 'Board', '2024-01-02 03:04:05');"
+        "INSERT INTO threads (board_id, subject, created_at) VALUES (1, 'T', '1970-01-01 00:00:01');"
+        "INSERT INTO admin_sessions (user_id, token, created_at, expires_at)"
+        " VALUES (1, 'tok', '2024-01-02 03:04:05', '2024-01-09 03:04:05');"
+    );
+    assert(rc == 0);
+    
+    rc = db_migrate();
+    if (rc != 0) {
+        test_fail("db_migrate failed on legacy schema");
+        db_close();
+        cleanup_test_db();
+        return;
+    }
+    
+    int ok = 1;
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT (SELECT created_at FROM boards WHERE name = 'b'),"
+        " (SELECT created_at FROM threads WHERE id = 1),"
+        " (SELECT expires_at FROM admin_sessions WHERE token = 'tok'),"
+        " (SELECT typeof(created_at) FROM admin_sessions WHERE token = 'tok'),"
+        " (SELECT user_version FROM pragma_user_version)"
+    );
+    assert(stmt != NULL);
+    if (db_step(stmt) == SQLITE_ROW) {
+        printf("  boards.created_at = %lld\n", (long long)sqlite3_column_int64(stmt, 0));
+        ok = sqlite3_column_int64(stmt, 0) == 1704164645000LL &&
+             sqlite3_column_int64(stmt, 1) == 1000 &&
+             sqlite3_column_int64(stmt, 2) == 1704769445000LL &&
+             strcmp((const char *)sqlite3_column_text(stmt, 3), "integer") == 0 &&
+             sqlite3_column_int(stmt, 4) == 2;
+    } else {
+        ok = 0;
+    }
+    db_finalize(stmt);
+    
+    /* Second run is a no-op. */
+    if (ok && db_migrate() != 0) {
+        ok = 0;
+    }
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Timestamps were not converted");
+    }
+}
+
+void test_db_migrate_content_html(void) {
+    test_start("DB migrate backfills posts.content_html");
+    
+    cleanup_test_db();
+    
+    int rc = db_init(TEST_DB_PATH);
+    assert(rc == 0);
+    
+    /* Schema 1 posts table, before content_html existed. */
+    rc = db_exec(
+        "CREATE TABLE posts (id INTEGER PRIMARY KEY AUTOINCREMENT, thread_id INTEGER NOT NULL,"
+        " author TEXT, content TEXT NOT NULL, reply_to INTEGER, created_at INTEGER NOT NULL);"
+        "INSERT INTO posts (thread_id, content, created_at) VALUES (1, 'a<b> & \"c\" ''d''', 0);"
+        "INSERT INTO posts (thread_id, content, created_at) VALUES (1, 'plain', 0);"
+        "PRAGMA user_version=1;"
+    );
+    assert(rc == 0);
+    
+    int ok = db_migrate() == 0;
+    
+    sqlite3_stmt *stmt = db_prepare(
+        "SELECT (SELECT content_html FROM posts WHERE id = 1),"
+        " (SELECT content_html FROM posts WHERE id = 2),"
+        " (SELECT user_version FROM pragma_user_version)"
+    );
+    assert(stmt != NULL);
+    if (ok && db_step(stmt) == SQLITE_ROW) {
+        const char *first = (const char *)sqlite3_column_text(stmt, 0);
+        const char *second = (const char *)sqlite3_column_text(stmt, 1);
+        printf("  content_html = %s\n", first ? first : "(null)");
+        ok = first && strcmp(first, "a&lt;b&gt; &amp; &quot;c&quot; &#39;d&#39;") == 0 &&
+             second && strcmp(second, "plain") == 0 &&
+             sqlite3_column_int(stmt, 2) == 2;
+    } else {
+        ok = 0;
+    }
+    db_finalize(stmt);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("content_html was not filled in");
+    }
+}
+
 void test_db_full_workflow(void) {
     test_start("DB wrapper full workflow");
     
@@ -280,6 +399,242 @@ void test_db_error_handling(void) {
     test_pass();
 }
 
+#define READER_THREADS 4
+
+typedef struct {
+    sqlite3 *conn;
+    int row_count;
+} reader_result_t;
+
+static void *reader_thread(void *arg) {
+    reader_result_t *result = arg;
+    
+    result->conn = db_get_connection();
+    result->row_count = -1;
+    
+    sqlite3_stmt *stmt = db_prepare("SELECT COUNT(*) FROM items;");
+    if (stmt) {
+        if (db_step(stmt) == SQLITE_ROW) {
+            result->row_count = sqlite3_column_int(stmt, 0);
+        }
+        db_finalize(stmt);
+    }
+    return NULL;
+}
+
+void test_db_connection_pool(void) {
+    test_start("DB wrapper per-thread connection pool");
+    
+    cleanup_test_db();
+    
+    int rc = db_init(TEST_DB_PATH);
+    assert(rc == 0);
+    
+    rc = db_exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT);");
+    assert(rc == 0);
+    
+    sqlite3_stmt *stmt = db_prepare("INSERT INTO items (name) VALUES (?);");
+    assert(stmt != NULL);
+    sqlite3 *writer = db_get_connection();
+    sqlite3_bind_text(stmt, 1, "written", -1, SQLITE_STATIC);
+    rc = db_step(stmt);
+    db_finalize(stmt);
+    assert(rc == SQLITE_DONE);
+    
+    sqlite3 *main_reader = db_get_connection();
+    printf("  Writer and main reader are distinct: %s\n", writer != main_reader ? "yes" : "no");
+    
+    pthread_t threads[READER_THREADS];
+    reader_result_t results[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, reader_thread, &results[i]);
+    }
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    int ok = writer != main_reader;
+    for (int i = 0; i < READER_THREADS; i++) {
+        printf("  Reader %d saw %d row(s)\n", i, results[i].row_count);
+        if (results[i].row_count != 1 || results[i].conn == writer ||
+            results[i].conn == main_reader) {
+            ok = 0;
+        }
+        for (int j = 0; j < i; j++) {
+            if (results[i].conn == results[j].conn) {
+                ok = 0;
+            }
+        }
+    }
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Readers did not get their own connections");
+    }
+}
+
+void test_db_last_write_time(void) {
+    test_start("DB wrapper write time ignores lock holders that change nothing");
+    
+    cleanup_test_db();
+    
+    int rc = db_init(TEST_DB_PATH);
+    assert(rc == 0);
+    rc = db_exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT);"
+                 "INSERT INTO items (name) VALUES ('first');");
+    assert(rc == 0);
+    time_t written = db_last_write_time();
+    
+    /* The stamp has second resolution. */
+    sleep(1);
+    
+    /* What the maintenance thread does on an idle database. */
+    db_write_lock();
+    sqlite3_wal_checkpoint_v2(db_get_connection(), NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL);
+    db_write_unlock();
+    db_exec("PRAGMA incremental_vacuum(16);");
+    int unchanged = db_last_write_time() == written;
+    printf("  Unchanged after checkpoint and vacuum: %s\n", unchanged ? "yes" : "no");
+    
+    rc = db_exec("INSERT INTO items (name) VALUES ('second');");
+    int advanced = rc == 0 && db_last_write_time() > written;
+    printf("  Advanced after an insert: %s\n", advanced ? "yes" : "no");
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (written > 0 && unchanged && advanced) {
+        test_pass();
+    } else {
+        test_fail("Write time did not follow row changes");
+    }
+}
+
+static long long reader_pragma(const char *sql) {
+    sqlite3_stmt *stmt = NULL;
+    long long value = -12345;
+    
+    /* Outside the write lock this is the calling thread's reader. */
+    if (sqlite3_prepare_v2(db_get_connection(), sql, -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+void test_db_storage_profile(void) {
+    test_start("DB wrapper storage profiles");
+    
+    int ok = db_set_profile("no-such-profile") == -1 &&
+             strcmp(db_get_profile()->name, "safe") == 0;
+    printf("  Unknown profile refused: %s\n", ok ? "yes" : "no");
+    
+    const char *names[] = { "read-heavy", "safe" };
+    for (int i = 0; i < 2; i++) {
+        cleanup_test_db();
+        ok = ok && db_set_profile(names[i]) == 0;
+        int rc = db_init(TEST_DB_PATH);
+        assert(rc == 0);
+        
+        const db_profile_t *profile = db_get_profile();
+        long long cache_size = reader_pragma("PRAGMA cache_size;");
+        long long mmap_size = reader_pragma("PRAGMA mmap_size;");
+        long long temp_store = reader_pragma("PRAGMA temp_store;");
+        printf("  %s reader: cache_size=%lld mmap_size=%lld temp_store=%lld\n",
+               names[i], cache_size, mmap_size, temp_store);
+        
+        ok = ok && strcmp(profile->name, names[i]) == 0 &&
+             cache_size == profile->cache_size &&
+             temp_store == (profile->temp_store_memory ? 2 : 0) &&
+             (profile->mmap_size == 0 ? mmap_size == 0 : mmap_size >= 64LL * 1024 * 1024);
+        
+        db_close();
+        cleanup_test_db();
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Reader settings do not match the profile");
+    }
+}
+
+#define WRITER_THREADS 8
+#define POSTS_PER_WRITER 10
+
+static void *post_writer_thread(void *arg) {
+    int64_t thread_id = *(int64_t *)arg;
+    
+    for (int i = 0; i < POSTS_PER_WRITER; i++) {
+        int64_t post_id = 0;
+        if (write_queue_create_post(thread_id, 0, "writer", "burst reply", NULL, NULL, &post_id) != 0 ||
+            post_id <= 0) {
+            return (void *)1;
+        }
+    }
+    return NULL;
+}
+
+void test_write_queue(void) {
+    test_start("Write queue group commit");
+    
+    cleanup_test_db();
+    
+    int rc = db_init(TEST_DB_PATH);
+    assert(rc == 0);
+    rc = db_migrate();
+    assert(rc == 0);
+    rc = db_exec("INSERT INTO boards (name, title) VALUES ('b', 'Board');");
+    assert(rc == 0);
+    
+    int64_t thread_id = 0, op_id = 0;
+    rc = write_queue_create_thread(1, "Subject", "op", "opening post", NULL, NULL, &thread_id, &op_id);
+    printf("  Inline commit: thread %lld, post %lld\n", (long long)thread_id, (long long)op_id);
+    
+    int ok = rc == 0 && thread_id > 0 && op_id > 0;
+    
+    rc = write_queue_start();
+    assert(rc == 0);
+    
+    pthread_t threads[WRITER_THREADS];
+    for (int i = 0; i < WRITER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, post_writer_thread, &thread_id);
+    }
+    for (int i = 0; i < WRITER_THREADS; i++) {
+        void *result = NULL;
+        pthread_join(threads[i], &result);
+        if (result) {
+            ok = 0;
+        }
+    }
+    
+    write_queue_stop();
+    
+    int post_count = 0;
+    sqlite3_stmt *stmt = db_prepare("SELECT COUNT(DISTINCT id) FROM posts WHERE thread_id = ?;");
+    assert(stmt != NULL);
+    sqlite3_bind_int64(stmt, 1, thread_id);
+    if (db_step(stmt) == SQLITE_ROW) {
+        post_count = sqlite3_column_int(stmt, 0);
+    }
+    db_finalize(stmt);
+    printf("  Posts committed: %d\n", post_count);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok && post_count == 1 + WRITER_THREADS * POSTS_PER_WRITER) {
+        test_pass();
+    } else {
+        test_fail("Queued inserts were lost or failed");
+    }
+}
+
 int main(void) {
     printf("\n");
     printf("======================================\n");
@@ -290,8 +645,14 @@ int main(void) {
     test_db_exec();
     test_db_prepare_step();
     test_db_migrate();
+    test_db_migrate_timestamps();
+    test_db_migrate_content_html();
     test_db_full_workflow();
     test_db_error_handling();
+    test_db_connection_pool();
+    test_db_last_write_time();
+    test_db_storage_profile();
+    test_write_queue();
     
     printf("======================================\n");
     printf("  Test Summary\n");
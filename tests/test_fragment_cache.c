@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "fragment_cache.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+void test_get_and_put(void) {
+    test_start("Fragments keyed by post and language");
+    
+    assert(fragment_cache_init(FRAGMENT_CACHE_DEFAULT_BYTES) == 0);
+    
+    char buf[256];
+    int ok = fragment_cache_get(1, LANG_EN, buf, sizeof(buf)) == -1;
+    
+    fragment_cache_put(1, 0, LANG_EN, "<p>reply</p>", 12);
+    fragment_cache_put(1, 0, LANG_ZH_CN, "<p>回复</p>", strlen("<p>回复</p>"));
+    
+    ok = ok && fragment_cache_get(1, LANG_EN, buf, sizeof(buf)) == 12 &&
+         strcmp(buf, "<p>reply</p>") == 0;
+    ok = ok && fragment_cache_get(1, LANG_ZH_CN, buf, sizeof(buf)) > 0 &&
+         strcmp(buf, "<p>回复</p>") == 0;
+    
+    /* A destination that is too small is a miss, not a truncated copy. */
+    ok = ok && fragment_cache_get(1, LANG_EN, buf, 12) == -1;
+    
+    /* Putting the same key again replaces the fragment. */
+    fragment_cache_put(1, 0, LANG_EN, "<p>new</p>", 10);
+    ok = ok && fragment_cache_get(1, LANG_EN, buf, sizeof(buf)) == 10 &&
+         strcmp(buf, "<p>new</p>") == 0;
+    
+    fragment_cache_stats_t stats;
+    fragment_cache_get_stats(&stats);
+    ok = ok && stats.entries == 2 && stats.hits == 3 && stats.misses == 2;
+    printf("  Entries: %lld, hits: %lld, misses: %lld\n",
+           (long long)stats.entries, (long long)stats.hits, (long long)stats.misses);
+    
+    fragment_cache_shutdown();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected cache contents");
+    }
+}
+
+void test_eviction(void) {
+    test_start("Byte budget evicts least recently used");
+    
+    /* 16 shards of 64 KB; each fragment is about 2 KB. */
+    assert(fragment_cache_init(1024 * 1024) == 0);
+    
+    char fragment[2000];
+    memset(fragment, 'x', sizeof(fragment));
+    char buf[4096];
+    
+    for (int64_t id = 1; id <= 2000; id++) {
+        fragment_cache_put(id, 0, LANG_EN, fragment, sizeof(fragment));
+        /* Keep post 1 hot. */
+        fragment_cache_get(1, LANG_EN, buf, sizeof(buf));
+    }
+    
+    fragment_cache_stats_t stats;
+    fragment_cache_get_stats(&stats);
+    int ok = stats.bytes <= 1024 * 1024 && stats.evictions > 0 &&
+             stats.entries + stats.evictions == 2000;
+    ok = ok && fragment_cache_get(1, LANG_EN, buf, sizeof(buf)) == (int)sizeof(fragment);
+    ok = ok && fragment_cache_get(2000, LANG_EN, buf, sizeof(buf)) == (int)sizeof(fragment);
+    printf("  Entries: %lld, evictions: %lld, bytes: %lld\n",
+           (long long)stats.entries, (long long)stats.evictions, (long long)stats.bytes);
+    
+    fragment_cache_shutdown();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Budget not respected");
+    }
+}
+
+void test_invalidate(void) {
+    test_start("Invalidation drops quoting fragments");
+    
+    assert(fragment_cache_init(FRAGMENT_CACHE_DEFAULT_BYTES) == 0);
+    
+    fragment_cache_put(10, 0, LANG_EN, "a", 1);
+    fragment_cache_put(10, 0, LANG_ZH_CN, "a", 1);
+    fragment_cache_put(11, 10, LANG_EN, "b", 1);
+    fragment_cache_put(12, 0, LANG_EN, "c", 1);
+    
+    fragment_cache_invalidate(10);
+    
+    char buf[16];
+    int ok = fragment_cache_get(10, LANG_EN, buf, sizeof(buf)) == -1 &&
+             fragment_cache_get(10, LANG_ZH_CN, buf, sizeof(buf)) == -1 &&
+             fragment_cache_get(11, LANG_EN, buf, sizeof(buf)) == -1 &&
+             fragment_cache_get(12, LANG_EN, buf, sizeof(buf)) == 1;
+    
+    fragment_cache_shutdown();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Stale fragment survived invalidation");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Fragment Cache Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_get_and_put();
+    test_eviction();
+    test_invalidate();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
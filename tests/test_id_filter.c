@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "db.h"
+#include "id_filter.h"
+#include "write_queue.h"
+
+#define TEST_DB_PATH "test_id_filter.db"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void cleanup_test_db(void) {
+    unlink(TEST_DB_PATH);
+}
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+void setup_db(void) {
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec(
+        "INSERT INTO boards (name, title) VALUES ('tech', 'Technology');"
+        "INSERT INTO threads (id, board_id, subject) VALUES (1, 1, 'First');"
+        "INSERT INTO threads (id, board_id, subject) VALUES (70000, 1, 'Far away');"
+        "INSERT INTO posts (id, thread_id, content) VALUES (5, 1, 'Hello');"
+    ) == 0);
+}
+
+void teardown_db(void) {
+    id_filter_shutdown();
+    write_queue_stop();
+    db_close();
+    cleanup_test_db();
+}
+
+void test_loaded_ids(void) {
+    test_start("Ids loaded at startup");
+    
+    setup_db();
+    int ok = id_filter_init() == 0;
+    
+    ok = ok && id_filter_may_exist(ID_FILTER_THREADS, 1) &&
+         id_filter_may_exist(ID_FILTER_THREADS, 70000) &&
+         id_filter_may_exist(ID_FILTER_POSTS, 5);
+    ok = ok && !id_filter_may_exist(ID_FILTER_THREADS, 2) &&
+         !id_filter_may_exist(ID_FILTER_THREADS, 69999) &&
+         !id_filter_may_exist(ID_FILTER_THREADS, 5000000) &&
+         !id_filter_may_exist(ID_FILTER_POSTS, 1) &&
+         !id_filter_may_exist(ID_FILTER_THREADS, 0) &&
+         !id_filter_may_exist(ID_FILTER_THREADS, -3);
+    
+    teardown_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected filter answer");
+    }
+}
+
+void test_inserts_update_filter(void) {
+    test_start("Committed inserts are added");
+    
+    setup_db();
+    assert(id_filter_init() == 0);
+    
+    int64_t thread_id = 0;
+    int64_t post_id = 0;
+    int64_t reply_id = 0;
+    int ok = write_queue_create_thread(1, "New", "Anon", "Body", NULL, NULL, &thread_id, &post_id) == 0 &&
+             write_queue_create_post(thread_id, 0, "Anon", "Reply", NULL, NULL, &reply_id) == 0;
+    
+    ok = ok && id_filter_may_exist(ID_FILTER_THREADS, thread_id) &&
+         id_filter_may_exist(ID_FILTER_POSTS, post_id) &&
+         id_filter_may_exist(ID_FILTER_POSTS, reply_id) &&
+         !id_filter_may_exist(ID_FILTER_THREADS, thread_id + 1);
+    printf("  Thread %lld, posts %lld and %lld\n",
+           (long long)thread_id, (long long)post_id, (long long)reply_id);
+    
+    teardown_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Inserted ids not visible");
+    }
+}
+
+void test_negative_cache(void) {
+    test_start("Negative cache for deleted ids");
+    
+    setup_db();
+    assert(id_filter_init() == 0);
+    assert(db_exec("DELETE FROM threads WHERE id = 70000") == 0);
+    
+    /* The bit stays set after a delete until a lookup records the miss. */
+    int ok = id_filter_may_exist(ID_FILTER_THREADS, 70000);
+    id_filter_record_miss(ID_FILTER_THREADS, 70000);
+    ok = ok && !id_filter_may_exist(ID_FILTER_THREADS, 70000) &&
+         id_filter_may_exist(ID_FILTER_THREADS, 1);
+    
+    /* Misses are per kind. */
+    id_filter_record_miss(ID_FILTER_POSTS, 1);
+    ok = ok && id_filter_may_exist(ID_FILTER_THREADS, 1);
+    
+    /* An insert clears a recorded miss for the same id. */
+    id_filter_add(ID_FILTER_THREADS, 70000);
+    ok = ok && id_filter_may_exist(ID_FILTER_THREADS, 70000);
+    
+    teardown_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Negative cache gave the wrong answer");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Id Filter Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_loaded_ids();
+    test_inserts_update_filter();
+    test_negative_cache();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
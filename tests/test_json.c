@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "json.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static int expect(const render_buf_t *buf, const char *expected) {
+    if (strcmp(buf->data, expected) != 0) {
+        printf("  Got: [%s]\n  Expected: [%s]\n", buf->data, expected);
+        return 0;
+    }
+    return 1;
+}
+
+void test_nesting_and_commas(void) {
+    test_start("Nested objects and arrays");
+    
+    render_buf_t buf;
+    json_writer_t json;
+    render_buf_init(&buf, 16);
+    json_writer_init(&json, &buf);
+    
+    int rc = json_begin_object(&json);
+    rc |= json_field_int(&json, "id", 7);
+    rc |= json_key(&json, "posts");
+    rc |= json_begin_array(&json);
+    for (int i = 1; i <= 3; i++) {
+        rc |= json_begin_object(&json);
+        rc |= json_field_int(&json, "id", i);
+        rc |= json_key(&json, "tags");
+        rc |= json_begin_array(&json);
+        rc |= json_end_array(&json);
+        rc |= json_end_object(&json);
+    }
+    rc |= json_end_array(&json);
+    rc |= json_key(&json, "empty");
+    rc |= json_begin_object(&json);
+    rc |= json_end_object(&json);
+    rc |= json_key(&json, "flags");
+    rc |= json_begin_array(&json);
+    rc |= json_bool(&json, 1);
+    rc |= json_bool(&json, 0);
+    rc |= json_null(&json);
+    rc |= json_end_array(&json);
+    rc |= json_end_object(&json);
+    
+    int ok = rc == 0 && json.depth == 0 &&
+        expect(&buf, "{\"id\":7,\"posts\":[{\"id\":1,\"tags\":[]},{\"id\":2,\"tags\":[]},"
+                     "{\"id\":3,\"tags\":[]}],\"empty\":{},\"flags\":[true,false,null]}");
+    render_buf_free(&buf);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected JSON");
+    }
+}
+
+void test_values(void) {
+    test_start("Strings and integers");
+    
+    render_buf_t buf;
+    json_writer_t json;
+    render_buf_init(&buf, 16);
+    json_writer_init(&json, &buf);
+    
+    int rc = json_begin_array(&json);
+    rc |= json_string(&json, "a \"quote\" \\ and\nnewline\x1f");
+    rc |= json_string(&json, "\xe4\xb8\xad\xe6\x96\x87");
+    rc |= json_string(&json, NULL);
+    rc |= json_int(&json, INT64_MAX);
+    rc |= json_int(&json, INT64_MIN);
+    rc |= json_int(&json, 0);
+    rc |= json_end_array(&json);
+    
+    int ok = rc == 0 &&
+        expect(&buf, "[\"a \\\"quote\\\" \\\\ and\\nnewline\\u001f\",\"\xe4\xb8\xad\xe6\x96\x87\",null,"
+                     "9223372036854775807,-9223372036854775808,0]");
+    
+    /* Long strings run through the vector loops of the escape kernel. */
+    char long_str[1000];
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    long_str[500] = '"';
+    render_buf_reset(&buf);
+    json_writer_init(&json, &buf);
+    ok = ok && json_string(&json, long_str) == 0 && buf.len == sizeof(long_str) + 2 &&
+        memcmp(buf.data + 500, "x\\\"", 3) == 0;
+    
+    render_buf_free(&buf);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected JSON");
+    }
+}
+
+void test_depth_limit(void) {
+    test_start("Nesting depth is limited");
+    
+    render_buf_t buf;
+    json_writer_t json;
+    render_buf_init(&buf, 16);
+    json_writer_init(&json, &buf);
+    
+    int rc = 0;
+    for (int i = 0; i < JSON_MAX_DEPTH - 1; i++) {
+        rc |= json_begin_array(&json);
+    }
+    int ok = rc == 0 && json_begin_array(&json) != 0;
+    
+    render_buf_reset(&buf);
+    json_writer_init(&json, &buf);
+    ok = ok && json_end_object(&json) != 0;
+    
+    render_buf_free(&buf);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Depth errors were not reported");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  JSON Writer Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_nesting_and_commas();
+    test_values();
+    test_depth_limit();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "live.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Reads from fd until expected has arrived or a second passes. */
+static int receives(int fd, const char *expected) {
+    char buf[4096];
+    size_t len = 0;
+    size_t want = strlen(expected);
+    while (len < want) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 1000) <= 0) {
+            break;
+        }
+        ssize_t n = read(fd, buf + len, sizeof(buf) - 1 - len);
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+    }
+    buf[len] = '\0';
+    if (strcmp(buf, expected) != 0) {
+        printf("  Got: [%s]\n  Expected: [%s]\n", buf, expected);
+        return 0;
+    }
+    return 1;
+}
+
+/* Waits up to a second for the loop to settle on count subscribers. */
+static int settles_at(int count) {
+    for (int i = 0; i < 100; i++) {
+        if (live_subscriber_count() == count) {
+            return 1;
+        }
+        sleep_ms(10);
+    }
+    printf("  Subscribers: %d, expected %d\n", live_subscriber_count(), count);
+    return 0;
+}
+
+void test_subscribe_and_publish(void) {
+    test_start("Subscribers receive events for their thread and language");
+    
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        test_fail("socketpair failed");
+        return;
+    }
+    
+    int ok = live_subscribe(sv[0], 7, LANG_EN) == 0 &&
+             receives(sv[1], "retry: 5000\n\n") &&
+             live_has_subscribers(7, LANG_EN) &&
+             !live_has_subscribers(7, LANG_ZH_CN) &&
+             !live_has_subscribers(8, LANG_EN);
+    
+    live_publish(8, LANG_EN, "post", 1, "other thread", 12);
+    live_publish(7, LANG_ZH_CN, "post", 2, "other language", 14);
+    live_publish(7, LANG_EN, "post", 3, "<p>a</p>\n<p>b</p>", 17);
+    ok = ok && receives(sv[1], "event: post\nid: 3\ndata: <p>a</p>\ndata: <p>b</p>\n\n");
+    
+    close(sv[1]);
+    ok = ok && settles_at(0) && !live_has_subscribers(7, LANG_EN);
+    
+    ok ? test_pass() : test_fail("event stream differs");
+}
+
+void test_slow_reader_dropped(void) {
+    test_start("A reader that stops reading is dropped");
+    
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        test_fail("socketpair failed");
+        return;
+    }
+    
+    int ok = live_subscribe(sv[0], 9, LANG_EN) == 0 && settles_at(1);
+    
+    char *chunk = malloc(64 * 1024);
+    memset(chunk, 'x', 64 * 1024);
+    for (int i = 0; i < 64 && live_subscriber_count() > 0; i++) {
+        live_publish(9, LANG_EN, "post", i, chunk, 64 * 1024);
+        sleep_ms(5);
+    }
+    free(chunk);
+    
+    ok = ok && settles_at(0);
+    close(sv[1]);
+    
+    ok ? test_pass() : test_fail("slow reader was kept");
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Live Updates Test Suite\n");
+    printf("======================================\n\n");
+    
+    if (live_start() != 0) {
+        printf(ANSI_COLOR_RED "Failed to start live updates" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+    
+    test_subscribe_and_publish();
+    test_slow_reader_dropped();
+    
+    live_stop();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
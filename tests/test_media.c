@@ -0,0 +1,223 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "media.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static size_t make_png(unsigned char *buf, unsigned width, unsigned height) {
+    static const unsigned char head[16] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 0, 0, 0, 13, 'I', 'H', 'D', 'R'
+    };
+    memcpy(buf, head, sizeof(head));
+    unsigned char *p = buf + 16;
+    p[0] = width >> 24; p[1] = width >> 16; p[2] = width >> 8; p[3] = width;
+    p[4] = height >> 24; p[5] = height >> 16; p[6] = height >> 8; p[7] = height;
+    memset(buf + 24, 0, 9);
+    return 33;
+}
+
+/* A JPEG with a long APP1 (EXIF) segment ahead of the frame header. */
+static size_t make_jpeg(unsigned char *buf, unsigned char sof, unsigned width, unsigned height) {
+    size_t n = 0;
+    buf[n++] = 0xFF; buf[n++] = 0xD8;
+    buf[n++] = 0xFF; buf[n++] = 0xE1;
+    buf[n++] = 5000 >> 8; buf[n++] = 5000 & 0xff;
+    memset(buf + n, 0xFF, 4998);            /* marker-like bytes must be skipped */
+    n += 4998;
+    buf[n++] = 0xFF; buf[n++] = 0xFF;       /* fill bytes */
+    buf[n++] = 0xFF; buf[n++] = sof;
+    buf[n++] = 0; buf[n++] = 17;
+    buf[n++] = 8;
+    buf[n++] = height >> 8; buf[n++] = height & 0xff;
+    buf[n++] = width >> 8; buf[n++] = width & 0xff;
+    memset(buf + n, 0, 10);
+    n += 10;
+    buf[n++] = 0xFF; buf[n++] = 0xD9;
+    return n;
+}
+
+static int probe_is(const unsigned char *data, size_t len, const char *type, int width, int height) {
+    media_info_t info;
+    if (media_probe_buffer(data, len, &info) != 0) {
+        printf("  expected %s %dx%d, got no match\n", type, width, height);
+        return 0;
+    }
+    if (strcmp(info.content_type, type) != 0 || info.width != width || info.height != height) {
+        printf("  expected %s %dx%d, got %s %dx%d\n", type, width, height,
+               info.content_type, info.width, info.height);
+        return 0;
+    }
+    return 1;
+}
+
+/* Test 1: Each format's size field */
+void test_formats(void) {
+    test_start("Image Formats");
+    
+    unsigned char buf[6000];
+    int ok = 1;
+    
+    size_t len = make_png(buf, 640, 480);
+    ok = ok && probe_is(buf, len, "image/png", 640, 480);
+    
+    memcpy(buf, "GIF89a\x0a\x00\x14\x00\x00\x00\x00", 13);
+    ok = ok && probe_is(buf, 13, "image/gif", 10, 20);
+    
+    len = make_jpeg(buf, 0xC0, 1920, 1080);
+    ok = ok && probe_is(buf, len, "image/jpeg", 1920, 1080);
+    len = make_jpeg(buf, 0xC2, 300, 200);     /* progressive */
+    ok = ok && probe_is(buf, len, "image/jpeg", 300, 200);
+    
+    /* Lossy WebP: 14-bit sizes after the VP8 start code. */
+    memset(buf, 0, 40);
+    memcpy(buf, "RIFF\0\0\0\0WEBPVP8 ", 16);
+    memcpy(buf + 23, "\x9d\x01\x2a", 3);
+    buf[26] = 800 & 0xff; buf[27] = 800 >> 8;
+    buf[28] = 600 & 0xff; buf[29] = 600 >> 8;
+    ok = ok && probe_is(buf, 40, "image/webp", 800, 600);
+    
+    /* Lossless WebP: width-1 and height-1 packed in 14-bit fields. */
+    memset(buf, 0, 40);
+    memcpy(buf, "RIFF\0\0\0\0WEBPVP8L", 16);
+    buf[20] = 0x2f;
+    unsigned bits = (100 - 1) | (50 - 1) << 14;
+    buf[21] = bits; buf[22] = bits >> 8; buf[23] = bits >> 16; buf[24] = bits >> 24;
+    ok = ok && probe_is(buf, 40, "image/webp", 100, 50);
+    
+    /* Extended WebP: 24-bit canvas size minus one. */
+    memset(buf, 0, 40);
+    memcpy(buf, "RIFF\0\0\0\0WEBPVP8X", 16);
+    buf[24] = (4000 - 1) & 0xff; buf[25] = (4000 - 1) >> 8;
+    buf[27] = (3000 - 1) & 0xff; buf[28] = (3000 - 1) >> 8;
+    ok = ok && probe_is(buf, 40, "image/webp", 4000, 3000);
+    
+    if (!ok) {
+        test_fail("Wrong type or size");
+        return;
+    }
+    test_pass();
+}
+
+/* Test 2: Things that are not images, or not plausible ones */
+void test_rejects(void) {
+    test_start("Rejected Inputs");
+    
+    unsigned char buf[6000];
+    media_info_t info;
+    int rejected = 0;
+    int cases = 0;
+    
+    size_t len = make_png(buf, 640, 480);
+    cases++; rejected += media_probe_buffer(buf, 20, &info) != 0;           /* truncated */
+    len = make_png(buf, 0, 480);
+    cases++; rejected += media_probe_buffer(buf, len, &info) != 0;          /* zero width */
+    len = make_png(buf, 100000, 10);
+    cases++; rejected += media_probe_buffer(buf, len, &info) != 0;          /* too wide */
+    
+    const char *text = "just some text, not an image at all";
+    cases++; rejected += media_probe_buffer((const unsigned char *)text, strlen(text), &info) != 0;
+    cases++; rejected += media_probe_buffer(buf, 0, &info) != 0;
+    
+    /* Scan data before any frame header. */
+    memcpy(buf, "\xFF\xD8\xFF\xDA\x00\x02\xFF\xD9", 8);
+    cases++; rejected += media_probe_buffer(buf, 8, &info) != 0;
+    
+    /* A segment length that runs past the end of the file. */
+    len = make_jpeg(buf, 0xC0, 10, 10);
+    cases++; rejected += media_probe_buffer(buf, 100, &info) != 0;
+    
+    /* DHT (C4) sits in the SOF range but holds no size. */
+    memcpy(buf, "\xFF\xD8\xFF\xC4\x00\x07\x00\x10\x00\x20\x00\xFF\xD9", 13);
+    cases++; rejected += media_probe_buffer(buf, 13, &info) != 0;
+    
+    if (rejected != cases) {
+        printf("  %d of %d rejected\n", rejected, cases);
+        test_fail("Accepted a bad input");
+        return;
+    }
+    test_pass();
+}
+
+/* Test 3: Probing a file reads it through the descriptor */
+void test_probe_file(void) {
+    test_start("Probe File");
+    
+    unsigned char buf[6000];
+    size_t len = make_jpeg(buf, 0xC1, 1024, 768);
+    
+    FILE *f = tmpfile();
+    if (!f || fwrite(buf, 1, len, f) != len || fflush(f) != 0) {
+        test_fail("Failed to write temporary file");
+        if (f) {
+            fclose(f);
+        }
+        return;
+    }
+    
+    media_info_t info;
+    int ok = media_probe(fileno(f), &info) == 0 &&
+             strcmp(info.content_type, "image/jpeg") == 0 &&
+             strcmp(info.extension, "jpg") == 0 &&
+             info.width == 1024 && info.height == 768;
+    fclose(f);
+    
+    if (!ok) {
+        test_fail("Wrong result from file");
+        return;
+    }
+    test_pass();
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Media Probe Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_formats();
+    test_rejects();
+    test_probe_file();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include "../src/http.h"
 #include "../src/router.h"
 #include "../src/db.h"
@@ -96,6 +98,130 @@ void test_http_response_empty_body(void) {
     test_pass();
 }
 
+static int stream_freed = 0;
+
+static int test_stream(http_writer_t *writer, void *ctx) {
+    return http_writer_write(writer, ctx, strlen(ctx));
+}
+
+static void test_stream_free(void *ctx) {
+    (void)ctx;
+    stream_freed++;
+}
+
+void test_http_response_stream(void) {
+    test_start("HTTP streaming response");
+    
+    char body[] = "chunk";
+    stream_freed = 0;
+    http_response_t *response = http_response_create_stream(200, "text/html", test_stream,
+                                                            body, test_stream_free);
+    if (response == NULL) {
+        test_fail("http_response_create_stream failed");
+        return;
+    }
+    
+    if (response->stream != test_stream || response->stream_ctx != body ||
+        response->body != NULL || response->body_len != 0) {
+        http_response_free(response);
+        test_fail("stream fields not set");
+        return;
+    }
+    
+    http_response_free(response);
+    if (stream_freed != 1) {
+        test_fail("stream context not released exactly once");
+        return;
+    }
+    printf("  Stream context released on free\n");
+    
+    test_pass();
+}
+
+static int test_stream_parts(http_writer_t *writer, void *ctx) {
+    (void)ctx;
+    if (http_writer_write(writer, "hello", 5) != 0 ||
+        http_writer_write(writer, "", 0) != 0 ||
+        http_writer_write(writer, "seventeen bytes!!", 17) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Sends a streamed response over a socketpair and returns what arrived
+ * after the headers, or NULL. has_te reports a Transfer-Encoding header. */
+static char *wire_body(int chunked, int *has_te) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        return NULL;
+    }
+    
+    http_response_t *response = http_response_create_stream(200, "text/plain", test_stream_parts,
+                                                            NULL, NULL);
+    if (response == NULL) {
+        close(pair[0]);
+        close(pair[1]);
+        return NULL;
+    }
+    http_response_send(pair[0], response, chunked, 0);
+    http_response_free(response);
+    close(pair[0]);
+    
+    static char wire[4096];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(wire) - 1 && (n = read(pair[1], wire + len, sizeof(wire) - 1 - len)) > 0) {
+        len += (size_t)n;
+    }
+    close(pair[1]);
+    wire[len] = '\0';
+    
+    char *body = strstr(wire, "\r\n\r\n");
+    if (body == NULL) {
+        return NULL;
+    }
+    *body = '\0';
+    *has_te = strstr(wire, "Transfer-Encoding: chunked\r\n") != NULL;
+    return body + 4;
+}
+
+void test_http_stream_wire(void) {
+    test_start("HTTP streamed response on the wire");
+    
+    int has_te = 0;
+    char *body = wire_body(1, &has_te);
+    if (body == NULL) {
+        test_fail("no response headers on the wire");
+        return;
+    }
+    if (!has_te) {
+        test_fail("chunked response without Transfer-Encoding");
+        return;
+    }
+    if (strcmp(body, "5\r\nhello\r\n11\r\nseventeen bytes!!\r\n0\r\n\r\n") != 0) {
+        test_fail("chunk framing differs");
+        return;
+    }
+    printf("  HTTP/1.1: hex size lines, empty write skipped, terminating chunk\n");
+    
+    body = wire_body(0, &has_te);
+    if (body == NULL) {
+        test_fail("no HTTP/1.0 response headers on the wire");
+        return;
+    }
+    if (has_te) {
+        test_fail("HTTP/1.0 response announced chunked encoding");
+        return;
+    }
+    if (strcmp(body, "helloseventeen bytes!!") != 0) {
+        test_fail("HTTP/1.0 body not sent raw");
+        return;
+    }
+    printf("  HTTP/1.0: raw body ending at close\n");
+    
+    test_pass();
+}
+
 http_response_t *test_route_handler(http_request_t *req) {
     (void)req;
     const char *body = "Test response";
@@ -177,6 +303,57 @@ void test_router_not_found(void) {
     test_pass();
 }
 
+static int test_auth_check(http_request_t *req) {
+    return req->cookies != NULL && strcmp(req->cookies, "session=ok") == 0;
+}
+
+/* Status router_admit() gives req, or 0 when it lets the request through. */
+static int admit_status(http_request_t *req) {
+    http_response_t *response = router_admit(router_match(req), req);
+    int status = response ? response->status_code : 0;
+    http_response_free(response);
+    return status;
+}
+
+void test_router_admission(void) {
+    test_start("Router admission before the body is read");
+    
+    router_init();
+    router_add_route("POST", "/form", test_route_handler);
+    router_add_limited_route("POST", "/upload", test_route_handler, 1000000, ROUTE_AUTH);
+    
+    http_request_t req = { .method = "POST", .path = "/form", .content_length = ROUTER_MAX_BODY };
+    int ok = admit_status(&req) == 0;
+    req.content_length = ROUTER_MAX_BODY + 1;
+    ok = ok && admit_status(&req) == 413;
+    printf("  Default body limit: %s\n", ok ? "OK" : "FAILED");
+    
+    /* Without a check, authenticated routes are closed to everyone. */
+    req.path = "/upload";
+    req.content_length = 10;
+    req.cookies = "session=ok";
+    ok = ok && admit_status(&req) == 401;
+    
+    router_set_auth_check(test_auth_check);
+    ok = ok && admit_status(&req) == 0;
+    req.content_length = 1000001;
+    ok = ok && admit_status(&req) == 413;
+    req.cookies = NULL;
+    ok = ok && admit_status(&req) == 401;
+    printf("  Route limit and authentication: %s\n", ok ? "OK" : "FAILED");
+    
+    req.path = "/missing";
+    ok = ok && router_match(&req) == NULL && admit_status(&req) == 0;
+    
+    router_cleanup();
+    
+    if (!ok) {
+        test_fail("wrong admission decision");
+        return;
+    }
+    test_pass();
+}
+
 void test_render_module(void) {
     test_start("Render module basic functionality");
     
@@ -479,8 +656,11 @@ int main(void) {
     
     test_http_module();
     test_http_response_empty_body();
+    test_http_response_stream();
+    test_http_stream_wire();
     test_router_module();
     test_router_not_found();
+    test_router_admission();
     test_render_module();
     test_render_escape_html();
     test_render_null_input();
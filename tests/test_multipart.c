@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "multipart.h"
+
+#define CONTENT_TYPE "multipart/form-data; boundary=----WebKitFormBoundaryX3"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+/* Records every callback as text, with part data copied verbatim. */
+typedef struct {
+    char log[300000];
+    size_t len;
+} recorder_t;
+
+static void record(recorder_t *r, const char *data, size_t len) {
+    if (r->len + len < sizeof(r->log)) {
+        memcpy(r->log + r->len, data, len);
+        r->len += len;
+    }
+}
+
+static int on_begin(void *ctx, const multipart_part_t *part) {
+    char line[600];
+    int n = snprintf(line, sizeof(line), "[begin %s|%s|%s]", part->name, part->filename,
+                     part->content_type);
+    record(ctx, line, (size_t)n);
+    return 0;
+}
+
+static int on_data(void *ctx, const char *data, size_t len) {
+    record(ctx, data, len);
+    return 0;
+}
+
+static int on_end(void *ctx) {
+    record(ctx, "[end]", 5);
+    return 0;
+}
+
+static const multipart_callbacks_t recorder_callbacks = { on_begin, on_data, on_end };
+
+/* Parses body fed in pieces of step bytes. Returns 0 when it parsed
+ * completely. */
+static int parse_in_steps(const char *body, size_t len, size_t step, recorder_t *r) {
+    static multipart_parser_t parser;
+    r->len = 0;
+    if (multipart_parser_init(&parser, CONTENT_TYPE, &recorder_callbacks, r) != 0) {
+        return -1;
+    }
+    for (size_t pos = 0; pos < len; pos += step) {
+        size_t n = len - pos < step ? len - pos : step;
+        if (multipart_parser_feed(&parser, body + pos, n) != 0) {
+            return -1;
+        }
+    }
+    return multipart_parser_finish(&parser);
+}
+
+static char body[250000];
+static char file_bytes[200000];
+static char expected[300000];
+
+void test_parse_any_split(void) {
+    test_start("Parts are identical however the body is split");
+    
+    /* File contents full of near-misses: CRLFs, dashes and a boundary
+     * prefix that is cut short. */
+    srand(7);
+    for (size_t i = 0; i < sizeof(file_bytes); i++) {
+        file_bytes[i] = (char)(rand() % 256);
+        if (i % 997 == 0 && i + 30 < sizeof(file_bytes)) {
+            memcpy(file_bytes + i, "\r\n------WebKitFormBoundaryX", 27);
+            file_bytes[i + 27] = '4';
+            i += 27;
+        }
+    }
+    
+    size_t len = (size_t)snprintf(body, sizeof(body),
+        "preamble is ignored\r\n"
+        "------WebKitFormBoundaryX3\r\n"
+        "Content-Disposition: form-data; name=\"subject\"\r\n"
+        "\r\n"
+        "Hello, world\r\n"
+        "------WebKitFormBoundaryX3\r\n"
+        "content-disposition: form-data; name=\"file\"; filename=\"cat photo.jpg\"\r\n"
+        "Content-Type: image/jpeg\r\n"
+        "\r\n");
+    memcpy(body + len, file_bytes, sizeof(file_bytes));
+    len += sizeof(file_bytes);
+    len += (size_t)snprintf(body + len, sizeof(body) - len,
+        "\r\n------WebKitFormBoundaryX3--\r\nepilogue");
+    
+    size_t expected_len = (size_t)snprintf(expected, sizeof(expected),
+        "[begin subject||]Hello, world[end][begin file|cat photo.jpg|image/jpeg]");
+    memcpy(expected + expected_len, file_bytes, sizeof(file_bytes));
+    expected_len += sizeof(file_bytes);
+    memcpy(expected + expected_len, "[end]", 5);
+    expected_len += 5;
+    
+    static recorder_t r;
+    const size_t steps[] = { 1, 2, 3, 7, 29, 64, 4096, 65536, 100000, sizeof(body) };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]) && ok; i++) {
+        ok = parse_in_steps(body, len, steps[i], &r) == 0 && r.len == expected_len &&
+             memcmp(r.log, expected, expected_len) == 0;
+        if (!ok) {
+            printf("  Mismatch when fed %zu bytes at a time\n", steps[i]);
+        }
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Parsed parts differ");
+    }
+}
+
+void test_malformed(void) {
+    test_start("Malformed bodies are rejected");
+    
+    static recorder_t r;
+    const char *truncated =
+        "------WebKitFormBoundaryX3\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+        "\r\n"
+        "no closing delimiter";
+    const char *no_disposition =
+        "------WebKitFormBoundaryX3\r\n"
+        "Content-Type: text/plain\r\n"
+        "\r\n"
+        "x\r\n------WebKitFormBoundaryX3--\r\n";
+    const char *bad_delimiter =
+        "------WebKitFormBoundaryX3xx\r\n";
+    
+    int ok = parse_in_steps(truncated, strlen(truncated), 5, &r) != 0 &&
+             parse_in_steps(no_disposition, strlen(no_disposition), 5, &r) != 0 &&
+             parse_in_steps(bad_delimiter, strlen(bad_delimiter), 5, &r) != 0;
+    
+    /* Headers that never end must not grow without bound. */
+    static char endless[MULTIPART_MAX_HEADERS * 2];
+    size_t len = (size_t)snprintf(endless, sizeof(endless), "------WebKitFormBoundaryX3\r\n");
+    memset(endless + len, 'h', sizeof(endless) - len);
+    ok = ok && parse_in_steps(endless, sizeof(endless), 1000, &r) != 0;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Malformed body accepted");
+    }
+}
+
+void test_boundary(void) {
+    test_start("Boundary parameter");
+    
+    char boundary[MULTIPART_MAX_BOUNDARY + 1];
+    int ok = multipart_get_boundary("multipart/form-data; boundary=abc", boundary, sizeof(boundary)) == 0 &&
+             strcmp(boundary, "abc") == 0;
+    ok = ok && multipart_get_boundary("Multipart/Form-Data; charset=utf-8; boundary=\"a b\"",
+                                      boundary, sizeof(boundary)) == 0 && strcmp(boundary, "a b") == 0;
+    ok = ok && multipart_get_boundary("application/x-www-form-urlencoded", boundary, sizeof(boundary)) != 0;
+    ok = ok && multipart_get_boundary("multipart/form-data", boundary, sizeof(boundary)) != 0;
+    ok = ok && multipart_get_boundary(NULL, boundary, sizeof(boundary)) != 0;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected boundary");
+    }
+}
+
+void test_find(void) {
+    test_start("Delimiter search matches a naive search");
+    
+    static char haystack[4096];
+    const char *needle = "\r\n--xyz";
+    size_t needle_len = strlen(needle);
+    int ok = 1;
+    
+    srand(11);
+    for (int round = 0; round < 3000 && ok; round++) {
+        size_t len = (size_t)(rand() % (int)sizeof(haystack));
+        for (size_t i = 0; i < len; i++) {
+            haystack[i] = "\r\n-xyza"[rand() % 7];
+        }
+        size_t naive = len;
+        for (size_t i = 0; i + needle_len <= len; i++) {
+            if (memcmp(haystack + i, needle, needle_len) == 0) {
+                naive = i;
+                break;
+            }
+        }
+        ok = multipart_find(haystack, len, needle, needle_len) == naive;
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Search result differs");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Multipart Parser Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_parse_any_split();
+    test_malformed();
+    test_boundary();
+    test_find();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
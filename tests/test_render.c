@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "render.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static const char *kernels[] = { "scalar", "sse2", "avx2" };
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+/* Straightforward per-byte escapers the kernels must agree with. */
+static size_t reference_html(char *dst, const char *src, size_t len) {
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        const char *entity = NULL;
+        switch (src[i]) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"': entity = "&quot;"; break;
+            case '\'': entity = "&#39;"; break;
+        }
+        if (entity) {
+            memcpy(dst + j, entity, strlen(entity));
+            j += strlen(entity);
+        } else {
+            dst[j++] = src[i];
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
+static size_t reference_js(char *dst, const char *src, size_t len) {
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        switch (src[i]) {
+            case '\\': case '\'': case '"':
+                dst[j++] = '\\'; dst[j++] = src[i]; break;
+            case '\n': dst[j++] = '\\'; dst[j++] = 'n'; break;
+            case '\r': dst[j++] = '\\'; dst[j++] = 'r'; break;
+            case '\t': dst[j++] = '\\'; dst[j++] = 't'; break;
+            default: dst[j++] = src[i]; break;
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
+static size_t reference_json(char *dst, const char *src, size_t len) {
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        switch (c) {
+            case '\\': case '"':
+                dst[j++] = '\\'; dst[j++] = (char)c; break;
+            case '\n': dst[j++] = '\\'; dst[j++] = 'n'; break;
+            case '\r': dst[j++] = '\\'; dst[j++] = 'r'; break;
+            case '\t': dst[j++] = '\\'; dst[j++] = 't'; break;
+            default:
+                if (c < 0x20) {
+                    j += (size_t)sprintf(dst + j, "\\u%04x", c);
+                } else {
+                    dst[j++] = (char)c;
+                }
+                break;
+        }
+    }
+    dst[j] = '\0';
+    return j;
+}
+
+static int check_input(const char *src, size_t len, char *expected, char *actual) {
+    size_t expected_len = reference_html(expected, src, len);
+    if (render_escape_html_into(actual, src, len) != expected_len ||
+        memcmp(expected, actual, expected_len + 1) != 0) {
+        return 0;
+    }
+    
+    expected_len = reference_js(expected, src, len);
+    if (render_escape_js_into(actual, src, len) != expected_len ||
+        memcmp(expected, actual, expected_len + 1) != 0) {
+        return 0;
+    }
+    
+    expected_len = reference_json(expected, src, len);
+    if (render_escape_json_into(actual, src, len) != expected_len ||
+        memcmp(expected, actual, expected_len + 1) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+void test_kernels_match_reference(void) {
+    test_start("Every kernel matches the reference escaper");
+    
+    const char specials[] = "&<>\"'\\\n\r\t\x01\x1f";
+    char src[300];
+    char expected[300 * RENDER_ESCAPE_MAX_EXPANSION + 1];
+    char actual[300 * RENDER_ESCAPE_MAX_EXPANSION + 1];
+    int ok = 1;
+    int tested = 0;
+    
+    for (size_t k = 0; k < KERNEL_COUNT && ok; k++) {
+        if (render_set_escape_kernel(kernels[k]) != 0) {
+            printf("  Kernel %s not available, skipped\n", kernels[k]);
+            continue;
+        }
+        tested++;
+        
+        /* One special character at every position of every length, so each
+         * lane and each tail path of the vector loops is hit. */
+        for (size_t len = 0; len <= 80 && ok; len++) {
+            for (size_t pos = 0; pos < len && ok; pos++) {
+                for (size_t s = 0; s < sizeof(specials) - 1 && ok; s++) {
+                    memset(src, 'a', len);
+                    src[pos] = specials[s];
+                    ok = check_input(src, len, expected, actual);
+                }
+            }
+        }
+        
+        /* Random bytes, including high-bit UTF-8 ones, biased towards specials. */
+        srand(42);
+        for (int round = 0; round < 2000 && ok; round++) {
+            size_t len = (size_t)(rand() % (int)sizeof(src));
+            for (size_t i = 0; i < len; i++) {
+                int r = rand() % 8;
+                src[i] = r == 0 ? specials[rand() % (sizeof(specials) - 1)] : (char)(1 + rand() % 255);
+            }
+            ok = check_input(src, len, expected, actual);
+        }
+        
+        printf("  Kernel %s: %s\n", kernels[k], ok ? "ok" : "mismatch");
+    }
+    
+    render_set_escape_kernel("scalar");
+    if (ok && tested > 0) {
+        test_pass();
+    } else {
+        test_fail("Kernel output differs from the reference");
+    }
+}
+
+void test_allocating_wrappers(void) {
+    test_start("Allocating escapers");
+    
+    char *html = render_escape_html("<a href=\"x\">Tom & Jerry's</a>");
+    char *js = render_escape_js("it's \"quoted\"\n\\");
+    
+    int ok = html && strcmp(html, "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#39;s&lt;/a&gt;") == 0;
+    ok = ok && js && strcmp(js, "it\\'s \\\"quoted\\\"\\n\\\\") == 0;
+    ok = ok && render_escape_html(NULL) == NULL;
+    
+    free(html);
+    free(js);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected escaped output");
+    }
+}
+
+void test_buffer(void) {
+    test_start("Growable buffer");
+    
+    render_buf_t buf;
+    int ok = render_buf_init(&buf, 4) == 0;
+    
+    ok = ok && render_buf_append_str(&buf, "<p>") == 0;
+    ok = ok && render_buf_append_html(&buf, "a < b") == 0;
+    ok = ok && render_buf_appendf(&buf, "</p><!-- %d -->", 12345) == 0;
+    ok = ok && strcmp(buf.data, "<p>a &lt; b</p><!-- 12345 -->") == 0;
+    ok = ok && buf.len == strlen(buf.data);
+    
+    /* Formatting past the current capacity grows the buffer. */
+    char big[1000];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    size_t before = buf.len;
+    ok = ok && render_buf_appendf(&buf, "%s", big) == 0;
+    ok = ok && buf.len == before + strlen(big) && buf.data[buf.len] == '\0';
+    
+    render_buf_reset(&buf);
+    ok = ok && buf.len == 0 && buf.data[0] == '\0';
+    ok = ok && render_buf_append_js(&buf, "'") == 0 && strcmp(buf.data, "\\'") == 0;
+    
+    render_buf_free(&buf);
+    ok = ok && buf.data == NULL;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Buffer contents are wrong");
+    }
+}
+
+void test_json_strings(void) {
+    test_start("JSON string escaping");
+    
+    render_buf_t buf;
+    int ok = render_buf_init(&buf, 4) == 0;
+    
+    ok = ok && render_buf_append_json(&buf, "say \"hi\"\\\n\t\x01 \xe4\xb8\xad") == 0;
+    ok = ok && strcmp(buf.data, "\"say \\\"hi\\\"\\\\\\n\\t\\u0001 \xe4\xb8\xad\"") == 0;
+    
+    render_buf_reset(&buf);
+    ok = ok && render_buf_append_json(&buf, NULL) == 0 && strcmp(buf.data, "null") == 0;
+    
+    render_buf_free(&buf);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("JSON escaping is wrong");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Render Test Suite\n");
+    printf("======================================\n\n");
+    
+    render_init();
+    printf("\n");
+    
+    test_kernels_match_reference();
+    test_allocating_wrappers();
+    test_buffer();
+    test_json_strings();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "db.h"
+#include "search.h"
+#include "cjk_tokenizer.h"
+
+#define TEST_DB_PATH "test_search.db"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void cleanup_test_db(void) {
+    unlink(TEST_DB_PATH);
+}
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static void setup_db(void) {
+    cleanup_test_db();
+    assert(cjk_tokenizer_install() == 0);
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec("INSERT INTO boards (name, title) VALUES ('tech', 'Technology');") == 0);
+}
+
+void test_build_match(void) {
+    test_start("Query sanitising");
+    
+    char match[128];
+    int ok = 1;
+    
+    ok &= search_build_match("  hello   world ", match, sizeof(match)) == 2 &&
+          strcmp(match, "\"hello\" \"world\"") == 0;
+    printf("  %s\n", match);
+    
+    ok &= search_build_match("say \"hi\" OR NOT sqli*", match, sizeof(match)) == 5 &&
+          strcmp(match, "\"say\" \"\"\"hi\"\"\" \"OR\" \"NOT\" \"sqli\"*") == 0;
+    printf("  %s\n", match);
+    
+    ok &= search_build_match("   ", match, sizeof(match)) == 0 && match[0] == '\0';
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected FTS5 query");
+    }
+}
+
+void test_triggers_and_ranking(void) {
+    test_start("Index kept in sync by triggers, ranked results");
+    
+    setup_db();
+    assert(search_init() == 0);
+    
+    assert(db_exec(
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'Compiler flags');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, 'gcc uses -O2 by default in this build');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, 'clang and gcc and gcc again');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, 'unrelated reply');"
+    ) == 0);
+    
+    char match[64];
+    search_build_match("gcc", match, sizeof(match));
+    
+    search_hit_t *hits = NULL;
+    int count = search_posts(match, 0, 10, &hits);
+    int ok = count == 2 && hits[0].post_id == 2 &&
+             strstr(hits[0].snippet, SEARCH_MARK_START "gcc" SEARCH_MARK_END) != NULL &&
+             strcmp(hits[0].subject, "Compiler flags") == 0;
+    printf("  Hits for gcc: %d\n", count);
+    search_hits_free(hits, count);
+    
+    /* Page two of a one-hit-per-page query. */
+    count = search_posts(match, 1, 1, &hits);
+    ok &= count == 1 && hits[0].post_id == 1;
+    search_hits_free(hits, count);
+    
+    assert(db_exec("UPDATE posts SET content = 'now about msvc' WHERE id = 2;") == 0);
+    assert(db_exec("DELETE FROM posts WHERE id = 1;") == 0);
+    count = search_posts(match, 0, 10, &hits);
+    ok &= count == 0;
+    printf("  Hits after update/delete: %d\n", count);
+    search_hits_free(hits, count);
+    
+    search_build_match("compil*", match, sizeof(match));
+    count = search_threads(match, 10, &hits);
+    ok &= count == 1 && hits[0].thread_id == 1;
+    search_hits_free(hits, count);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Search results did not follow table changes");
+    }
+}
+
+void test_rebuild_existing_rows(void) {
+    test_start("Existing rows indexed on first init and by rebuild");
+    
+    setup_db();
+    assert(db_exec(
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'Old thread');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, 'written before search existed');"
+    ) == 0);
+    
+    int ok = search_init() == 0;
+    
+    char match[64];
+    search_build_match("before", match, sizeof(match));
+    search_hit_t *hits = NULL;
+    int count = search_posts(match, 0, 10, &hits);
+    ok &= count == 1;
+    search_hits_free(hits, count);
+    
+    ok &= search_rebuild() == 0;
+    count = search_posts(match, 0, 10, &hits);
+    ok &= count == 1;
+    search_hits_free(hits, count);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Existing rows missing from the index");
+    }
+}
+
+static int count_posts(const char *query, char *snippet, size_t snippet_size) {
+    char match[128];
+    search_hit_t *hits = NULL;
+    
+    search_build_match(query, match, sizeof(match));
+    int count = search_posts(match, 0, 10, &hits);
+    if (snippet && count > 0) {
+        snprintf(snippet, snippet_size, "%s", hits[0].snippet);
+    }
+    search_hits_free(hits, count);
+    return count;
+}
+
+void test_cjk_bigrams(void) {
+    test_start("CJK bigram tokenizer");
+    
+    setup_db();
+    assert(search_init() == 0);
+    
+    assert(db_exec(
+        "INSERT INTO threads (board_id, subject) VALUES (1, '中文');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, '我们使用中文搜索引擎 with SQLite');"
+        "INSERT INTO posts (thread_id, content) VALUES (1, '今天天气很好');"
+    ) == 0);
+    
+    char snippet[256] = "";
+    int ok = 1;
+    
+    ok &= count_posts("中文搜索", snippet, sizeof(snippet)) == 1;
+    printf("  中文搜索 -> %s\n", snippet);
+    ok &= strstr(snippet, SEARCH_MARK_START "中文搜索" SEARCH_MARK_END) != NULL;
+    ok &= count_posts("搜索", NULL, 0) == 1;
+    ok &= count_posts("擎", NULL, 0) == 1;
+    ok &= count_posts("天", NULL, 0) == 1;
+    ok &= count_posts("中文 sqlite", NULL, 0) == 1;
+    ok &= count_posts("文中", NULL, 0) == 0;
+    ok &= count_posts("天气很好 sqlite", NULL, 0) == 0;
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Chinese text not searchable");
+    }
+}
+
+/* Snippets of long posts full of characters that expand when escaped make
+ * a results page far larger than any fixed buffer. */
+void test_large_results_page(void) {
+    test_start("Results page grows with escaped snippets");
+    
+    setup_db();
+    assert(search_init() == 0);
+    assert(db_exec("INSERT INTO threads (board_id, subject) VALUES (1, 'Quotes');") == 0);
+    
+    char content[2048];
+    size_t n = (size_t)snprintf(content, sizeof(content), "needle");
+    while (n + 40 < sizeof(content)) {
+        n += (size_t)snprintf(content + n, sizeof(content) - n,
+                              " \"\"\"\"\"\"\"\"\"\"<<<<<<<<<<\"\"\"\"\"\"\"\"\"\" w");
+    }
+    sqlite3_stmt *stmt = db_prepare("INSERT INTO posts (thread_id, content) VALUES (1, ?)");
+    assert(stmt != NULL);
+    for (int i = 0; i < SEARCH_PAGE_SIZE; i++) {
+        sqlite3_bind_text(stmt, 1, content, -1, SQLITE_STATIC);
+        assert(db_step(stmt) == SQLITE_DONE);
+        sqlite3_reset(stmt);
+    }
+    db_finalize(stmt);
+    
+    http_request_t req = { .method = "GET", .path = "/search", .query_string = "q=needle" };
+    http_response_t *response = search_handler(&req);
+    int ok = response && response->status_code == 200 && response->body_len > 65536 &&
+             response->body_len >= 7 &&
+             memcmp(response->body + response->body_len - 7, "</html>", 7) == 0;
+    printf("  Page size: %zu bytes\n", response ? response->body_len : 0);
+    http_response_free(response);
+    
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Results page was cut short");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Search Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_build_match();
+    test_triggers_and_ranking();
+    test_rebuild_existing_rows();
+    test_cjk_bigrams();
+    test_large_results_page();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
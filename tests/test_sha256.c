@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "sha256.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static void hash_hex(const void *data, size_t len, char hex[SHA256_HEX_SIZE]) {
+    sha256_t ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, digest);
+    sha256_hex(digest, hex);
+}
+
+/* Test 1: FIPS 180-4 example messages */
+void test_known_vectors(void) {
+    test_start("Known Vectors");
+    
+    static const struct {
+        const char *message;
+        const char *expected;
+    } vectors[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "The quick brown fox jumps over the lazy dog",
+          "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592" },
+    };
+    
+    char hex[SHA256_HEX_SIZE];
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        hash_hex(vectors[i].message, strlen(vectors[i].message), hex);
+        if (strcmp(hex, vectors[i].expected) != 0) {
+            printf("  message \"%s\": got %s\n", vectors[i].message, hex);
+            test_fail("Digest mismatch");
+            return;
+        }
+    }
+    
+    test_pass();
+}
+
+/* Test 2: One million 'a' characters, fed in uneven pieces */
+void test_million_a(void) {
+    test_start("Million a");
+    
+    char piece[997];
+    memset(piece, 'a', sizeof(piece));
+    
+    sha256_t ctx;
+    sha256_init(&ctx);
+    size_t remaining = 1000000;
+    while (remaining > 0) {
+        size_t n = remaining < sizeof(piece) ? remaining : sizeof(piece);
+        sha256_update(&ctx, piece, n);
+        remaining -= n;
+    }
+    
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hex[SHA256_HEX_SIZE];
+    sha256_final(&ctx, digest);
+    sha256_hex(digest, hex);
+    
+    if (strcmp(hex, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") != 0) {
+        printf("  got %s\n", hex);
+        test_fail("Digest mismatch");
+        return;
+    }
+    
+    test_pass();
+}
+
+/* Test 3: Any way of splitting the input gives the same digest */
+void test_incremental(void) {
+    test_start("Incremental Updates");
+    
+    unsigned char data[1000];
+    srand(7);
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)rand();
+    }
+    
+    for (size_t len = 0; len <= sizeof(data); len += 37) {
+        char whole[SHA256_HEX_SIZE];
+        hash_hex(data, len, whole);
+    
+        for (int round = 0; round < 20; round++) {
+            sha256_t ctx;
+            sha256_init(&ctx);
+            size_t pos = 0;
+            while (pos < len) {
+                size_t n = (size_t)(rand() % 130);
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                sha256_update(&ctx, data + pos, n);
+                pos += n;
+            }
+    
+            uint8_t digest[SHA256_DIGEST_SIZE];
+            char hex[SHA256_HEX_SIZE];
+            sha256_final(&ctx, digest);
+            sha256_hex(digest, hex);
+            if (strcmp(hex, whole) != 0) {
+                printf("  length %zu, round %d\n", len, round);
+                test_fail("Split input changed the digest");
+                return;
+            }
+        }
+    }
+    
+    test_pass();
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  SHA-256 Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_known_vectors();
+    test_million_a();
+    test_incremental();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,282 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "static_file.h"
+
+#define TEST_ROOT "/tmp/test_static_file"
+#define TEST_FILE_SIZE (300 * 1024)
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static char file_data[TEST_FILE_SIZE];
+
+static int write_test_file(void) {
+    mkdir(TEST_ROOT, 0755);
+    mkdir(TEST_ROOT "/ab", 0755);
+    for (size_t i = 0; i < sizeof(file_data); i++) {
+        file_data[i] = (char)('a' + i % 26);
+    }
+    FILE *fp = fopen(TEST_ROOT "/ab/clip.mp4", "wb");
+    if (!fp) {
+        return -1;
+    }
+    size_t written = fwrite(file_data, 1, sizeof(file_data), fp);
+    fclose(fp);
+    return written == sizeof(file_data) ? 0 : -1;
+}
+
+typedef struct {
+    http_response_t *response;
+    int fd;
+} detach_args_t;
+
+/* Plays the HTTP worker, which may block until the body is sent. */
+static void *run_detach(void *arg) {
+    detach_args_t *args = arg;
+    args->response->detach(args->fd, args->response->stream_ctx);
+    return NULL;
+}
+
+/* Runs the response's detach callback on one end of a socket pair and
+ * checks that the other end receives exactly expected_len bytes of the
+ * file from offset. Large bodies overflow the socket buffer, so the
+ * sender has to wait for the reader. */
+static int receives_body(http_response_t *response, size_t offset, size_t expected_len) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        return 0;
+    }
+    detach_args_t args = { response, pair[0] };
+    pthread_t worker;
+    if (pthread_create(&worker, NULL, run_detach, &args) != 0) {
+        close(pair[0]);
+        close(pair[1]);
+        return 0;
+    }
+    
+    char *buf = malloc(expected_len + 1);
+    size_t len = 0;
+    for (;;) {
+        struct pollfd pfd = { pair[1], POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            break;
+        }
+        ssize_t n = read(pair[1], buf + len, expected_len + 1 - len);
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+    }
+    close(pair[1]);
+    pthread_join(worker, NULL);
+    
+    int ok = len == expected_len && memcmp(buf, file_data + offset, expected_len) == 0;
+    if (!ok) {
+        printf("  Received %zu bytes, expected %zu\n", len, expected_len);
+    }
+    free(buf);
+    return ok;
+}
+
+static int has_header(const http_response_t *response, const char *line) {
+    return response->headers && strstr(response->headers, line) != NULL;
+}
+
+void test_parse_range(void) {
+    test_start("Range header parsing");
+    
+    int64_t start = -1;
+    int64_t end = -1;
+    int ok = 1;
+    
+    ok = ok && static_file_parse_range("bytes=0-99", 1000, &start, &end) == 0 && start == 0 && end == 99;
+    ok = ok && static_file_parse_range("bytes=500-", 1000, &start, &end) == 0 && start == 500 && end == 999;
+    ok = ok && static_file_parse_range("bytes=900-5000", 1000, &start, &end) == 0 && end == 999;
+    ok = ok && static_file_parse_range("bytes=-100", 1000, &start, &end) == 0 && start == 900 && end == 999;
+    ok = ok && static_file_parse_range("bytes=-5000", 1000, &start, &end) == 0 && start == 0;
+    ok = ok && static_file_parse_range("bytes=1000-", 1000, &start, &end) == -1;
+    ok = ok && static_file_parse_range("bytes=-0", 1000, &start, &end) == -1;
+    ok = ok && static_file_parse_range("bytes=0-1,5-6", 1000, &start, &end) == 1;
+    ok = ok && static_file_parse_range("bytes=9-3", 1000, &start, &end) == 1;
+    ok = ok && static_file_parse_range("items=0-1", 1000, &start, &end) == 1;
+    ok = ok && static_file_parse_range("bytes=abc", 1000, &start, &end) == 1;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected range");
+    }
+}
+
+void test_content_types(void) {
+    test_start("Content types by extension");
+    
+    int ok = strcmp(static_file_content_type("a/b/photo.JPG"), "image/jpeg") == 0 &&
+             strcmp(static_file_content_type("clip.webm"), "video/webm") == 0 &&
+             strcmp(static_file_content_type("page.html"), "application/octet-stream") == 0 &&
+             strcmp(static_file_content_type("dir.png/noext"), "application/octet-stream") == 0;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected content type");
+    }
+}
+
+void test_unsafe_paths(void) {
+    test_start("Unsafe and missing paths are not served");
+    
+    const char *paths[] = { "../etc/passwd", "ab/../ab/clip.mp4", ".hidden", "/etc/passwd",
+                            "ab//clip.mp4", "", "ab", "missing.png" };
+    http_request_t req = { 0 };
+    int ok = 1;
+    
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        http_response_t *response = static_file_serve(&req, TEST_ROOT, paths[i], NULL);
+        if (!response || response->status_code != 404) {
+            printf("  %s was not rejected\n", paths[i]);
+            ok = 0;
+        }
+        http_response_free(response);
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unsafe path served");
+    }
+}
+
+void test_serve_file(const char *label) {
+    char name[128];
+    snprintf(name, sizeof(name), "Full, ranged and conditional responses (%s)", label);
+    test_start(name);
+    
+    http_request_t req = { 0 };
+    http_response_t *response = static_file_serve(&req, TEST_ROOT, "ab/clip.mp4", NULL);
+    int ok = response && response->status_code == 200 &&
+             strcmp(response->content_type, "video/mp4") == 0 &&
+             has_header(response, "Content-Length: 307200\r\n") &&
+             has_header(response, "Accept-Ranges: bytes\r\n") &&
+             has_header(response, "Last-Modified: ") &&
+             receives_body(response, 0, TEST_FILE_SIZE);
+    
+    /* Remember Last-Modified for the conditional request below. */
+    char last_modified[64] = "";
+    if (response && response->headers) {
+        const char *value = strstr(response->headers, "Last-Modified: ");
+        if (value) {
+            sscanf(value + 15, "%63[^\r]", last_modified);
+        }
+    }
+    http_response_free(response);
+    
+    req.range = "bytes=100000-100099";
+    response = static_file_serve(&req, TEST_ROOT, "ab/clip.mp4", NULL);
+    ok = ok && response && response->status_code == 206 &&
+         has_header(response, "Content-Length: 100\r\n") &&
+         has_header(response, "Content-Range: bytes 100000-100099/307200\r\n") &&
+         receives_body(response, 100000, 100);
+    http_response_free(response);
+    
+    req.range = "bytes=400000-";
+    response = static_file_serve(&req, TEST_ROOT, "ab/clip.mp4", NULL);
+    ok = ok && response && response->status_code == 416 &&
+         has_header(response, "Content-Range: bytes */307200\r\n");
+    http_response_free(response);
+    
+    /* Callers that know the type override the extension. */
+    req.range = NULL;
+    response = static_file_serve(&req, TEST_ROOT, "ab/clip.mp4", "image/png");
+    ok = ok && response && response->status_code == 200 &&
+         strcmp(response->content_type, "image/png") == 0;
+    http_response_free(response);
+    
+    req.if_modified_since = last_modified;
+    response = static_file_serve(&req, TEST_ROOT, "ab/clip.mp4", NULL);
+    ok = ok && response && response->status_code == 304 && !response->detach;
+    http_response_free(response);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected response");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Static File Test Suite\n");
+    printf("======================================\n\n");
+    
+    if (write_test_file() != 0) {
+        printf(ANSI_COLOR_RED "Failed to create test file" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+    
+    test_parse_range();
+    test_content_types();
+    test_unsafe_paths();
+    
+    /* Before the sender starts, the calling thread sends everything. */
+    test_serve_file("worker");
+    
+    if (static_file_start() != 0) {
+        printf(ANSI_COLOR_RED "Failed to start the sender" ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+    test_serve_file("sender thread");
+    static_file_stop();
+    
+    unlink(TEST_ROOT "/ab/clip.mp4");
+    rmdir(TEST_ROOT "/ab");
+    rmdir(TEST_ROOT);
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
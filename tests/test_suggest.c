@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "db.h"
+#include "suggest.h"
+
+#define TEST_DB_PATH "test_suggest.db"
+#define READER_THREADS 4
+#define ADDED_SUBJECTS 2000
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void cleanup_test_db(void) {
+    unlink(TEST_DB_PATH);
+}
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+void test_build_and_lookup(void) {
+    test_start("Trie built from threads table");
+    
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(db_exec(
+        "INSERT INTO boards (name, title) VALUES ('tech', 'Technology');"
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'SQLite tuning tips');"
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'Sqlite WAL mode');"
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'Rust vs C');"
+        "INSERT INTO threads (board_id, subject) VALUES (1, 'Why   tuning   matters');"
+    ) == 0);
+    
+    int ok = suggest_init() == 0;
+    
+    suggest_result_t results[SUGGEST_TOP_K];
+    int count = suggest_lookup("sql", results, SUGGEST_TOP_K);
+    printf("  sql -> %d results, first: %s\n", count, count > 0 ? results[0].subject : "");
+    ok &= count == 2 && results[0].thread_id == 2 && results[1].thread_id == 1;
+    
+    count = suggest_lookup("  SQLite T", results, SUGGEST_TOP_K);
+    ok &= count == 1 && results[0].thread_id == 1;
+    
+    /* Word starts are indexed too, newest first. */
+    count = suggest_lookup("tun", results, SUGGEST_TOP_K);
+    ok &= count == 2 && results[0].thread_id == 4 && results[1].thread_id == 1;
+    
+    ok &= suggest_lookup("go", results, SUGGEST_TOP_K) == 0;
+    ok &= suggest_lookup("", results, SUGGEST_TOP_K) == 0;
+    
+    suggest_add(5, "Rust async runtimes");
+    count = suggest_lookup("rus", results, SUGGEST_TOP_K);
+    ok &= count == 2 && results[0].thread_id == 5;
+    count = suggest_lookup("rust v", results, SUGGEST_TOP_K);
+    ok &= count == 1 && results[0].thread_id == 3;
+    
+    suggest_shutdown();
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected suggestions");
+    }
+}
+
+/* Returns 1 when len bytes of s are well-formed UTF-8. */
+static int valid_utf8(const char *s, size_t len) {
+    const unsigned char *p = (const unsigned char *)s;
+    size_t i = 0;
+    while (i < len) {
+        int n = p[i] < 0x80 ? 1 : (p[i] & 0xE0) == 0xC0 ? 2 : (p[i] & 0xF0) == 0xE0 ? 3 :
+                (p[i] & 0xF8) == 0xF0 ? 4 : 0;
+        if (n == 0 || i + n > len) {
+            return 0;
+        }
+        for (int k = 1; k < n; k++) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        i += n;
+    }
+    return 1;
+}
+
+void test_long_utf8_subject(void) {
+    test_start("Long UTF-8 subjects cut at a character");
+    
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    int ok = suggest_init() == 0;
+    
+    /* After the 10-byte prefix, a 3-byte character straddles byte 255. */
+    char subject[512] = "Unicode \"x";
+    for (int i = 0; i < 100; i++) {
+        strcat(subject, "\xe6\x97\xa5");
+    }
+    suggest_add(1, subject);
+    
+    suggest_result_t results[SUGGEST_TOP_K];
+    int count = suggest_lookup("unicode", results, SUGGEST_TOP_K);
+    size_t len = count == 1 ? strlen(results[0].subject) : 0;
+    printf("  Subject of %zu bytes returned as %zu\n", strlen(subject), len);
+    ok &= count == 1 && len == 253 && valid_utf8(results[0].subject, len) &&
+          strncmp(results[0].subject, subject, len) == 0;
+    
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "GET";
+    req.path = "/suggest";
+    req.query_string = "q=unicode";
+    const char *expected = "[{\"id\":1,\"subject\":\"Unicode \\\"x\xe6\x97\xa5";
+    http_response_t *response = suggest_handler(&req);
+    ok &= response && response->status_code == 200 &&
+          valid_utf8(response->body, response->body_len) &&
+          response->body_len > strlen(expected) + 3 &&
+          memcmp(response->body, expected, strlen(expected)) == 0 &&
+          memcmp(response->body + response->body_len - 3, "\"}]", 3) == 0;
+    http_response_free(response);
+    
+    suggest_shutdown();
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Subject cut inside a UTF-8 sequence");
+    }
+}
+
+static atomic_int stop_readers;
+static atomic_int reader_errors;
+
+static void *reader_main(void *arg) {
+    (void)arg;
+    suggest_result_t results[SUGGEST_TOP_K];
+    static const char *prefixes[] = {"t", "topic", "topic 1", "s", "subject 9", "x"};
+    
+    while (!atomic_load(&stop_readers)) {
+        for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+            int count = suggest_lookup(prefixes[i], results, SUGGEST_TOP_K);
+            for (int j = 0; j < count; j++) {
+                if (strncmp(results[j].subject, "Topic", 5) != 0 &&
+                    strncmp(results[j].subject, "Subject", 7) != 0) {
+                    atomic_fetch_add(&reader_errors, 1);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+void test_concurrent_readers(void) {
+    test_start("Lock-free lookups during inserts");
+    
+    cleanup_test_db();
+    assert(db_init(TEST_DB_PATH) == 0);
+    assert(db_migrate() == 0);
+    assert(suggest_init() == 0);
+    
+    atomic_store(&stop_readers, 0);
+    atomic_store(&reader_errors, 0);
+    
+    pthread_t readers[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_create(&readers[i], NULL, reader_main, NULL);
+    }
+    
+    char subject[64];
+    for (int i = 1; i <= ADDED_SUBJECTS; i++) {
+        snprintf(subject, sizeof(subject), "%s %d", i % 2 ? "Topic" : "Subject", i);
+        suggest_add(i, subject);
+    }
+    
+    atomic_store(&stop_readers, 1);
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+    
+    suggest_result_t results[SUGGEST_TOP_K];
+    int count = suggest_lookup("topic 1", results, SUGGEST_TOP_K);
+    int ok = atomic_load(&reader_errors) == 0 && count == SUGGEST_TOP_K &&
+             results[0].thread_id == 1999;
+    printf("  Reader errors: %d, newest 'topic 1': %lld\n",
+           atomic_load(&reader_errors), count > 0 ? (long long)results[0].thread_id : 0LL);
+    
+    suggest_shutdown();
+    db_close();
+    cleanup_test_db();
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Readers saw inconsistent data");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Suggest Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_build_and_lookup();
+    test_long_utf8_subject();
+    test_concurrent_readers();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "template.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+typedef struct {
+    int64_t id;
+    const char *name;
+    int pinned;
+} item_t;
+
+typedef struct {
+    const char *title;
+    const char *body_html;
+    int64_t count;
+    int show_footer;
+    template_list_t items;          /* item_t */
+    template_list_t groups;         /* group_t */
+} page_t;
+
+typedef struct {
+    const char *label;
+    template_list_t items;          /* item_t */
+} group_t;
+
+static const template_field_t item_fields[] = {
+    TEMPLATE_FIELD(item_t, id, TEMPLATE_INT),
+    TEMPLATE_FIELD(item_t, name, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(item_t, pinned, TEMPLATE_BOOL),
+};
+static const template_schema_t item_schema = TEMPLATE_SCHEMA(item_t, item_fields);
+
+static const template_field_t group_fields[] = {
+    TEMPLATE_FIELD(group_t, label, TEMPLATE_TEXT),
+    TEMPLATE_LIST_FIELD(group_t, items, item_schema),
+};
+static const template_schema_t group_schema = TEMPLATE_SCHEMA(group_t, group_fields);
+
+static const template_field_t page_fields[] = {
+    TEMPLATE_FIELD(page_t, title, TEMPLATE_TEXT),
+    TEMPLATE_FIELD(page_t, body_html, TEMPLATE_RAW),
+    TEMPLATE_FIELD(page_t, count, TEMPLATE_INT),
+    TEMPLATE_FIELD(page_t, show_footer, TEMPLATE_BOOL),
+    TEMPLATE_LIST_FIELD(page_t, items, item_schema),
+    TEMPLATE_LIST_FIELD(page_t, groups, group_schema),
+};
+static const template_schema_t page_schema = TEMPLATE_SCHEMA(page_t, page_fields);
+
+/* Renders source against page and compares with expected. */
+static int renders_as(const char *source, const page_t *page, const char *expected) {
+    template_t *tmpl = template_compile("test", source, &page_schema);
+    if (!tmpl) {
+        return 0;
+    }
+    
+    render_buf_t buf;
+    render_buf_init(&buf, 16);
+    int ok = template_render(tmpl, page, &buf) == 0 && strcmp(buf.data, expected) == 0;
+    if (!ok) {
+        printf("  Got: [%s]\n  Expected: [%s]\n", buf.data, expected);
+    }
+    
+    render_buf_free(&buf);
+    template_destroy(tmpl);
+    return ok;
+}
+
+void test_fields(void) {
+    test_start("Text, raw and integer fields");
+    
+    page_t page = { .title = "<Tom & Jerry>", .body_html = "<b>bold</b>", .count = -42 };
+    
+    int ok = renders_as("<h1>{{title}}</h1>{{body_html}} {{ count }}{{! ignored }}!", &page,
+                        "<h1>&lt;Tom &amp; Jerry&gt;</h1><b>bold</b> -42!");
+    ok = ok && renders_as("plain text", &page, "plain text");
+    ok = ok && renders_as("", &page, "");
+    
+    page.title = NULL;
+    ok = ok && renders_as("[{{title}}]", &page, "[]");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Field output is wrong");
+    }
+}
+
+void test_conditionals(void) {
+    test_start("Conditionals");
+    
+    page_t page = { .title = "x", .show_footer = 0 };
+    const char *source = "{{#if show_footer}}footer{{else}}none{{/if}}|{{#if title}}T{{/if}}|"
+                         "{{#if count}}C{{/if}}|{{#if items}}I{{/if}}end";
+    
+    int ok = renders_as(source, &page, "none|T||end");
+    
+    item_t items[] = { { 1, "a", 0 } };
+    page.show_footer = 1;
+    page.title = "";
+    page.count = 3;
+    page.items = (template_list_t){ items, 1 };
+    ok = ok && renders_as(source, &page, "footer||C|Iend");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Wrong branch taken");
+    }
+}
+
+void test_loops(void) {
+    test_start("Loops and nested scopes");
+    
+    item_t first[] = { { 1, "one", 1 }, { 2, "t<wo>", 0 } };
+    item_t second[] = { { 3, "three", 0 } };
+    group_t groups[] = {
+        { "A", { first, 2 } },
+        { "B", { second, 1 } },
+        { "C", { NULL, 0 } },
+    };
+    page_t page = { .title = "page", .items = { first, 2 }, .groups = { groups, 3 } };
+    
+    int ok = renders_as("{{#each items}}{{id}}={{name}}{{#if pinned}}*{{/if}};{{/each}}", &page,
+                        "1=one*;2=t&lt;wo&gt;;");
+    
+    /* Inner names shadow outer ones; outer fields stay reachable. */
+    ok = ok && renders_as("{{#each groups}}{{label}}[{{#each items}}{{title}}:{{id}} {{/each}}]{{/each}}",
+                          &page, "A[page:1 page:2 ]B[page:3 ]C[]");
+    
+    page.items.count = 0;
+    ok = ok && renders_as("<{{#each items}}x{{/each}}>", &page, "<>");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Loop output is wrong");
+    }
+}
+
+void test_standalone_lines(void) {
+    test_start("Block tags on their own line");
+    
+    item_t items[] = { { 1, "a", 0 }, { 2, "b", 0 } };
+    page_t page = { .items = { items, 2 } };
+    
+    int ok = renders_as("<ul>\n"
+                        "  {{#each items}}\n"
+                        "  <li>{{name}}</li>\n"
+                        "  {{/each}}\n"
+                        "</ul>\n", &page,
+                        "<ul>\n  <li>a</li>\n  <li>b</li>\n</ul>\n");
+    
+    /* Tags sharing a line with text keep the line. */
+    ok = ok && renders_as("x {{#if show_footer}}y{{/if}}\nz", &page, "x \nz");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Standalone lines handled incorrectly");
+    }
+}
+
+void test_compile_errors(void) {
+    test_start("Compile errors");
+    
+    const char *bad[] = {
+        "{{missing}}",
+        "{{#each title}}{{/each}}",
+        "{{#if title}}open",
+        "{{/if}}",
+        "{{#each items}}{{/if}}",
+        "{{items}}",
+        "{{show_footer}}",
+        "{{title",
+        "{{#if title}}{{else}}{{else}}{{/if}}",
+        "{{#each items}}{{label}}{{/each}}",
+    };
+    
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        template_t *tmpl = template_compile("bad", bad[i], &page_schema);
+        if (tmpl) {
+            printf("  Accepted: %s\n", bad[i]);
+            template_destroy(tmpl);
+            ok = 0;
+        }
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Invalid template compiled");
+    }
+}
+
+void test_registry(void) {
+    test_start("Named templates");
+    
+    page_t page = { .title = "<hi>" };
+    int ok = template_register("greeting", "Hello {{title}}", &page_schema) != NULL;
+    ok = ok && template_find("greeting") != NULL && template_find("nope") == NULL;
+    
+    render_result_t *result = render_template("greeting", &page);
+    ok = ok && result && strcmp(result->html, "Hello &lt;hi&gt;") == 0 && result->len == 16;
+    render_free(result);
+    
+    ok = ok && render_template("nope", &page) == NULL;
+    
+    template_shutdown();
+    ok = ok && template_find("greeting") == NULL;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Registry lookup or render_template failed");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Template Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_fields();
+    test_conditionals();
+    test_loops();
+    test_standalone_lines();
+    test_compile_errors();
+    test_registry();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
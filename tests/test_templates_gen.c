@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "templates_gen.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static int contains(const render_buf_t *buf, const char *needle) {
+    int found = buf->data && strstr(buf->data, needle) != NULL;
+    if (!found) {
+        printf("  Missing: [%s]\n", needle);
+    }
+    return found;
+}
+
+void test_board_thread(void) {
+    test_start("Board thread row escapes and formats fields");
+    
+    render_buf_t buf;
+    render_buf_init(&buf, 16);
+    thread_summary_t summary = { .id = 7, .subject = "<b>hi</b>", .post_count = 12 };
+    
+    int ok = tmpl_board_thread(&buf, &summary) == 0 &&
+             strcmp(buf.data,
+                    "<li class=\"thread-item\">\n"
+                    "<a href=\"/thread?id=7\" class=\"thread-link\">&lt;b&gt;hi&lt;/b&gt;</a>\n"
+                    "<span class=\"thread-meta\">💬 12 posts</span>\n"
+                    "</li>\n") == 0;
+    
+    render_buf_reset(&buf);
+    summary.subject = NULL;
+    ok = ok && tmpl_board_thread(&buf, &summary) == 0 && contains(&buf, ">No Subject</a>");
+    
+    render_buf_free(&buf);
+    ok ? test_pass() : test_fail("thread row output differs");
+}
+
+void test_thread_post(void) {
+    test_start("Thread post renders quotes and attachments only when present");
+    
+    render_buf_t buf;
+    render_buf_init(&buf, 16);
+    post_view_t post = {
+        .lang = LANG_EN,
+        .id = 3,
+        .author = NULL,
+        .content_html = "a &amp; b",
+    };
+    
+    int ok = tmpl_thread_post(&buf, &post) == 0 &&
+             contains(&buf, "<div class=\"post\" id=\"post-3\">") &&
+             contains(&buf, "<span class=\"post-author\">Anonymous</span>") &&
+             contains(&buf, "<div class=\"post-content\">a &amp; b</div>") &&
+             contains(&buf, i18n_get(LANG_EN, "reply")) &&
+             strstr(buf.data, "quote") == NULL &&
+             strstr(buf.data, "attachment") == NULL;
+    
+    render_buf_reset(&buf);
+    post.author = "bob";
+    post.quoted_id = 1;
+    post.quoted_author = "<al>";
+    post.quoted_content_html = "<i>first</i>";
+    ok = ok && tmpl_thread_post(&buf, &post) == 0 &&
+         contains(&buf, "onclick=\"toggleQuote(1)\">&gt;&gt;1</span></div>") &&
+         contains(&buf, "<div class=\"quoted-post\" id=\"quote-1\">\n"
+                        "<strong>&lt;al&gt;</strong> (#1): <i>first</i>\n"
+                        "</div>\n");
+    
+    render_buf_reset(&buf);
+    post.attachment_url = "/uploads/ab/cd/abcd.png";
+    post.attachment_name = "a<b>.png";
+    post.attachment_kb = 12;
+    post.attachment_width = 640;
+    post.attachment_height = 480;
+    ok = ok && tmpl_thread_post(&buf, &post) == 0 &&
+         contains(&buf, "<img src=\"/uploads/ab/cd/abcd.png\" width=\"640\" height=\"480\" "
+                        "alt=\"a&lt;b&gt;.png\" loading=\"lazy\">") &&
+         contains(&buf, "a&lt;b&gt;.png (12 KB, 640×480)");
+    
+    render_buf_free(&buf);
+    ok ? test_pass() : test_fail("post fragment output differs");
+}
+
+void test_kaomoji_picker(void) {
+    test_start("Kaomoji picker marks the first tab and escapes items");
+    
+    const char *faces[] = { "(^_^)", "it's <ok>" };
+    kaomoji_category_t categories[] = {
+        { "Happy", faces, 2 },
+        { "Other", faces, 1 },
+    };
+    kaomoji_picker_t picker = { categories, 2 };
+    
+    render_buf_t buf;
+    render_buf_init(&buf, 16);
+    int ok = tmpl_kaomoji_picker(&buf, &picker) == 0 &&
+             contains(&buf, "<button class=\"kaomoji-tab active\" onclick=\"switchTab(0)\">Happy</button>\n"
+                            "<button class=\"kaomoji-tab\" onclick=\"switchTab(1)\">Other</button>\n"
+                            "</div>\n"
+                            "<div class=\"kaomoji-content\">\n"
+                            "<div class=\"kaomoji-category active\">\n") &&
+             contains(&buf, "insertKaomoji('it\\'s <ok>')\">it&#39;s &lt;ok&gt;</span>");
+    
+    render_buf_free(&buf);
+    ok ? test_pass() : test_fail("picker output differs");
+}
+
+void test_page_language(void) {
+    test_start("Page head highlights the active language and translates labels");
+    
+    board_page_t page = {
+        .lang = LANG_ZH_CN,
+        .lang_en = 0,
+        .lang_zh_cn = 1,
+        .id = 5,
+        .name = "tech",
+        .description = NULL,
+        .kaomoji_picker_html = "<!-- picker -->",
+    };
+    
+    render_buf_t buf;
+    render_buf_init(&buf, 16);
+    int ok = tmpl_board_head(&buf, &page) == 0 &&
+             contains(&buf, "<title>tech</title>") &&
+             contains(&buf, "'?id=5&lang=' + lang") &&
+             contains(&buf, "margin-left:8px;\">English</a>") &&
+             contains(&buf, "margin-left:8px;background:rgba(255,255,255,0.2);\">中文</a>") &&
+             contains(&buf, "<p>No description</p>") &&
+             contains(&buf, i18n_get(LANG_ZH_CN, "threads"));
+    
+    render_buf_reset(&buf);
+    ok = ok && tmpl_board_tail(&buf, &page) == 0 &&
+         contains(&buf, "<div class=\"kaomoji-tabs\">\n<!-- picker --></div>") &&
+         contains(&buf, "value=\"5\"");
+    
+    render_buf_free(&buf);
+    ok ? test_pass() : test_fail("page head or tail output differs");
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Generated Templates Test Suite\n");
+    printf("======================================\n\n");
+    
+    test_board_thread();
+    test_thread_post();
+    test_kaomoji_picker();
+    test_page_language();
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    return 0;
+}
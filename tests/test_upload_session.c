@@ -0,0 +1,370 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#include "upload_session.h"
+#include "upload.h"
+#include "sha256.h"
+#include "db.h"
+
+#define TEST_ROOT "/tmp/test_upload_session"
+#define TEST_DB_PATH TEST_ROOT "/test.db"
+#define TEST_CONTENT "0123456789"
+#define SESSION_PREFIX "/upload/sessions/"
+
+static int test_count = 0;
+static int test_passed = 0;
+static int test_failed = 0;
+
+void test_start(const char *name) {
+    test_count++;
+    printf(ANSI_COLOR_YELLOW "[TEST %d] %s" ANSI_COLOR_RESET "\n", test_count, name);
+}
+
+void test_pass(void) {
+    test_passed++;
+    printf(ANSI_COLOR_GREEN "  ✓ PASSED" ANSI_COLOR_RESET "\n\n");
+}
+
+void test_fail(const char *msg) {
+    test_failed++;
+    printf(ANSI_COLOR_RED "  ✗ FAILED: %s" ANSI_COLOR_RESET "\n\n", msg);
+}
+
+static int has_header(const http_response_t *response, const char *line) {
+    return response->headers && strstr(response->headers, line) != NULL;
+}
+
+static int status_of(http_response_t *response) {
+    int status = response ? response->status_code : -1;
+    http_response_free(response);
+    return status;
+}
+
+/* Creates a session for TEST_CONTENT and copies its path into path. */
+static int create_session(char *path, size_t size) {
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "POST";
+    req.path = "/upload/sessions";
+    req.query_string = "filename=notes.bin";
+    req.upload_length = "10";
+    
+    http_response_t *response = upload_session_create_handler(&req);
+    int ok = response && response->status_code == 201 &&
+             has_header(response, "Upload-Offset: 0\r\n") &&
+             has_header(response, "Upload-Length: 10\r\n");
+    const char *location = ok ? strstr(response->headers, "Location: ") : NULL;
+    if (location) {
+        location += strlen("Location: ");
+        snprintf(path, size, "%.*s", (int)strcspn(location, "\r\n"), location);
+    }
+    http_response_free(response);
+    return location && strncmp(path, SESSION_PREFIX, strlen(SESSION_PREFIX)) == 0 ? 0 : -1;
+}
+
+static void partial_file(const char *path, char *file, size_t size) {
+    snprintf(file, size, TEST_ROOT "/.partial/%s", path + strlen(SESSION_PREFIX));
+}
+
+static off_t file_size(const char *file) {
+    struct stat st;
+    return stat(file, &st) == 0 ? st.st_size : -1;
+}
+
+/* Sends a PATCH of data at offset; when body is non-NULL the data is
+ * read from it instead of arriving with the headers. */
+static http_response_t *patch(const char *path, const char *offset, const char *data, size_t len,
+                              http_body_t *body) {
+    http_body_t buffered = { -1, data, len, 0 };
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "PATCH";
+    req.path = path;
+    req.upload_offset = offset;
+    req.content_length = len;
+    req.body = data;
+    req.body_len = body ? 0 : len;
+    req.body_reader = body ? body : &buffered;
+    return upload_session_handler(&req);
+}
+
+static http_response_t *head(const char *path) {
+    http_request_t req;
+    memset(&req, 0, sizeof(req));
+    req.method = "HEAD";
+    req.path = path;
+    return upload_session_handler(&req);
+}
+
+typedef struct {
+    const char *path;
+    http_body_t body;
+    http_response_t *response;
+} patch_args_t;
+
+/* Plays the HTTP worker, blocked reading the body from the socket. */
+static void *run_patch(void *arg) {
+    patch_args_t *args = arg;
+    args->response = patch(args->path, "4", NULL, args->body.remaining, &args->body);
+    return NULL;
+}
+
+void test_patch_session(void) {
+    test_start("PATCH offsets and limits");
+    
+    char path[64];
+    char file[128];
+    if (create_session(path, sizeof(path)) != 0) {
+        test_fail("session not created");
+        return;
+    }
+    partial_file(path, file, sizeof(file));
+    
+    int ok = 1;
+    http_response_t *response = patch(path, "5", "56789", 5, NULL);
+    ok = ok && response && response->status_code == 409 &&
+         has_header(response, "Upload-Offset: 0\r\n");
+    http_response_free(response);
+    printf("  Offset mismatch: 409 with the server's offset\n");
+    
+    ok = ok && status_of(patch(path, "0", TEST_CONTENT "!", 11, NULL)) == 413 &&
+         file_size(file) == 0;
+    printf("  Data past Upload-Length: 413, nothing written\n");
+    
+    response = patch(path, "0", "0123", 4, NULL);
+    ok = ok && response && response->status_code == 204 &&
+         has_header(response, "Upload-Offset: 4\r\n") && file_size(file) == 4;
+    http_response_free(response);
+    
+    response = head(path);
+    ok = ok && response && response->status_code == 200 &&
+         has_header(response, "Upload-Offset: 4\r\n");
+    http_response_free(response);
+    printf("  Partial PATCH: 204, HEAD reports offset 4\n");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Unexpected response");
+    }
+}
+
+void test_concurrent_patch(void) {
+    test_start("Concurrent PATCH refused");
+    
+    char path[64];
+    char file[128];
+    if (create_session(path, sizeof(path)) != 0 ||
+        status_of(patch(path, "0", "0123", 4, NULL)) != 204) {
+        test_fail("session not prepared");
+        return;
+    }
+    partial_file(path, file, sizeof(file));
+    
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        test_fail("socketpair failed");
+        return;
+    }
+    patch_args_t args = { path, { pair[1], NULL, 0, 3 }, NULL };
+    pthread_t worker;
+    if (pthread_create(&worker, NULL, run_patch, &args) != 0) {
+        close(pair[0]);
+        close(pair[1]);
+        test_fail("pthread_create failed");
+        return;
+    }
+    
+    /* Once the first byte is on disk the worker holds the session. */
+    struct timespec pause = { 0, 10 * 1000 * 1000 };
+    int ok = write(pair[0], "4", 1) == 1;
+    for (int i = 0; ok && i < 200 && file_size(file) != 5; i++) {
+        nanosleep(&pause, NULL);
+    }
+    ok = ok && file_size(file) == 5;
+    
+    http_response_t *response = patch(path, "5", "56", 2, NULL);
+    ok = ok && response && response->status_code == 409 &&
+         response->body && strstr(response->body, "in progress") != NULL;
+    http_response_free(response);
+    
+    ok = (write(pair[0], "56", 2) == 2) && ok;
+    pthread_join(worker, NULL);
+    close(pair[0]);
+    close(pair[1]);
+    
+    ok = ok && args.response && args.response->status_code == 204 &&
+         has_header(args.response, "Upload-Offset: 7\r\n") && file_size(file) == 7;
+    http_response_free(args.response);
+    
+    /* Released again: the next PATCH goes through. */
+    ok = ok && status_of(patch(path, "7", "789", 3, NULL)) == 201;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Second PATCH not refused while the first was running");
+    }
+}
+
+void test_finish_session(void) {
+    test_start("Last byte stores the file");
+    
+    char path[64];
+    char file[128];
+    if (create_session(path, sizeof(path)) != 0 ||
+        status_of(patch(path, "0", "0123456", 7, NULL)) != 204) {
+        test_fail("session not prepared");
+        return;
+    }
+    partial_file(path, file, sizeof(file));
+    
+    sha256_t ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hash[SHA256_HEX_SIZE];
+    sha256_init(&ctx);
+    sha256_update(&ctx, TEST_CONTENT, strlen(TEST_CONTENT));
+    sha256_final(&ctx, digest);
+    sha256_hex(digest, hash);
+    
+    char url[160];
+    char location[200];
+    upload_url(hash, "notes.bin", url, sizeof(url));
+    snprintf(location, sizeof(location), "Location: %s\r\n", url);
+    
+    http_response_t *response = patch(path, "7", "789", 3, NULL);
+    int ok = response && response->status_code == 201 &&
+             has_header(response, "Upload-Offset: 10\r\n") && has_header(response, location);
+    http_response_free(response);
+    printf("  201 with %s\n", url);
+    
+    char stored[256];
+    char relative[80];
+    char content[16] = "";
+    upload_hash_path(hash, relative, sizeof(relative));
+    snprintf(stored, sizeof(stored), TEST_ROOT "/%s", relative);
+    FILE *fp = fopen(stored, "rb");
+    if (fp) {
+        content[fread(content, 1, sizeof(content) - 1, fp)] = '\0';
+        fclose(fp);
+    }
+    ok = ok && strcmp(content, TEST_CONTENT) == 0;
+    ok = ok && file_size(file) == -1 && status_of(head(path)) == 404;
+    printf("  Stored in the upload directory, session gone\n");
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Upload not stored");
+    }
+}
+
+void test_expire(void) {
+    test_start("Expired sessions removed");
+    
+    char path[64];
+    char file[128];
+    if (create_session(path, sizeof(path)) != 0) {
+        test_fail("session not created");
+        return;
+    }
+    partial_file(path, file, sizeof(file));
+    
+    int ok = upload_session_expire() == 0 && file_size(file) == 0;
+    
+    char sql[160];
+    snprintf(sql, sizeof(sql), "UPDATE upload_sessions SET expires_at = 0 WHERE id = '%s';",
+             path + strlen(SESSION_PREFIX));
+    ok = ok && db_exec(sql) == 0;
+    ok = ok && upload_session_expire() == 1 && file_size(file) == -1 &&
+         status_of(head(path)) == 404;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Expired session or its partial file left behind");
+    }
+}
+
+void test_remove_orphans(void) {
+    test_start("Orphaned partial files removed");
+    
+    char path[64];
+    char file[128];
+    if (create_session(path, sizeof(path)) != 0) {
+        test_fail("session not created");
+        return;
+    }
+    partial_file(path, file, sizeof(file));
+    
+    const char *orphan = TEST_ROOT "/.partial/0123456789abcdef0123456789abcdef";
+    FILE *fp = fopen(orphan, "wb");
+    if (fp) {
+        fclose(fp);
+    }
+    
+    /* Startup clears files without a session and keeps the rest. */
+    upload_session_init(TEST_ROOT);
+    int ok = fp && file_size(orphan) == -1 && file_size(file) == 0;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Orphan kept or live partial file removed");
+    }
+}
+
+int main(void) {
+    printf("\n");
+    printf("======================================\n");
+    printf("  Upload Session Test Suite\n");
+    printf("======================================\n\n");
+    
+    system("rm -rf " TEST_ROOT);
+    if (mkdir(TEST_ROOT, 0755) != 0 || db_init(TEST_DB_PATH) != 0 || db_migrate() != 0) {
+        printf(ANSI_COLOR_RED "Failed to set up " TEST_ROOT ANSI_COLOR_RESET "\n");
+        return 1;
+    }
+    upload_init(TEST_ROOT);
+    upload_session_init(TEST_ROOT);
+    
+    test_patch_session();
+    test_concurrent_patch();
+    test_finish_session();
+    test_expire();
+    test_remove_orphans();
+    
+    db_close();
+    system("rm -rf " TEST_ROOT);
+    
+    printf("======================================\n");
+    printf("  Test Summary\n");
+    printf("======================================\n");
+    printf("Total tests:  %d\n", test_count);
+    printf(ANSI_COLOR_GREEN "Passed:       %d" ANSI_COLOR_RESET "\n", test_passed);
+    if (test_failed > 0) {
+        printf(ANSI_COLOR_RED "Failed:       %d" ANSI_COLOR_RESET "\n", test_failed);
+    } else {
+        printf("Failed:       %d\n", test_failed);
+    }
+    printf("======================================\n\n");
+    
+    if (test_failed > 0) {
+        return 1;
+    }
+    
+    printf(ANSI_COLOR_GREEN "All tests passed!" ANSI_COLOR_RESET "\n\n");
+    return 0;
+}
@@ -0,0 +1,797 @@
+/*
+ * tmplc - compiles .tmpl files into C rendering functions.
+ *
+ *   tmplc -o <base> [-I header.h]... file.tmpl...
+ *
+ * writes <base>.c and <base>.h. Each {{@template name context_t}} section
+ * becomes
+ *
+ *   int tmpl_<name>(render_buf_t *out, const context_t *ctx);
+ *
+ * Literal text becomes static const arrays appended with one memcpy, and
+ * field output calls the escaping functions directly. context_t and the
+ * structs it refers to are read from the -I headers, so unknown fields and
+ * wrong types are reported here, with the template line, and again by the
+ * C compiler through #line directives.
+ *
+ * Tags:
+ *   {{field}}          escaped text, or an integer
+ *   {{{field}}}        text emitted as is (trusted markup)
+ *   {{js field}}       text escaped for a single-quoted JS string
+ *   {{t key}}          i18n_get(ctx->lang, "key")
+ *   {{#if field}} {{else}} {{/if}}
+ *   {{#each list}} {{/each}}
+ *                      list is `const T *list` with a `list_count` sibling;
+ *                      T is a struct, or char * for a list of strings ({{.}})
+ *   {{@index}} {{#if @first}}
+ *   {{! comment}}
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HEADERS 16
+#define MAX_STRUCTS 128
+#define MAX_FIELDS 64
+#define MAX_DEPTH 16
+
+typedef enum {
+    KIND_OTHER,
+    KIND_STR,                       /* char * */
+    KIND_STR_LIST,                  /* char ** */
+    KIND_INT,
+    KIND_LANG,                      /* language_t */
+    KIND_PTR                        /* pointer to a struct: a list */
+} kind_t;
+
+typedef struct {
+    char name[64];
+    char base[64];                  /* type without const and '*' */
+    kind_t kind;
+} field_t;
+
+typedef struct {
+    char name[64];
+    field_t fields[MAX_FIELDS];
+    int field_count;
+} struct_def_t;
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} sb_t;
+
+typedef struct {
+    const struct_def_t *def;        /* NULL for a list of strings */
+    char var[16];                   /* C expression for the item */
+    char index[16];                 /* loop counter, "" for the root */
+} scope_t;
+
+static struct_def_t structs[MAX_STRUCTS];
+static int struct_count = 0;
+
+static const char *tmpl_path;
+static int tmpl_line;
+static int errors = 0;
+
+static void sb_grow(sb_t *sb, size_t extra) {
+    if (sb->len + extra + 1 <= sb->cap) {
+        return;
+    }
+    size_t cap = sb->cap ? sb->cap : 4096;
+    while (cap < sb->len + extra + 1) {
+        cap *= 2;
+    }
+    sb->data = realloc(sb->data, cap);
+    if (!sb->data) {
+        fprintf(stderr, "tmplc: out of memory\n");
+        exit(1);
+    }
+    sb->cap = cap;
+}
+
+static void sb_printf(sb_t *sb, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int needed = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    
+    sb_grow(sb, (size_t)needed);
+    va_start(args, fmt);
+    vsnprintf(sb->data + sb->len, (size_t)needed + 1, fmt, args);
+    va_end(args);
+    sb->len += (size_t)needed;
+}
+
+static void error(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s:%d: error: ", tmpl_path, tmpl_line);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    errors++;
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "tmplc: cannot open %s\n", path);
+        exit(1);
+    }
+    
+    sb_t sb = {0};
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        sb_grow(&sb, n);
+        memcpy(sb.data + sb.len, chunk, n);
+        sb.len += n;
+    }
+    fclose(f);
+    
+    sb_grow(&sb, 0);
+    sb.data[sb.len] = '\0';
+    return sb.data;
+}
+
+/* ---- Header parsing ---- */
+
+static void strip_comments(char *src) {
+    char *p = src;
+    while (*p) {
+        if (p[0] == '/' && p[1] == '*') {
+            char *end = strstr(p + 2, "*/");
+            char *stop = end ? end + 2 : p + strlen(p);
+            memset(p, ' ', (size_t)(stop - p));
+            p = stop;
+        } else if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') {
+                *p++ = ' ';
+            }
+        } else {
+            p++;
+        }
+    }
+}
+
+static int is_int_type(const char *base) {
+    static const char *names[] = {
+        "int", "long", "short", "unsigned", "signed", "size_t", "long long",
+        "unsigned int", "unsigned long", "int32_t", "int64_t", "uint32_t", "uint64_t"
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(base, names[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void parse_field(struct_def_t *def, char *decl) {
+    while (isspace((unsigned char)*decl)) {
+        decl++;
+    }
+    char *end = decl + strlen(decl);
+    while (end > decl && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    if (!*decl || def->field_count == MAX_FIELDS) {
+        return;
+    }
+    
+    /* The name is the trailing identifier; arrays and bit-fields are not
+     * template fields. */
+    if (strchr(decl, '[') || strchr(decl, ':') || strchr(decl, '(')) {
+        return;
+    }
+    char *name = end;
+    while (name > decl && (isalnum((unsigned char)name[-1]) || name[-1] == '_')) {
+        name--;
+    }
+    
+    field_t *field = &def->fields[def->field_count++];
+    snprintf(field->name, sizeof(field->name), "%s", name);
+    
+    int pointers = 0;
+    field->base[0] = '\0';
+    char *tok = decl;
+    while (tok < name) {
+        if (*tok == '*') {
+            pointers++;
+            tok++;
+            continue;
+        }
+        if (!isalnum((unsigned char)*tok) && *tok != '_') {
+            tok++;
+            continue;
+        }
+        char *word = tok;
+        while (tok < name && (isalnum((unsigned char)*tok) || *tok == '_')) {
+            tok++;
+        }
+        size_t len = (size_t)(tok - word);
+        if (len == 5 && memcmp(word, "const", 5) == 0) {
+            continue;
+        }
+        size_t used = strlen(field->base);
+        snprintf(field->base + used, sizeof(field->base) - used, "%s%.*s",
+                 used ? " " : "", (int)len, word);
+    }
+    
+    if (strcmp(field->base, "char") == 0 && pointers == 1) {
+        field->kind = KIND_STR;
+    } else if (strcmp(field->base, "char") == 0 && pointers == 2) {
+        field->kind = KIND_STR_LIST;
+    } else if (pointers == 1) {
+        field->kind = KIND_PTR;
+    } else if (pointers == 0 && strcmp(field->base, "language_t") == 0) {
+        field->kind = KIND_LANG;
+    } else if (pointers == 0 && is_int_type(field->base)) {
+        field->kind = KIND_INT;
+    } else {
+        field->kind = KIND_OTHER;
+    }
+}
+
+static void parse_header(const char *path) {
+    char *src = read_file(path);
+    strip_comments(src);
+    
+    char *p = src;
+    while ((p = strstr(p, "typedef struct")) != NULL) {
+        char *open = strchr(p, '{');
+        char *semi = strchr(p, ';');
+        if (!open || (semi && semi < open)) {
+            p += 14;
+            continue;
+        }
+        char *close = strchr(open, '}');
+        if (!close || struct_count == MAX_STRUCTS) {
+            break;
+        }
+    
+        struct_def_t *def = &structs[struct_count++];
+        memset(def, 0, sizeof(*def));
+    
+        *close = '\0';
+        char *decl = open + 1;
+        char *next;
+        while ((next = strchr(decl, ';')) != NULL) {
+            *next = '\0';
+            parse_field(def, decl);
+            decl = next + 1;
+        }
+    
+        char *name = close + 1;
+        while (*name && !isalnum((unsigned char)*name) && *name != '_') {
+            name++;
+        }
+        size_t len = 0;
+        while (isalnum((unsigned char)name[len]) || name[len] == '_') {
+            len++;
+        }
+        snprintf(def->name, sizeof(def->name), "%.*s", (int)len, name);
+        p = name + len;
+    }
+    free(src);
+}
+
+static const struct_def_t *find_struct(const char *name) {
+    for (int i = 0; i < struct_count; i++) {
+        if (strcmp(structs[i].name, name) == 0) {
+            return &structs[i];
+        }
+    }
+    return NULL;
+}
+
+static const field_t *find_field(const struct_def_t *def, const char *name) {
+    for (int i = 0; i < def->field_count; i++) {
+        if (strcmp(def->fields[i].name, name) == 0) {
+            return &def->fields[i];
+        }
+    }
+    return NULL;
+}
+
+/* ---- Code generation ---- */
+
+typedef struct {
+    sb_t *decls;                    /* file-scope literal arrays */
+    sb_t *body;
+    char func[96];
+    int literal_count;
+    sb_t text;                      /* pending literal text */
+    scope_t scopes[MAX_DEPTH];
+    int scope_count;
+    char blocks[MAX_DEPTH * 4];     /* 'i', 'e' (if with else) or 'l' */
+    int block_count;
+    int text_line;
+} gen_t;
+
+static void indent(gen_t *g) {
+    for (int i = 0; i <= g->block_count; i++) {
+        sb_printf(g->body, "    ");
+    }
+}
+
+static void emit_line(gen_t *g) {
+    sb_printf(g->body, "#line %d \"%s\"\n", tmpl_line, tmpl_path);
+}
+
+static void flush_text(gen_t *g) {
+    if (g->text.len == 0) {
+        return;
+    }
+    
+    sb_printf(g->decls, "static const char %s_text%d[] =\n    \"", g->func, g->literal_count);
+    for (size_t i = 0; i < g->text.len; i++) {
+        unsigned char c = (unsigned char)g->text.data[i];
+        if (c == '\n') {
+            sb_printf(g->decls, i + 1 < g->text.len ? "\\n\"\n    \"" : "\\n");
+        } else if (c == '"' || c == '\\') {
+            sb_printf(g->decls, "\\%c", c);
+        } else if (c == '?' && i > 0 && g->text.data[i - 1] == '?') {
+            sb_printf(g->decls, "\\?");     /* no trigraphs */
+        } else if (c == '\t') {
+            sb_printf(g->decls, "\\t");
+        } else if (c < 0x20) {
+            sb_printf(g->decls, "\\%03o", c);
+        } else {
+            sb_printf(g->decls, "%c", c);
+        }
+    }
+    sb_printf(g->decls, "\";\n\n");
+    
+    int line = tmpl_line;
+    tmpl_line = g->text_line;
+    emit_line(g);
+    tmpl_line = line;
+    indent(g);
+    sb_printf(g->body, "rc |= render_buf_append(out, %s_text%d, sizeof(%s_text%d) - 1);\n",
+              g->func, g->literal_count, g->func, g->literal_count);
+    g->literal_count++;
+    g->text.len = 0;
+}
+
+static void add_text(gen_t *g, const char *text, size_t len, int line) {
+    if (len == 0) {
+        return;
+    }
+    if (g->text.len == 0) {
+        g->text_line = line;
+    }
+    sb_grow(&g->text, len);
+    memcpy(g->text.data + g->text.len, text, len);
+    g->text.len += len;
+}
+
+/* Resolves name against the scopes, innermost first. Writes the C
+ * expression for it into expr and returns the field, or NULL. */
+static const field_t *resolve(gen_t *g, const char *name, char *expr, size_t expr_size,
+                              const scope_t **owner) {
+    for (int s = g->scope_count - 1; s >= 0; s--) {
+        const scope_t *scope = &g->scopes[s];
+        if (!scope->def) {
+            continue;
+        }
+        const field_t *field = find_field(scope->def, name);
+        if (field) {
+            snprintf(expr, expr_size, "%s->%s", scope->var, name);
+            if (owner) {
+                *owner = scope;
+            }
+            return field;
+        }
+    }
+    error("unknown field '%s'", name);
+    return NULL;
+}
+
+static const scope_t *innermost_loop(gen_t *g, const char *what) {
+    if (g->scope_count < 2) {
+        error("%s outside {{#each}}", what);
+        return NULL;
+    }
+    return &g->scopes[g->scope_count - 1];
+}
+
+static void gen_output(gen_t *g, const char *name, int raw, int js) {
+    const scope_t *loop;
+    char expr[320];
+    kind_t kind;
+    
+    if (strcmp(name, ".") == 0) {
+        loop = innermost_loop(g, "{{.}}");
+        if (!loop) {
+            return;
+        }
+        if (loop->def) {
+            error("{{.}} needs a list of strings");
+            return;
+        }
+        snprintf(expr, sizeof(expr), "%s", loop->var);
+        kind = KIND_STR;
+    } else if (strcmp(name, "@index") == 0) {
+        loop = innermost_loop(g, "{{@index}}");
+        if (!loop) {
+            return;
+        }
+        snprintf(expr, sizeof(expr), "%s", loop->index);
+        kind = KIND_INT;
+    } else {
+        const field_t *field = resolve(g, name, expr, sizeof(expr), NULL);
+        if (!field) {
+            return;
+        }
+        kind = field->kind;
+    }
+    
+    emit_line(g);
+    indent(g);
+    if (kind == KIND_INT && !raw && !js) {
+        sb_printf(g->body, "rc |= render_buf_append_int(out, (int64_t)%s);\n", expr);
+    } else if (kind == KIND_STR) {
+        const char *fn = raw ? "render_buf_append_str" : js ? "render_buf_append_js" : "render_buf_append_html";
+        sb_printf(g->body, "if (%s) rc |= %s(out, %s);\n", expr, fn, expr);
+    } else {
+        error("'%s' cannot be output this way", name);
+    }
+}
+
+static void gen_if(gen_t *g, const char *name) {
+    char expr[320];
+    char cond[720];
+    
+    if (strcmp(name, "@first") == 0) {
+        const scope_t *loop = innermost_loop(g, "@first");
+        if (!loop) {
+            return;
+        }
+        snprintf(cond, sizeof(cond), "%s == 0", loop->index);
+    } else {
+        const scope_t *owner = NULL;
+        const field_t *field = resolve(g, name, expr, sizeof(expr), &owner);
+        if (!field) {
+            return;
+        }
+        switch (field->kind) {
+            case KIND_STR:
+                snprintf(cond, sizeof(cond), "%s && %s[0]", expr, expr);
+                break;
+            case KIND_INT:
+                snprintf(cond, sizeof(cond), "%s", expr);
+                break;
+            case KIND_STR_LIST:
+            case KIND_PTR:
+                snprintf(cond, sizeof(cond), "%s->%s_count > 0", owner->var, name);
+                break;
+            default:
+                error("'%s' cannot be tested", name);
+                return;
+        }
+    }
+    
+    emit_line(g);
+    indent(g);
+    sb_printf(g->body, "if (%s) {\n", cond);
+    g->blocks[g->block_count++] = 'i';
+}
+
+static void gen_each(gen_t *g, const char *name) {
+    char expr[320];
+    const scope_t *owner = NULL;
+    const field_t *field = resolve(g, name, expr, sizeof(expr), &owner);
+    if (!field) {
+        return;
+    }
+    if (g->scope_count == MAX_DEPTH) {
+        error("loops nested too deep");
+        return;
+    }
+    
+    const struct_def_t *item = NULL;
+    if (field->kind == KIND_PTR) {
+        item = find_struct(field->base);
+        if (!item) {
+            error("'%s' points to %s, which is not a struct in the headers", name, field->base);
+            return;
+        }
+    } else if (field->kind != KIND_STR_LIST) {
+        error("'%s' is not a list", name);
+        return;
+    }
+    
+    char count_name[320];
+    snprintf(count_name, sizeof(count_name), "%s_count", name);
+    const field_t *count = find_field(owner->def, count_name);
+    if (!count || count->kind != KIND_INT) {
+        error("list '%s' needs an integer '%s' next to it", name, count_name);
+        return;
+    }
+    
+    scope_t *scope = &g->scopes[g->scope_count];
+    int depth = g->scope_count;
+    snprintf(scope->var, sizeof(scope->var), "it%d", depth);
+    snprintf(scope->index, sizeof(scope->index), "i%d", depth);
+    scope->def = item;
+    
+    emit_line(g);
+    indent(g);
+    sb_printf(g->body, "for (size_t %s = 0; %s < (size_t)%s->%s; %s++) {\n",
+              scope->index, scope->index, owner->var, count_name, scope->index);
+    g->blocks[g->block_count++] = 'l';
+    indent(g);
+    if (item) {
+        sb_printf(g->body, "const %s *%s = &%s[%s];\n", item->name, scope->var, expr, scope->index);
+    } else {
+        sb_printf(g->body, "const char *%s = %s[%s];\n", scope->var, expr, scope->index);
+    }
+    indent(g);
+    sb_printf(g->body, "(void)%s;\n", scope->var);
+    g->scope_count++;
+}
+
+static void close_block(gen_t *g, char kind) {
+    if (g->block_count == 0 || (kind == 'l') != (g->blocks[g->block_count - 1] == 'l')) {
+        error("unexpected {{/%s}}", kind == 'l' ? "each" : "if");
+        return;
+    }
+    if (kind == 'l') {
+        g->scope_count--;
+    }
+    g->block_count--;
+    indent(g);
+    sb_printf(g->body, "}\n");
+}
+
+static void end_function(gen_t *g) {
+    if (!g->func[0]) {
+        return;
+    }
+    flush_text(g);
+    if (g->block_count > 0) {
+        error("missing {{/%s}} in %s", g->blocks[g->block_count - 1] == 'l' ? "each" : "if", g->func);
+        g->block_count = 0;
+    }
+    sb_printf(g->body, "    return rc ? -1 : 0;\n}\n\n");
+    g->func[0] = '\0';
+}
+
+static void begin_function(gen_t *g, sb_t *header, const char *args) {
+    char name[64];
+    char type[64];
+    if (sscanf(args, "%63s %63s", name, type) != 2) {
+        error("expected {{@template name context_t}}");
+        return;
+    }
+    const struct_def_t *def = find_struct(type);
+    if (!def) {
+        error("unknown context type '%s'", type);
+        return;
+    }
+    
+    end_function(g);
+    snprintf(g->func, sizeof(g->func), "tmpl_%s", name);
+    g->literal_count = 0;
+    g->scope_count = 1;
+    g->scopes[0].def = def;
+    snprintf(g->scopes[0].var, sizeof(g->scopes[0].var), "ctx");
+    g->scopes[0].index[0] = '\0';
+    
+    sb_printf(header, "int %s(render_buf_t *out, const %s *ctx);\n", g->func, type);
+    sb_printf(g->body, "int %s(render_buf_t *out, const %s *ctx) {\n    int rc = 0;\n", g->func, type);
+}
+
+static void gen_tag(gen_t *g, sb_t *header, const char *tag, size_t len, int raw) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%.*s", (int)len, tag);
+    
+    if (buf[0] == '!') {
+        return;
+    }
+    if (strncmp(buf, "@template ", 10) == 0) {
+        begin_function(g, header, buf + 10);
+        return;
+    }
+    if (!g->func[0]) {
+        error("tag before the first {{@template}}");
+        return;
+    }
+    
+    flush_text(g);
+    if (raw) {
+        gen_output(g, buf, 1, 0);
+    } else if (strncmp(buf, "#if ", 4) == 0) {
+        gen_if(g, buf + 4);
+    } else if (strncmp(buf, "#each ", 6) == 0) {
+        gen_each(g, buf + 6);
+    } else if (strcmp(buf, "else") == 0) {
+        if (g->block_count == 0 || g->blocks[g->block_count - 1] != 'i') {
+            error("unexpected {{else}}");
+            return;
+        }
+        g->blocks[g->block_count - 1] = 'e';
+        sb_printf(g->body, "%*s} else {\n", 4 * g->block_count, "");
+    } else if (strcmp(buf, "/if") == 0) {
+        close_block(g, 'i');
+    } else if (strcmp(buf, "/each") == 0) {
+        close_block(g, 'l');
+    } else if (strncmp(buf, "js ", 3) == 0) {
+        gen_output(g, buf + 3, 0, 1);
+    } else if (strncmp(buf, "t ", 2) == 0) {
+        const field_t *lang = find_field(g->scopes[0].def, "lang");
+        if (!lang || lang->kind != KIND_LANG) {
+            error("{{t}} needs a language_t 'lang' field in the context");
+            return;
+        }
+        emit_line(g);
+        indent(g);
+        sb_printf(g->body, "rc |= render_buf_append_str(out, i18n_get(ctx->lang, \"%s\"));\n", buf + 2);
+    } else {
+        gen_output(g, buf, 0, 0);
+    }
+}
+
+static void compile_template(const char *path, sb_t *decls, sb_t *body, sb_t *header) {
+    char *src = read_file(path);
+    gen_t g = { .decls = decls, .body = body };
+    tmpl_path = path;
+    tmpl_line = 1;
+    
+    const char *p = src;
+    while (*p) {
+        const char *open = strstr(p, "{{");
+        const char *text_end = open ? open : p + strlen(p);
+    
+        /* Standalone block tags and comments drop their whole line, as in
+         * the runtime engine. */
+        int raw = open && open[2] == '{';
+        const char *close = open ? strstr(open + 2, raw ? "}}}" : "}}") : NULL;
+        const char *tag = NULL;
+        const char *tag_end = NULL;
+        int standalone = 0;
+        const char *line_start = text_end;
+        const char *line_end = NULL;
+    
+        if (open && close) {
+            tag = open + (raw ? 3 : 2);
+            tag_end = close;
+            while (tag < tag_end && isspace((unsigned char)*tag)) {
+                tag++;
+            }
+            while (tag_end > tag && isspace((unsigned char)tag_end[-1])) {
+                tag_end--;
+            }
+            while (line_start > p && (line_start[-1] == ' ' || line_start[-1] == '\t')) {
+                line_start--;
+            }
+            line_end = close + (raw ? 3 : 2);
+            while (*line_end == ' ' || *line_end == '\t' || *line_end == '\r') {
+                line_end++;
+            }
+            standalone = !raw && (strchr("#/!@", *tag) != NULL ||
+                                  (tag_end - tag == 4 && memcmp(tag, "else", 4) == 0));
+            standalone = standalone && (line_start == src || line_start[-1] == '\n') &&
+                         (*line_end == '\n' || *line_end == '\0');
+        }
+    
+        const char *keep_end = standalone ? line_start : text_end;
+        if (g.func[0]) {
+            add_text(&g, p, (size_t)(keep_end - p), tmpl_line);
+        } else {
+            for (const char *c = p; c < keep_end; c++) {
+                if (!isspace((unsigned char)*c)) {
+                    error("text before the first {{@template}}");
+                    break;
+                }
+            }
+        }
+        for (const char *c = p; c < text_end; c++) {
+            tmpl_line += *c == '\n';
+        }
+        if (!open) {
+            break;
+        }
+        if (!close) {
+            error("unclosed tag");
+            break;
+        }
+    
+        gen_tag(&g, header, tag, (size_t)(tag_end - tag), raw);
+        if (standalone && *line_end == '\n') {
+            tmpl_line++;
+            p = line_end + 1;
+        } else {
+            p = standalone ? line_end : close + (raw ? 3 : 2);
+        }
+    }
+    
+    end_function(&g);
+    free(g.text.data);
+    free(src);
+}
+
+static const char *basename_of(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static void write_file(const char *path, const sb_t *sb) {
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(sb->data, 1, sb->len, f) != sb->len) {
+        fprintf(stderr, "tmplc: cannot write %s\n", path);
+        exit(1);
+    }
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    const char *out_base = NULL;
+    const char *headers[MAX_HEADERS];
+    int header_count = 0;
+    int first_template = argc;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_base = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc && header_count < MAX_HEADERS) {
+            headers[header_count++] = argv[++i];
+        } else {
+            first_template = i;
+            break;
+        }
+    }
+    if (!out_base || first_template == argc) {
+        fprintf(stderr, "usage: tmplc -o <base> [-I header.h]... file.tmpl...\n");
+        return 2;
+    }
+    
+    for (int i = 0; i < header_count; i++) {
+        parse_header(headers[i]);
+    }
+    
+    sb_t decls = {0};
+    sb_t body = {0};
+    sb_t header = {0};
+    char guard[128];
+    snprintf(guard, sizeof(guard), "%s_H", basename_of(out_base));
+    for (char *c = guard; *c; c++) {
+        *c = isalnum((unsigned char)*c) ? (char)toupper((unsigned char)*c) : '_';
+    }
+    
+    sb_printf(&header, "/* Generated by tools/tmplc. Do not edit. */\n"
+                       "#ifndef %s\n#define %s\n\n#include \"render.h\"\n", guard, guard);
+    for (int i = 0; i < header_count; i++) {
+        sb_printf(&header, "#include \"%s\"\n", basename_of(headers[i]));
+    }
+    sb_printf(&header, "\n");
+    
+    for (int i = first_template; i < argc; i++) {
+        compile_template(argv[i], &decls, &body, &header);
+    }
+    sb_printf(&header, "\n#endif\n");
+    
+    if (errors) {
+        return 1;
+    }
+    
+    sb_t source = {0};
+    sb_printf(&source, "/* Generated by tools/tmplc. Do not edit. */\n"
+                       "#include \"%s.h\"\n#include \"i18n.h\"\n#include <stddef.h>\n\n",
+              basename_of(out_base));
+    sb_printf(&source, "%.*s%.*s", (int)decls.len, decls.data ? decls.data : "",
+              (int)body.len, body.data ? body.data : "");
+    
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.h", out_base);
+    write_file(path, &header);
+    snprintf(path, sizeof(path), "%s.c", out_base);
+    write_file(path, &source);
+    return 0;
+}